@@ -181,6 +181,11 @@ namespace sibr
 		\return A reference to the current stream of recorded cameras.
 		*/
 		std::vector<Camera>& cams() { return _cameras;  }
+
+		/**
+		\return The current stream of recorded cameras.
+		*/
+		const std::vector<Camera>& cams() const { return _cameras; }
 		
 		/**
 		Updates the cameras from a vector, usefull to play already loaded path.
@@ -198,6 +203,16 @@ namespace sibr
 		*/
 		void recordOfflinePath(const std::string& outPathDir, ViewBase::Ptr view, const std::string& prefix);
 
+		/**
+		\return The directory of the last path loaded, or the destination of saved images.
+		*/
+		const std::string & savingPath() const { return _savingPath; }
+
+		/**
+		\return The offline output path resolution, set by loadPath.
+		*/
+		Vector2u offlineResolution() const { return Vector2u(uint(_ow), uint(_oh)); }
+
 		/**
 		 * \return the interpolation speed
 		*/
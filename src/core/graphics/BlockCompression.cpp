@@ -0,0 +1,762 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include "core/graphics/BlockCompression.hpp"
+#include "core/system/Utils.hpp"
+
+namespace sibr
+{
+	namespace {
+
+		const char		blockCacheMagic[4] = { 'S', 'B', 'C', 'C' }; ///< Cache file signature.
+		const uint32_t	blockCacheVersion = 2; ///< Cache file version.
+
+		/** BC7 4 bits interpolation weights, out of 64. */
+		const int		bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		/** Tightly packed RGBA8 pixels. */
+		struct PixelBuffer {
+			uint w = 0;
+			uint h = 0;
+			std::vector<unsigned char> pixels;
+
+			const unsigned char * at(uint x, uint y) const { return &pixels[4 * (size_t(y) * w + x)]; }
+		};
+
+		/** Copy an image to a packed buffer, optionally flipping its rows. */
+		template<unsigned int N>
+		PixelBuffer toBuffer(const Image<unsigned char, N> & image, bool flip)
+		{
+			PixelBuffer buffer;
+			buffer.w = image.w();
+			buffer.h = image.h();
+			buffer.pixels.resize(4 * size_t(buffer.w) * buffer.h);
+			#pragma omp parallel for
+			for (int y = 0; y < int(buffer.h); ++y) {
+				const uint sy = flip ? buffer.h - 1 - uint(y) : uint(y);
+				unsigned char * dst = &buffer.pixels[4 * size_t(y) * buffer.w];
+				for (uint x = 0; x < buffer.w; ++x) {
+					const auto & pix = image(x, sy);
+					for (uint c = 0; c < 4; ++c) {
+						dst[4 * x + c] = c < N ? pix[c] : 255;
+					}
+				}
+			}
+			return buffer;
+		}
+
+		/** Half resolution version of a buffer, 2x2 box filter. */
+		PixelBuffer downsample(const PixelBuffer & src)
+		{
+			PixelBuffer dst;
+			dst.w = std::max(src.w / 2, 1u);
+			dst.h = std::max(src.h / 2, 1u);
+			dst.pixels.resize(4 * size_t(dst.w) * dst.h);
+			#pragma omp parallel for
+			for (int y = 0; y < int(dst.h); ++y) {
+				const uint y0 = std::min(2 * uint(y), src.h - 1);
+				const uint y1 = std::min(2 * uint(y) + 1, src.h - 1);
+				for (uint x = 0; x < dst.w; ++x) {
+					const uint x0 = std::min(2 * x, src.w - 1);
+					const uint x1 = std::min(2 * x + 1, src.w - 1);
+					for (uint c = 0; c < 4; ++c) {
+						const uint sum = src.at(x0, y0)[c] + src.at(x1, y0)[c] + src.at(x0, y1)[c] + src.at(x1, y1)[c];
+						dst.pixels[4 * (size_t(y) * dst.w + x) + c] = (unsigned char)((sum + 2) / 4);
+					}
+				}
+			}
+			return dst;
+		}
+
+		/** Pixels of a 4x4 block, edges are replicated. */
+		struct Block {
+			float px[16][4];
+		};
+
+		/** Principal axis fit: the block mean and the extremities of the pixels projected on the principal axis. */
+		template<int N>
+		void principalEndpoints(const Block & block, float e0[4], float e1[4])
+		{
+			float mean[N] = { 0 };
+			for (int i = 0; i < 16; ++i) {
+				for (int c = 0; c < N; ++c) {
+					mean[c] += block.px[i][c] / 16.0f;
+				}
+			}
+			float cov[N][N] = { { 0 } };
+			for (int i = 0; i < 16; ++i) {
+				for (int a = 0; a < N; ++a) {
+					for (int b = 0; b < N; ++b) {
+						cov[a][b] += (block.px[i][a] - mean[a]) * (block.px[i][b] - mean[b]);
+					}
+				}
+			}
+			// Power iteration, starting from the diagonal of the bounding box.
+			float axis[N];
+			for (int c = 0; c < N; ++c) {
+				float mini = 255.0f, maxi = 0.0f;
+				for (int i = 0; i < 16; ++i) {
+					mini = std::min(mini, block.px[i][c]);
+					maxi = std::max(maxi, block.px[i][c]);
+				}
+				axis[c] = maxi - mini;
+			}
+			for (int it = 0; it < 4; ++it) {
+				float next[N] = { 0 };
+				float norm = 0.0f;
+				for (int a = 0; a < N; ++a) {
+					for (int b = 0; b < N; ++b) {
+						next[a] += cov[a][b] * axis[b];
+					}
+					norm = std::max(norm, std::abs(next[a]));
+				}
+				if (norm < 1e-6f) {
+					break;
+				}
+				for (int a = 0; a < N; ++a) {
+					axis[a] = next[a] / norm;
+				}
+			}
+			float minT = 0.0f, maxT = 0.0f, len2 = 0.0f;
+			for (int c = 0; c < N; ++c) {
+				len2 += axis[c] * axis[c];
+			}
+			if (len2 > 1e-12f) {
+				minT = std::numeric_limits<float>::max();
+				maxT = -minT;
+				for (int i = 0; i < 16; ++i) {
+					float t = 0.0f;
+					for (int c = 0; c < N; ++c) {
+						t += (block.px[i][c] - mean[c]) * axis[c];
+					}
+					minT = std::min(minT, t / len2);
+					maxT = std::max(maxT, t / len2);
+				}
+			}
+			for (int c = 0; c < 4; ++c) {
+				e0[c] = c < N ? std::min(std::max(mean[c] + axis[c] * maxT, 0.0f), 255.0f) : 255.0f;
+				e1[c] = c < N ? std::min(std::max(mean[c] + axis[c] * minT, 0.0f), 255.0f) : 255.0f;
+			}
+		}
+
+		/** Least squares endpoints for fixed interpolation weights (weight of e1, in [0,1]).
+		 \return false if the system is degenerate (all weights equal) */
+		template<int N>
+		bool leastSquaresEndpoints(const Block & block, const float weights[16], float e0[4], float e1[4])
+		{
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			float ax[N] = { 0 }, bx[N] = { 0 };
+			for (int i = 0; i < 16; ++i) {
+				const float b = weights[i];
+				const float a = 1.0f - b;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (int c = 0; c < N; ++c) {
+					ax[c] += a * block.px[i][c];
+					bx[c] += b * block.px[i][c];
+				}
+			}
+			const float det = aa * bb - ab * ab;
+			if (std::abs(det) < 1e-6f) {
+				return false;
+			}
+			for (int c = 0; c < N; ++c) {
+				e0[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / det, 0.0f), 255.0f);
+				e1[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / det, 0.0f), 255.0f);
+			}
+			return true;
+		}
+
+		// ----- BC1 -----
+
+		uint16_t to565(const float c[4])
+		{
+			const uint r = uint(std::lround(c[0] * 31.0f / 255.0f));
+			const uint g = uint(std::lround(c[1] * 63.0f / 255.0f));
+			const uint b = uint(std::lround(c[2] * 31.0f / 255.0f));
+			return uint16_t((r << 11) | (g << 5) | b);
+		}
+
+		void from565(uint16_t v, int c[3])
+		{
+			const int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+			c[0] = (r << 3) | (r >> 2);
+			c[1] = (g << 2) | (g >> 4);
+			c[2] = (b << 3) | (b >> 2);
+		}
+
+		/** BC1 palette, 4 colors mode if c0 > c1. */
+		void bc1Palette(uint16_t c0, uint16_t c1, int palette[4][4])
+		{
+			from565(c0, palette[0]);
+			from565(c1, palette[1]);
+			for (int c = 0; c < 3; ++c) {
+				if (c0 > c1) {
+					palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+				} else {
+					palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+					palette[3][c] = 0;
+				}
+			}
+			palette[0][3] = palette[1][3] = palette[2][3] = 255;
+			palette[3][3] = c0 > c1 ? 255 : 0;
+		}
+
+		/** Nearest palette entries in 4 colors mode. \return the squared error */
+		float bc1Indices(const Block & block, uint16_t c0, uint16_t c1, int indices[16])
+		{
+			int palette[4][4];
+			bc1Palette(std::max(c0, c1), std::min(c0, c1), palette);
+			float error = 0.0f;
+			for (int i = 0; i < 16; ++i) {
+				float best = std::numeric_limits<float>::max();
+				for (int p = 0; p < 4; ++p) {
+					float d = 0.0f;
+					for (int c = 0; c < 3; ++c) {
+						const float diff = block.px[i][c] - float(palette[p][c]);
+						d += diff * diff;
+					}
+					if (d < best) {
+						best = d;
+						indices[i] = p;
+					}
+				}
+				error += best;
+			}
+			// Indices are relative to the ordered endpoints.
+			if (c0 < c1) {
+				static const int swapped[4] = { 1, 0, 3, 2 };
+				for (int i = 0; i < 16; ++i) {
+					indices[i] = swapped[indices[i]];
+				}
+			}
+			return error;
+		}
+
+		void encodeBC1(const Block & block, unsigned char * out)
+		{
+			float e0[4], e1[4];
+			principalEndpoints<3>(block, e0, e1);
+			uint16_t c0 = to565(e0), c1 = to565(e1);
+			int indices[16];
+			float error = bc1Indices(block, c0, c1, indices);
+
+			// Refine the endpoints for the chosen indices.
+			static const float bc1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			float weights[16];
+			for (int i = 0; i < 16; ++i) {
+				weights[i] = bc1Weights[indices[i]];
+			}
+			if (c0 != c1 && leastSquaresEndpoints<3>(block, weights, e0, e1)) {
+				const uint16_t r0 = to565(e0), r1 = to565(e1);
+				int refined[16];
+				const float refinedError = bc1Indices(block, r0, r1, refined);
+				if (refinedError < error) {
+					c0 = r0;
+					c1 = r1;
+					error = refinedError;
+					std::copy(refined, refined + 16, indices);
+				}
+			}
+
+			// The 4 colors mode requires c0 > c1, equal endpoints only use the first one.
+			if (c0 < c1) {
+				static const int swapped[4] = { 1, 0, 3, 2 };
+				std::swap(c0, c1);
+				for (int i = 0; i < 16; ++i) {
+					indices[i] = swapped[indices[i]];
+				}
+			} else if (c0 == c1) {
+				std::fill(indices, indices + 16, 0);
+			}
+			uint32_t bits = 0;
+			for (int i = 0; i < 16; ++i) {
+				bits |= uint32_t(indices[i]) << (2 * i);
+			}
+			out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+			out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+			for (int b = 0; b < 4; ++b) {
+				out[4 + b] = (bits >> (8 * b)) & 0xFF;
+			}
+		}
+
+		void decodeBC1(const unsigned char * in, unsigned char out[16][4])
+		{
+			const uint16_t c0 = uint16_t(in[0] | (in[1] << 8));
+			const uint16_t c1 = uint16_t(in[2] | (in[3] << 8));
+			const uint32_t bits = uint32_t(in[4]) | (uint32_t(in[5]) << 8) | (uint32_t(in[6]) << 16) | (uint32_t(in[7]) << 24);
+			int palette[4][4];
+			bc1Palette(c0, c1, palette);
+			for (int i = 0; i < 16; ++i) {
+				const int id = (bits >> (2 * i)) & 3;
+				for (int c = 0; c < 4; ++c) {
+					out[i][c] = (unsigned char)palette[id][c];
+				}
+			}
+		}
+
+		// ----- BC7, mode 6 -----
+
+		/** 7 bits endpoint and its shared P-bit minimizing the quantization error. */
+		void quantizeBC7(const float e[4], int q[4], int & pbit)
+		{
+			float bestError = std::numeric_limits<float>::max();
+			for (int p = 0; p < 2; ++p) {
+				int cand[4];
+				float error = 0.0f;
+				for (int c = 0; c < 4; ++c) {
+					cand[c] = std::min(std::max(int(std::lround((e[c] - float(p)) / 2.0f)), 0), 127);
+					const float diff = float((cand[c] << 1) | p) - e[c];
+					error += diff * diff;
+				}
+				if (error < bestError) {
+					bestError = error;
+					pbit = p;
+					std::copy(cand, cand + 4, q);
+				}
+			}
+		}
+
+		/** Nearest palette entries. \return the squared error */
+		float bc7Indices(const Block & block, const int q0[4], int p0, const int q1[4], int p1, int indices[16])
+		{
+			int palette[16][4];
+			for (int c = 0; c < 4; ++c) {
+				const int a = (q0[c] << 1) | p0;
+				const int b = (q1[c] << 1) | p1;
+				for (int w = 0; w < 16; ++w) {
+					palette[w][c] = ((64 - bc7Weights[w]) * a + bc7Weights[w] * b + 32) >> 6;
+				}
+			}
+			float error = 0.0f;
+			for (int i = 0; i < 16; ++i) {
+				float best = std::numeric_limits<float>::max();
+				for (int w = 0; w < 16; ++w) {
+					float d = 0.0f;
+					for (int c = 0; c < 4; ++c) {
+						const float diff = block.px[i][c] - float(palette[w][c]);
+						d += diff * diff;
+					}
+					if (d < best) {
+						best = d;
+						indices[i] = w;
+					}
+				}
+				error += best;
+			}
+			return error;
+		}
+
+		/** Little endian bit writer for a 128 bits block. */
+		struct BitWriter {
+			unsigned char * out;
+			uint pos = 0;
+
+			void write(uint value, uint count)
+			{
+				for (uint b = 0; b < count; ++b, ++pos) {
+					if ((value >> b) & 1) {
+						out[pos / 8] |= (unsigned char)(1 << (pos % 8));
+					}
+				}
+			}
+		};
+
+		/** Little endian bit reader for a 128 bits block. */
+		struct BitReader {
+			const unsigned char * in;
+			uint pos = 0;
+
+			uint read(uint count)
+			{
+				uint value = 0;
+				for (uint b = 0; b < count; ++b, ++pos) {
+					value |= uint((in[pos / 8] >> (pos % 8)) & 1) << b;
+				}
+				return value;
+			}
+		};
+
+		void encodeBC7(const Block & block, unsigned char * out)
+		{
+			float e0[4], e1[4];
+			principalEndpoints<4>(block, e0, e1);
+			int q0[4], q1[4], p0 = 0, p1 = 0;
+			quantizeBC7(e0, q0, p0);
+			quantizeBC7(e1, q1, p1);
+			int indices[16];
+			float error = bc7Indices(block, q0, p0, q1, p1, indices);
+
+			// Refine the endpoints for the chosen indices.
+			float weights[16];
+			for (int i = 0; i < 16; ++i) {
+				weights[i] = float(bc7Weights[indices[i]]) / 64.0f;
+			}
+			if (leastSquaresEndpoints<4>(block, weights, e0, e1)) {
+				int r0[4], r1[4], rp0 = 0, rp1 = 0;
+				quantizeBC7(e0, r0, rp0);
+				quantizeBC7(e1, r1, rp1);
+				int refined[16];
+				const float refinedError = bc7Indices(block, r0, rp0, r1, rp1, refined);
+				if (refinedError < error) {
+					std::copy(r0, r0 + 4, q0);
+					std::copy(r1, r1 + 4, q1);
+					p0 = rp0;
+					p1 = rp1;
+					error = refinedError;
+					std::copy(refined, refined + 16, indices);
+				}
+			}
+
+			// The anchor (first) index is stored on 3 bits: its high bit must be 0.
+			if (indices[0] & 8) {
+				std::swap(q0, q1);
+				std::swap(p0, p1);
+				for (int i = 0; i < 16; ++i) {
+					indices[i] = 15 - indices[i];
+				}
+			}
+
+			std::fill(out, out + 16, (unsigned char)0);
+			BitWriter writer = { out };
+			writer.write(1 << 6, 7);
+			for (int c = 0; c < 4; ++c) {
+				writer.write(uint(q0[c]), 7);
+				writer.write(uint(q1[c]), 7);
+			}
+			writer.write(uint(p0), 1);
+			writer.write(uint(p1), 1);
+			writer.write(uint(indices[0]), 3);
+			for (int i = 1; i < 16; ++i) {
+				writer.write(uint(indices[i]), 4);
+			}
+		}
+
+		void decodeBC7(const unsigned char * in, unsigned char out[16][4])
+		{
+			if ((in[0] & 0x7F) != 0x40) {
+				// Not a mode 6 block.
+				for (int i = 0; i < 16; ++i) {
+					out[i][0] = out[i][1] = out[i][2] = 0;
+					out[i][3] = 255;
+				}
+				return;
+			}
+			BitReader reader = { in };
+			reader.read(7);
+			int q[2][4];
+			for (int c = 0; c < 4; ++c) {
+				q[0][c] = int(reader.read(7));
+				q[1][c] = int(reader.read(7));
+			}
+			const int p0 = int(reader.read(1));
+			const int p1 = int(reader.read(1));
+			for (int i = 0; i < 16; ++i) {
+				const int w = bc7Weights[reader.read(i == 0 ? 3 : 4)];
+				for (int c = 0; c < 4; ++c) {
+					const int a = (q[0][c] << 1) | p0;
+					const int b = (q[1][c] << 1) | p1;
+					out[i][c] = (unsigned char)(((64 - w) * a + w * b + 32) >> 6);
+				}
+			}
+		}
+
+		/** Encode all the blocks of a buffer. */
+		CompressedImage::Level encodeLevel(const PixelBuffer & buffer, BlockFormat format)
+		{
+			CompressedImage::Level level;
+			level.w = buffer.w;
+			level.h = buffer.h;
+			const uint bw = (buffer.w + 3) / 4;
+			const uint bh = (buffer.h + 3) / 4;
+			const size_t blockSize = BlockEncoder::blockBytes(format);
+			level.blocks.resize(size_t(bw) * bh * blockSize);
+
+			#pragma omp parallel for schedule(dynamic, 1)
+			for (int by = 0; by < int(bh); ++by) {
+				Block block;
+				for (uint bx = 0; bx < bw; ++bx) {
+					for (uint i = 0; i < 16; ++i) {
+						const uint x = std::min(4 * bx + i % 4, buffer.w - 1);
+						const uint y = std::min(4 * uint(by) + i / 4, buffer.h - 1);
+						for (uint c = 0; c < 4; ++c) {
+							block.px[i][c] = float(buffer.at(x, y)[c]);
+						}
+					}
+					unsigned char * out = &level.blocks[(size_t(by) * bw + bx) * blockSize];
+					if (format == BlockFormat::BC1) {
+						encodeBC1(block, out);
+					} else {
+						encodeBC7(block, out);
+					}
+				}
+			}
+			return level;
+		}
+
+		template<unsigned int N>
+		CompressedImage encodeImage(const Image<unsigned char, N> & image, const BlockEncoder::Options & options)
+		{
+			CompressedImage result;
+			result.format = options.format;
+			result.flipped = options.flip;
+			if (image.w() == 0 || image.h() == 0) {
+				return result;
+			}
+			PixelBuffer buffer = toBuffer(image, options.flip);
+			result.levels.push_back(encodeLevel(buffer, options.format));
+			while (options.mipmaps && (buffer.w > 1 || buffer.h > 1)) {
+				buffer = downsample(buffer);
+				result.levels.push_back(encodeLevel(buffer, options.format));
+			}
+			return result;
+		}
+
+		/** \return true if a level has the size implied by its dimensions. */
+		bool validLevel(const CompressedImage::Level & level, BlockFormat format)
+		{
+			const size_t blocks = size_t((level.w + 3) / 4) * size_t((level.h + 3) / 4);
+			return level.w > 0 && level.h > 0 && level.blocks.size() == blocks * BlockEncoder::blockBytes(format);
+		}
+	}
+
+	size_t CompressedImage::size() const
+	{
+		size_t bytes = 0;
+		for (const Level & level : levels) {
+			bytes += level.blocks.size();
+		}
+		return bytes;
+	}
+
+	CompressedImage BlockEncoder::encode(const ImageRGB & image, const Options & options)
+	{
+		return encodeImage(image, options);
+	}
+
+	CompressedImage BlockEncoder::encode(const ImageRGBA & image, const Options & options)
+	{
+		return encodeImage(image, options);
+	}
+
+	ImageRGBA BlockEncoder::decode(const CompressedImage & image, uint level)
+	{
+		if (level >= image.levels.size() || !validLevel(image.levels[level], image.format)) {
+			SIBR_WRG << "[BlockEncoder] Invalid level " << level << " to decode." << std::endl;
+			return ImageRGBA();
+		}
+		const CompressedImage::Level & lvl = image.levels[level];
+		ImageRGBA result(lvl.w, lvl.h);
+		const uint bw = (lvl.w + 3) / 4;
+		const uint bh = (lvl.h + 3) / 4;
+		const size_t blockSize = blockBytes(image.format);
+
+		#pragma omp parallel for
+		for (int by = 0; by < int(bh); ++by) {
+			unsigned char pixels[16][4];
+			for (uint bx = 0; bx < bw; ++bx) {
+				const unsigned char * in = &lvl.blocks[(size_t(by) * bw + bx) * blockSize];
+				if (image.format == BlockFormat::BC1) {
+					decodeBC1(in, pixels);
+				} else {
+					decodeBC7(in, pixels);
+				}
+				for (uint i = 0; i < 16; ++i) {
+					const uint x = 4 * bx + i % 4;
+					const uint y = 4 * uint(by) + i / 4;
+					if (x >= lvl.w || y >= lvl.h) {
+						continue;
+					}
+					const uint dy = image.flipped ? lvl.h - 1 - y : y;
+					result(x, dy) = ImageRGBA::Pixel(pixels[i][0], pixels[i][1], pixels[i][2], pixels[i][3]);
+				}
+			}
+		}
+		return result;
+	}
+
+	double BlockEncoder::psnr(const ImageRGB & reference, const CompressedImage & image)
+	{
+		if (reference.w() != image.w() || reference.h() != image.h()) {
+			SIBR_WRG << "[BlockEncoder] The reference and compressed images sizes differ." << std::endl;
+			return 0.0;
+		}
+		const ImageRGBA decoded = decode(image, 0);
+		double squaredError = 0.0;
+		#pragma omp parallel for reduction(+:squaredError)
+		for (int y = 0; y < int(reference.h()); ++y) {
+			for (uint x = 0; x < reference.w(); ++x) {
+				for (uint c = 0; c < 3; ++c) {
+					const double diff = double(reference(x, y)[c]) - double(decoded(x, y)[c]);
+					squaredError += diff * diff;
+				}
+			}
+		}
+		const double mse = squaredError / (3.0 * double(reference.w()) * double(reference.h()));
+		if (mse <= 0.0) {
+			return std::numeric_limits<double>::infinity();
+		}
+		return 10.0 * std::log10(255.0 * 255.0 / mse);
+	}
+
+	size_t BlockEncoder::blockBytes(BlockFormat format)
+	{
+		return format == BlockFormat::BC1 ? 8 : 16;
+	}
+
+	bool BlockEncoder::save(const std::string & path, const std::vector<CompressedImage> & images, uint64_t signature)
+	{
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!file) {
+			SIBR_WRG << "Unable to write compressed textures cache to " << path << std::endl;
+			return false;
+		}
+		const uint32_t count = (uint32_t)images.size();
+		writeRaw(file, blockCacheMagic, 4);
+		writeRaw(file, &blockCacheVersion, 1);
+		writeRaw(file, &signature, 1);
+		writeRaw(file, &count, 1);
+		for (const CompressedImage & image : images) {
+			const uint32_t header[3] = { uint32_t(image.format), image.flipped ? 1u : 0u, (uint32_t)image.levels.size() };
+			writeRaw(file, header, 3);
+			for (const CompressedImage::Level & level : image.levels) {
+				const uint32_t size[2] = { level.w, level.h };
+				writeRaw(file, size, 2);
+				writeRaw(file, level.blocks.data(), level.blocks.size());
+			}
+		}
+		return bool(file);
+	}
+
+	bool BlockEncoder::load(const std::string & path, uint64_t signature, std::vector<CompressedImage> & images)
+	{
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+		char magic[4];
+		uint32_t version = 0;
+		uint64_t fileSignature = 0;
+		uint32_t count = 0;
+		if (!readRaw(file, magic, 4) || !std::equal(magic, magic + 4, blockCacheMagic)
+			|| !readRaw(file, &version, 1) || version != blockCacheVersion
+			|| !readRaw(file, &fileSignature, 1) || !readRaw(file, &count, 1)) {
+			SIBR_WRG << "Invalid compressed textures cache file " << path << std::endl;
+			return false;
+		}
+		if (fileSignature != signature) {
+			SIBR_LOG << "Compressed textures cache " << path << " does not match the images, ignoring it." << std::endl;
+			return false;
+		}
+
+		std::vector<CompressedImage> loaded(count);
+		bool valid = true;
+		for (CompressedImage & image : loaded) {
+			uint32_t header[3];
+			valid = readRaw(file, header, 3) && (header[0] == uint32_t(BlockFormat::BC1) || header[0] == uint32_t(BlockFormat::BC7));
+			if (!valid) {
+				break;
+			}
+			image.format = BlockFormat(header[0]);
+			image.flipped = header[1] != 0;
+			image.levels.resize(header[2]);
+			for (CompressedImage::Level & level : image.levels) {
+				uint32_t size[2];
+				valid = readRaw(file, size, 2);
+				if (!valid) {
+					break;
+				}
+				level.w = size[0];
+				level.h = size[1];
+				level.blocks.resize(size_t((level.w + 3) / 4) * size_t((level.h + 3) / 4) * blockBytes(image.format));
+				valid = readRaw(file, level.blocks.data(), level.blocks.size());
+				if (!valid) {
+					break;
+				}
+			}
+			if (!valid) {
+				break;
+			}
+		}
+		if (!valid) {
+			SIBR_WRG << "Truncated compressed textures cache file " << path << std::endl;
+			return false;
+		}
+		images.swap(loaded);
+		return true;
+	}
+
+	std::vector<CompressedImage> BlockEncoder::loadOrEncode(const std::vector<ImageRGB::Ptr> & images, uint w, uint h, const Options & options, const std::string & path)
+	{
+		const uint64_t hash = signature(images, w, h, options);
+		std::vector<CompressedImage> compressed;
+		if (load(path, hash, compressed)) {
+			bool matches = compressed.size() == images.size();
+			for (size_t i = 0; matches && i < compressed.size(); ++i) {
+				const CompressedImage & image = compressed[i];
+				matches = image.format == options.format && image.flipped == options.flip && image.w() == w && image.h() == h
+					&& (image.levels.size() > 1) == (options.mipmaps && (w > 1 || h > 1));
+			}
+			if (matches) {
+				SIBR_LOG << "Loaded " << compressed.size() << " compressed images from " << path << std::endl;
+				return compressed;
+			}
+			SIBR_LOG << "Compressed textures cache " << path << " does not match the images, ignoring it." << std::endl;
+		}
+
+		SIBR_LOG << "Compressing " << images.size() << " images..." << std::endl;
+		compressed.resize(images.size());
+		for (size_t i = 0; i < images.size(); ++i) {
+			const ImageRGB & image = *images[i];
+			if (image.w() == w && image.h() == h) {
+				compressed[i] = encode(image, options);
+			} else {
+				compressed[i] = encode(image.resized(int(w), int(h), cv::INTER_AREA), options);
+			}
+		}
+		save(path, compressed, hash);
+		return compressed;
+	}
+
+	uint64_t BlockEncoder::signature(const std::vector<ImageRGB::Ptr> & images, uint w, uint h, const Options & options)
+	{
+		// FNV-1a of each image in parallel, then of the parameters and the images hashes.
+		std::vector<uint64_t> hashes(images.size(), fnv1aSeed);
+		#pragma omp parallel for
+		for (int i = 0; i < int(images.size()); ++i) {
+			const ImageRGB & image = *images[i];
+			const uint32_t size[2] = { image.w(), image.h() };
+			hashes[i] = hashWords(fnv1aSeed, size, 2);
+			for (uint y = 0; y < image.h(); ++y) {
+				hashes[i] = hashBytes(hashes[i], image.toOpenCV().ptr<unsigned char>(y), 3 * size_t(image.w()));
+			}
+		}
+		const uint32_t params[6] = { (uint32_t)images.size(), w, h, uint32_t(options.format), options.mipmaps ? 1u : 0u, options.flip ? 1u : 0u };
+		uint64_t hash = hashWords(fnv1aSeed, params, 6);
+		if (!hashes.empty()) {
+			hash = hashWords(hash, reinterpret_cast<const uint32_t*>(hashes.data()), 2 * hashes.size());
+		}
+		return hash;
+	}
+
+	std::string BlockEncoder::cachePath(const std::string & datasetPath, BlockFormat format)
+	{
+		return datasetPath + "/textures_" + (format == BlockFormat::BC1 ? "bc1" : "bc7") + ".bin";
+	}
+
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include "core/graphics/Config.hpp"
+# include "core/graphics/Image.hpp"
+
+namespace sibr
+{
+	/** GPU block compression formats, both encode 4x4 pixels blocks.
+	\ingroup sibr_graphics
+	*/
+	enum class BlockFormat : uint32_t {
+		BC1 = 1, ///< RGB, 8 bytes per block (0.5 byte per pixel).
+		BC7 = 7 ///< RGBA, 16 bytes per block (1 byte per pixel), higher quality.
+	};
+
+	/** A block compressed image with its mip levels, ready for upload (see Texture2DArray::createFromImages).
+	\ingroup sibr_graphics
+	*/
+	struct SIBR_GRAPHICS_EXPORT CompressedImage {
+
+		/** A mip level. */
+		struct Level {
+			uint w = 0; ///< Width in pixels.
+			uint h = 0; ///< Height in pixels.
+			std::vector<unsigned char> blocks; ///< Blocks, row by row.
+		};
+
+		BlockFormat format = BlockFormat::BC7; ///< Blocks format.
+		bool flipped = false; ///< Are the rows stored bottom to top (OpenGL order)?
+		std::vector<Level> levels; ///< Mip levels, the first one is full resolution.
+
+		/** \return the full resolution width. */
+		uint w() const { return levels.empty() ? 0 : levels[0].w; }
+
+		/** \return the full resolution height. */
+		uint h() const { return levels.empty() ? 0 : levels[0].h; }
+
+		/** \return the size of all levels, in bytes. */
+		size_t size() const;
+	};
+
+	/** Multithreaded CPU encoder for BC1 and BC7 images, meant to be run once at preprocess time:
+	 the results can be saved to a cache file next to the dataset and uploaded as is to the GPU,
+	 dividing the texture memory of RGB8 input images by 4 (BC7) or 8 (BC1).
+	 - BC1: endpoints along the principal axis of the block colors, refined once by least squares;
+	 - BC7: mode 6 only (one subset, 7+1 bits endpoints, 4 bits indices), fitted the same way.
+	 Blocks are encoded in parallel. Mip levels are built with a box filter before encoding.
+	\ingroup sibr_graphics
+	*/
+	class SIBR_GRAPHICS_EXPORT BlockEncoder
+	{
+	public:
+
+		/** Encoding parameters. */
+		struct Options {
+			BlockFormat format = BlockFormat::BC7; ///< Output format.
+			bool mipmaps = true; ///< Encode the full mip chain.
+			bool flip = true; ///< Store the rows bottom to top, as done by SIBR_FLIP_TEXTURE.
+		};
+
+		/** Encode an image.
+		\param image the input image
+		\param options encoding parameters
+		\return the compressed image
+		*/
+		static CompressedImage encode(const ImageRGB & image, const Options & options);
+
+		/** Encode an image, BC1 ignores the alpha channel.
+		\param image the input image
+		\param options encoding parameters
+		\return the compressed image
+		*/
+		static CompressedImage encode(const ImageRGBA & image, const Options & options);
+
+		/** Decode one level of a compressed image, with its original row order.
+		\param image the compressed image
+		\param level the mip level
+		\return the decoded image
+		\note Only the BC7 blocks produced by the encoder (mode 6) are supported.
+		*/
+		static ImageRGBA decode(const CompressedImage & image, uint level = 0);
+
+		/** Compute the peak signal to noise ratio of the full resolution level of a compressed image.
+		\param reference the image that was encoded
+		\param image the compressed image
+		\return the PSNR over the RGB channels, in dB
+		*/
+		static double psnr(const ImageRGB & reference, const CompressedImage & image);
+
+		/** \return the size of a 4x4 block, in bytes.
+		\param format the block format
+		*/
+		static size_t blockBytes(BlockFormat format);
+
+		/** Save compressed images to a binary cache file.
+		\param path the destination file
+		\param images the images
+		\param signature the signature of the inputs (see signature)
+		\return true if the file was written
+		*/
+		static bool save(const std::string & path, const std::vector<CompressedImage> & images, uint64_t signature);
+
+		/** Load compressed images from a binary cache file.
+		\param path the cache file
+		\param signature the expected signature of the inputs, the cache is rejected if it differs
+		\param images will contain the images
+		\return true if the file was loaded and is valid
+		*/
+		static bool load(const std::string & path, uint64_t signature, std::vector<CompressedImage> & images);
+
+		/** Load compressed images from a cache file if it matches the input images and options, or encode them and update the cache.
+		\param images the input images
+		\param w the width of the compressed images, the inputs are resized if needed
+		\param h the height of the compressed images
+		\param options encoding parameters
+		\param path the cache file
+		\return the compressed images, one per input image
+		*/
+		static std::vector<CompressedImage> loadOrEncode(const std::vector<ImageRGB::Ptr> & images, uint w, uint h, const Options & options, const std::string & path);
+
+		/** Hash the input images content and the encoding parameters, to detect stale caches.
+		\param images the input images
+		\param w the width of the compressed images
+		\param h the height of the compressed images
+		\param options encoding parameters
+		\return the signature
+		*/
+		static uint64_t signature(const std::vector<ImageRGB::Ptr> & images, uint w, uint h, const Options & options);
+
+		/** \return the default cache file path for the input images of a dataset.
+		\param datasetPath the dataset directory
+		\param format the block format
+		*/
+		static std::string cachePath(const std::string & datasetPath, BlockFormat format);
+	};
+
+}
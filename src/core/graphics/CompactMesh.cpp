@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <cstring>
+#include "core/graphics/CompactMesh.hpp"
+
+namespace sibr
+{
+	namespace {
+
+		/** Sign function returning 1 for 0, as required by the octahedral mapping. */
+		inline float signNotZero(float v)
+		{
+			return v < 0.0f ? -1.0f : 1.0f;
+		}
+
+	}
+
+	CompactMesh::CompactMesh(bool withGraphics)
+	{
+		if (withGraphics) {
+			_bufferGL.reset(new MeshBufferGL());
+		}
+	}
+
+	void CompactMesh::encode(const sibr::Mesh & mesh)
+	{
+		const int verticesCount = (int)mesh.vertices().size();
+		_box = mesh.getBoundingBox();
+		const sibr::Vector3f origin = _box.isEmpty() ? sibr::Vector3f(0.0f, 0.0f, 0.0f) : sibr::Vector3f(_box.min());
+		const sibr::Vector3f extent = _box.isEmpty() ? sibr::Vector3f(1.0f, 1.0f, 1.0f) : sibr::Vector3f(_box.sizes());
+		const sibr::Vector3f scale(
+			extent[0] > 0.0f ? 65535.0f / extent[0] : 0.0f,
+			extent[1] > 0.0f ? 65535.0f / extent[1] : 0.0f,
+			extent[2] > 0.0f ? 65535.0f / extent[2] : 0.0f);
+
+		_positions.resize(3 * size_t(verticesCount));
+		_normals.resize(mesh.hasNormals() ? 2 * size_t(verticesCount) : 0);
+		_texCoords.resize(mesh.hasTexCoords() ? 2 * size_t(verticesCount) : 0);
+		_colors.resize(mesh.hasColors() ? 3 * size_t(verticesCount) : 0);
+
+		#pragma omp parallel for
+		for (int vid = 0; vid < verticesCount; ++vid) {
+			const sibr::Vector3f & p = mesh.vertices()[vid];
+			for (int c = 0; c < 3; ++c) {
+				const float q = std::round((p[c] - origin[c]) * scale[c]);
+				_positions[3 * size_t(vid) + c] = uint16_t(std::min(65535.0f, std::max(0.0f, q)));
+			}
+			if (!_normals.empty()) {
+				encodeOctahedral(mesh.normals()[vid], _normals[2 * size_t(vid)], _normals[2 * size_t(vid) + 1]);
+			}
+			if (!_texCoords.empty()) {
+				_texCoords[2 * size_t(vid)] = floatToHalf(mesh.texCoords()[vid][0]);
+				_texCoords[2 * size_t(vid) + 1] = floatToHalf(mesh.texCoords()[vid][1]);
+			}
+			if (!_colors.empty()) {
+				for (int c = 0; c < 3; ++c) {
+					_colors[3 * size_t(vid) + c] = uint8_t(std::round(std::min(1.0f, std::max(0.0f, mesh.colors()[vid][c])) * 255.0f));
+				}
+			}
+		}
+		_triangles = mesh.triangles();
+		_decoded.reset();
+		_dirtyBufferGL = true;
+	}
+
+	sibr::Mesh::Ptr CompactMesh::decode(bool withGraphics) const
+	{
+		const int count = (int)verticesCount();
+		sibr::Mesh::Vertices vertices(count);
+		sibr::Mesh::Normals normals(hasNormals() ? count : 0);
+		sibr::Mesh::UVs texCoords(hasTexCoords() ? count : 0);
+		sibr::Mesh::Colors colors(hasColors() ? count : 0);
+
+		#pragma omp parallel for
+		for (int vid = 0; vid < count; ++vid) {
+			vertices[vid] = vertex(vid);
+			if (!normals.empty()) {
+				normals[vid] = normal(vid);
+			}
+			if (!texCoords.empty()) {
+				texCoords[vid] = texCoord(vid);
+			}
+			if (!colors.empty()) {
+				colors[vid] = color(vid);
+			}
+		}
+
+		sibr::Mesh::Ptr mesh(new sibr::Mesh(withGraphics));
+		mesh->vertices(vertices);
+		mesh->normals(normals);
+		mesh->texCoords(texCoords);
+		mesh->colors(colors);
+		mesh->triangles(_triangles);
+		return mesh;
+	}
+
+	const sibr::Mesh & CompactMesh::decoded() const
+	{
+		if (!_decoded) {
+			_decoded = decode(false);
+		}
+		return *_decoded;
+	}
+
+	void CompactMesh::releaseDecoded() const
+	{
+		_decoded.reset();
+	}
+
+	sibr::Vector3f CompactMesh::vertex(size_t vid) const
+	{
+		const sibr::Vector3f extent = _box.isEmpty() ? sibr::Vector3f(0.0f, 0.0f, 0.0f) : sibr::Vector3f(_box.sizes());
+		const sibr::Vector3f origin = _box.isEmpty() ? sibr::Vector3f(0.0f, 0.0f, 0.0f) : sibr::Vector3f(_box.min());
+		const uint16_t * q = &_positions[3 * vid];
+		return sibr::Vector3f(
+			origin[0] + float(q[0]) * extent[0] / 65535.0f,
+			origin[1] + float(q[1]) * extent[1] / 65535.0f,
+			origin[2] + float(q[2]) * extent[2] / 65535.0f);
+	}
+
+	sibr::Vector3f CompactMesh::normal(size_t vid) const
+	{
+		return decodeOctahedral(_normals[2 * vid], _normals[2 * vid + 1]);
+	}
+
+	sibr::Vector3f CompactMesh::color(size_t vid) const
+	{
+		const uint8_t * c = &_colors[3 * vid];
+		return sibr::Vector3f(float(c[0]), float(c[1]), float(c[2])) / 255.0f;
+	}
+
+	sibr::Vector2f CompactMesh::texCoord(size_t vid) const
+	{
+		return sibr::Vector2f(halfToFloat(_texCoords[2 * vid]), halfToFloat(_texCoords[2 * vid + 1]));
+	}
+
+	sibr::Matrix4f CompactMesh::positionTransform() const
+	{
+		sibr::Matrix4f transform = sibr::Matrix4f::Identity();
+		if (!_box.isEmpty()) {
+			transform.block<3, 3>(0, 0) = _box.sizes().asDiagonal();
+			transform.block<3, 1>(0, 3) = _box.min();
+		}
+		return transform;
+	}
+
+	sibr::Vector3f CompactMesh::positionErrorBound() const
+	{
+		if (_box.isEmpty()) {
+			return sibr::Vector3f(0.0f, 0.0f, 0.0f);
+		}
+		return _box.sizes() / (2.0f * 65535.0f);
+	}
+
+	size_t CompactMesh::memorySize() const
+	{
+		return _positions.size() * sizeof(uint16_t) + _normals.size() * sizeof(int16_t)
+			+ _texCoords.size() * sizeof(uint16_t) + _colors.size() * sizeof(uint8_t)
+			+ _triangles.size() * sizeof(sibr::Vector3u);
+	}
+
+	void CompactMesh::render(bool depthTest, bool backFaceCulling) const
+	{
+		if (!_bufferGL) { SIBR_ERR << "Tried to render a non OpenGL CompactMesh" << std::endl; return; }
+		if (_dirtyBufferGL) {
+			uploadBufferGL();
+		}
+
+		if (depthTest)
+			glEnable(GL_DEPTH_TEST);
+		else
+			glDisable(GL_DEPTH_TEST);
+
+		if (backFaceCulling) {
+			glEnable(GL_CULL_FACE);
+			glCullFace(GL_BACK);
+		}
+		else
+			glDisable(GL_CULL_FACE);
+
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		if (!_triangles.empty()) {
+			_bufferGL->draw();
+		}
+
+		// Reset default state (Policy is 'restore default values')
+		glDisable(GL_CULL_FACE);
+		glDisable(GL_DEPTH_TEST);
+	}
+
+	void CompactMesh::uploadBufferGL() const
+	{
+		_bufferGL->build(*this, _quantizedPositionsGL);
+		_dirtyBufferGL = false;
+	}
+
+	void CompactMesh::encodeOctahedral(const sibr::Vector3f & n, int16_t & x, int16_t & y)
+	{
+		const float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+		float px = 0.0f, py = 0.0f;
+		if (l1 > 0.0f) {
+			px = n[0] / l1;
+			py = n[1] / l1;
+			if (n[2] < 0.0f) {
+				const float fx = (1.0f - std::abs(py)) * signNotZero(px);
+				const float fy = (1.0f - std::abs(px)) * signNotZero(py);
+				px = fx;
+				py = fy;
+			}
+		}
+		// Pick the best of the four neighbouring quantized values, rounding each coordinate independently is not optimal.
+		const float qx = std::min(1.0f, std::max(-1.0f, px)) * 32767.0f;
+		const float qy = std::min(1.0f, std::max(-1.0f, py)) * 32767.0f;
+		float bestDot = -2.0f;
+		for (int i = 0; i < 4; ++i) {
+			const int16_t cx = int16_t(std::max(-32767.0f, std::min(32767.0f, (i & 1) ? std::ceil(qx) : std::floor(qx))));
+			const int16_t cy = int16_t(std::max(-32767.0f, std::min(32767.0f, (i & 2) ? std::ceil(qy) : std::floor(qy))));
+			const float d = decodeOctahedral(cx, cy).dot(n);
+			if (d > bestDot) {
+				bestDot = d;
+				x = cx;
+				y = cy;
+			}
+		}
+	}
+
+	sibr::Vector3f CompactMesh::decodeOctahedral(int16_t x, int16_t y)
+	{
+		float px = std::max(-1.0f, float(x) / 32767.0f);
+		float py = std::max(-1.0f, float(y) / 32767.0f);
+		const float pz = 1.0f - std::abs(px) - std::abs(py);
+		if (pz < 0.0f) {
+			const float fx = (1.0f - std::abs(py)) * signNotZero(px);
+			const float fy = (1.0f - std::abs(px)) * signNotZero(py);
+			px = fx;
+			py = fy;
+		}
+		return sibr::Vector3f(px, py, pz).normalized();
+	}
+
+	uint16_t CompactMesh::floatToHalf(float value)
+	{
+		uint32_t f;
+		std::memcpy(&f, &value, sizeof(float));
+		const uint32_t sign = (f >> 16) & 0x8000u;
+		const uint32_t exponent = (f >> 23) & 0xffu;
+		uint32_t mantissa = f & 0x7fffffu;
+
+		// Infinity and NaN.
+		if (exponent == 0xffu) {
+			return uint16_t(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+		}
+		const int halfExponent = int(exponent) - 127 + 15;
+		// Overflow to infinity.
+		if (halfExponent >= 31) {
+			return uint16_t(sign | 0x7c00u);
+		}
+		// Denormals (or zero).
+		if (halfExponent <= 0) {
+			if (halfExponent < -10) {
+				return uint16_t(sign);
+			}
+			mantissa |= 0x800000u;
+			const uint32_t shift = uint32_t(14 - halfExponent);
+			uint32_t half = mantissa >> shift;
+			const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+			const uint32_t halfway = 1u << (shift - 1u);
+			if (remainder > halfway || (remainder == halfway && (half & 1u))) {
+				++half;
+			}
+			return uint16_t(sign | half);
+		}
+		// Normal numbers, round to nearest even (a carry correctly propagates to the exponent).
+		uint32_t half = sign | (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+		const uint32_t remainder = mantissa & 0x1fffu;
+		if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+			++half;
+		}
+		return uint16_t(half);
+	}
+
+	float CompactMesh::halfToFloat(uint16_t value)
+	{
+		const uint32_t sign = uint32_t(value & 0x8000u) << 16;
+		const uint32_t exponent = (value >> 10) & 0x1fu;
+		const uint32_t mantissa = value & 0x3ffu;
+		uint32_t f;
+		if (exponent == 0) {
+			// Zero and denormals.
+			const float denormal = float(mantissa) / 16777216.0f;
+			return sign ? -denormal : denormal;
+		} else if (exponent == 31) {
+			f = sign | 0x7f800000u | (mantissa << 13);
+		} else {
+			f = sign | ((exponent + 127u - 15u) << 23) | (mantissa << 13);
+		}
+		float result;
+		std::memcpy(&result, &f, sizeof(float));
+		return result;
+	}
+
+} // namespace sibr
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include "core/graphics/Config.hpp"
+# include "core/system/Matrix.hpp"
+# include "core/graphics/Mesh.hpp"
+# include "core/graphics/MeshBufferGL.hpp"
+
+namespace sibr
+{
+	/** Quantized version of a mesh, using 17 bytes per vertex with all attributes instead of 44.
+	 - positions: 3 x 16 bits, relative to the bounding box. Error per axis at most extent / (2 * 65535), up to float rounding;
+	 - normals: octahedral encoding, 2 x 16 bits. Angular error below 0.01 degree;
+	 - UVs: 2 half floats. Relative error at most 2^-11, that is 2.4e-4 for coordinates in [0.5, 1[ (a quarter of a texel in 1024 wide textures);
+	 - colors: 3 x 8 bits. Error at most 1/510.
+	 Triangles are kept as is. The attributes can be decoded lazily, per vertex, or all at once into a regular Mesh.
+	 For rendering, the attributes are uploaded as normalized integers/half floats so that shaders still receive
+	 floating point values: normals as 10 bits per component (error below 0.1 degree), colors and UVs as is.
+	 Positions are uploaded as floats, unless quantized positions are requested: in that case the shader receives
+	 values in [0,1] and positionTransform() has to be applied before the view-projection (it can be folded in the MVP matrix).
+	\ingroup sibr_graphics
+	*/
+	class SIBR_GRAPHICS_EXPORT CompactMesh
+	{
+		SIBR_CLASS_PTR(CompactMesh);
+
+	public:
+
+		/** Constructor.
+		\param withGraphics should the mesh be renderable with OpenGL
+		*/
+		CompactMesh(bool withGraphics = true);
+
+		/** Quantize a mesh.
+		\param mesh the mesh to encode
+		*/
+		void encode(const sibr::Mesh & mesh);
+
+		/** Decode all attributes into a regular mesh.
+		\param withGraphics should the decoded mesh be renderable with OpenGL
+		\return the decoded mesh
+		*/
+		sibr::Mesh::Ptr decode(bool withGraphics = false) const;
+
+		/** \return the decoded mesh, decoding it on first call. The result is kept until releaseDecoded() is called. */
+		const sibr::Mesh & decoded() const;
+
+		/** Free the cached decoded mesh. */
+		void releaseDecoded() const;
+
+		/** \return the number of vertices. */
+		size_t verticesCount() const { return _positions.size() / 3; }
+
+		/** \return the triangles. */
+		const sibr::Mesh::Triangles & triangles() const { return _triangles; }
+
+		/** \return true if the mesh has normals. */
+		bool hasNormals() const { return !_normals.empty(); }
+
+		/** \return true if the mesh has colors. */
+		bool hasColors() const { return !_colors.empty(); }
+
+		/** \return true if the mesh has UVs. */
+		bool hasTexCoords() const { return !_texCoords.empty(); }
+
+		/** Decode a vertex position.
+		\param vid the vertex index
+		\return the position
+		*/
+		sibr::Vector3f vertex(size_t vid) const;
+
+		/** Decode a vertex normal.
+		\param vid the vertex index
+		\return the unit normal
+		*/
+		sibr::Vector3f normal(size_t vid) const;
+
+		/** Decode a vertex color.
+		\param vid the vertex index
+		\return the color in [0,1]
+		*/
+		sibr::Vector3f color(size_t vid) const;
+
+		/** Decode a vertex UV.
+		\param vid the vertex index
+		\return the texture coordinates
+		*/
+		sibr::Vector2f texCoord(size_t vid) const;
+
+		/** \return the quantized positions (3 per vertex, 0 and 65535 map to the bounding box corners). */
+		const std::vector<uint16_t> & quantizedPositions() const { return _positions; }
+
+		/** \return the octahedral normals (2 per vertex, see decodeOctahedral()). */
+		const std::vector<int16_t> & octahedralNormals() const { return _normals; }
+
+		/** \return the half float UVs (2 per vertex). */
+		const std::vector<uint16_t> & halfTexCoords() const { return _texCoords; }
+
+		/** \return the 8 bits colors (3 per vertex). */
+		const std::vector<uint8_t> & quantizedColors() const { return _colors; }
+
+		/** \return the bounding box used to quantize positions. */
+		const Eigen::AlignedBox<float, 3> & boundingBox() const { return _box; }
+
+		/** \return the transformation from quantized positions in [0,1] to world space. */
+		sibr::Matrix4f positionTransform() const;
+
+		/** \return the maximum position error along each axis. */
+		sibr::Vector3f positionErrorBound() const;
+
+		/** \return the size of the encoded attributes and triangles, in bytes. */
+		size_t memorySize() const;
+
+		/** Should positions be uploaded quantized (see positionTransform()).
+		\param quantized the new value
+		*/
+		void quantizedPositionsGL(bool quantized) { _quantizedPositionsGL = quantized; _dirtyBufferGL = true; }
+
+		/** \return true if positions are uploaded quantized. */
+		bool quantizedPositionsGL() const { return _quantizedPositionsGL; }
+
+		/** Render the mesh using OpenGL.
+		\param depthTest should depth testing be performed
+		\param backFaceCulling should culling be performed
+		*/
+		void render(bool depthTest = true, bool backFaceCulling = true) const;
+
+		/** Octahedral encoding of a unit vector.
+		\param n the unit vector
+		\param x will contain the first coordinate
+		\param y will contain the second coordinate
+		*/
+		static void encodeOctahedral(const sibr::Vector3f & n, int16_t & x, int16_t & y);
+
+		/** Octahedral decoding of a unit vector.
+		\param x the first coordinate
+		\param y the second coordinate
+		\return the unit vector
+		*/
+		static sibr::Vector3f decodeOctahedral(int16_t x, int16_t y);
+
+		/** Convert a float to a half float (round to nearest).
+		\param value the float value
+		\return the half float bits
+		*/
+		static uint16_t floatToHalf(float value);
+
+		/** Convert a half float to a float.
+		\param value the half float bits
+		\return the float value
+		*/
+		static float halfToFloat(uint16_t value);
+
+	private:
+
+		/** Upload the data to the GPU. */
+		void uploadBufferGL() const;
+
+		std::vector<uint16_t>			_positions; ///< Quantized positions (3 per vertex).
+		std::vector<int16_t>			_normals; ///< Octahedral normals (2 per vertex).
+		std::vector<uint16_t>			_texCoords; ///< Half float UVs (2 per vertex).
+		std::vector<uint8_t>			_colors; ///< 8 bits colors (3 per vertex).
+		sibr::Mesh::Triangles			_triangles; ///< Triangles.
+		Eigen::AlignedBox<float, 3>		_box; ///< Quantization bounding box.
+
+		mutable sibr::Mesh::Ptr			_decoded; ///< Lazily decoded mesh.
+		bool							_quantizedPositionsGL = false; ///< Upload quantized positions.
+		mutable bool					_dirtyBufferGL = true; ///< Should the GPU data be updated.
+		std::unique_ptr<MeshBufferGL>	_bufferGL; ///< GPU data.
+	};
+
+} // namespace sibr
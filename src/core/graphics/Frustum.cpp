@@ -26,7 +26,7 @@ namespace sibr
 		float farD = cam.zfar();
 
 		// compute width and height of the near and far plane sections
-		float tang = (float)tan(SIBR_DEGTORAD(angle) * 0.5);
+		float tang = (float)tan(angle * 0.5);
 		float nh = nearD * tang;
 		float nw = nh * ratio;
 		float fh = farD  * tang;
@@ -75,9 +75,41 @@ namespace sibr
 		aux.normalize();
 		normal = Y.cross(aux);
 		_planes[RIGHT].buildFrom( normal, nc + X*nw );
+
+		for (int c = 0; c < 8; ++c) {
+			const Vector3f& center = (c & 4) ? fc : nc;
+			const float w = (c & 4) ? fw : nw;
+			const float h = (c & 4) ? fh : nh;
+			_corners[c] = center + X * ((c & 1) ? w : -w) + Y * ((c & 2) ? h : -h);
+		}
 	}
 
-	Frustum::TestResult	Frustum::testSphere(const Vector3f& p, float radius)
+	Frustum::Frustum(const Matrix4f& viewproj)
+	{
+		// Gribb-Hartmann extraction, a point p is inside if dot(plane, (p,1)) >= 0.
+		const Vector4f r0 = viewproj.row(0).transpose();
+		const Vector4f r1 = viewproj.row(1).transpose();
+		const Vector4f r2 = viewproj.row(2).transpose();
+		const Vector4f r3 = viewproj.row(3).transpose();
+		const std::array<Vector4f, COUNT> planes = { r3 - r1, r3 + r1, r3 + r0, r3 - r0, r3 + r2, r3 - r2 };
+		for (int i = 0; i < COUNT; ++i) {
+			Vector4f plane = planes[i];
+			const float norm = plane.head<3>().norm();
+			if (norm > 0.0f) {
+				plane /= norm;
+			}
+			_planes[i] = { plane.x(), plane.y(), plane.z(), plane.w() };
+		}
+
+		const Matrix4f invViewproj = viewproj.inverse();
+		for (int c = 0; c < 8; ++c) {
+			const Vector4f ndc((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f, 1.0f);
+			const Vector4f world = invViewproj * ndc;
+			_corners[c] = world.head<3>() / world.w();
+		}
+	}
+
+	Frustum::TestResult	Frustum::testSphere(const Vector3f& p, float radius) const
 	{
 		float distance;
 		TestResult result = INSIDE;
@@ -92,7 +124,29 @@ namespace sibr
 		return result;
 	}
 
-	float	Frustum::Plane::distanceWithPoint(const Vector3f& p)
+	bool	Frustum::overlaps(const Frustum& other) const
+	{
+		// Small tolerance, relative to normalized planes, for frusta sharing a face.
+		const float eps = 1e-5f;
+		auto separates = [eps](const Frustum& a, const Frustum& b) {
+			for (const Plane& plane : a._planes) {
+				bool allOutside = true;
+				for (const Vector3f& corner : b._corners) {
+					if (plane.distanceWithPoint(corner) >= -eps) {
+						allOutside = false;
+						break;
+					}
+				}
+				if (allOutside) {
+					return true;
+				}
+			}
+			return false;
+		};
+		return !separates(*this, other) && !separates(other, *this);
+	}
+
+	float	Frustum::Plane::distanceWithPoint(const Vector3f& p) const
 	{
 		// dist = A*rx + B*ry + C*rz + D = n . r  + D
 		return A*p.x() + B*p.y() + C*p.z() + D;
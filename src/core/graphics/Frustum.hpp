@@ -15,6 +15,7 @@
 # include <array>
 # include "core/graphics/Config.hpp"
 # include "core/system/Vector.hpp"
+# include "core/system/Matrix.hpp"
 
 namespace sibr
 {
@@ -48,7 +49,7 @@ namespace sibr
 			\param p 3D point
 			\return distance
 			*/
-			float	distanceWithPoint(const Vector3f& p);
+			float	distanceWithPoint(const Vector3f& p) const;
 
 			/** Build a plane from a normal and a point.
 			\param normal the normal
@@ -64,12 +65,27 @@ namespace sibr
 		*/
 		Frustum(const Camera& cam);
 
+		/** Construct the frustum of a view projection matrix, off-axis projections included.
+		\param viewproj the view projection matrix (OpenGL clip space convention)
+		*/
+		Frustum(const Matrix4f& viewproj);
+
 		/** Test if a sphere intersects the frustum or is contained in it.
 		\param sphere sphere center
 		\param radius sphere radis
 		\return if the sphere is inside, intersecting or outside the frustum
 		*/
-		TestResult	testSphere(const Vector3f& sphere, float radius);
+		TestResult	testSphere(const Vector3f& sphere, float radius) const;
+
+		/** Conservative overlap test: two frusta are disjoint if all the corners of one of them are
+		outside of a plane of the other. Some disjoint frusta might be reported as overlapping.
+		\param other the other frustum
+		\return false if the frusta are disjoint
+		*/
+		bool		overlaps(const Frustum& other) const;
+
+		/** \return the world space corners, near plane first. */
+		const std::array<Vector3f, 8>&	corners() const { return _corners; }
 
 	private:
 
@@ -87,7 +103,8 @@ namespace sibr
 		};
 
 
-		std::array<Plane, COUNT> _planes; ///< Frustum planes.
+		std::array<Plane, COUNT> _planes; ///< Frustum planes, normals pointing inside.
+		std::array<Vector3f, 8> _corners; ///< Frustum corners.
 
 	};
 
@@ -0,0 +1,380 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <algorithm>
+#include <fstream>
+#include "core/graphics/LODMesh.hpp"
+#include "core/graphics/MeshDecimator.hpp"
+#include "core/graphics/Frustum.hpp"
+#include "core/system/Utils.hpp"
+
+namespace sibr
+{
+	namespace {
+
+		const char		lodCacheMagic[4] = { 'S', 'L', 'O', 'D' }; ///< Cache file signature.
+		const uint32_t	lodCacheVersion = 1; ///< Cache file version.
+
+		/** Compare two bounding boxes up to float precision. */
+		bool sameBox(const Eigen::AlignedBox<float, 3> & a, const Eigen::AlignedBox<float, 3> & b)
+		{
+			return a.min().isApprox(b.min(), 1e-5f) && a.max().isApprox(b.max(), 1e-5f);
+		}
+	}
+
+	LODMesh::LODMesh(bool withGraphics)
+	{
+		_mesh.reset(new Mesh(withGraphics));
+	}
+
+	void LODMesh::build(const sibr::Mesh & mesh, const Options & options)
+	{
+		_clusters.clear();
+		_sourceVerticesCount = (uint)mesh.vertices().size();
+		_sourceTrianglesCount = (uint)mesh.triangles().size();
+		_sourceBox = mesh.getBoundingBox();
+
+		// Weld vertices sharing the same position (UV/normal seams) so that only geometric borders remain.
+		const sibr::Mesh::Vertices & inVertices = mesh.vertices();
+		std::vector<uint> order(inVertices.size());
+		for (uint vid = 0; vid < (uint)order.size(); ++vid) {
+			order[vid] = vid;
+		}
+		const auto lessPosition = [&inVertices](uint a, uint b) {
+			const sibr::Vector3f & pa = inVertices[a];
+			const sibr::Vector3f & pb = inVertices[b];
+			return pa[0] < pb[0] || (pa[0] == pb[0] && (pa[1] < pb[1] || (pa[1] == pb[1] && pa[2] < pb[2])));
+		};
+		std::sort(order.begin(), order.end(), lessPosition);
+		std::vector<uint> welded(inVertices.size());
+		sibr::Mesh::Vertices vertices;
+		vertices.reserve(inVertices.size());
+		for (size_t i = 0; i < order.size(); ++i) {
+			if (i == 0 || inVertices[order[i]] != inVertices[order[i - 1]]) {
+				vertices.push_back(inVertices[order[i]]);
+			}
+			welded[order[i]] = uint(vertices.size() - 1);
+		}
+
+		sibr::Mesh::Triangles triangles;
+		triangles.reserve(mesh.triangles().size());
+		for (const sibr::Vector3u & t : mesh.triangles()) {
+			const sibr::Vector3u wt(welded[t[0]], welded[t[1]], welded[t[2]]);
+			if (wt[0] != wt[1] && wt[1] != wt[2] && wt[2] != wt[0]) {
+				triangles.push_back(wt);
+			}
+		}
+
+		// Split the triangles in clusters: median split of the centroids along the largest axis.
+		std::vector<sibr::Vector3f> centroids(triangles.size());
+		std::vector<uint> trianglesOrder(triangles.size());
+		for (uint tid = 0; tid < (uint)triangles.size(); ++tid) {
+			const sibr::Vector3u & t = triangles[tid];
+			centroids[tid] = (vertices[t[0]] + vertices[t[1]] + vertices[t[2]]) / 3.0f;
+			trianglesOrder[tid] = tid;
+		}
+		const size_t maxClusterSize = std::max(1u, options.trianglesPerCluster);
+		std::vector<sibr::Vector2u> leaves;
+		std::vector<sibr::Vector2u> stack;
+		if (!triangles.empty()) {
+			stack.emplace_back(0u, (uint)triangles.size());
+		}
+		while (!stack.empty()) {
+			const sibr::Vector2u node = stack.back();
+			stack.pop_back();
+			if (node[1] - node[0] <= maxClusterSize) {
+				leaves.push_back(node);
+				continue;
+			}
+			Eigen::AlignedBox<float, 3> box;
+			for (uint i = node[0]; i < node[1]; ++i) {
+				box.extend(centroids[trianglesOrder[i]]);
+			}
+			int axis;
+			box.sizes().maxCoeff(&axis);
+			const uint middle = (node[0] + node[1]) / 2;
+			std::nth_element(trianglesOrder.begin() + node[0], trianglesOrder.begin() + middle, trianglesOrder.begin() + node[1],
+				[&centroids, axis](uint a, uint b) { return centroids[a][axis] < centroids[b][axis]; });
+			// Push the right half first so that leaves are produced in depth-first, spatially coherent order.
+			stack.emplace_back(middle, node[1]);
+			stack.emplace_back(node[0], middle);
+		}
+
+		// Simplify each cluster independently, with locked borders.
+		const int clustersCount = (int)leaves.size();
+		const uint maxLevels = std::max(1u, options.levelsCount);
+		std::vector<std::vector<sibr::Mesh::Triangles>> levels(clustersCount);
+		_clusters.resize(clustersCount);
+
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int cid = 0; cid < clustersCount; ++cid) {
+			const sibr::Vector2u & leaf = leaves[cid];
+			Cluster & cluster = _clusters[cid];
+
+			// Extract the cluster as a standalone mesh.
+			std::vector<uint> localToGlobal;
+			std::vector<std::pair<uint, uint>> globalToLocal;
+			for (uint i = leaf[0]; i < leaf[1]; ++i) {
+				const sibr::Vector3u & t = triangles[trianglesOrder[i]];
+				for (int k = 0; k < 3; ++k) {
+					globalToLocal.emplace_back(t[k], 0u);
+				}
+			}
+			std::sort(globalToLocal.begin(), globalToLocal.end());
+			globalToLocal.erase(std::unique(globalToLocal.begin(), globalToLocal.end()), globalToLocal.end());
+			sibr::Mesh::Vertices localVertices(globalToLocal.size());
+			localToGlobal.resize(globalToLocal.size());
+			for (uint lid = 0; lid < (uint)globalToLocal.size(); ++lid) {
+				globalToLocal[lid].second = lid;
+				localToGlobal[lid] = globalToLocal[lid].first;
+				localVertices[lid] = vertices[globalToLocal[lid].first];
+			}
+			const auto toLocal = [&globalToLocal](uint gid) {
+				return std::lower_bound(globalToLocal.begin(), globalToLocal.end(), std::make_pair(gid, 0u))->second;
+			};
+			sibr::Mesh::Triangles localTriangles;
+			localTriangles.reserve(leaf[1] - leaf[0]);
+			levels[cid].emplace_back();
+			for (uint i = leaf[0]; i < leaf[1]; ++i) {
+				const sibr::Vector3u & t = triangles[trianglesOrder[i]];
+				levels[cid].back().push_back(t);
+				localTriangles.emplace_back(toLocal(t[0]), toLocal(t[1]), toLocal(t[2]));
+			}
+
+			// Bounding sphere. Coarser levels only use a subset of the vertices, so it bounds them too.
+			Eigen::AlignedBox<float, 3> box;
+			for (const sibr::Vector3f & v : localVertices) {
+				box.extend(v);
+			}
+			cluster.center = box.center();
+			cluster.radius = 0.0f;
+			for (const sibr::Vector3f & v : localVertices) {
+				cluster.radius = std::max(cluster.radius, (v - cluster.center).norm());
+			}
+			cluster.errors.push_back(0.0f);
+
+			sibr::Mesh::Ptr current(new Mesh(false));
+			current->vertices(localVertices);
+			current->triangles(localTriangles);
+			float error = 0.0f;
+
+			while (levels[cid].size() < maxLevels && current->triangles().size() > 8) {
+				const size_t currentCount = current->triangles().size();
+				MeshDecimator::Options decimation;
+				decimation.targetTriangles = std::max(size_t(1), size_t(options.levelRatio * float(currentCount)));
+				decimation.lockBorders = true;
+				decimation.partitionPasses = 0;
+				decimation.verbose = false;
+				MeshDecimator decimator;
+				sibr::Mesh::Ptr next = decimator.decimate(*current, decimation);
+				// Stop when the locked borders prevent any significant reduction.
+				if (next->triangles().empty() || next->triangles().size() > size_t(0.9f * float(currentCount))) {
+					break;
+				}
+				const Eigen::AlignedBox<float, 3> currentBox = current->getBoundingBox();
+				error += decimator.error() * currentBox.diagonal().norm();
+
+				std::vector<uint> nextToGlobal(next->vertices().size());
+				for (size_t vid = 0; vid < nextToGlobal.size(); ++vid) {
+					nextToGlobal[vid] = localToGlobal[decimator.mapping()[vid]];
+				}
+				levels[cid].emplace_back();
+				for (const sibr::Vector3u & t : next->triangles()) {
+					levels[cid].back().emplace_back(nextToGlobal[t[0]], nextToGlobal[t[1]], nextToGlobal[t[2]]);
+				}
+				cluster.errors.push_back(error);
+				localToGlobal.swap(nextToGlobal);
+				current = next;
+			}
+		}
+
+		// Store the levels one after the other, so that neighbouring clusters at the same level are contiguous.
+		sibr::Mesh::Triangles lodTriangles;
+		for (uint lid = 0; lid < maxLevels; ++lid) {
+			for (int cid = 0; cid < clustersCount; ++cid) {
+				if (lid >= levels[cid].size()) {
+					continue;
+				}
+				const uint begin = 3 * uint(lodTriangles.size());
+				lodTriangles.insert(lodTriangles.end(), levels[cid][lid].begin(), levels[cid][lid].end());
+				_clusters[cid].ranges.emplace_back(begin, 3 * uint(lodTriangles.size()));
+			}
+		}
+
+		_mesh->vertices(vertices);
+		_mesh->triangles(lodTriangles);
+	}
+
+	bool LODMesh::save(const std::string & path) const
+	{
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!file) {
+			SIBR_WRG << "Unable to write LOD cache to " << path << std::endl;
+			return false;
+		}
+		const uint32_t counts[4] = { _sourceVerticesCount, _sourceTrianglesCount,
+			(uint32_t)_mesh->vertices().size(), (uint32_t)_mesh->triangles().size() };
+		writeRaw(file, lodCacheMagic, 4);
+		writeRaw(file, &lodCacheVersion, 1);
+		writeRaw(file, counts, 4);
+		writeRaw(file, _sourceBox.min().data(), 3);
+		writeRaw(file, _sourceBox.max().data(), 3);
+		writeRaw(file, _mesh->vertexArray(), 3 * size_t(counts[2]));
+		writeRaw(file, _mesh->triangleArray(), 3 * size_t(counts[3]));
+
+		const uint32_t clustersCount = (uint32_t)_clusters.size();
+		writeRaw(file, &clustersCount, 1);
+		for (const Cluster & cluster : _clusters) {
+			const uint32_t levelsCount = (uint32_t)cluster.ranges.size();
+			writeRaw(file, cluster.center.data(), 3);
+			writeRaw(file, &cluster.radius, 1);
+			writeRaw(file, &levelsCount, 1);
+			for (uint32_t lid = 0; lid < levelsCount; ++lid) {
+				writeRaw(file, cluster.ranges[lid].data(), 2);
+				writeRaw(file, &cluster.errors[lid], 1);
+			}
+		}
+		return bool(file);
+	}
+
+	bool LODMesh::load(const std::string & path, const sibr::Mesh * source)
+	{
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+		char magic[4];
+		uint32_t version = 0;
+		uint32_t counts[4];
+		Eigen::Vector3f boxMin, boxMax;
+		if (!readRaw(file, magic, 4) || !std::equal(magic, magic + 4, lodCacheMagic)
+			|| !readRaw(file, &version, 1) || version != lodCacheVersion
+			|| !readRaw(file, counts, 4) || !readRaw(file, boxMin.data(), 3) || !readRaw(file, boxMax.data(), 3)) {
+			SIBR_WRG << "Invalid LOD cache file " << path << std::endl;
+			return false;
+		}
+		const Eigen::AlignedBox<float, 3> box(boxMin, boxMax);
+		if (source && (counts[0] != source->vertices().size() || counts[1] != source->triangles().size() || !sameBox(box, source->getBoundingBox()))) {
+			SIBR_LOG << "LOD cache " << path << " does not match the mesh, ignoring it." << std::endl;
+			return false;
+		}
+
+		sibr::Mesh::Vertices vertices(counts[2]);
+		sibr::Mesh::Triangles triangles(counts[3]);
+		uint32_t clustersCount = 0;
+		bool valid = readRaw(file, reinterpret_cast<float*>(vertices.data()), 3 * size_t(counts[2]))
+			&& readRaw(file, reinterpret_cast<uint*>(triangles.data()), 3 * size_t(counts[3]))
+			&& readRaw(file, &clustersCount, 1);
+
+		std::vector<Cluster> clusters(valid ? clustersCount : 0);
+		for (Cluster & cluster : clusters) {
+			uint32_t levelsCount = 0;
+			valid = valid && readRaw(file, cluster.center.data(), 3) && readRaw(file, &cluster.radius, 1) && readRaw(file, &levelsCount, 1);
+			if (!valid) {
+				break;
+			}
+			cluster.ranges.resize(levelsCount);
+			cluster.errors.resize(levelsCount);
+			for (uint32_t lid = 0; lid < levelsCount && valid; ++lid) {
+				valid = readRaw(file, cluster.ranges[lid].data(), 2) && readRaw(file, &cluster.errors[lid], 1)
+					&& cluster.ranges[lid][0] <= cluster.ranges[lid][1] && cluster.ranges[lid][1] <= 3 * counts[3];
+			}
+		}
+		if (!valid) {
+			SIBR_WRG << "Truncated LOD cache file " << path << std::endl;
+			return false;
+		}
+
+		_sourceVerticesCount = counts[0];
+		_sourceTrianglesCount = counts[1];
+		_sourceBox = box;
+		_clusters.swap(clusters);
+		_mesh->vertices(vertices);
+		_mesh->triangles(triangles);
+		return true;
+	}
+
+	void LODMesh::loadOrBuild(const sibr::Mesh & mesh, const std::string & path, const Options & options)
+	{
+		if (load(path, &mesh)) {
+			SIBR_LOG << "Loaded LOD (" << _clusters.size() << " clusters) from " << path << std::endl;
+			return;
+		}
+		SIBR_LOG << "Building LOD for a mesh with " << mesh.triangles().size() << " triangles..." << std::endl;
+		build(mesh, options);
+		SIBR_LOG << "Built " << _clusters.size() << " clusters, " << _mesh->triangles().size() << " triangles in all levels." << std::endl;
+		save(path);
+	}
+
+	std::string LODMesh::cachePath(const std::string & meshPath)
+	{
+		return sibr::removeExtension(meshPath) + "_lod.bin";
+	}
+
+	void LODMesh::select(const sibr::Camera & eye, float viewportHeight, float pixelError, Selection & selection) const
+	{
+		selection.ranges.clear();
+		selection.trianglesCount = 0;
+		selection.culledClusters = 0;
+
+		// Size in pixels of a unit length at unit distance (perspective) or at any distance (orthographic).
+		const float pixelsPerUnit = eye.ortho()
+			? viewportHeight / (2.0f * eye.orthoTop())
+			: viewportHeight / (2.0f * std::tan(0.5f * eye.fovy()));
+		const float threshold = pixelError / pixelsPerUnit;
+
+		// Frustum only supports perspective cameras, orthographic views are not culled.
+		Frustum frustum(eye);
+		for (const Cluster & cluster : _clusters) {
+			if (!eye.ortho() && frustum.testSphere(cluster.center, cluster.radius) == Frustum::OUTSIDE) {
+				++selection.culledClusters;
+				continue;
+			}
+			const float distance = eye.ortho() ? 1.0f : std::max((cluster.center - eye.position()).norm() - cluster.radius, eye.znear());
+			// Errors increase with the level: pick the coarsest one that is below the threshold.
+			size_t level = cluster.errors.size() - 1;
+			while (level > 0 && cluster.errors[level] > threshold * distance) {
+				--level;
+			}
+			selection.ranges.push_back(cluster.ranges[level]);
+		}
+
+		std::sort(selection.ranges.begin(), selection.ranges.end(),
+			[](const sibr::Vector2u & a, const sibr::Vector2u & b) { return a[0] < b[0]; });
+		size_t merged = 0;
+		for (size_t rid = 0; rid < selection.ranges.size(); ++rid) {
+			const sibr::Vector2u & range = selection.ranges[rid];
+			selection.trianglesCount += (range[1] - range[0]) / 3;
+			if (merged > 0 && selection.ranges[merged - 1][1] == range[0]) {
+				selection.ranges[merged - 1][1] = range[1];
+			} else {
+				selection.ranges[merged++] = range;
+			}
+		}
+		selection.ranges.resize(merged);
+	}
+
+	void LODMesh::render(const Selection & selection, bool depthTest, bool backFaceCulling) const
+	{
+		for (const sibr::Vector2u & range : selection.ranges) {
+			_mesh->renderSubMesh(range[0], range[1], depthTest, backFaceCulling);
+		}
+	}
+
+	void LODMesh::render(const sibr::Camera & eye, float viewportHeight, float pixelError, bool depthTest, bool backFaceCulling) const
+	{
+		Selection selection;
+		select(eye, viewportHeight, pixelError, selection);
+		render(selection, depthTest, backFaceCulling);
+	}
+
+} // namespace sibr
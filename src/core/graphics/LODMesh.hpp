@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include "core/graphics/Config.hpp"
+# include "core/graphics/Mesh.hpp"
+# include "core/graphics/Camera.hpp"
+
+namespace sibr
+{
+	/** Clustered, multi-level version of a mesh, used to render proxy geometry with a view-dependent level of detail.
+	 The mesh is split in spatially coherent clusters of triangles; each cluster is then simplified
+	 independently into a chain of levels (see MeshDecimator), with its open borders locked so that
+	 neighbouring clusters always match whatever level each of them is rendered at.
+	 All levels share the vertices of the input mesh (welded by position) and their triangles are stored
+	 in a single index buffer, level after level, so that selecting a level per cluster boils down to
+	 a list of index ranges that can be drawn with Mesh::renderSubMesh.
+	 Only positions are kept: the LOD is meant for depth and visibility passes.
+	 Building can be long for large meshes, the result can be saved to and reloaded from a cache file.
+	\ingroup sibr_graphics
+	*/
+	class SIBR_GRAPHICS_EXPORT LODMesh
+	{
+		SIBR_CLASS_PTR(LODMesh);
+
+	public:
+
+		/** Build options. */
+		struct Options {
+			uint trianglesPerCluster = 4096; ///< Maximum number of triangles of a cluster at the finest level.
+			uint levelsCount = 6; ///< Maximum number of levels, including the input mesh.
+			float levelRatio = 0.5f; ///< Target triangle count of a level, relative to the previous one.
+		};
+
+		/** Cluster information. */
+		struct Cluster {
+			sibr::Vector3f center; ///< Bounding sphere center.
+			float radius = 0.0f; ///< Bounding sphere radius.
+			std::vector<sibr::Vector2u> ranges; ///< Index range [begin, end[ of each level in the index buffer, finest first.
+			std::vector<float> errors; ///< World space error of each level (increasing, 0 for the finest level).
+		};
+
+		/** Result of a per-view level selection. */
+		struct Selection {
+			std::vector<sibr::Vector2u> ranges; ///< Index ranges to render, contiguous ranges are merged.
+			size_t trianglesCount = 0; ///< Number of selected triangles.
+			uint culledClusters = 0; ///< Number of clusters outside of the view frustum.
+		};
+
+		/** Constructor.
+		\param withGraphics should the internal mesh be renderable with OpenGL
+		*/
+		LODMesh(bool withGraphics = true);
+
+		/** Build the clusters and levels of a mesh.
+		\param mesh the input mesh
+		\param options build options
+		*/
+		void build(const sibr::Mesh & mesh, const Options & options);
+
+		/** Save the LOD to a binary cache file.
+		\param path the destination file
+		\return true if the file was written
+		*/
+		bool save(const std::string & path) const;
+
+		/** Load the LOD from a binary cache file.
+		\param path the cache file
+		\param source if not null, the cache is rejected unless it was built from a mesh with the same vertex and triangle counts and bounding box
+		\return true if the file was loaded and is valid
+		*/
+		bool load(const std::string & path, const sibr::Mesh * source = nullptr);
+
+		/** Load the LOD from a cache file if it is valid for the mesh, or build it and update the cache.
+		\param mesh the input mesh
+		\param path the cache file
+		\param options build options
+		*/
+		void loadOrBuild(const sibr::Mesh & mesh, const std::string & path, const Options & options);
+
+		/** \return the default cache file path associated with a mesh file.
+		\param meshPath path of the mesh file
+		*/
+		static std::string cachePath(const std::string & meshPath);
+
+		/** Select the level of each cluster for a given view: clusters outside of the camera frustum
+		 are skipped (perspective cameras only), the others use their coarsest level whose error, projected on screen, is below a threshold.
+		\param eye the camera
+		\param viewportHeight the viewport height in pixels
+		\param pixelError the maximum screen space error, in pixels
+		\param selection will contain the ranges to render
+		*/
+		void select(const sibr::Camera & eye, float viewportHeight, float pixelError, Selection & selection) const;
+
+		/** Render a selection using OpenGL.
+		\param selection the selection to render
+		\param depthTest should depth testing be performed
+		\param backFaceCulling should culling be performed
+		*/
+		void render(const Selection & selection, bool depthTest = true, bool backFaceCulling = true) const;
+
+		/** Select the levels for a view and render them using OpenGL.
+		\param eye the camera
+		\param viewportHeight the viewport height in pixels
+		\param pixelError the maximum screen space error, in pixels
+		\param depthTest should depth testing be performed
+		\param backFaceCulling should culling be performed
+		*/
+		void render(const sibr::Camera & eye, float viewportHeight, float pixelError, bool depthTest = true, bool backFaceCulling = true) const;
+
+		/** \return the internal mesh (welded vertices, all levels triangles). */
+		const sibr::Mesh & mesh() const { return *_mesh; }
+
+		/** \return the clusters. */
+		const std::vector<Cluster> & clusters() const { return _clusters; }
+
+		/** \return true if the LOD contains geometry. */
+		bool isValid() const { return !_clusters.empty(); }
+
+	private:
+
+		sibr::Mesh::Ptr				_mesh; ///< Welded vertices and triangles of all levels.
+		std::vector<Cluster>		_clusters; ///< Clusters.
+		uint						_sourceVerticesCount = 0; ///< Vertex count of the source mesh, for cache validation.
+		uint						_sourceTrianglesCount = 0; ///< Triangle count of the source mesh, for cache validation.
+		Eigen::AlignedBox<float, 3>	_sourceBox; ///< Bounding box of the source mesh, for cache validation.
+	};
+
+} // namespace sibr
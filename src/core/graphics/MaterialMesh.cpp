@@ -32,6 +32,28 @@
 
 namespace sibr
 {
+	namespace {
+
+		/** Number of AO samples per vertex of the first, coarse, AO computation. */
+		const int aoCoarseSamples = 8;
+
+		/** Number of AO samples per vertex once refined. */
+		const int aoSamples = 64;
+
+		/** \return the factory of default AO functions. */
+		std::function<std::function<sibr::Mesh::Colors(sibr::MaterialMesh&, const int)>(void)> & aoFunctionFactory(void)
+		{
+			static std::function<std::function<sibr::Mesh::Colors(sibr::MaterialMesh&, const int)>(void)> factory;
+			return factory;
+		}
+
+	}
+
+	void	MaterialMesh::defaultAoFunction(const std::function<std::function<sibr::Mesh::Colors(sibr::MaterialMesh&, const int)>(void)>& factory)
+	{
+		aoFunctionFactory() = factory;
+	}
+
 	bool	MaterialMesh::load(const std::string& filename)
 	{
 
@@ -1285,33 +1307,25 @@ namespace sibr
 
 	void MaterialMesh::ambientOcclusion(const MaterialMesh::AmbientOcclusion & ao)
 	{
+		if (!_aoFunction) {
+			if (!aoFunctionFactory()) {
+				SIBR_WRG << "No ambient occlusion function, link with sibr_raycaster or set one with aoFunction()." << std::endl;
+				_ambientOcclusion = ao;
+				return;
+			}
+			_aoFunction = aoFunctionFactory()();
+		}
+
 		if (!_aoInitialized) {
 
+			// Coarse result first, refined by the next calls.
 			_ambientOcclusion = ao;
-			colors(_aoFunction(*this, 64));
+			_aoSamples = aoCoarseSamples;
+			colors(_aoFunction(*this, _aoSamples));
 			createSubMeshes();
-			float averageDistance = 0.f;
-			for (sibr::Vector3u t : triangles()) {
-
-				float maximumDistance = 0.f;
-
-				sibr::Vector3f a = vertices().at(t.x());
-				sibr::Vector3f b = vertices().at(t.y());
-				sibr::Vector3f c = vertices().at(t.z());
 
-				float d = distance(a, b);
-				if (d > maximumDistance)  maximumDistance = d;
-				d = distance(b, c);
-				if (d > maximumDistance)  maximumDistance = d;
-				d = distance(a, c);
-				if (d > maximumDistance)  maximumDistance = d;
-
-				averageDistance += maximumDistance;
-			}
-
-
-			const auto areaHeronsFormula = [](sibr::Vector3f A, sibr::Vector3f B,
-				sibr::Vector3f C) -> float {
+			const auto areaHeronsFormula = [](const sibr::Vector3f & A, const sibr::Vector3f & B,
+				const sibr::Vector3f & C) -> float {
 				float a = distance(A, B);
 				float b = distance(B, C);
 				float c = distance(C, A);
@@ -1319,16 +1333,21 @@ namespace sibr
 					(a + (b - c))) / 4.f;
 			};
 
+			const sibr::Mesh::Vertices & verts = vertices();
+			const sibr::Mesh::Triangles & tris = triangles();
+			float averageDistance = 0.f;
 			float averageArea = 0.f;
-			for (sibr::Vector3u t : triangles()) {
-
-				averageArea += areaHeronsFormula(vertices().at(t.x()),
-					vertices().at(t.y()),
-					vertices().at(t.z()));
+			#pragma omp parallel for reduction(+:averageDistance,averageArea)
+			for (int tid = 0; tid < (int)tris.size(); ++tid) {
+				const sibr::Vector3u & t = tris[tid];
+				const sibr::Vector3f & a = verts[t.x()];
+				const sibr::Vector3f & b = verts[t.y()];
+				const sibr::Vector3f & c = verts[t.z()];
+
+				averageDistance += std::max(distance(a, b), std::max(distance(b, c), distance(a, c)));
+				averageArea += areaHeronsFormula(a, b, c);
 			}
 
-
-
 			averageDistance /= triangles().size();
 			_averageSize = averageDistance;
 			averageArea /= triangles().size();
@@ -1336,19 +1355,27 @@ namespace sibr
 			std::cout << "Average distance SIZE = " << _averageSize << std::endl;
 			std::cout << "Average distance SIZE = " << _averageArea << std::endl;
 			_aoInitialized = true;
+			return;
 		}
-		if (ao.AttenuationDistance != _ambientOcclusion.AttenuationDistance) {
-			_ambientOcclusion = ao;
-			colors(_aoFunction(*this, 64));
-			createSubMeshes();
-		}
+
+		bool update = false;
 		if (ao.SubdivideThreshold < _ambientOcclusion.SubdivideThreshold) {
-			_ambientOcclusion = ao;
-			subdivideMesh(_ambientOcclusion.SubdivideThreshold);
-			colors(_aoFunction(*this, 64));
-			createSubMeshes();
+			// New geometry, start again from a coarse result.
+			subdivideMesh(ao.SubdivideThreshold);
+			_aoSamples = aoCoarseSamples;
+			update = true;
+		} else if (ao.AttenuationDistance != _ambientOcclusion.AttenuationDistance) {
+			// Same samples count, the AO function can reuse its cached samples.
+			update = true;
+		} else if (ao.AoIsActive && _aoSamples < aoSamples) {
+			_aoSamples = std::min(aoSamples, 2 * _aoSamples);
+			update = true;
 		}
 		_ambientOcclusion = ao;
+		if (update) {
+			colors(_aoFunction(*this, _aoSamples));
+			createSubMeshes();
+		}
 	}
 
 
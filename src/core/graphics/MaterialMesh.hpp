@@ -331,10 +331,18 @@ namespace sibr
 		/** Set the function used to compute ambient occlusion at each vertex. 
 		\param aoFunction the new function to use 
 		*/
-		inline void aoFunction(std::function<sibr::Mesh::Colors(
+		inline void aoFunction(const std::function<sibr::Mesh::Colors(
 			sibr::MaterialMesh&,
 			const int)>& aoFunction);
 
+		/** Set the factory creating the AO function of meshes that have none, on their first AO computation.
+		 sibr_raycaster installs one based on AmbientOcclusionBaker.
+		\param factory returns a new AO function for each mesh
+		*/
+		static void defaultAoFunction(const std::function<std::function<sibr::Mesh::Colors(
+			sibr::MaterialMesh&,
+			const int)>(void)>& factory);
+
 		/** Load a mesh from the disk.
 		\param filename the file path
 		\return a success flag
@@ -514,6 +522,7 @@ namespace sibr
 		AmbientOcclusion _ambientOcclusion; ///< AO options.
 		std::function<sibr::Mesh::Colors(sibr::MaterialMesh&, const int)> _aoFunction; ///< AO generation function.
 		bool _aoInitialized = false; ///< Is AO data initialized.
+		int _aoSamples = 0; ///< Number of AO samples per vertex used so far, increased at each call until converged.
 		float _averageSize = 0.0f; ///< Average maximum edge length.
 		float _averageArea = 0.0f; ///< Average triangle area.
 
@@ -673,7 +682,7 @@ namespace sibr
 		return _ambientOcclusion;
 	}
 
-	inline void MaterialMesh::aoFunction(std::function<sibr::Mesh::Colors
+	inline void MaterialMesh::aoFunction(const std::function<sibr::Mesh::Colors
 	(sibr::MaterialMesh&, const int)>&
 		aoFunction)
 	{
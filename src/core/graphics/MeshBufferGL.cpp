@@ -13,6 +13,7 @@
 
 #include "core/graphics/Mesh.hpp"
 #include "core/graphics/MeshBufferGL.hpp"
+#include "core/graphics/CompactMesh.hpp"
 
 #include <unordered_map>
 
@@ -232,6 +233,103 @@ namespace sibr
 		glBindVertexArray(0);
 	}
 
+	void 	MeshBufferGL::build( const CompactMesh& mesh, bool quantizedPositions )
+	{
+		if (!_vaoId)
+		{
+			glGenVertexArrays(1, &_vaoId);
+			glGenBuffers(BUFCOUNT, &_bufferIds[0]);
+		}
+
+		glBindVertexArray(_vaoId);
+		CHECK_GL_ERROR;
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _bufferIds[BUFINDEX]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * 3 * mesh.triangles().size(), mesh.triangles().data(), GL_STATIC_DRAW);
+		_indexCount = (uint)(3 * mesh.triangles().size());
+		CHECK_GL_ERROR;
+
+		const uint numVertices = (uint)mesh.verticesCount();
+		_vertexCount = numVertices;
+
+		std::vector<GLfloat> vertices;
+		if (!quantizedPositions) {
+			vertices.resize(3 * size_t(numVertices));
+			#pragma omp parallel for
+			for (int vid = 0; vid < (int)numVertices; ++vid) {
+				const Vector3f v = mesh.vertex(vid);
+				vertices[3 * size_t(vid)] = v[0];
+				vertices[3 * size_t(vid) + 1] = v[1];
+				vertices[3 * size_t(vid) + 2] = v[2];
+			}
+		}
+		// Normals are decoded and packed as signed normalized 10 bits components.
+		std::vector<GLuint> normals(mesh.hasNormals() ? numVertices : 0);
+		#pragma omp parallel for
+		for (int vid = 0; vid < (int)normals.size(); ++vid) {
+			const Vector3f n = mesh.normal(vid);
+			GLuint packed = 0;
+			for (int c = 0; c < 3; ++c) {
+				const int q = int(std::round(std::min(1.0f, std::max(-1.0f, n[c])) * 511.0f));
+				packed |= (GLuint(q) & 0x3ffu) << (10 * c);
+			}
+			normals[vid] = packed;
+		}
+
+		// Each attribute sub-array starts on a 4 bytes boundary, as required by GL for the
+		// packed normals and to stay on the fast path for the other attributes.
+		std::vector<uint8> 	vertexData;
+		const auto alignVertexData = [&vertexData]() {
+			vertexData.resize((vertexData.size() + 3) & ~size_t(3), 0);
+			return vertexData.size();
+		};
+		if (quantizedPositions) {
+			appendVertexData(vertexData, mesh.quantizedPositions());
+		} else {
+			appendVertexData(vertexData, vertices);
+		}
+		const size_t colorsOffset = alignVertexData();
+		appendVertexData(vertexData, mesh.quantizedColors());
+		const size_t texCoordsOffset = alignVertexData();
+		appendVertexData(vertexData, mesh.halfTexCoords());
+		const size_t normalsOffset = alignVertexData();
+		appendVertexData(vertexData, normals);
+
+		glBindBuffer(GL_ARRAY_BUFFER, _bufferIds[BUFVERTEX]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(uint8)*vertexData.size(), vertexData.data(), GL_STATIC_DRAW);
+		CHECK_GL_ERROR;
+
+		if (quantizedPositions) {
+			glVertexAttribPointer(VertexAttribLocation, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0, (uint8_t*)(0));
+		} else {
+			glVertexAttribPointer(VertexAttribLocation, 3, GL_FLOAT, GL_FALSE, 0, (uint8_t*)(0));
+		}
+		glEnableVertexAttribArray(VertexAttribLocation);
+
+		// Missing attributes are disabled, shaders get the default (0,0,0,1) value.
+		if (mesh.hasColors()) {
+			glVertexAttribPointer(ColorAttribLocation, 3, GL_UNSIGNED_BYTE, GL_TRUE, 0, (uint8_t*)(0) + colorsOffset);
+			glEnableVertexAttribArray(ColorAttribLocation);
+		} else {
+			glDisableVertexAttribArray(ColorAttribLocation);
+		}
+		if (mesh.hasTexCoords()) {
+			glVertexAttribPointer(TexCoordAttribLocation, 2, GL_HALF_FLOAT, GL_FALSE, 0, (uint8_t*)(0) + texCoordsOffset);
+			glEnableVertexAttribArray(TexCoordAttribLocation);
+		} else {
+			glDisableVertexAttribArray(TexCoordAttribLocation);
+		}
+		if (mesh.hasNormals()) {
+			glVertexAttribPointer(NormalAttribLocation, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 0, (uint8_t*)(0) + normalsOffset);
+			glEnableVertexAttribArray(NormalAttribLocation);
+		} else {
+			glDisableVertexAttribArray(NormalAttribLocation);
+		}
+		CHECK_GL_ERROR;
+
+		glBindVertexArray(0);
+	}
+
 	void	MeshBufferGL::free(void)
 	{
 		if (_bufferIds[0] && _bufferIds[1] && _bufferIds[2])
@@ -30,6 +30,7 @@ namespace sibr
 
 
 	class Mesh;
+	class CompactMesh;
 
 	/**
 	* This class is used to render mesh. It act like a vertex buffer object
@@ -100,6 +101,13 @@ namespace sibr
 		*/
 		void	build( const Mesh& mesh, bool adjacency = false );
 
+		/** Build from a quantized mesh, uploading its attributes without decoding them: normals are
+		* stored as 10 bits integers, colors as bytes, UVs as half floats, all normalized so that shaders receive floats.
+		* \param mesh the mesh to upload
+		* \param quantizedPositions upload positions as 16 bits normalized integers (the shader receives values in [0,1], see CompactMesh::positionTransform), instead of floats
+		*/
+		void	build( const CompactMesh& mesh, bool quantizedPositions = false );
+
 		/** Delete the GPU buffer, freeing memory. */
 		void	free(void);
 
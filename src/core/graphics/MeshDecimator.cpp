@@ -0,0 +1,560 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <algorithm>
+#include <queue>
+#include "core/graphics/MeshDecimator.hpp"
+
+namespace sibr
+{
+	namespace {
+
+		/** Symmetric 4x4 plane quadric, with the accumulated area. */
+		struct Quadric {
+			double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+			double area = 0;
+
+			/** Build the quadric of a plane, weighted by an area. */
+			static Quadric fromPlane(const Eigen::Vector3d & n, double d, double w) {
+				Quadric q;
+				q.a2 = w * n.x() * n.x(); q.ab = w * n.x() * n.y(); q.ac = w * n.x() * n.z(); q.ad = w * n.x() * d;
+				q.b2 = w * n.y() * n.y(); q.bc = w * n.y() * n.z(); q.bd = w * n.y() * d;
+				q.c2 = w * n.z() * n.z(); q.cd = w * n.z() * d;
+				q.d2 = w * d * d;
+				q.area = w;
+				return q;
+			}
+
+			Quadric & operator+=(const Quadric & o) {
+				a2 += o.a2; ab += o.ab; ac += o.ac; ad += o.ad; b2 += o.b2;
+				bc += o.bc; bd += o.bd; c2 += o.c2; cd += o.cd; d2 += o.d2;
+				area += o.area;
+				return *this;
+			}
+
+			/** \return the area-weighted squared distance of p to the accumulated planes. */
+			double eval(const Eigen::Vector3d & p) const {
+				const double x = p.x(), y = p.y(), z = p.z();
+				return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+					+ b2 * y * y + 2 * bc * y * z + 2 * bd * y
+					+ c2 * z * z + 2 * cd * z + d2;
+			}
+		};
+
+		/** Collapse candidate, u collapses onto v. */
+		struct Collapse {
+			double cost;
+			uint u, v;
+			uint stampU, stampV;
+			bool operator<(const Collapse & o) const { return cost > o.cost; }
+		};
+
+		/** Shared, read-only data and the triangles being simplified. */
+		struct DecimationData {
+			std::vector<Eigen::Vector3d> positions; ///< Positions, normalized by the bounding box diagonal.
+			const sibr::Mesh::Colors * colors = nullptr;
+			const sibr::Mesh::UVs * uvs = nullptr;
+			sibr::Mesh::Triangles triangles;
+			std::vector<unsigned char> alive; ///< Per triangle.
+			std::vector<unsigned char> locked; ///< Per vertex, for the current pass.
+			double attributeWeight = 0.0;
+			double maxErrorSq = 0.0;
+			bool lockBorders = false;
+		};
+
+		/** Simplify the triangles of a cell. Only unlocked vertices can move; they must
+		 not be referenced by triangles from other cells.
+		\param data the shared data
+		\param cellTris the triangles of the cell
+		\param target the triangle count to reach (0 to only use the error bound)
+		\param partial true if other cells share some of the locked vertices of this cell
+		\return the largest accepted error (squared)
+		*/
+		double decimateCell(DecimationData & data, const std::vector<uint> & cellTris, size_t target, bool partial)
+		{
+			// Local vertex indexing.
+			std::vector<uint> verts;
+			verts.reserve(cellTris.size() * 3);
+			for (uint t : cellTris) {
+				verts.push_back(data.triangles[t][0]);
+				verts.push_back(data.triangles[t][1]);
+				verts.push_back(data.triangles[t][2]);
+			}
+			std::sort(verts.begin(), verts.end());
+			verts.erase(std::unique(verts.begin(), verts.end()), verts.end());
+			const auto local = [&verts](uint g) {
+				return uint(std::lower_bound(verts.begin(), verts.end(), g) - verts.begin());
+			};
+
+			const size_t vCount = verts.size();
+			std::vector<sibr::Vector3u> tris(cellTris.size());
+			std::vector<std::vector<uint>> vtris(vCount);
+			std::vector<Quadric> quadrics(vCount);
+			for (uint lt = 0; lt < cellTris.size(); ++lt) {
+				const sibr::Vector3u & gt = data.triangles[cellTris[lt]];
+				tris[lt] = sibr::Vector3u(local(gt[0]), local(gt[1]), local(gt[2]));
+				const Eigen::Vector3d & p0 = data.positions[gt[0]];
+				const Eigen::Vector3d n = (data.positions[gt[1]] - p0).cross(data.positions[gt[2]] - p0);
+				const double len = n.norm();
+				const double area = 0.5 * len;
+				Quadric q;
+				if (len > 0) {
+					const Eigen::Vector3d nn = n / len;
+					q = Quadric::fromPlane(nn, -nn.dot(p0), area);
+				}
+				for (int k = 0; k < 3; ++k) {
+					vtris[tris[lt][k]].push_back(lt);
+					quadrics[tris[lt][k]] += q;
+				}
+			}
+
+			// Vertex classification.
+			enum : unsigned char { INTERIOR = 0, BORDER = 1, LOCKED = 2 };
+			std::vector<unsigned char> kind(vCount, INTERIOR);
+			std::vector<uint> counts;
+			std::vector<uint> ring;
+			const auto buildRing = [&](uint v, std::vector<uint> & out, std::vector<uint> * edgeCounts) {
+				out.clear();
+				for (uint t : vtris[v]) {
+					for (int k = 0; k < 3; ++k) {
+						if (tris[t][k] != v) {
+							out.push_back(tris[t][k]);
+						}
+					}
+				}
+				std::sort(out.begin(), out.end());
+				if (edgeCounts) {
+					edgeCounts->clear();
+					for (size_t i = 0; i < out.size();) {
+						size_t j = i;
+						while (j < out.size() && out[j] == out[i]) { ++j; }
+						edgeCounts->push_back(uint(j - i));
+						i = j;
+					}
+				}
+				out.erase(std::unique(out.begin(), out.end()), out.end());
+			};
+			for (uint v = 0; v < vCount; ++v) {
+				if (data.locked[verts[v]]) {
+					kind[v] = LOCKED;
+					continue;
+				}
+				buildRing(v, ring, &counts);
+				for (uint c : counts) {
+					if (c > 2) {
+						kind[v] = LOCKED; // Non-manifold edge.
+						break;
+					}
+					if (c == 1) {
+						kind[v] = data.lockBorders ? LOCKED : BORDER;
+					}
+				}
+			}
+
+			const auto trianglesOnEdge = [&](uint u, uint v, uint * opposite) {
+				uint count = 0;
+				for (uint t : vtris[u]) {
+					const sibr::Vector3u & tri = tris[t];
+					if (tri[0] == v || tri[1] == v || tri[2] == v) {
+						if (opposite && count < 2) {
+							opposite[count] = tri[0] + tri[1] + tri[2] - u - v;
+						}
+						++count;
+					}
+				}
+				return count;
+			};
+
+			const auto attributeCost = [&](uint u, uint v) {
+				double diff = 0.0;
+				if (data.colors) {
+					diff += ((*data.colors)[verts[u]] - (*data.colors)[verts[v]]).squaredNorm();
+				}
+				if (data.uvs) {
+					diff += ((*data.uvs)[verts[u]] - (*data.uvs)[verts[v]]).squaredNorm();
+				}
+				return data.attributeWeight * diff;
+			};
+
+			const auto collapseCost = [&](uint u, uint v) {
+				Quadric q = quadrics[u];
+				q += quadrics[v];
+				const double area = std::max(q.area, 1e-30);
+				return std::max(0.0, q.eval(data.positions[verts[v]])) / area + attributeCost(u, v);
+			};
+
+			std::vector<uint> stamps(vCount, 0);
+			std::vector<unsigned char> vAlive(vCount, 1);
+			std::priority_queue<Collapse> heap;
+			const auto pushCandidate = [&](uint u, uint v) {
+				if (kind[u] == LOCKED) {
+					return;
+				}
+				if (kind[u] == BORDER && (kind[v] == INTERIOR || trianglesOnEdge(u, v, nullptr) != 1)) {
+					return;
+				}
+				heap.push({ collapseCost(u, v), u, v, stamps[u], stamps[v] });
+			};
+			for (uint v = 0; v < vCount; ++v) {
+				buildRing(v, ring, nullptr);
+				for (uint w : ring) {
+					pushCandidate(v, w);
+				}
+			}
+
+			size_t liveTris = cellTris.size();
+			double maxAccepted = 0.0;
+			std::vector<uint> ringU, ringV;
+			while (!heap.empty() && (target == 0 || liveTris > target)) {
+				const Collapse c = heap.top();
+				heap.pop();
+				if (!vAlive[c.u] || !vAlive[c.v] || stamps[c.u] != c.stampU || stamps[c.v] != c.stampV) {
+					continue;
+				}
+				if (c.cost > data.maxErrorSq) {
+					break;
+				}
+				const uint u = c.u, v = c.v;
+
+				// Link condition: the common neighbours must be the opposite vertices of the edge triangles.
+				uint opposite[2];
+				const uint edgeTris = trianglesOnEdge(u, v, opposite);
+				if (edgeTris == 0 || edgeTris > 2) {
+					continue;
+				}
+				buildRing(u, ringU, nullptr);
+				buildRing(v, ringV, nullptr);
+				uint common = 0;
+				bool validLink = true;
+				for (uint a = 0, b = 0; a < ringU.size() && b < ringV.size();) {
+					if (ringU[a] < ringV[b]) { ++a; }
+					else if (ringV[b] < ringU[a]) { ++b; }
+					else {
+						if (ringU[a] != opposite[0] && (edgeTris < 2 || ringU[a] != opposite[1])) {
+							validLink = false;
+							break;
+						}
+						++common; ++a; ++b;
+					}
+				}
+				if (!validLink || common != edgeTris) {
+					continue;
+				}
+				// A locked v can have neighbours through triangles of other cells, missing from its ring. Such a
+				// neighbour also adjacent to u is shared between cells, hence locked: reject the collapse conservatively.
+				if (partial && data.locked[verts[v]]) {
+					for (uint w : ringU) {
+						if (w != v && w != opposite[0] && (edgeTris < 2 || w != opposite[1]) && data.locked[verts[w]]) {
+							validLink = false;
+							break;
+						}
+					}
+					if (!validLink) {
+						continue;
+					}
+				}
+
+				// Reject face flips and slivers around u.
+				const Eigen::Vector3d & pv = data.positions[verts[v]];
+				bool flips = false;
+				for (uint t : vtris[u]) {
+					const sibr::Vector3u & tri = tris[t];
+					if (tri[0] == v || tri[1] == v || tri[2] == v) {
+						continue;
+					}
+					const Eigen::Vector3d p0 = data.positions[verts[tri[0]]];
+					const Eigen::Vector3d p1 = data.positions[verts[tri[1]]];
+					const Eigen::Vector3d p2 = data.positions[verts[tri[2]]];
+					const Eigen::Vector3d nOld = (p1 - p0).cross(p2 - p0);
+					const Eigen::Vector3d q0 = tri[0] == u ? pv : p0;
+					const Eigen::Vector3d q1 = tri[1] == u ? pv : p1;
+					const Eigen::Vector3d q2 = tri[2] == u ? pv : p2;
+					const Eigen::Vector3d nNew = (q1 - q0).cross(q2 - q0);
+					const double lenOld = nOld.norm(), lenNew = nNew.norm();
+					if (lenNew <= 1e-12 * std::max(lenOld, 1e-30) || nOld.dot(nNew) <= 0.2 * lenOld * lenNew) {
+						flips = true;
+						break;
+					}
+				}
+				if (flips) {
+					continue;
+				}
+
+				// Apply the collapse.
+				for (uint t : vtris[u]) {
+					sibr::Vector3u & tri = tris[t];
+					if (tri[0] == v || tri[1] == v || tri[2] == v) {
+						data.alive[cellTris[t]] = 0;
+						--liveTris;
+						for (int k = 0; k < 3; ++k) {
+							if (tri[k] != u) {
+								std::vector<uint> & list = vtris[tri[k]];
+								list.erase(std::find(list.begin(), list.end(), t));
+							}
+						}
+					} else {
+						for (int k = 0; k < 3; ++k) {
+							if (tri[k] == u) {
+								tri[k] = v;
+								data.triangles[cellTris[t]][k] = verts[v];
+							}
+						}
+						vtris[v].push_back(t);
+					}
+				}
+				vtris[u].clear();
+				vAlive[u] = 0;
+				quadrics[v] += quadrics[u];
+				++stamps[v];
+				maxAccepted = std::max(maxAccepted, c.cost);
+
+				buildRing(v, ringV, nullptr);
+				for (uint w : ringV) {
+					pushCandidate(v, w);
+					pushCandidate(w, v);
+				}
+			}
+			return maxAccepted;
+		}
+
+	}
+
+	sibr::Mesh::Ptr MeshDecimator::decimate(const sibr::Mesh & mesh, const Options & options)
+	{
+		const sibr::Mesh::Vertices & vertices = mesh.vertices();
+		const size_t vCount = vertices.size();
+
+		DecimationData data;
+		const Eigen::AlignedBox<float, 3> bbox = mesh.getBoundingBox();
+		const double diag = bbox.isEmpty() ? 1.0 : std::max(1e-30, double(bbox.diagonal().norm()));
+		const Eigen::Vector3d origin = bbox.isEmpty() ? Eigen::Vector3d::Zero() : Eigen::Vector3d(bbox.min().cast<double>());
+		const Eigen::Vector3d extent = bbox.isEmpty() ? Eigen::Vector3d::Ones() : Eigen::Vector3d((bbox.sizes().cast<double>() / diag).cwiseMax(1e-12));
+		data.positions.resize(vCount);
+		#pragma omp parallel for
+		for (int vid = 0; vid < (int)vCount; ++vid) {
+			data.positions[vid] = (vertices[vid].cast<double>() - origin) / diag;
+		}
+		data.colors = mesh.hasColors() ? &mesh.colors() : nullptr;
+		data.uvs = mesh.hasTexCoords() ? &mesh.texCoords() : nullptr;
+		data.attributeWeight = options.attributeWeight;
+		data.maxErrorSq = options.maxError >= std::numeric_limits<float>::max() ? std::numeric_limits<double>::max() : double(options.maxError) * double(options.maxError);
+		data.lockBorders = options.lockBorders;
+		data.triangles = mesh.triangles();
+		data.alive.assign(data.triangles.size(), 1);
+
+		// Weld the vertices sharing a position and attributes (unwelded or flat shaded meshes), their normals are averaged.
+		// Coincident vertices that differ in color or UV are attribute seams: they are kept apart and locked.
+		std::vector<uint> welded(vCount);
+		std::vector<unsigned char> seams(vCount, 0);
+		{
+			std::vector<uint> order(vCount);
+			for (uint vid = 0; vid < vCount; ++vid) {
+				order[vid] = vid;
+				welded[vid] = vid;
+			}
+			const auto lexLess = [&vertices](uint a, uint b) {
+				const sibr::Vector3f & pa = vertices[a];
+				const sibr::Vector3f & pb = vertices[b];
+				return pa[0] != pb[0] ? pa[0] < pb[0] : (pa[1] != pb[1] ? pa[1] < pb[1] : pa[2] < pb[2]);
+			};
+			std::sort(order.begin(), order.end(), lexLess);
+			const auto sameAttributes = [&data](uint a, uint b) {
+				return (!data.colors || (*data.colors)[a] == (*data.colors)[b]) && (!data.uvs || (*data.uvs)[a] == (*data.uvs)[b]);
+			};
+			std::vector<uint> reps;
+			for (size_t i = 0; i < order.size();) {
+				size_t j = i + 1;
+				while (j < order.size() && vertices[order[j]] == vertices[order[i]]) {
+					++j;
+				}
+				reps.clear();
+				for (size_t k = i; k < j; ++k) {
+					const uint vid = order[k];
+					const auto rep = std::find_if(reps.begin(), reps.end(), [&](uint r) { return sameAttributes(r, vid); });
+					if (rep == reps.end()) {
+						reps.push_back(vid);
+					} else {
+						welded[vid] = *rep;
+					}
+				}
+				if (reps.size() > 1) {
+					for (uint r : reps) {
+						seams[r] = 1;
+					}
+				}
+				i = j;
+			}
+		}
+		for (sibr::Vector3u & t : data.triangles) {
+			t = sibr::Vector3u(welded[t[0]], welded[t[1]], welded[t[2]]);
+		}
+		sibr::Mesh::Normals weldedNormals;
+		if (mesh.hasNormals()) {
+			weldedNormals.assign(vCount, sibr::Vector3f(0.0f, 0.0f, 0.0f));
+			for (uint vid = 0; vid < vCount; ++vid) {
+				weldedNormals[welded[vid]] += mesh.normals()[vid];
+			}
+			#pragma omp parallel for
+			for (int vid = 0; vid < (int)vCount; ++vid) {
+				const float len = weldedNormals[vid].norm();
+				weldedNormals[vid] = len > 0.0f ? sibr::Vector3f(weldedNormals[vid] / len) : mesh.normals()[vid];
+			}
+		}
+
+		size_t liveTris = 0;
+		for (size_t tid = 0; tid < data.triangles.size(); ++tid) {
+			const sibr::Vector3u & t = data.triangles[tid];
+			if (t[0] == t[1] || t[1] == t[2] || t[0] == t[2]) {
+				data.alive[tid] = 0;
+			} else {
+				++liveTris;
+			}
+		}
+
+		_error = 0.0f;
+		const size_t target = options.targetTriangles;
+		const bool limited = target > 0 || data.maxErrorSq < std::numeric_limits<double>::max();
+		double maxAccepted = 0.0;
+		for (uint pass = 0; limited && pass <= options.partitionPasses; ++pass) {
+			if (target > 0 && liveTris <= target) {
+				break;
+			}
+
+			// The last pass uses a single cell covering the whole mesh.
+			const bool lastPass = pass == options.partitionPasses;
+			const int res = lastPass ? 1 : std::max(1, int(std::ceil(std::cbrt(double(liveTris) / double(std::max<size_t>(1, options.trianglesPerCell))))));
+			const double offset = (pass % 2 == 1) ? 0.5 / res : 0.0;
+
+			// Assign live triangles to cells by centroid.
+			std::vector<int> triCell(data.triangles.size(), -1);
+			#pragma omp parallel for
+			for (int tid = 0; tid < (int)data.triangles.size(); ++tid) {
+				if (!data.alive[tid]) {
+					continue;
+				}
+				const sibr::Vector3u & t = data.triangles[tid];
+				const Eigen::Vector3d c = (data.positions[t[0]] + data.positions[t[1]] + data.positions[t[2]]) / 3.0;
+				int cell = 0;
+				for (int k = 2; k >= 0; --k) {
+					const int ck = std::min(res - 1, std::max(0, int(std::floor((c[k] / extent[k] + offset) * res))));
+					cell = cell * res + ck;
+				}
+				triCell[tid] = cell;
+			}
+
+			// Lock vertices shared by several cells.
+			std::vector<int> owner(vCount, -1);
+			data.locked = seams;
+			for (size_t tid = 0; tid < data.triangles.size(); ++tid) {
+				if (triCell[tid] < 0) {
+					continue;
+				}
+				for (int k = 0; k < 3; ++k) {
+					const uint vid = data.triangles[tid][k];
+					if (owner[vid] == -1) {
+						owner[vid] = triCell[tid];
+					} else if (owner[vid] != triCell[tid]) {
+						data.locked[vid] = 1;
+					}
+				}
+			}
+
+			std::vector<std::vector<uint>> cells(size_t(res) * res * res);
+			for (size_t tid = 0; tid < data.triangles.size(); ++tid) {
+				if (triCell[tid] >= 0) {
+					cells[triCell[tid]].push_back(uint(tid));
+				}
+			}
+
+			const size_t passTris = liveTris;
+			std::vector<double> cellErrors(cells.size(), 0.0);
+			#pragma omp parallel for schedule(dynamic, 1)
+			for (int cid = 0; cid < (int)cells.size(); ++cid) {
+				if (cells[cid].empty()) {
+					continue;
+				}
+				const size_t cellTarget = target == 0 ? 0 : std::max<size_t>(1, size_t(std::ceil(double(cells[cid].size()) * double(target) / double(passTris))));
+				cellErrors[cid] = decimateCell(data, cells[cid], cellTarget, res > 1);
+			}
+			for (double e : cellErrors) {
+				maxAccepted = std::max(maxAccepted, e);
+			}
+
+			liveTris = 0;
+			for (unsigned char a : data.alive) {
+				liveTris += a;
+			}
+			if (options.verbose) {
+				SIBR_LOG << "[MeshDecimator] Pass " << pass << " (" << cells.size() << " cells): " << liveTris << " triangles." << std::endl;
+			}
+
+			if (res == 1) {
+				break;
+			}
+		}
+		_error = float(std::sqrt(maxAccepted));
+
+		// Compact the result, keeping only referenced vertices.
+		std::vector<uint> newIds(vCount, uint(-1));
+		_mapping.clear();
+		sibr::Mesh::Triangles outTriangles;
+		outTriangles.reserve(liveTris);
+		for (size_t tid = 0; tid < data.triangles.size(); ++tid) {
+			if (!data.alive[tid]) {
+				continue;
+			}
+			sibr::Vector3u t = data.triangles[tid];
+			for (int k = 0; k < 3; ++k) {
+				if (newIds[t[k]] == uint(-1)) {
+					newIds[t[k]] = uint(_mapping.size());
+					_mapping.push_back(t[k]);
+				}
+				t[k] = newIds[t[k]];
+			}
+			outTriangles.push_back(t);
+		}
+
+		sibr::Mesh::Vertices outVertices(_mapping.size());
+		sibr::Mesh::Normals outNormals(mesh.hasNormals() ? _mapping.size() : 0);
+		sibr::Mesh::Colors outColors(mesh.hasColors() ? _mapping.size() : 0);
+		sibr::Mesh::UVs outUVs(mesh.hasTexCoords() ? _mapping.size() : 0);
+		#pragma omp parallel for
+		for (int vid = 0; vid < (int)_mapping.size(); ++vid) {
+			const uint src = _mapping[vid];
+			outVertices[vid] = vertices[src];
+			if (!outNormals.empty()) {
+				outNormals[vid] = weldedNormals[src];
+			}
+			if (!outColors.empty()) {
+				outColors[vid] = mesh.colors()[src];
+			}
+			if (!outUVs.empty()) {
+				outUVs[vid] = mesh.texCoords()[src];
+			}
+		}
+
+		sibr::Mesh::Ptr outMesh(new sibr::Mesh(false));
+		outMesh->vertices(outVertices);
+		outMesh->triangles(outTriangles);
+		if (!outNormals.empty()) {
+			outMesh->normals(outNormals);
+		}
+		if (!outColors.empty()) {
+			outMesh->colors(outColors);
+		}
+		if (!outUVs.empty()) {
+			outMesh->texCoords(outUVs);
+		}
+		return outMesh;
+	}
+
+} // namespace sibr
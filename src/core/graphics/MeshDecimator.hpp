@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include <limits>
+# include "core/graphics/Config.hpp"
+# include "core/graphics/Mesh.hpp"
+
+namespace sibr
+{
+	/** Simplify a triangle mesh using quadric error metrics (Garland and Heckbert 97).
+	 Edges are collapsed onto one of their endpoints (half-edge collapses), so the surviving
+	 vertices keep their exact position, color and UV attributes. Vertices sharing a position
+	 and attributes are welded first, averaging their normals; coincident vertices that differ in
+	 color or UV (attribute seams) are locked. Open borders can only collapse along themselves,
+	 and collapses that would flip a face or make the mesh non-manifold are rejected.
+	 The mesh is split in a grid of cells that are simplified in parallel; vertices shared between
+	 cells are locked, and successive passes use shifted grids so that cell boundaries get simplified too.
+	\ingroup sibr_graphics
+	*/
+	class SIBR_GRAPHICS_EXPORT MeshDecimator
+	{
+	public:
+
+		/** Simplification options. */
+		struct Options {
+			size_t targetTriangles = 0; ///< Stop when the triangle count reaches this value (0 to only use the error bound).
+			float maxError = std::numeric_limits<float>::max(); ///< Maximum collapse error, as a distance relative to the bounding box diagonal.
+			float attributeWeight = 1e-3f; ///< Weight of color/UV differences, relative to the squared geometric error.
+			bool lockBorders = false; ///< Prevent any collapse of open border vertices.
+			size_t trianglesPerCell = 100000; ///< Approximate number of triangles per parallel cell.
+			uint partitionPasses = 3; ///< Number of parallel passes before the final, global pass.
+			bool verbose = true; ///< Log the triangle count after each pass.
+		};
+
+		/** Simplify a mesh.
+		\param mesh the mesh to simplify, only used during the call
+		\param options simplification options
+		\return the simplified mesh (without graphics)
+		*/
+		sibr::Mesh::Ptr decimate(const sibr::Mesh & mesh, const Options & options);
+
+		/** For each vertex of the simplified mesh, the mapping gives the index of the corresponding vertex in the input mesh.
+		\return a reference to the mapping vector
+		*/
+		const std::vector<uint> & mapping() const { return _mapping; }
+
+		/** \return the largest collapse error accepted during the last simplification, relative to the bounding box diagonal. */
+		float error() const { return _error; }
+
+	private:
+
+		std::vector<uint> _mapping; ///< Mapping from the simplified vertices to the input ones.
+		float _error = 0.0f; ///< Maximum error reached.
+	};
+
+} // namespace sibr
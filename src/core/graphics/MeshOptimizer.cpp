@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <algorithm>
+#include "core/graphics/MeshOptimizer.hpp"
+
+namespace sibr
+{
+	namespace {
+
+		/** Spread the 21 lower bits of an integer, leaving two zero bits between each of them. */
+		inline uint64_t spreadBits(uint64_t x)
+		{
+			x &= 0x1fffff;
+			x = (x | x << 32) & 0x1f00000000ffffull;
+			x = (x | x << 16) & 0x1f0000ff0000ffull;
+			x = (x | x << 8) & 0x100f00f00f00f00full;
+			x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+			x = (x | x << 2) & 0x1249249249249249ull;
+			return x;
+		}
+
+		/** Apply a permutation to a vertex attribute.
+		\param values the attribute values
+		\param newIndices for each original vertex, its new index
+		*/
+		template<typename T>
+		std::vector<T> permute(const std::vector<T> & values, const std::vector<uint> & newIndices)
+		{
+			std::vector<T> result(values.size());
+			for (size_t vid = 0; vid < values.size(); ++vid) {
+				result[newIndices[vid]] = values[vid];
+			}
+			return result;
+		}
+	}
+
+	MeshOptimizer::Report MeshOptimizer::optimize(sibr::Mesh & mesh, Order order, uint cacheSize, Remapping * remapping)
+	{
+		const sibr::Mesh::Triangles & triangles = mesh.triangles();
+		const size_t verticesCount = mesh.vertices().size();
+
+		Report report;
+		report.acmrBefore = averageCacheMissRatio(triangles, verticesCount, cacheSize);
+
+		const std::vector<uint> trianglesOrder = order == Order::CACHE
+			? cacheTriangleOrder(triangles, verticesCount, cacheSize)
+			: spatialTriangleOrder(triangles, mesh.vertices());
+
+		// Number vertices by first use in the new triangle order, unreferenced ones are kept at the end.
+		const uint unassigned = std::numeric_limits<uint>::max();
+		std::vector<uint> newIndices(verticesCount, unassigned);
+		uint nextIndex = 0;
+		sibr::Mesh::Triangles newTriangles(triangles.size());
+		for (size_t tid = 0; tid < trianglesOrder.size(); ++tid) {
+			const sibr::Vector3u & t = triangles[trianglesOrder[tid]];
+			for (int k = 0; k < 3; ++k) {
+				if (newIndices[t[k]] == unassigned) {
+					newIndices[t[k]] = nextIndex++;
+				}
+				newTriangles[tid][k] = newIndices[t[k]];
+			}
+		}
+		for (uint & index : newIndices) {
+			if (index == unassigned) {
+				index = nextIndex++;
+			}
+		}
+
+		const bool hasNormals = mesh.hasNormals();
+		const bool hasColors = mesh.hasColors();
+		const bool hasTexCoords = mesh.hasTexCoords();
+		mesh.vertices(permute(mesh.vertices(), newIndices));
+		if (hasNormals) {
+			mesh.normals(permute(mesh.normals(), newIndices));
+		}
+		if (hasColors) {
+			mesh.colors(permute(mesh.colors(), newIndices));
+		}
+		if (hasTexCoords) {
+			mesh.texCoords(permute(mesh.texCoords(), newIndices));
+		}
+		mesh.triangles(newTriangles);
+
+		report.acmrAfter = averageCacheMissRatio(mesh.triangles(), verticesCount, cacheSize);
+		SIBR_LOG << "[MeshOptimizer] ACMR (cache size " << cacheSize << "): " << report.acmrBefore << " -> " << report.acmrAfter << "." << std::endl;
+
+		if (remapping) {
+			remapping->triangles = trianglesOrder;
+			remapping->vertices.swap(newIndices);
+		}
+		return report;
+	}
+
+	float MeshOptimizer::averageCacheMissRatio(const sibr::Mesh::Triangles & triangles, size_t verticesCount, uint cacheSize)
+	{
+		if (triangles.empty()) {
+			return 0.0f;
+		}
+		// A vertex is in the FIFO cache if less than cacheSize misses happened since it was inserted.
+		std::vector<size_t> insertion(verticesCount, 0);
+		std::vector<unsigned char> seen(verticesCount, 0);
+		size_t misses = 0;
+		for (const sibr::Vector3u & t : triangles) {
+			for (int k = 0; k < 3; ++k) {
+				const uint v = t[k];
+				if (!seen[v] || misses - insertion[v] >= cacheSize) {
+					seen[v] = 1;
+					insertion[v] = misses;
+					++misses;
+				}
+			}
+		}
+		return float(double(misses) / double(triangles.size()));
+	}
+
+	std::vector<uint> MeshOptimizer::cacheTriangleOrder(const sibr::Mesh::Triangles & triangles, size_t verticesCount, uint cacheSize)
+	{
+		const uint trianglesCount = (uint)triangles.size();
+		const int k = int(std::max(3u, cacheSize));
+
+		// Vertex to triangles adjacency, in compressed rows.
+		std::vector<uint> offsets(verticesCount + 1, 0);
+		for (const sibr::Vector3u & t : triangles) {
+			++offsets[t[0] + 1];
+			++offsets[t[1] + 1];
+			++offsets[t[2] + 1];
+		}
+		for (size_t vid = 0; vid < verticesCount; ++vid) {
+			offsets[vid + 1] += offsets[vid];
+		}
+		std::vector<uint> adjacency(offsets.back());
+		std::vector<uint> fill(offsets.begin(), offsets.end() - 1);
+		for (uint tid = 0; tid < trianglesCount; ++tid) {
+			for (int c = 0; c < 3; ++c) {
+				adjacency[fill[triangles[tid][c]]++] = tid;
+			}
+		}
+
+		std::vector<int> liveCount(verticesCount);
+		for (size_t vid = 0; vid < verticesCount; ++vid) {
+			liveCount[vid] = int(offsets[vid + 1] - offsets[vid]);
+		}
+		std::vector<int> cacheTime(verticesCount, 0);
+		std::vector<unsigned char> emitted(trianglesCount, 0);
+		std::vector<uint> deadEnd;
+		std::vector<uint> candidates;
+		std::vector<uint> order;
+		order.reserve(trianglesCount);
+
+		int time = k + 1;
+		size_t cursor = 0;
+		int fanning = -1;
+		while (cursor < verticesCount && liveCount[cursor] == 0) {
+			++cursor;
+		}
+		if (cursor < verticesCount) {
+			fanning = int(cursor);
+		}
+
+		while (fanning >= 0) {
+			candidates.clear();
+			// Emit all remaining triangles around the fanning vertex.
+			for (uint a = offsets[fanning]; a < offsets[fanning + 1]; ++a) {
+				const uint tid = adjacency[a];
+				if (emitted[tid]) {
+					continue;
+				}
+				emitted[tid] = 1;
+				order.push_back(tid);
+				for (int c = 0; c < 3; ++c) {
+					const uint v = triangles[tid][c];
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					--liveCount[v];
+					if (time - cacheTime[v] > k) {
+						cacheTime[v] = time;
+						++time;
+					}
+				}
+			}
+
+			// Next fanning vertex: the candidate that will stay the longest in the cache, if its remaining triangles fit.
+			fanning = -1;
+			int bestPriority = -1;
+			for (uint v : candidates) {
+				if (liveCount[v] <= 0) {
+					continue;
+				}
+				int priority = 0;
+				if (time - cacheTime[v] + 2 * liveCount[v] <= k) {
+					priority = time - cacheTime[v];
+				}
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					fanning = int(v);
+				}
+			}
+
+			// Dead end: backtrack to a recently used vertex, or the next vertex in input order.
+			while (fanning < 0 && !deadEnd.empty()) {
+				const uint v = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveCount[v] > 0) {
+					fanning = int(v);
+				}
+			}
+			while (fanning < 0 && cursor < verticesCount) {
+				if (liveCount[cursor] > 0) {
+					fanning = int(cursor);
+				}
+				++cursor;
+			}
+		}
+		return order;
+	}
+
+	std::vector<uint> MeshOptimizer::spatialTriangleOrder(const sibr::Mesh::Triangles & triangles, const sibr::Mesh::Vertices & vertices)
+	{
+		const int trianglesCount = (int)triangles.size();
+		Eigen::AlignedBox<float, 3> box;
+		for (const sibr::Vector3f & v : vertices) {
+			box.extend(v);
+		}
+		const sibr::Vector3f origin = box.isEmpty() ? sibr::Vector3f(0.0f, 0.0f, 0.0f) : sibr::Vector3f(box.min());
+		const float extent = box.isEmpty() ? 1.0f : std::max(box.sizes().maxCoeff(), 1e-20f);
+		const float scale = float((1 << 21) - 1) / extent;
+
+		std::vector<std::pair<uint64_t, uint>> codes(trianglesCount);
+		#pragma omp parallel for
+		for (int tid = 0; tid < trianglesCount; ++tid) {
+			const sibr::Vector3u & t = triangles[tid];
+			const sibr::Vector3f centroid = (vertices[t[0]] + vertices[t[1]] + vertices[t[2]]) / 3.0f;
+			const sibr::Vector3f q = ((centroid - origin) * scale).cwiseMax(0.0f);
+			codes[tid].first = spreadBits(uint64_t(q[0])) | (spreadBits(uint64_t(q[1])) << 1) | (spreadBits(uint64_t(q[2])) << 2);
+			codes[tid].second = uint(tid);
+		}
+		std::sort(codes.begin(), codes.end());
+
+		std::vector<uint> order(trianglesCount);
+		for (int tid = 0; tid < trianglesCount; ++tid) {
+			order[tid] = codes[tid].second;
+		}
+		return order;
+	}
+
+} // namespace sibr
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include "core/graphics/Config.hpp"
+# include "core/graphics/Mesh.hpp"
+
+namespace sibr
+{
+	/** Reorder the triangles and vertices of a mesh to improve memory locality, without changing its geometry.
+	 Two orders are available:
+	 - CACHE: triangles are reordered for post-transform vertex cache reuse (Tipsify, Sander et al. 2007),
+	 which benefits GPU rasterization passes;
+	 - SPATIAL: triangles are sorted along a Morton curve of their centroids, which benefits spatial
+	 structure builds and traversal (Embree raycasting).
+	 In both cases vertices are then renumbered by first use, and all vertex attributes are remapped.
+	 The efficiency is measured as the ACMR (average number of vertex cache misses per triangle,
+	 simulated with a FIFO cache; between 0.5 and 3, lower is better).
+	\ingroup sibr_graphics
+	*/
+	class SIBR_GRAPHICS_EXPORT MeshOptimizer
+	{
+	public:
+
+		/** Target ordering. */
+		enum class Order { CACHE, SPATIAL };
+
+		/** Permutations applied by an optimization. */
+		struct Remapping {
+			std::vector<uint> triangles; ///< For each new triangle, the index of the original triangle.
+			std::vector<uint> vertices; ///< For each original vertex, its new index.
+		};
+
+		/** Efficiency measured before and after an optimization. */
+		struct Report {
+			float acmrBefore; ///< ACMR of the original mesh.
+			float acmrAfter; ///< ACMR of the optimized mesh.
+		};
+
+		/** Reorder the triangles and vertices of a mesh in place.
+		\param mesh the mesh to optimize
+		\param order the target ordering
+		\param cacheSize the simulated vertex cache size
+		\param remapping if not null, will contain the applied permutations (for instance to remap per-triangle data of derived meshes)
+		\return the ACMR before and after optimization
+		*/
+		static Report optimize(sibr::Mesh & mesh, Order order = Order::CACHE, uint cacheSize = 16, Remapping * remapping = nullptr);
+
+		/** Simulate a FIFO vertex cache to compute the average cache miss ratio of a list of triangles.
+		\param triangles the triangles
+		\param verticesCount the number of vertices
+		\param cacheSize the cache size
+		\return the number of cache misses per triangle
+		*/
+		static float averageCacheMissRatio(const sibr::Mesh::Triangles & triangles, size_t verticesCount, uint cacheSize = 16);
+
+		/** Compute a triangle order with good vertex cache reuse (Tipsify).
+		\param triangles the triangles
+		\param verticesCount the number of vertices
+		\param cacheSize the target cache size
+		\return for each new triangle, the index of the original one
+		*/
+		static std::vector<uint> cacheTriangleOrder(const sibr::Mesh::Triangles & triangles, size_t verticesCount, uint cacheSize = 16);
+
+		/** Compute a spatially coherent triangle order, following a Morton curve of the triangle centroids.
+		\param triangles the triangles
+		\param vertices the vertex positions
+		\return for each new triangle, the index of the original one
+		*/
+		static std::vector<uint> spatialTriangleOrder(const sibr::Mesh::Triangles & triangles, const sibr::Mesh::Vertices & vertices);
+
+	};
+
+} // namespace sibr
@@ -33,5 +33,103 @@ namespace sibr
 			mask, filter);
 	}
 
+	PixelPackReadback::PixelPackReadback(size_t ringSize) :
+		_slots(std::max(ringSize, size_t(1)))
+	{
+	}
+
+	PixelPackReadback::~PixelPackReadback(void)
+	{
+		for (Slot & slot : _slots) {
+			if (slot.fence) {
+				glDeleteSync(slot.fence);
+			}
+			if (slot.pbo) {
+				glDeleteBuffers(1, &slot.pbo);
+			}
+		}
+	}
+
+	void PixelPackReadback::source(const IRenderTarget & rt, uint target)
+	{
+		_source = &rt;
+		_target = target;
+	}
+
+	void PixelPackReadback::request(void)
+	{
+		if (!_source) {
+			SIBR_ERR << "PixelPackReadback::request: no source rendertarget." << std::endl;
+		}
+		if (full()) {
+			SIBR_ERR << "PixelPackReadback::request: all buffers are pending." << std::endl;
+		}
+
+		Slot & slot = _slots[(_first + _count) % _slots.size()];
+		slot.w = _source->w();
+		slot.h = _source->h();
+		const size_t bytes = size_t(slot.w) * size_t(slot.h) * 3;
+		if (!slot.pbo) {
+			glGenBuffers(1, &slot.pbo);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		if (slot.bytes != bytes) {
+			glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+			slot.bytes = bytes;
+		}
+
+		// Tightly packed rows, so that the buffer can be wrapped as is.
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, _source->fbo());
+		glReadBuffer(GL_COLOR_ATTACHMENT0 + _target);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, slot.w, slot.h, GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		++_count;
+	}
+
+	bool PixelPackReadback::retrieve(cv::Mat & frame, bool wait)
+	{
+		if (_count == 0) {
+			return false;
+		}
+		Slot & slot = _slots[_first];
+
+		// The flush bit makes sure the fence is submitted, so that waiting on it terminates.
+		const GLuint64 timeout = wait ? GLuint64(1000000000) : GLuint64(0);
+		GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+		while (wait && status == GL_TIMEOUT_EXPIRED) {
+			status = glClientWaitSync(slot.fence, 0, timeout);
+		}
+		if (status == GL_TIMEOUT_EXPIRED) {
+			return false;
+		}
+		if (status == GL_WAIT_FAILED) {
+			SIBR_WRG << "PixelPackReadback::retrieve: waiting for the readback failed." << std::endl;
+		}
+		glDeleteSync(slot.fence);
+		slot.fence = 0;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		const void * data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.bytes, GL_MAP_READ_BIT);
+		if (data) {
+			// OpenGL rows start at the bottom.
+			const cv::Mat mapped(int(slot.h), int(slot.w), CV_8UC3, const_cast<void*>(data));
+			cv::flip(mapped, frame, 0);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		} else {
+			SIBR_WRG << "PixelPackReadback::retrieve: unable to map the buffer." << std::endl;
+			frame = cv::Mat::zeros(int(slot.h), int(slot.w), CV_8UC3);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		_first = (_first + 1) % _slots.size();
+		--_count;
+		return true;
+	}
+
 	
 } // namespace sibr
@@ -222,6 +222,100 @@ namespace sibr
 	*/
 	SIBR_GRAPHICS_EXPORT void			blit_and_flip(const IRenderTarget& src, const IRenderTarget& dst, GLbitfield mask = GL_COLOR_BUFFER_BIT, GLenum filter = GL_LINEAR);
 
+	/** Asynchronous readback interface: frames are requested at some point and retrieved later,
+	* once their transfer is done, in the order of the requests.
+	* \sa PixelPackReadback
+	* \ingroup sibr_graphics
+	*/
+	class SIBR_GRAPHICS_EXPORT IAsyncReadback
+	{
+	public:
+		typedef std::shared_ptr<IAsyncReadback>	Ptr;
+
+		/** Destructor. */
+		virtual ~IAsyncReadback(void) { }
+
+		/** Start reading the current content of the source. Should not be called when full(). */
+		virtual void request(void) = 0;
+
+		/** Retrieve the oldest request.
+		\param frame will contain the frame, as a BGR 8 bits image with the first row at the top
+		\param wait block until the oldest request is available
+		\return false if there is no request, or if the oldest one is not available yet and wait is false
+		*/
+		virtual bool retrieve(cv::Mat & frame, bool wait) = 0;
+
+		/** \return the number of requests not retrieved yet. */
+		virtual size_t pending(void) const = 0;
+
+		/** \return the maximum number of requests not retrieved yet. */
+		virtual size_t capacity(void) const = 0;
+
+		/** \return true if the oldest request has to be retrieved before making a new one. */
+		bool full(void) const { return pending() >= capacity(); }
+	};
+
+	/** Asynchronous readback of a rendertarget color attachment through a ring of pixel pack buffers.
+	* Each request starts a glReadPixels into the next buffer, which returns immediately, and inserts a fence
+	* telling when the copy is done. With N buffers, a frame can be retrieved up to N-1 frames later without
+	* stalling the pipeline as RenderTarget::readBack does.
+	* \note All calls have to be made on the thread owning the OpenGL context.
+	* \ingroup sibr_graphics
+	*/
+	class SIBR_GRAPHICS_EXPORT PixelPackReadback : public IAsyncReadback
+	{
+		SIBR_DISALLOW_COPY(PixelPackReadback);
+	public:
+		typedef std::shared_ptr<PixelPackReadback>	Ptr;
+
+		/** Constructor.
+		\param ringSize the number of pixel pack buffers
+		*/
+		PixelPackReadback(size_t ringSize = 3);
+
+		/** Destructor. */
+		~PixelPackReadback(void);
+
+		/** Set the rendertarget read by the next requests. Its size can change between requests.
+		\param rt the rendertarget, it has to be alive when a request is made
+		\param target the color attachment to read
+		*/
+		void source(const IRenderTarget & rt, uint target = 0);
+
+		/** Start reading the current content of the source rendertarget. */
+		void request(void) override;
+
+		/** Retrieve the oldest request, mapping its buffer.
+		\param frame will contain the frame, as a BGR 8 bits image with the first row at the top
+		\param wait block until the copy is done
+		\return false if there is no request, or if the copy is not done yet and wait is false
+		*/
+		bool retrieve(cv::Mat & frame, bool wait) override;
+
+		/** \return the number of requests not retrieved yet. */
+		size_t pending(void) const override { return _count; }
+
+		/** \return the number of pixel pack buffers. */
+		size_t capacity(void) const override { return _slots.size(); }
+
+	private:
+
+		/** A ring buffer element. */
+		struct Slot {
+			GLuint pbo = 0; ///< Pixel pack buffer handle.
+			size_t bytes = 0; ///< Buffer allocated size.
+			GLsync fence = 0; ///< Signaled when the copy is done.
+			uint w = 0; ///< Frame width.
+			uint h = 0; ///< Frame height.
+		};
+
+		const IRenderTarget * _source = nullptr; ///< Rendertarget to read.
+		uint _target = 0; ///< Color attachment to read.
+		std::vector<Slot> _slots; ///< Ring of buffers.
+		size_t _first = 0; ///< Oldest request slot.
+		size_t _count = 0; ///< Number of requests not retrieved yet.
+	};
+
 	/** Display a rendertarget color content in a popup window (backed by OpenCV).
 	\param rt the rendertarget to display
 	\param layer the color attachment to display
@@ -22,6 +22,16 @@
 
 namespace sibr
 {
+	namespace {
+
+		/** \return the program binary cache shared by all shaders. */
+		ShaderProgramCache::Ptr & sharedProgramCache()
+		{
+			static ShaderProgramCache::Ptr cache;
+			return cache;
+		}
+	}
+
 	GLuint GLShader::compileShader(const char* shader_code, GLuint type)
 	{
 		std::string shader_type;
@@ -111,7 +121,34 @@ namespace sibr
 		terminate();
 
 		m_Name = name;
+
+		const ShaderProgramCache::Ptr & cache = programCache();
+		uint64_t cacheKey = 0;
+		if (cache) {
+			cacheKey = ShaderProgramCache::key({ vp_code, fp_code, gp_code, tcs_code, tes_code });
+			ShaderProgramCache::Binary binary;
+			if (cache->find(cacheKey, binary)) {
+				m_Shader = glCreateProgram();
+				glProgramBinary(m_Shader, GLenum(binary.format), binary.data.data(), GLsizei(binary.data.size()));
+				GLint binary_linked = 0;
+				glGetProgramiv(m_Shader, GL_LINK_STATUS, &binary_linked);
+				if (binary_linked) {
+					// Same final state as after compiling the sources below.
+					glUseProgram(0);
+					CHECK_GL_ERROR;
+					return true;
+				}
+				// The driver rejected the binary (after an update for instance), compile the sources instead.
+				(void)glGetError();
+				glDeleteProgram(m_Shader);
+				cache->remove(cacheKey);
+			}
+		}
+
 		m_Shader = glCreateProgram();
+		if (cache) {
+			glProgramParameteri(m_Shader, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
 
 		CHECK_GL_ERROR;
 
@@ -170,6 +207,17 @@ namespace sibr
 
 			if (exitOnError)
 				SIBR_ERR << "GLSL program failed to link" << std::endl;
+		} else if (cache) {
+			GLint length = 0;
+			glGetProgramiv(m_Shader, GL_PROGRAM_BINARY_LENGTH, &length);
+			if (length > 0) {
+				ShaderProgramCache::Binary binary;
+				binary.data.resize(length);
+				GLenum format = 0;
+				glGetProgramBinary(m_Shader, length, NULL, &format, binary.data.data());
+				binary.format = uint32_t(format);
+				cache->store(cacheKey, binary);
+			}
 		}
 
 		if (vp) glDeleteShader(vp);
@@ -221,6 +269,16 @@ namespace sibr
 	
 	}
 
+	void GLShader::programCache(const ShaderProgramCache::Ptr & cache)
+	{
+		sharedProgramCache() = cache;
+	}
+
+	const ShaderProgramCache::Ptr & GLShader::programCache(void)
+	{
+		return sharedProgramCache();
+	}
+
 	void GLShader::terminate( void )
 	{
 		if (m_Shader) {
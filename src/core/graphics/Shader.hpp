@@ -15,6 +15,7 @@
 # include <vector>
 # include <string>
 # include "core/graphics/Config.hpp"
+# include "core/graphics/ShaderProgramCache.hpp"
 # include "core/system/Matrix.hpp"
 
 #define SIBR_SHADER(version, shader)  std::string("#version " #version "\n" #shader)
@@ -129,6 +130,15 @@ namespace sibr
 		/** \return true if the shader will validate linked uniforms. */
 		bool			isStrict  ( void )  const;
 
+		/** Set the program binary cache used by all shaders: init will load programs already linked with the same
+		sources from their binary instead of compiling them.
+		\param cache the cache, nullptr to always compile
+		*/
+		static void		programCache( const ShaderProgramCache::Ptr & cache );
+
+		/** \return the program binary cache used by all shaders, can be null. */
+		static const ShaderProgramCache::Ptr &	programCache( void );
+
 	private:
 
 		/** Compile a shader for a given stage.
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include "core/graphics/ShaderProgramCache.hpp"
+#include "core/system/Utils.hpp"
+
+namespace sibr
+{
+	namespace {
+
+		const char		programCacheMagic[4] = { 'S', 'P', 'G', 'B' }; ///< Cache file signature.
+		const uint32_t	programCacheVersion = 1; ///< Cache file version.
+
+	}
+
+	ShaderProgramCache::ShaderProgramCache(const std::string & directory) :
+		_directory(directory)
+	{
+		if (!_directory.empty() && !sibr::directoryExists(_directory)) {
+			sibr::makeDirectory(_directory);
+		}
+	}
+
+	void ShaderProgramCache::driver(const std::string & id)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (id != _driver) {
+			// Binaries are only valid for the driver that produced them.
+			_binaries.clear();
+			_driver = id;
+		}
+	}
+
+	uint64_t ShaderProgramCache::key(const std::vector<std::string> & stages)
+	{
+		// The stage index and length are hashed too, so that moving code between stages changes the key.
+		uint64_t hash = fnv1aSeed;
+		for (size_t s = 0; s < stages.size(); ++s) {
+			const uint64_t header[2] = { uint64_t(s), uint64_t(stages[s].size()) };
+			hash = hashBytes(hash, header, sizeof(header));
+			hash = hashBytes(hash, stages[s].data(), stages[s].size());
+		}
+		return hash;
+	}
+
+	bool ShaderProgramCache::find(uint64_t key, Binary & binary)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		const auto it = _binaries.find(key);
+		if (it != _binaries.end()) {
+			binary = it->second;
+			return true;
+		}
+		if (!load(key, binary)) {
+			return false;
+		}
+		_binaries[key] = binary;
+		return true;
+	}
+
+	void ShaderProgramCache::store(uint64_t key, const Binary & binary)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_binaries[key] = binary;
+		save(key, binary);
+	}
+
+	void ShaderProgramCache::remove(uint64_t key)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_binaries.erase(key);
+		if (!_directory.empty()) {
+			std::remove(filePath(key).c_str());
+		}
+	}
+
+	size_t ShaderProgramCache::size(void) const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _binaries.size();
+	}
+
+	std::string ShaderProgramCache::filePath(uint64_t key) const
+	{
+		if (_directory.empty()) {
+			return "";
+		}
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.glbin", (unsigned long long)key);
+		return _directory + "/" + name;
+	}
+
+	bool ShaderProgramCache::load(uint64_t key, Binary & binary) const
+	{
+		if (_directory.empty()) {
+			return false;
+		}
+		const std::string path = filePath(key);
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+		char magic[4];
+		uint32_t version = 0;
+		uint64_t fileKey = 0;
+		uint32_t driverSize = 0;
+		if (!readRaw(file, magic, 4) || !std::equal(magic, magic + 4, programCacheMagic)
+			|| !readRaw(file, &version, 1) || version != programCacheVersion
+			|| !readRaw(file, &fileKey, 1) || fileKey != key
+			|| !readRaw(file, &driverSize, 1)) {
+			SIBR_WRG << "Invalid program binary cache file " << path << std::endl;
+			return false;
+		}
+		std::string fileDriver(driverSize, '\0');
+		uint64_t dataSize = 0;
+		if (!readRaw(file, &fileDriver[0], driverSize) || !readRaw(file, &binary.format, 1) || !readRaw(file, &dataSize, 1)) {
+			SIBR_WRG << "Truncated program binary cache file " << path << std::endl;
+			return false;
+		}
+		if (fileDriver != _driver) {
+			return false;
+		}
+		binary.data.resize(size_t(dataSize));
+		if (!readRaw(file, binary.data.data(), binary.data.size())) {
+			SIBR_WRG << "Truncated program binary cache file " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool ShaderProgramCache::save(uint64_t key, const Binary & binary) const
+	{
+		if (_directory.empty()) {
+			return false;
+		}
+		const std::string path = filePath(key);
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!file) {
+			SIBR_WRG << "Unable to write program binary to " << path << std::endl;
+			return false;
+		}
+		const uint32_t driverSize = uint32_t(_driver.size());
+		const uint64_t dataSize = uint64_t(binary.data.size());
+		writeRaw(file, programCacheMagic, 4);
+		writeRaw(file, &programCacheVersion, 1);
+		writeRaw(file, &key, 1);
+		writeRaw(file, &driverSize, 1);
+		writeRaw(file, _driver.data(), _driver.size());
+		writeRaw(file, &binary.format, 1);
+		writeRaw(file, &dataSize, 1);
+		writeRaw(file, binary.data.data(), binary.data.size());
+		return bool(file);
+	}
+
+} // namespace sibr
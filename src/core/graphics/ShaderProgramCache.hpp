@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include <map>
+# include <mutex>
+# include <string>
+# include <vector>
+# include "core/graphics/Config.hpp"
+
+namespace sibr
+{
+	/** Store of linked GPU program binaries, keyed by a hash of the program stages sources.
+	 When installed on GLShader (see GLShader::programCache), programs already linked with the same sources are
+	 loaded from their binary instead of being compiled again: when switching between shader variants at runtime,
+	 or across runs if a directory is given. Defines are substituted in the sources before GLShader::init
+	 (see loadFile), so they are part of the key.
+	 The store itself does not make any OpenGL call.
+	\ingroup sibr_graphics
+	*/
+	class SIBR_GRAPHICS_EXPORT ShaderProgramCache
+	{
+		SIBR_CLASS_PTR(ShaderProgramCache);
+
+	public:
+
+		/** A linked program, as returned by glGetProgramBinary. */
+		struct Binary {
+			uint32_t format = 0; ///< Driver specific binary format.
+			std::vector<char> data; ///< Binary content.
+		};
+
+		/** Constructor.
+		\param directory where the binaries are also stored to be reused across runs, empty to only keep them in memory
+		*/
+		ShaderProgramCache(const std::string & directory);
+
+		/** Set the identifier of the OpenGL driver, binaries stored on disk by another driver are ignored.
+		\param id the driver identifier (vendor, renderer and version strings for instance)
+		*/
+		void driver(const std::string & id);
+
+		/** \return the identifier of the OpenGL driver. */
+		const std::string & driver(void) const { return _driver; }
+
+		/** \return the directory where binaries are stored, empty if they are only kept in memory. */
+		const std::string & directory(void) const { return _directory; }
+
+		/** Compute the key of a program.
+		\param stages the sources of all the program stages, in a fixed order, empty for unused stages
+		\return the key
+		*/
+		static uint64_t key(const std::vector<std::string> & stages);
+
+		/** Look for a program binary, in memory then on disk.
+		\param key the program key
+		\param binary will contain the binary if found
+		\return true if the binary was found
+		*/
+		bool find(uint64_t key, Binary & binary);
+
+		/** Store a program binary, in memory and on disk if a directory was given.
+		\param key the program key
+		\param binary the binary
+		*/
+		void store(uint64_t key, const Binary & binary);
+
+		/** Forget a program binary, for instance when the driver rejected it.
+		\param key the program key
+		*/
+		void remove(uint64_t key);
+
+		/** \return the number of binaries kept in memory. */
+		size_t size(void) const;
+
+		/** \return the file where a program binary is stored on disk, empty if there is no directory.
+		\param key the program key
+		*/
+		std::string filePath(uint64_t key) const;
+
+	private:
+
+		/** Load a program binary from disk.
+		\param key the program key
+		\param binary will contain the binary
+		\return true if the file exists and was stored by the same driver
+		*/
+		bool load(uint64_t key, Binary & binary) const;
+
+		/** Save a program binary to disk.
+		\param key the program key
+		\param binary the binary
+		\return true if the file was written
+		*/
+		bool save(uint64_t key, const Binary & binary) const;
+
+		std::map<uint64_t, Binary>	_binaries; ///< Binaries in memory.
+		std::string					_directory; ///< Binaries directory, empty to only keep them in memory.
+		std::string					_driver; ///< Driver identifier.
+		mutable std::mutex			_mutex; ///< Protects the binaries.
+	};
+
+} // namespace sibr
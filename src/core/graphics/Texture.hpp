@@ -19,6 +19,7 @@
 # include "core/graphics/Image.hpp"
 # include "core/graphics/Types.hpp"
 # include "core/graphics/RenderTarget.hpp"
+# include "core/graphics/BlockCompression.hpp"
 
 namespace sibr
 {
@@ -289,6 +290,13 @@ namespace sibr
 		template<typename ImageType>
 		void createCompressedFromImages(const std::vector<ImageType>& images, uint w, uint h, uint compression, uint flags = 0);
 
+		/** Create the texture from images block compressed on the CPU (see BlockEncoder) and send them to GPU as is.
+		\param images list of compressed images, one for each layer, with the same format, size and number of levels
+		\param flags options
+		\note SIBR_FLIP_TEXTURE and SIBR_GPU_AUTOGEN_MIPMAP are ignored, flipping and mipmaps are done when encoding.
+		*/
+		void createFromImages(const std::vector<CompressedImage>& images, uint flags = 0);
+
 		/** Create the texture from a set of images with custom mipmaps and send it to GPU.
 		\param images list of lists of images, one for each mip level, each containing an image for each layer
 		\param flags options
@@ -328,6 +336,14 @@ namespace sibr
 		template<typename ImageType>
 		void updateSlices(const std::vector<ImageType>& images, const std::vector<int>& slices);
 
+		/** Update the content of one layer of the texture. If the texture has mipmaps, the ones of this layer
+		are built on the CPU and uploaded level by level, the other layers are left untouched.
+		\param image the new content to use, resized to the texture size if needed
+		\param slice the index of the slice to update
+		*/
+		template<typename ImageType>
+		void updateSlice(const ImageType& image, uint slice);
+
 		/// Destructor.
 		~Texture2DArray(void);
 
@@ -1214,6 +1230,44 @@ namespace sibr
 		sendArray(images);
 	}
 
+	template<typename T_Type, unsigned int T_NumComp>
+	void Texture2DArray<T_Type, T_NumComp>::createFromImages(const std::vector<CompressedImage>& images, uint flags) {
+		if (images.empty() || images[0].levels.empty()) {
+			SIBR_WRG << "No compressed image to upload." << std::endl;
+			return;
+		}
+		const CompressedImage& first = images[0];
+		for (const CompressedImage& image : images) {
+			if (image.format != first.format || image.w() != first.w() || image.h() != first.h() || image.levels.size() != first.levels.size()) {
+				SIBR_ERR << "All compressed layers should have the same format, size and number of levels." << std::endl;
+			}
+		}
+		m_W = first.w();
+		m_H = first.h();
+		m_Depth = (uint)images.size();
+		m_numLODs = (uint)first.levels.size();
+		m_Flags = flags & ~SIBR_GPU_AUTOGEN_MIPMAP;
+		const GLenum compression = first.format == BlockFormat::BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_BPTC_UNORM;
+		createArray(compression);
+
+		for (int lid = 0; lid < int(m_numLODs); ++lid) {
+			for (int im = 0; im < (int)m_Depth; ++im) {
+				const CompressedImage::Level& level = images[im].levels[lid];
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+					lid,
+					0, 0, im,
+					level.w,
+					level.h,
+					1, // one slice at a time
+					compression,
+					(GLsizei)level.blocks.size(),
+					level.blocks.data()
+				);
+			}
+		}
+		CHECK_GL_ERROR;
+	}
+
 	template<typename T_Type, unsigned int T_NumComp> template<typename ImageType>
 	void Texture2DArray<T_Type, T_NumComp>::createFromImages(const std::vector<std::vector<ImageType>>& images, uint flags) {
 		using ImgTypeInfo = GLTexFormat<ImageType, T_Type, T_NumComp>;
@@ -1295,6 +1349,54 @@ namespace sibr
 		CHECK_GL_ERROR;
 	}
 
+	template<typename T_Type, unsigned int T_NumComp> template<typename ImageType>
+	void Texture2DArray<T_Type, T_NumComp>::updateSlice(const ImageType& image, uint slice) {
+		using ImgTypeInfo = GLTexFormat<ImageType, T_Type, T_NumComp>;
+
+		const bool flip = (m_Flags & SIBR_FLIP_TEXTURE) != 0;
+		const bool resize = !(m_W == ImgTypeInfo::width(image) && m_H == ImgTypeInfo::height(image));
+		ImageType tmp;
+		if (resize) {
+			tmp = ImgTypeInfo::resize(image, m_W, m_H);
+		}
+		if (flip) {
+			tmp = ImgTypeInfo::flip(resize ? tmp : image);
+		}
+		const ImageType & imageToSend = (flip || resize) ? tmp : image;
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_Handle);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+			0,
+			0, 0, slice,
+			m_W,
+			m_H,
+			1,
+			ImgTypeInfo::format,
+			ImgTypeInfo::type,
+			ImgTypeInfo::data(imageToSend)
+		);
+
+		// glGenerateMipmap would rebuild the mipmaps of all layers: halve this one level by level instead.
+		ImageType level;
+		for (int lid = 1; lid < int(m_numLODs); ++lid) {
+			const uint dW = std::max(m_W >> lid, 1u);
+			const uint dH = std::max(m_H >> lid, 1u);
+			level = ImgTypeInfo::resize(lid == 1 ? imageToSend : level, dW, dH);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+				lid,
+				0, 0, slice,
+				dW,
+				dH,
+				1,
+				ImgTypeInfo::format,
+				ImgTypeInfo::type,
+				ImgTypeInfo::data(level)
+			);
+		}
+		CHECK_GL_ERROR;
+	}
+
 	template<typename T_Type, unsigned int T_NumComp>
 	void Texture2DArray<T_Type, T_NumComp>::createFromRTs(const std::vector<typename PixelRT::Ptr>& RTs, uint flags) {
 		m_W = 0;
@@ -14,6 +14,7 @@
 #include "core/graphics/Input.hpp"
 #include "core/graphics/Window.hpp"
 #include "core/graphics/RenderUtility.hpp"
+#include "core/graphics/Shader.hpp"
 
 #include "imgui/imgui.cpp" // needed for loading ini settings
 #include "imgui/imgui.h"
@@ -301,6 +302,15 @@ namespace sibr
 		(void)glGetError(); // I notice that glew might do wrong things during its init()
 							// some drivers complain about it. So I reset OpenGL's errors to discard this.
 
+		// Keep the linked programs to skip recompiling shader variants, and store them across runs if requested.
+		GLint binaryFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+		if (!GLShader::programCache() && binaryFormats > 0) {
+			ShaderProgramCache::Ptr programCache(new ShaderProgramCache(args.shader_cache.get()));
+			programCache->driver(std::string((const char*)glGetString(GL_VENDOR)) + "/" + (const char*)glGetString(GL_RENDERER) + "/" + (const char*)glGetString(GL_VERSION));
+			GLShader::programCache(programCache);
+		}
+
 		glfwSetWindowUserPointer(_glfwWin.get(), this);
 		/// \todo TODO: fix, width and height might be erroneous. SR
 		viewport(Viewport(0.f, 0.f, (float)width, (float)height));	/// \todo TODO: bind both
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "core/raycaster/AmbientOcclusionBaker.hpp"
+#include "core/system/Utils.hpp"
+
+namespace sibr
+{
+	namespace {
+
+		/** Integer hash (Wang), used for per-sample jittering. */
+		inline uint hashUint(uint x)
+		{
+			x = (x ^ 61u) ^ (x >> 16);
+			x *= 9u;
+			x = x ^ (x >> 4);
+			x *= 0x27d4eb2du;
+			x = x ^ (x >> 15);
+			return x;
+		}
+
+		/** Map a hash to [0,1). */
+		inline float hashToFloat(uint x)
+		{
+			return float(x >> 8) / float(1u << 24);
+		}
+
+		/** Build an orthonormal basis around a unit vector (Duff et al. 2017). */
+		inline void buildFrame(const sibr::Vector3f & n, sibr::Vector3f & t, sibr::Vector3f & b)
+		{
+			const float sign = std::copysign(1.0f, n.z());
+			const float a = -1.0f / (sign + n.z());
+			const float c = n.x() * n.y() * a;
+			t = sibr::Vector3f(1.0f + sign * n.x() * n.x() * a, sign * c, -sign * n.x());
+			b = sibr::Vector3f(c, sign + n.y() * n.y() * a, -n.y());
+		}
+
+		/** Install a baker as the AO function of the meshes that have none. */
+		const bool defaultAoFunctionInstalled = []() {
+			sibr::MaterialMesh::defaultAoFunction([]() {
+				return AmbientOcclusionBaker::aoFunction(std::make_shared<AmbientOcclusionBaker>());
+			});
+			return true;
+		}();
+
+	}
+
+	AmbientOcclusionBaker::AmbientOcclusionBaker() :
+		AmbientOcclusionBaker(Options())
+	{
+	}
+
+	AmbientOcclusionBaker::AmbientOcclusionBaker(const Options & options) :
+		_options(options)
+	{
+		_gridSize = std::max(1u, (uint)std::ceil(std::sqrt((float)std::max(1u, _options.samplesCount))));
+		_samplesCount = _gridSize * _gridSize;
+		_options.samplesPerPass = std::max(8u, ((_options.samplesPerPass + 7u) / 8u) * 8u);
+
+		// Scatter the strata so that any prefix of the sequence covers the hemisphere:
+		// step through them with a stride close to N/phi, coprime with N.
+		uint stride = std::max(1u, (uint)std::round(0.618034f * _samplesCount));
+		const auto gcd = [](uint a, uint b) { while (b != 0) { const uint r = a % b; a = b; b = r; } return a; };
+		while (_samplesCount > 1 && gcd(stride, _samplesCount) != 1) {
+			++stride;
+		}
+		_strataOrder.resize(_samplesCount);
+		for (uint k = 0; k < _samplesCount; ++k) {
+			_strataOrder[k] = uint((uint64_t(k) * stride) % _samplesCount);
+		}
+	}
+
+	bool AmbientOcclusionBaker::setMesh(const sibr::Mesh & mesh)
+	{
+		_vertices = mesh.vertices();
+		if (mesh.hasNormals()) {
+			_normals = mesh.normals();
+		} else {
+			// Area-weighted face normals, without touching the (const) input mesh.
+			_normals.assign(_vertices.size(), sibr::Vector3f(0.0f, 0.0f, 0.0f));
+			for (const sibr::Vector3u & t : mesh.triangles()) {
+				const sibr::Vector3f n = (_vertices[t[1]] - _vertices[t[0]]).cross(_vertices[t[2]] - _vertices[t[0]]);
+				_normals[t[0]] += n;
+				_normals[t[1]] += n;
+				_normals[t[2]] += n;
+			}
+		}
+		#pragma omp parallel for
+		for (int vid = 0; vid < (int)_normals.size(); ++vid) {
+			const float len = _normals[vid].norm();
+			_normals[vid] = len > 0.0f ? sibr::Vector3f(_normals[vid] / len) : sibr::Vector3f(0.0f, 0.0f, 0.0f);
+		}
+
+		const Eigen::AlignedBox<float, 3> bbox = mesh.getBoundingBox();
+		_epsilon = _options.epsilon * (bbox.isEmpty() ? 1.0f : bbox.diagonal().norm());
+
+		_signature = meshSignature(mesh);
+		_traced = 0;
+
+		_raycaster = std::make_shared<Raycaster>();
+		if (!_raycaster->init()) {
+			SIBR_WRG << "Unable to initialize the raycaster, ambient occlusion will not be baked." << std::endl;
+			_raycaster.reset();
+			_distances.clear();
+			return false;
+		}
+		_raycaster->addMesh(mesh);
+
+		_distances.assign(_vertices.size() * size_t(_samplesCount), RayHit::InfinityDist);
+		return true;
+	}
+
+	bool AmbientOcclusionBaker::refine(void)
+	{
+		if (!_raycaster || converged()) {
+			return false;
+		}
+
+		const uint first = _traced;
+		const uint last = std::min(_samplesCount, first + _options.samplesPerPass);
+		const int verticesCount = (int)_vertices.size();
+
+		#pragma omp parallel for schedule(dynamic, 256)
+		for (int vid = 0; vid < verticesCount; ++vid) {
+			const sibr::Vector3f & n = _normals[vid];
+			if (n.isZero()) {
+				continue;
+			}
+			sibr::Vector3f t, b;
+			buildFrame(n, t, b);
+			const sibr::Vector3f origin = _vertices[vid] + _epsilon * n;
+			float * dists = &_distances[size_t(vid) * _samplesCount];
+
+			std::vector<int> valid(8, 0);
+			for (uint s = first; s < last; s += 8) {
+				const uint packetSize = std::min(8u, last - s);
+				std::array<Ray, 8> rays;
+				std::fill(valid.begin(), valid.end(), 0);
+				for (uint r = 0; r < packetSize; ++r) {
+					const sibr::Vector3f l = localSample(vid, s + r);
+					rays[r] = Ray(origin, l.x() * t + l.y() * b + l.z() * n);
+					valid[r] = -1;
+				}
+				const std::array<RayHit, 8> hits = _raycaster->intersect8(rays, valid, _epsilon);
+				for (uint r = 0; r < packetSize; ++r) {
+					dists[s + r] = hits[r].dist();
+				}
+			}
+		}
+
+		_traced = last;
+		return !converged();
+	}
+
+	void AmbientOcclusionBaker::refineUntil(uint samplesCount)
+	{
+		const uint target = std::min(samplesCount, _samplesCount);
+		while (_traced < target && refine()) {
+		}
+	}
+
+	bool AmbientOcclusionBaker::converged(void) const
+	{
+		return _traced >= _samplesCount;
+	}
+
+	sibr::Mesh::Colors AmbientOcclusionBaker::colors(float attenuationDistance) const
+	{
+		sibr::Mesh::Colors aos(_vertices.size(), sibr::Vector3f(1.0f, 1.0f, 1.0f));
+		if (_traced == 0) {
+			return aos;
+		}
+		const float invAttenuation = attenuationDistance > 0.0f ? 1.0f / attenuationDistance : 0.0f;
+		const float invCount = 1.0f / float(_traced);
+
+		#pragma omp parallel for
+		for (int vid = 0; vid < (int)_vertices.size(); ++vid) {
+			if (_normals[vid].isZero()) {
+				continue;
+			}
+			const float * dists = &_distances[size_t(vid) * _samplesCount];
+			float visibility = 0.0f;
+			for (uint s = 0; s < _traced; ++s) {
+				visibility += std::min(1.0f, dists[s] * invAttenuation);
+			}
+			visibility *= invCount;
+			aos[vid] = sibr::Vector3f(visibility, visibility, visibility);
+		}
+		return aos;
+	}
+
+	sibr::Mesh::Colors AmbientOcclusionBaker::bake(const sibr::Mesh & mesh, float attenuationDistance)
+	{
+		if (!_raycaster || meshSignature(mesh) != _signature) {
+			setMesh(mesh);
+		}
+		refineUntil(_samplesCount);
+		return colors(attenuationDistance);
+	}
+
+	std::function<sibr::Mesh::Colors(sibr::MaterialMesh&, const int)> AmbientOcclusionBaker::aoFunction(const AmbientOcclusionBaker::Ptr & baker)
+	{
+		return [baker](sibr::MaterialMesh & mesh, const int samplesCount) -> sibr::Mesh::Colors {
+			if (!baker->_raycaster || meshSignature(mesh) != baker->_signature) {
+				baker->setMesh(mesh);
+			}
+			baker->refineUntil(uint(std::max(samplesCount, 1)));
+			return baker->colors(mesh.ambientOcclusion().AttenuationDistance);
+		};
+	}
+
+	size_t AmbientOcclusionBaker::meshSignature(const sibr::Mesh & mesh)
+	{
+		// FNV-1a over the raw geometry buffers, one 32-bit word at a time.
+		const uint32_t counts[2] = { (uint32_t)mesh.vertices().size(), (uint32_t)mesh.triangles().size() };
+		uint64_t h = hashWords(fnv1aSeed, counts, 2);
+		if (counts[0] > 0) {
+			h = hashWords(h, reinterpret_cast<const uint32_t*>(mesh.vertexArray()), 3 * size_t(counts[0]));
+		}
+		if (counts[1] > 0) {
+			h = hashWords(h, reinterpret_cast<const uint32_t*>(mesh.triangleArray()), 3 * size_t(counts[1]));
+		}
+		return size_t(h);
+	}
+
+	sibr::Vector3f AmbientOcclusionBaker::localSample(uint vertexId, uint sampleId) const
+	{
+		const uint stratum = _strataOrder[sampleId];
+		const uint sx = stratum % _gridSize;
+		const uint sy = stratum / _gridSize;
+
+		const uint seed = hashUint(vertexId * 0x9E3779B9u + sampleId);
+		const float u = (float(sx) + hashToFloat(seed)) / float(_gridSize);
+		const float v = (float(sy) + hashToFloat(hashUint(seed))) / float(_gridSize);
+
+		// Cosine-weighted hemisphere mapping.
+		const float r = std::sqrt(u);
+		const float phi = 2.0f * float(M_PI) * v;
+		return sibr::Vector3f(r * std::cos(phi), r * std::sin(phi), std::sqrt(std::max(0.0f, 1.0f - u)));
+	}
+
+} // namespace sibr
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include <functional>
+# include <core/graphics/Mesh.hpp>
+# include <core/graphics/MaterialMesh.hpp>
+# include "core/raycaster/Config.hpp"
+# include "core/raycaster/Raycaster.hpp"
+
+namespace sibr
+{
+
+	/** Bake per-vertex ambient occlusion using the Embree raycaster.
+	 Each vertex shoots stratified, cosine-weighted rays in its normal hemisphere.
+	 Baking is progressive: each call to refine() traces one more batch of samples
+	 (packets of 8 rays) for every vertex in parallel, so a coarse result is available
+	 after the first pass and improves until all samples have been traced.
+	 Hit distances are cached, so changing the attenuation distance only re-evaluates
+	 the cached samples and does not trace new rays.
+	 \note The distance cache uses (vertex count x samples count) floats.
+	 \ingroup sibr_raycaster
+	*/
+	class SIBR_RAYCASTER_EXPORT AmbientOcclusionBaker
+	{
+		SIBR_CLASS_PTR(AmbientOcclusionBaker);
+
+	public:
+
+		/** Baking options. */
+		struct Options {
+			uint samplesCount = 64; ///< Total number of samples per vertex (rounded up to a square number of strata).
+			uint samplesPerPass = 8; ///< Number of samples traced per vertex at each refinement step (rounded up to a multiple of 8).
+			float epsilon = 1e-4f; ///< Ray offset, relative to the mesh bounding box diagonal, to avoid self intersections.
+		};
+
+		/** Constructor, using the default baking options. */
+		AmbientOcclusionBaker();
+
+		/** Constructor.
+		\param options baking options
+		*/
+		AmbientOcclusionBaker(const Options & options);
+
+		/** Set the mesh to bake, build the raycasting structure and reset the distance cache.
+		 If the mesh has no normals, they will be generated on an internal copy.
+		\param mesh the mesh
+		\return false if the raycaster could not be initialized, nothing will be traced
+		*/
+		bool setMesh(const sibr::Mesh & mesh);
+
+		/** Trace the next batch of samples for all vertices.
+		\return true if there are samples left to trace
+		*/
+		bool refine(void);
+
+		/** Trace samples until at least a given number of samples per vertex has been traced.
+		\param samplesCount the required number of samples (clamped to the total samples count)
+		*/
+		void refineUntil(uint samplesCount);
+
+		/** \return true if all samples have been traced. */
+		bool converged(void) const;
+
+		/** \return the number of samples per vertex traced so far. */
+		uint tracedSamples(void) const { return _traced; }
+
+		/** \return the total number of samples per vertex. */
+		uint samplesCount(void) const { return _samplesCount; }
+
+		/** Compute the ambient occlusion from the cached samples, without tracing new rays.
+		 Each sample contributes min(1, hitDistance/attenuationDistance), misses contribute 1.
+		 The result is stored in all three channels, as expected by MaterialMesh rendering.
+		\param attenuationDistance distance after which occluders are ignored
+		\return per-vertex AO values
+		*/
+		sibr::Mesh::Colors colors(float attenuationDistance) const;
+
+		/** Fully bake a mesh (set it if it differs from the current one, then trace all samples).
+		\param mesh the mesh
+		\param attenuationDistance distance after which occluders are ignored
+		\return per-vertex AO values
+		*/
+		sibr::Mesh::Colors bake(const sibr::Mesh & mesh, float attenuationDistance);
+
+		/** Generate a function that can be passed to MaterialMesh::aoFunction.
+		 The baker is only reset when the mesh geometry changes (for instance after subdivision);
+		 when only the attenuation distance changes, the cached distances are reused.
+		 A function using a new baker is installed as the MaterialMesh default when sibr_raycaster is loaded.
+		\param baker the baker to use
+		\return the AO function
+		*/
+		static std::function<sibr::Mesh::Colors(sibr::MaterialMesh&, const int)> aoFunction(const AmbientOcclusionBaker::Ptr & baker);
+
+	private:
+
+		/** Compute a signature of the mesh geometry, used to detect changes.
+		\param mesh the mesh
+		\return the signature
+		*/
+		static size_t meshSignature(const sibr::Mesh & mesh);
+
+		/** Compute the i-th stratified sample direction of a vertex, in the local frame (z up).
+		\param vertexId the vertex index (used to decorrelate jittering)
+		\param sampleId the sample index in the progressive order
+		\return the direction
+		*/
+		sibr::Vector3f localSample(uint vertexId, uint sampleId) const;
+
+		Options						_options; ///< Baking options.
+		uint						_samplesCount = 0; ///< Total number of samples per vertex.
+		uint						_gridSize = 0; ///< Number of strata along each dimension.
+		std::vector<uint>			_strataOrder; ///< Progressive ordering of the strata.
+
+		Raycaster::Ptr				_raycaster; ///< Raycaster containing the mesh.
+		sibr::Mesh::Vertices		_vertices; ///< Mesh vertices.
+		sibr::Mesh::Normals			_normals; ///< Mesh normals.
+		size_t						_signature = 0; ///< Signature of the current mesh.
+		float						_epsilon = 0.0f; ///< Absolute ray offset.
+
+		std::vector<float>			_distances; ///< Cached hit distances (vertex major), RayHit::InfinityDist for misses.
+		uint						_traced = 0; ///< Number of samples per vertex already traced.
+	};
+
+} // namespace sibr
@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include "core/raycaster/InputDepthMaps.hpp"
+#include "core/system/SimpleTimer.hpp"
+#include "core/system/Utils.hpp"
+
+namespace sibr
+{
+	namespace {
+
+		const char		depthCacheMagic[4] = { 'S', 'D', 'E', 'P' }; ///< Cache file signature.
+		const uint32_t	depthCacheVersion = 1; ///< Cache file version.
+		const uint16_t	depthCacheMiss = 0xFFFF; ///< Quantized value of the pixels where nothing is hit.
+		const uint		rowsPerStream = 16; ///< Number of rows cast as one ray stream.
+
+		/** Homogeneous transform of a point. */
+		sibr::Vector3f transform(const sibr::Matrix4f & m, const sibr::Vector3f & p, float & w)
+		{
+			const sibr::Vector4f q = m * sibr::Vector4f(p[0], p[1], p[2], 1.0f);
+			w = q[3];
+			return sibr::Vector3f(q[0], q[1], q[2]);
+		}
+	}
+
+	void InputDepthMaps::setCameras(const std::vector<InputCamera::Ptr> & cams, uint w, uint h)
+	{
+		_w = w;
+		_h = h;
+		_cams.resize(cams.size());
+		for (size_t i = 0; i < cams.size(); ++i) {
+			_cams[i].viewproj = cams[i]->viewproj();
+			_cams[i].invViewproj = cams[i]->invViewproj();
+			_cams[i].position = cams[i]->position();
+		}
+	}
+
+	Ray InputDepthMaps::pixelRay(const CameraMatrices & cam, uint x, uint y, sibr::Vector3f & far) const
+	{
+		const float ndcX = 2.0f * (float(x) + 0.5f) / float(_w) - 1.0f;
+		const float ndcY = 1.0f - 2.0f * (float(y) + 0.5f) / float(_h);
+		float w = 1.0f;
+		const sibr::Vector3f near = transform(cam.invViewproj, sibr::Vector3f(ndcX, ndcY, -1.0f), w) / w;
+		far = transform(cam.invViewproj, sibr::Vector3f(ndcX, ndcY, 1.0f), w) / w;
+		return Ray(near, far - near);
+	}
+
+	void InputDepthMaps::compute(const sibr::Mesh & mesh, const std::vector<InputCamera::Ptr> & cams, uint w, uint h)
+	{
+		setCameras(cams, w, h);
+		_signature = signature(mesh, cams, w, h);
+		_rayDepths.resize(cams.size());
+		for (sibr::ImageL32F & depth : _rayDepths) {
+			depth = sibr::ImageL32F(w, h, RayHit::InfinityDist);
+		}
+		if (cams.empty() || w == 0 || h == 0) {
+			return;
+		}
+
+		Raycaster raycaster;
+		raycaster.init();
+		raycaster.addMesh(mesh);
+
+		sibr::Timer timer(true);
+		// One task per tile of rows of a camera, so that all cameras are processed in parallel.
+		const uint tilesPerCam = (h + rowsPerStream - 1) / rowsPerStream;
+		const int tilesCount = int(tilesPerCam * cams.size());
+
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int tid = 0; tid < tilesCount; ++tid) {
+			const uint cid = uint(tid) / tilesPerCam;
+			const uint firstRow = (uint(tid) % tilesPerCam) * rowsPerStream;
+			const uint lastRow = std::min(h, firstRow + rowsPerStream);
+
+			std::vector<Ray> rays;
+			rays.reserve(size_t(lastRow - firstRow) * w);
+			sibr::Vector3f far;
+			for (uint y = firstRow; y < lastRow; ++y) {
+				for (uint x = 0; x < w; ++x) {
+					rays.push_back(pixelRay(_cams[cid], x, y, far));
+				}
+			}
+			std::vector<float> dists;
+			raycaster.intersectStream(rays, dists);
+
+			size_t rid = 0;
+			for (uint y = firstRow; y < lastRow; ++y) {
+				for (uint x = 0; x < w; ++x, ++rid) {
+					_rayDepths[cid](x, y)[0] = dists[rid];
+				}
+			}
+		}
+		SIBR_LOG << "[InputDepthMaps] Raycast " << cams.size() << " depth maps (" << w << "x" << h << ") in "
+			<< timer.deltaTimeFromLastTic() << "ms." << std::endl;
+	}
+
+	bool InputDepthMaps::save(const std::string & path) const
+	{
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!file) {
+			SIBR_WRG << "Unable to write depth maps cache to " << path << std::endl;
+			return false;
+		}
+		const uint32_t header[3] = { (uint32_t)_rayDepths.size(), _w, _h };
+		writeRaw(file, depthCacheMagic, 4);
+		writeRaw(file, &depthCacheVersion, 1);
+		writeRaw(file, header, 3);
+		writeRaw(file, &_signature, 1);
+
+		std::vector<uint16_t> quantized(size_t(_w) * _h);
+		for (const sibr::ImageL32F & depth : _rayDepths) {
+			// Range of the hits of this image.
+			float range[2] = { std::numeric_limits<float>::max(), 0.0f };
+			for (uint y = 0; y < _h; ++y) {
+				for (uint x = 0; x < _w; ++x) {
+					const float d = depth(x, y)[0];
+					if (d != RayHit::InfinityDist) {
+						range[0] = std::min(range[0], d);
+						range[1] = std::max(range[1], d);
+					}
+				}
+			}
+			if (range[0] > range[1]) {
+				range[0] = range[1] = 0.0f;
+			}
+			const float scale = range[1] > range[0] ? float(depthCacheMiss - 1) / (range[1] - range[0]) : 0.0f;
+			#pragma omp parallel for
+			for (int y = 0; y < int(_h); ++y) {
+				for (uint x = 0; x < _w; ++x) {
+					const float d = depth(x, y)[0];
+					quantized[size_t(y) * _w + x] = d == RayHit::InfinityDist ? depthCacheMiss : uint16_t(std::lround((d - range[0]) * scale));
+				}
+			}
+			writeRaw(file, range, 2);
+			writeRaw(file, quantized.data(), quantized.size());
+		}
+		return bool(file);
+	}
+
+	bool InputDepthMaps::load(const std::string & path, const sibr::Mesh & mesh, const std::vector<InputCamera::Ptr> & cams, uint w, uint h)
+	{
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+		char magic[4];
+		uint32_t version = 0;
+		uint32_t header[3];
+		uint64_t fileSignature = 0;
+		if (!readRaw(file, magic, 4) || !std::equal(magic, magic + 4, depthCacheMagic)
+			|| !readRaw(file, &version, 1) || version != depthCacheVersion
+			|| !readRaw(file, header, 3) || !readRaw(file, &fileSignature, 1)) {
+			SIBR_WRG << "Invalid depth maps cache file " << path << std::endl;
+			return false;
+		}
+		const uint64_t expected = signature(mesh, cams, w, h);
+		if (header[0] != cams.size() || header[1] != w || header[2] != h || fileSignature != expected) {
+			SIBR_LOG << "Depth maps cache " << path << " does not match the proxy and cameras, ignoring it." << std::endl;
+			return false;
+		}
+
+		std::vector<sibr::ImageL32F> depths(cams.size());
+		std::vector<uint16_t> quantized(size_t(w) * h);
+		for (sibr::ImageL32F & depth : depths) {
+			float range[2];
+			if (!readRaw(file, range, 2) || !readRaw(file, quantized.data(), quantized.size())) {
+				SIBR_WRG << "Truncated depth maps cache file " << path << std::endl;
+				return false;
+			}
+			const float step = (range[1] - range[0]) / float(depthCacheMiss - 1);
+			depth = sibr::ImageL32F(w, h);
+			#pragma omp parallel for
+			for (int y = 0; y < int(h); ++y) {
+				for (uint x = 0; x < w; ++x) {
+					const uint16_t q = quantized[size_t(y) * w + x];
+					depth(x, uint(y))[0] = q == depthCacheMiss ? RayHit::InfinityDist : range[0] + float(q) * step;
+				}
+			}
+		}
+
+		setCameras(cams, w, h);
+		_signature = expected;
+		_rayDepths.swap(depths);
+		return true;
+	}
+
+	void InputDepthMaps::loadOrCompute(const sibr::Mesh & mesh, const std::vector<InputCamera::Ptr> & cams, uint w, uint h, const std::string & path)
+	{
+		if (load(path, mesh, cams, w, h)) {
+			SIBR_LOG << "Loaded " << _rayDepths.size() << " depth maps from " << path << std::endl;
+			return;
+		}
+		compute(mesh, cams, w, h);
+		save(path);
+	}
+
+	sibr::ImageL32F InputDepthMaps::windowDepth(uint cam) const
+	{
+		sibr::ImageL32F result(_w, _h, 1.0f);
+		const CameraMatrices & matrices = _cams[cam];
+		const sibr::ImageL32F & depth = _rayDepths[cam];
+		#pragma omp parallel for
+		for (int y = 0; y < int(_h); ++y) {
+			sibr::Vector3f far;
+			for (uint x = 0; x < _w; ++x) {
+				const float d = depth(x, uint(y))[0];
+				if (d == RayHit::InfinityDist) {
+					continue;
+				}
+				const Ray ray = pixelRay(matrices, x, uint(y), far);
+				float w = 1.0f;
+				const sibr::Vector3f p = transform(matrices.viewproj, ray.orig() + d * ray.dir(), w);
+				result(x, uint(y))[0] = std::min(std::max(0.5f * p[2] / w + 0.5f, 0.0f), 1.0f);
+			}
+		}
+		return result;
+	}
+
+	std::vector<sibr::ImageL32F> InputDepthMaps::windowDepths(void) const
+	{
+		std::vector<sibr::ImageL32F> depths(_rayDepths.size());
+		for (uint i = 0; i < uint(depths.size()); ++i) {
+			depths[i] = windowDepth(i);
+		}
+		return depths;
+	}
+
+	sibr::ImageL32F InputDepthMaps::distance(uint cam) const
+	{
+		sibr::ImageL32F result(_w, _h);
+		const CameraMatrices & matrices = _cams[cam];
+		const sibr::ImageL32F & depth = _rayDepths[cam];
+		#pragma omp parallel for
+		for (int y = 0; y < int(_h); ++y) {
+			sibr::Vector3f far;
+			for (uint x = 0; x < _w; ++x) {
+				const float d = depth(x, uint(y))[0];
+				const Ray ray = pixelRay(matrices, x, uint(y), far);
+				const sibr::Vector3f p = d == RayHit::InfinityDist ? far : sibr::Vector3f(ray.orig() + d * ray.dir());
+				result(x, uint(y))[0] = (p - matrices.position).norm();
+			}
+		}
+		return result;
+	}
+
+	std::string InputDepthMaps::cachePath(const std::string & datasetPath, uint w, uint h)
+	{
+		return datasetPath + "/depth_maps_" + std::to_string(w) + "x" + std::to_string(h) + ".bin";
+	}
+
+	uint64_t InputDepthMaps::signature(const sibr::Mesh & mesh, const std::vector<InputCamera::Ptr> & cams, uint w, uint h)
+	{
+		// FNV-1a over the raw geometry buffers and camera matrices, one 32-bit word at a time.
+		const uint32_t counts[4] = { (uint32_t)mesh.vertices().size(), (uint32_t)mesh.triangles().size(), w, h };
+		uint64_t hash = hashWords(fnv1aSeed, counts, 4);
+		if (counts[0] > 0) {
+			hash = hashWords(hash, reinterpret_cast<const uint32_t*>(mesh.vertexArray()), 3 * size_t(counts[0]));
+		}
+		if (counts[1] > 0) {
+			hash = hashWords(hash, reinterpret_cast<const uint32_t*>(mesh.triangleArray()), 3 * size_t(counts[1]));
+		}
+		for (const InputCamera::Ptr & cam : cams) {
+			const sibr::Matrix4f viewproj = cam->viewproj();
+			hash = hashWords(hash, reinterpret_cast<const uint32_t*>(viewproj.data()), 16);
+		}
+		return hash;
+	}
+
+} // namespace sibr
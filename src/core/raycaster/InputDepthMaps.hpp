@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include <core/graphics/Mesh.hpp>
+# include <core/graphics/Image.hpp>
+# include <core/assets/InputCamera.hpp>
+# include "core/raycaster/Config.hpp"
+# include "core/raycaster/Raycaster.hpp"
+
+namespace sibr
+{
+
+	/** Depth maps of the input cameras, raycast on the CPU with Embree instead of rasterized camera per camera on the GPU.
+	 Rays start on the near plane of each camera, through the pixel centers; tiles of rows are cast as coherent ray
+	 streams and all cameras are processed in parallel. The same maps provide the window depth expected by the
+	 input depth texture arrays and the distance to the camera center used to build soft visibility maps.
+	 They can be saved to a compact cache file: 16 bits per pixel, quantized in the range of hit distances of each image,
+	 tagged with a signature of the mesh and cameras so that stale caches are ignored.
+	 \note Unlike the GPU path, backfaces are not culled.
+	 \ingroup sibr_raycaster
+	*/
+	class SIBR_RAYCASTER_EXPORT InputDepthMaps
+	{
+		SIBR_CLASS_PTR(InputDepthMaps);
+
+	public:
+
+		/** Raycast the depth maps of all cameras.
+		\param mesh the proxy
+		\param cams the input cameras
+		\param w the depth maps width
+		\param h the depth maps height
+		*/
+		void compute(const sibr::Mesh & mesh, const std::vector<InputCamera::Ptr> & cams, uint w, uint h);
+
+		/** Save the depth maps to a binary cache file.
+		\param path the destination file
+		\return true if the file was written
+		*/
+		bool save(const std::string & path) const;
+
+		/** Load the depth maps from a binary cache file.
+		\param path the cache file
+		\param mesh the proxy, the cache is rejected unless it was computed for the same mesh
+		\param cams the input cameras, the cache is rejected unless it was computed for the same cameras
+		\param w the expected depth maps width
+		\param h the expected depth maps height
+		\return true if the file was loaded and is valid
+		*/
+		bool load(const std::string & path, const sibr::Mesh & mesh, const std::vector<InputCamera::Ptr> & cams, uint w, uint h);
+
+		/** Load the depth maps from a cache file if it is valid, or compute them and update the cache.
+		\param mesh the proxy
+		\param cams the input cameras
+		\param w the depth maps width
+		\param h the depth maps height
+		\param path the cache file
+		*/
+		void loadOrCompute(const sibr::Mesh & mesh, const std::vector<InputCamera::Ptr> & cams, uint w, uint h, const std::string & path);
+
+		/** \return the number of depth maps. */
+		size_t size(void) const { return _rayDepths.size(); }
+
+		/** \return the depth maps width. */
+		uint w(void) const { return _w; }
+
+		/** \return the depth maps height. */
+		uint h(void) const { return _h; }
+
+		/** Window depth of a camera, as written by the depthonly shader.
+		\param cam the camera index
+		\return the depth in [0,1], 1 where nothing is hit, first row at the top
+		*/
+		sibr::ImageL32F windowDepth(uint cam) const;
+
+		/** \return the window depths of all cameras, see windowDepth. */
+		std::vector<sibr::ImageL32F> windowDepths(void) const;
+
+		/** Distance to the camera center of a camera.
+		\param cam the camera index
+		\return the distance, to the far plane where nothing is hit, first row at the top
+		*/
+		sibr::ImageL32F distance(uint cam) const;
+
+		/** \return the default cache file path for depth maps of the input cameras of a dataset.
+		\param datasetPath the dataset directory
+		\param w the depth maps width
+		\param h the depth maps height
+		*/
+		static std::string cachePath(const std::string & datasetPath, uint w, uint h);
+
+	private:
+
+		/** Per camera matrices, copied once since Camera updates them lazily. */
+		struct CameraMatrices {
+			sibr::Matrix4f viewproj; ///< View projection.
+			sibr::Matrix4f invViewproj; ///< Inverse view projection.
+			sibr::Vector3f position; ///< Center.
+		};
+
+		/** Ray from the near plane to the far plane through the center of a pixel.
+		\param cam the camera matrices
+		\param x the pixel column
+		\param y the pixel row, from the top
+		\param far will contain the far plane point
+		\return the ray, normalized
+		*/
+		Ray pixelRay(const CameraMatrices & cam, uint x, uint y, sibr::Vector3f & far) const;
+
+		/** Signature of the inputs, stored in the cache file. */
+		static uint64_t signature(const sibr::Mesh & mesh, const std::vector<InputCamera::Ptr> & cams, uint w, uint h);
+
+		/** Copy the matrices of the cameras. */
+		void setCameras(const std::vector<InputCamera::Ptr> & cams, uint w, uint h);
+
+		std::vector<CameraMatrices>		_cams; ///< Camera matrices.
+		std::vector<sibr::ImageL32F>	_rayDepths; ///< Hit distance from the near plane along each ray, RayHit::InfinityDist for misses.
+		uint							_w = 0; ///< Width.
+		uint							_h = 0; ///< Height.
+		uint64_t						_signature = 0; ///< Signature of the inputs.
+	};
+
+} // namespace sibr
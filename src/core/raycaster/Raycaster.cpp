@@ -342,6 +342,48 @@ namespace sibr
 		return res;
 	}
 
+	void Raycaster::intersectStream(const std::vector<Ray>& inrays, std::vector<float>& dists, float minDist, bool coherent)
+	{
+		assert(minDist >= 0.f);
+
+		dists.assign(inrays.size(), RayHit::InfinityDist);
+		if (inrays.empty()) {
+			return;
+		}
+		if (init() == false) {
+			SIBR_ERR << "cannot initialize embree, failed cast rays." << std::endl;
+			return;
+		}
+
+		std::vector<RTCRayHit> rhs(inrays.size());
+		for (size_t r = 0; r < inrays.size(); ++r) {
+			RTCRayHit & rh = rhs[r];
+			rh.ray.org_x = inrays[r].orig()[0];
+			rh.ray.org_y = inrays[r].orig()[1];
+			rh.ray.org_z = inrays[r].orig()[2];
+			rh.ray.dir_x = inrays[r].dir()[0];
+			rh.ray.dir_y = inrays[r].dir()[1];
+			rh.ray.dir_z = inrays[r].dir()[2];
+			rh.ray.tnear = minDist;
+			rh.ray.tfar = RayHit::InfinityDist;
+			rh.ray.time = 0.f;
+			rh.ray.mask = 0xFFFFFFFF;
+			rh.ray.flags = 0;
+			rh.hit.geomID = RTC_INVALID_GEOMETRY_ID;
+		}
+
+		RTCIntersectContext context;
+		rtcInitIntersectContext(&context);
+		context.flags = coherent ? RTC_INTERSECT_CONTEXT_FLAG_COHERENT : RTC_INTERSECT_CONTEXT_FLAG_INCOHERENT;
+		rtcIntersect1M(*_scene.get(), &context, rhs.data(), (unsigned int)rhs.size(), sizeof(RTCRayHit));
+
+		for (size_t r = 0; r < inrays.size(); ++r) {
+			if (rhs[r].hit.geomID != RTC_INVALID_GEOMETRY_ID) {
+				dists[r] = rhs[r].ray.tfar;
+			}
+		}
+	}
+
 	void Raycaster::clearGeometry()
 	{
 		_scene.reset();
@@ -104,6 +104,14 @@ namespace sibr
 		/// \return the list of (potential) intersection informations
 		std::array<RayHit, 8>	intersect8(const std::array<Ray, 8>& inray,const std::vector<int> & valid8=std::vector<int>(8,-1), float minDist = 0.f );
 
+		/// Launch a stream of rays into the raycaster scene, only reporting the hit distances.
+		/// Embree traces the stream as packets, which is much faster for coherent rays (all the pixels of a camera for instance).
+		/// \param inrays the rays to cast
+		/// \param dists will contain the hit distance of each ray, RayHit::InfinityDist if nothing was hit
+		/// \param minDist Any intersection closer than minDist from the ray origin will be ignored. Useful to avoid self intersections. 
+		/// \param coherent hint that neighboring rays have similar origins and directions
+		void	intersectStream(const std::vector<Ray>& inrays, std::vector<float>& dists, float minDist = 0.f, bool coherent = true);
+
 		/// Optimized ray-cast that only tells you if an intersection occured.
 		/// \sa intersect
 		/// \param ray the ray to cast
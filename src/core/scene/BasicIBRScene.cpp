@@ -18,6 +18,7 @@
 #include "core/scene/ParseData.hpp"
 #include "core/scene/ProxyMesh.hpp"
 #include "core/scene/InputImages.hpp"
+#include "core/graphics/MeshOptimizer.hpp"
 
 namespace sibr
 {
@@ -38,6 +39,11 @@ namespace sibr
 		_data.reset(new ParseData());
 		_currentOpts.renderTargets = !noRTs;
 		_currentOpts.mesh = !noMesh;
+		_currentOpts.optimizeProxy = myArgs.optimize_proxy;
+		_currentOpts.lodProxy = myArgs.lod_proxy;
+		if (myArgs.input_rt_16) {
+			_currentOpts.inputRTFormat = RGBDInputFormat::RGBA16;
+		}
 
 		_data->getParsedData(myArgs);
 		std::cout << "Number of input Images to read: " << _data->imgInfos().size() << std::endl;
@@ -47,6 +53,7 @@ namespace sibr
 
 		if (_data->datasetType() != IParseData::Type::EMPTY) {
 			createFromData(myArgs.texture_width);
+			_proxies->lodPixelError(myArgs.lod_pixel_error);
 		}
 	}
 
@@ -54,6 +61,11 @@ namespace sibr
 	{
 		BasicIBRScene();
 		_currentOpts = myOpts;
+		_currentOpts.optimizeProxy = myOpts.optimizeProxy || myArgs.optimize_proxy;
+		_currentOpts.lodProxy = myOpts.lodProxy || myArgs.lod_proxy;
+		if (myArgs.input_rt_16) {
+			_currentOpts.inputRTFormat = RGBDInputFormat::RGBA16;
+		}
 
 		// parse metadata file
 		_data.reset(new ParseData());
@@ -67,6 +79,7 @@ namespace sibr
 
 		if (_data->datasetType() != IParseData::Type::EMPTY) {
 			createFromData(myArgs.texture_width);
+			_proxies->lodPixelError(myArgs.lod_pixel_error);
 		}
 	}
 
@@ -80,6 +93,7 @@ namespace sibr
 
 	void BasicIBRScene::createRenderTargets()
 	{
+		_renderTargets->inputRTFormat(_currentOpts.inputRTFormat);
 		_renderTargets->initializeDefaultRenderTargets(_cams, _imgs, _proxies);
 	}
 
@@ -125,7 +139,12 @@ namespace sibr
 		if (_currentOpts.mesh) {
 			// load proxy
 			_proxies->loadFromData(_data);
-
+			if (_currentOpts.optimizeProxy && _proxies->hasProxy()) {
+				MeshOptimizer::optimize(*_proxies->proxyPtr());
+			}
+			if (_currentOpts.lodProxy) {
+				_proxies->buildLODProxy(LODMesh::cachePath(_data->meshPath()), LODMesh::Options());
+			}
 
 			std::vector<InputCamera::Ptr> inCams = _cams->inputCameras();
 			float eps = 0.1f;
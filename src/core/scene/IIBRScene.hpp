@@ -53,6 +53,9 @@ namespace sibr {
 			bool		images = true; ///< Load images?
 			bool		cameras = true; ///< Load cameras?
 			bool        texture = true; ///< Load texture ?
+			bool		optimizeProxy = false; ///< Reorder the proxy triangles and vertices for vertex cache efficiency?
+			bool		lodProxy = false; ///< Build (or load from cache) a clustered LOD version of the proxy, used by depth passes?
+			RGBDInputFormat inputRTFormat = RGBDInputFormat::RGBA32F; ///< Storage of the RGBD input rendertargets.
 		};
 
 		/**
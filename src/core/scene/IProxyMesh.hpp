@@ -15,6 +15,7 @@
 #include "core/scene/Config.hpp"
 #include "core/scene/IParseData.hpp"
 #include "core/graphics/Mesh.hpp"
+#include "core/graphics/LODMesh.hpp"
 
 namespace sibr {
 	/**
@@ -32,6 +33,27 @@ namespace sibr {
 		virtual const Mesh&											proxy(void) const = 0;
 		virtual const Mesh::Ptr										proxyPtr(void) const = 0;
 
+		/** Build the clustered level of detail version of the proxy, or load it from a cache file.
+		\param cachePath the cache file (rebuilt if invalid), or an empty string to build without caching
+		\param options LOD build options
+		*/
+		virtual void												buildLODProxy(const std::string & cachePath, const LODMesh::Options & options) = 0;
+		virtual bool												hasLODProxy(void) const = 0;
+		virtual const LODMesh&										lodProxy(void) const = 0;
+		virtual const LODMesh::Ptr									lodProxyPtr(void) const = 0;
+		/** Set the maximum screen space error (in pixels) used when rendering the LOD proxy. */
+		virtual void												lodPixelError(float error) = 0;
+		virtual float												lodPixelError(void) const = 0;
+
+		/** Render the proxy from a viewpoint, using the LOD proxy if available (clusters outside of the view are skipped),
+		or the full resolution proxy otherwise. The view-projection matrix should already be set by the caller.
+		\param eye the viewpoint
+		\param viewportHeight the viewport height in pixels
+		\param depthTest should depth testing be performed
+		\param backFaceCulling should culling be performed
+		*/
+		virtual void												renderForView(const Camera & eye, float viewportHeight, bool depthTest = true, bool backFaceCulling = true) const = 0;
+
 	protected:
 		IProxyMesh() {};
 
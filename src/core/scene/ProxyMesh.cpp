@@ -29,6 +29,7 @@ namespace sibr {
 
 	void ProxyMesh::replaceProxy(Mesh::Ptr newProxy)
 	{
+		_lodProxy.reset();
 		_proxy.reset(new Mesh());
 		_proxy->vertices(newProxy->vertices());
 		_proxy->normals(newProxy->normals());
@@ -47,9 +48,33 @@ namespace sibr {
 
 	void ProxyMesh::replaceProxyPtr(Mesh::Ptr newProxy)
 	{
+		_lodProxy.reset();
 		_proxy = newProxy;
 	}
 
+	void ProxyMesh::buildLODProxy(const std::string & cachePath, const LODMesh::Options & options)
+	{
+		if (!hasProxy()) {
+			SIBR_WRG << "Cannot build a LOD proxy without proxy." << std::endl;
+			return;
+		}
+		_lodProxy.reset(new LODMesh());
+		if (cachePath.empty()) {
+			_lodProxy->build(*_proxy, options);
+		} else {
+			_lodProxy->loadOrBuild(*_proxy, cachePath, options);
+		}
+	}
+
+	void ProxyMesh::renderForView(const Camera & eye, float viewportHeight, bool depthTest, bool backFaceCulling) const
+	{
+		if (hasLODProxy()) {
+			_lodProxy->render(eye, viewportHeight, _lodPixelError, depthTest, backFaceCulling);
+		} else {
+			_proxy->render(depthTest, backFaceCulling);
+		}
+	}
+
 
 }
 
@@ -32,9 +32,19 @@ namespace sibr {
 		const Mesh&											proxy(void) const;
 		const Mesh::Ptr										proxyPtr(void) const;
 
+		void												buildLODProxy(const std::string & cachePath, const LODMesh::Options & options) override;
+		bool												hasLODProxy(void) const override;
+		const LODMesh&										lodProxy(void) const override;
+		const LODMesh::Ptr									lodProxyPtr(void) const override;
+		void												lodPixelError(float error) override;
+		float												lodPixelError(void) const override;
+		void												renderForView(const Camera & eye, float viewportHeight, bool depthTest = true, bool backFaceCulling = true) const override;
+
 	protected:
 
 		Mesh::Ptr											_proxy;
+		LODMesh::Ptr										_lodProxy;
+		float												_lodPixelError = 1.0f;
 
 	};
 
@@ -53,4 +63,29 @@ namespace sibr {
 		return _proxy;
 	}
 
+	inline bool												ProxyMesh::hasLODProxy(void) const
+	{
+		return _lodProxy && _lodProxy->isValid();
+	}
+
+	inline const LODMesh&									ProxyMesh::lodProxy(void) const
+	{
+		return *_lodProxy;
+	}
+
+	inline const LODMesh::Ptr								ProxyMesh::lodProxyPtr(void) const
+	{
+		return _lodProxy;
+	}
+
+	inline void												ProxyMesh::lodPixelError(float error)
+	{
+		_lodPixelError = error;
+	}
+
+	inline float											ProxyMesh::lodPixelError(void) const
+	{
+		return _lodPixelError;
+	}
+
 };
\ No newline at end of file
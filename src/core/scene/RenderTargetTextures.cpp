@@ -11,6 +11,7 @@
 
 
 #include "RenderTargetTextures.hpp"
+#include "core/raycaster/InputDepthMaps.hpp"
 
 namespace sibr {
 
@@ -43,7 +44,7 @@ namespace sibr {
 		return _isInit;
 	}
 
-	const std::vector<RenderTargetRGBA32F::Ptr>& RGBDInputTextures::inputImagesRT() const
+	const std::vector<IRenderTarget::Ptr>& RGBDInputTextures::inputImagesRT() const
 	{
 		return _inputRGBARenderTextures;
 	}
@@ -64,15 +65,20 @@ namespace sibr {
 			loadFile(Resources::Instance()->getResourceFilePathName("texture.fp")));
 		uint interpFlag = (SIBR_SCENE_LINEAR_SAMPLING & SIBR_SCENE_LINEAR_SAMPLING) ? SIBR_GPU_LINEAR_SAMPLING : 0; // LINEAR_SAMPLING Set to default
 
+		// The images are uploaded as is, the first row at the bottom of the texture:
+		// flip the texture coordinates instead of copying and flipping each image.
+		GLfloat flippedCoords[] = { 0,1,  1,1,  1,0,  0,0 };
+
 		for (uint i = 0; i < imgs->inputImages().size(); i++) {
 			if (cams->inputCameras()[i]->isActive()) {
-				ImageRGB img = std::move(imgs->inputImages()[i]->clone());
-				img.flipH();
-
-				std::shared_ptr<Texture2DRGB> rawInputImage(new Texture2DRGB(img, interpFlag));
+				std::shared_ptr<Texture2DRGB> rawInputImage(new Texture2DRGB(*imgs->inputImages()[i], interpFlag));
 
 				glViewport(0, 0, _width, _height);
-				_inputRGBARenderTextures[i].reset(new RenderTargetRGBA32F(_width, _height, interpFlag));
+				if (_inputRTFormat == RGBDInputFormat::RGBA16) {
+					_inputRGBARenderTextures[i].reset(new RenderTargetRGBA16(_width, _height, interpFlag));
+				} else {
+					_inputRGBARenderTextures[i].reset(new RenderTargetRGBA32F(_width, _height, interpFlag));
+				}
 				_inputRGBARenderTextures[i]->clear();
 				_inputRGBARenderTextures[i]->bind();
 
@@ -81,7 +87,7 @@ namespace sibr {
 
 				glDisable(GL_DEPTH_TEST);
 				textureShader.begin();
-				RenderUtility::renderScreenQuad();
+				RenderUtility::renderScreenQuad(false, flippedCoords);
 				textureShader.end();
 				_inputRGBARenderTextures[i]->unbind();
 			}
@@ -121,7 +127,7 @@ namespace sibr {
 					depthShader.begin();
 					size.set((float)w, (float)h);
 					proj.set(cams->inputCameras()[i]->viewproj());
-					proxies->proxy().render(true, facecull);
+					proxies->renderForView(*cams->inputCameras()[i], float(h), true, facecull);
 
 					depthShader.end();
 				}
@@ -143,6 +149,14 @@ namespace sibr {
 			return;
 		}
 
+		if (!_depthCacheDirectory.empty()) {
+			InputDepthMaps depthMaps;
+			depthMaps.loadOrCompute(proxies->proxy(), cams->inputCameras(), _width, _height, InputDepthMaps::cachePath(_depthCacheDirectory, _width, _height));
+			// The CPU depth maps are stored top to bottom, unlike the rendertargets.
+			_inputDepthMapArrayPtr.reset(new Texture2DArrayLum32F(depthMaps.windowDepths(), _width, _height, flags | SIBR_FLIP_TEXTURE));
+			return;
+		}
+
 		SIBR_LOG << "Depth vertex shader location: " << Resources::Instance()->getResourceFilePathName("depthonly.vp") << std::endl;
 		SIBR_LOG << "Depth fragment shader location: " << Resources::Instance()->getResourceFilePathName("depthonly.fp") << std::endl;
 
@@ -172,7 +186,7 @@ namespace sibr {
 
 			depthOnlyShader.begin();
 			proj.set(cams->inputCameras()[i]->viewproj());
-			proxies->proxy().render(true, facecull);
+			proxies->renderForView(*cams->inputCameras()[i], float(_height), true, facecull);
 			depthOnlyShader.end();
 
 			depthRT.unbind();
@@ -186,6 +200,11 @@ namespace sibr {
 		CHECK_GL_ERROR;
 	}
 
+	void DepthInputTextureArray::cpuDepthMaps(const std::string & cacheDirectory)
+	{
+		_depthCacheDirectory = cacheDirectory;
+	}
+
 	const Texture2DArrayLum32F::Ptr & DepthInputTextureArray::getInputDepthMapArrayPtr() const
 	{
 		return _inputDepthMapArrayPtr;
@@ -197,7 +216,23 @@ namespace sibr {
 			initSize(imgs->inputImages()[_initActiveCam]->w(), imgs->inputImages()[_initActiveCam]->h());
 		}
 
-		_inputRGBArrayPtr.reset(new Texture2DArrayRGB(imgs->inputImages(), _width, _height, flags));
+		if (_compressionCache.empty()) {
+			_inputRGBArrayPtr.reset(new Texture2DArrayRGB(imgs->inputImages(), _width, _height, flags));
+			return;
+		}
+		BlockEncoder::Options options;
+		options.format = _compression;
+		options.flip = (flags & SIBR_FLIP_TEXTURE) != 0;
+		options.mipmaps = (flags & SIBR_GPU_AUTOGEN_MIPMAP) != 0;
+		const std::vector<CompressedImage> compressed = BlockEncoder::loadOrEncode(imgs->inputImages(), _width, _height, options, _compressionCache);
+		_inputRGBArrayPtr.reset(new Texture2DArrayRGB());
+		_inputRGBArrayPtr->createFromImages(compressed, flags);
+	}
+
+	void RGBInputTextureArray::compressedInputs(BlockFormat format, const std::string & cachePath)
+	{
+		_compression = format;
+		_compressionCache = cachePath;
 	}
 
 	const Texture2DArrayRGB::Ptr & RGBInputTextureArray::getInputRGBTextureArrayPtr() const
@@ -27,6 +27,14 @@
 
 namespace sibr{
 
+	/** Storage of the RGBD input rendertargets: color in RGB, window depth of the proxy in alpha.
+	\ingroup sibr_scene
+	*/
+	enum class RGBDInputFormat {
+		RGBA32F, ///< 32 bits floats, 16 bytes per pixel.
+		RGBA16 ///< 16 bits normalized, 8 bytes per pixel: 8 bits colors are exact, depth is quantized to 1/65535.
+	};
+
 	/** 
 	\ingroup sibr_scene
 	*/
@@ -39,6 +47,12 @@ namespace sibr{
 
 		bool isInit() const;
 
+		/** \return the width of the textures, valid once initialized. */
+		uint width() const { return _width; }
+
+		/** \return the height of the textures, valid once initialized. */
+		uint height() const { return _height; }
+
 	protected:
 		uint		_width = 0; //constrained width provided by the command line args, defaults to 0
 		uint		_height = 0; //associated height, computed in initSize
@@ -53,13 +67,22 @@ namespace sibr{
 	class SIBR_SCENE_EXPORT RGBDInputTextures : public virtual RTTextureSize {
 		SIBR_CLASS_PTR(RGBDInputTextures)
 	public:
-		const std::vector<RenderTargetRGBA32F::Ptr> & inputImagesRT() const;
+		const std::vector<IRenderTarget::Ptr> & inputImagesRT() const;
+
+		/** Set the storage of the rendertargets created by initializeImageRenderTargets.
+		\param format the rendertargets format
+		*/
+		void inputRTFormat(RGBDInputFormat format) { _inputRTFormat = format; }
+
+		/** \return the storage of the rendertargets. */
+		RGBDInputFormat inputRTFormat() const { return _inputRTFormat; }
 
 		virtual void initializeImageRenderTargets(ICalibratedCameras::Ptr cams, IInputImages::Ptr imgs);
 		virtual void initializeDepthRenderTargets(ICalibratedCameras::Ptr cams, IProxyMesh::Ptr proxies, bool facecull);
 
 	protected:
-		std::vector<RenderTargetRGBA32F::Ptr> _inputRGBARenderTextures;
+		std::vector<IRenderTarget::Ptr> _inputRGBARenderTextures;
+		RGBDInputFormat _inputRTFormat = RGBDInputFormat::RGBA32F;
 
 	};
 
@@ -72,8 +95,15 @@ namespace sibr{
 		virtual void initDepthTextureArrays(ICalibratedCameras::Ptr cams, IProxyMesh::Ptr proxies, bool facecull, int flags = SIBR_GPU_LINEAR_SAMPLING);
 		const Texture2DArrayLum32F::Ptr &  getInputDepthMapArrayPtr() const;
 
+		/** Raycast the depth maps created by initDepthTextureArrays on the CPU instead of rasterizing them, see InputDepthMaps.
+		 The depth maps are loaded from a cache file if it matches the proxy, cameras and resolution, else computed and saved to it.
+		\param cacheDirectory the directory of the cache file (see InputDepthMaps::cachePath)
+		*/
+		void cpuDepthMaps(const std::string & cacheDirectory);
+
 	protected:
 		Texture2DArrayLum32F::Ptr _inputDepthMapArrayPtr;
+		std::string _depthCacheDirectory; ///< CPU depth maps cache directory, empty if the depth maps are rasterized.
 
 	};
 	/**
@@ -87,8 +117,17 @@ namespace sibr{
 		virtual void initRGBTextureArrays(IInputImages::Ptr imgs, int flags = 0);
 		const Texture2DArrayRGB::Ptr & getInputRGBTextureArrayPtr() const;
 
+		/** Block compress the RGB texture array created by initRGBTextureArrays, 4 (BC7) or 8 (BC1) times smaller.
+		 The compressed images are loaded from a cache file if it matches the input images, else encoded and saved to it.
+		\param format the block format
+		\param cachePath the cache file (see BlockEncoder::cachePath)
+		*/
+		void compressedInputs(BlockFormat format, const std::string & cachePath);
+
 	protected:
 		Texture2DArrayRGB::Ptr _inputRGBArrayPtr;
+		BlockFormat _compression = BlockFormat::BC7; ///< Block format of the RGB texture array.
+		std::string _compressionCache; ///< Compressed images cache, empty if the array is not compressed.
 
 	};
 
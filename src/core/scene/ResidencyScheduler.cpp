@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "ResidencyScheduler.hpp"
+
+namespace sibr {
+
+	ResidencyScheduler::ResidencyScheduler(size_t viewsCount, size_t sliceBytes, const ResidencyOptions & options) :
+		_slots(slotsCount(viewsCount, sliceBytes, options)),
+		_viewSlots(viewsCount, -1),
+		_maxRequests(std::max(options.maxRequestsPerFrame, size_t(1)))
+	{
+	}
+
+	size_t ResidencyScheduler::slotsCount(size_t viewsCount, size_t sliceBytes, const ResidencyOptions & options)
+	{
+		size_t count = viewsCount;
+		if (options.maxResident > 0) {
+			count = std::min(count, options.maxResident);
+		}
+		if (options.byteBudget > 0 && sliceBytes > 0) {
+			count = std::min(count, options.byteBudget / sliceBytes);
+		}
+		return std::max(count, size_t(1));
+	}
+
+	const std::vector<ResidencyScheduler::Request> & ResidencyScheduler::update(const std::vector<uint> & wanted)
+	{
+		++_frame;
+		_requests.clear();
+		const size_t considered = std::min(wanted.size(), _slots.size());
+
+		// Protect the wanted views from eviction first.
+		for (size_t k = 0; k < considered; ++k) {
+			const uint view = wanted[k];
+			if (view >= _viewSlots.size()) {
+				continue;
+			}
+			const int slotId = _viewSlots[view];
+			if (slotId >= 0) {
+				_slots[slotId].lastUsed = _frame;
+			}
+			if (slotId >= 0 && _slots[slotId].state == SlotState::RESIDENT) {
+				++_stats.hits;
+			} else {
+				++_stats.misses;
+			}
+		}
+
+		// Then request the missing ones, most relevant first.
+		for (size_t k = 0; k < considered && _requests.size() < _maxRequests; ++k) {
+			const uint view = wanted[k];
+			if (view >= _viewSlots.size() || _viewSlots[view] >= 0) {
+				continue;
+			}
+			const int slotId = pickSlot();
+			if (slotId < 0) {
+				break;
+			}
+			Slot & slot = _slots[slotId];
+			if (slot.state == SlotState::RESIDENT) {
+				_viewSlots[slot.view] = -1;
+				++_stats.evictions;
+			}
+			slot.view = int(view);
+			slot.state = SlotState::LOADING;
+			slot.lastUsed = _frame;
+			_viewSlots[view] = slotId;
+			_requests.push_back({ view, uint(slotId) });
+			++_stats.requests;
+		}
+		return _requests;
+	}
+
+	void ResidencyScheduler::loaded(uint view)
+	{
+		if (view >= _viewSlots.size() || _viewSlots[view] < 0) {
+			return;
+		}
+		_slots[_viewSlots[view]].state = SlotState::RESIDENT;
+	}
+
+	void ResidencyScheduler::reset()
+	{
+		std::fill(_slots.begin(), _slots.end(), Slot());
+		std::fill(_viewSlots.begin(), _viewSlots.end(), -1);
+		_requests.clear();
+		_stats = Stats();
+	}
+
+	int ResidencyScheduler::slot(uint view) const
+	{
+		if (view >= _viewSlots.size() || _viewSlots[view] < 0) {
+			return -1;
+		}
+		const int slotId = _viewSlots[view];
+		return _slots[slotId].state == SlotState::RESIDENT ? slotId : -1;
+	}
+
+	bool ResidencyScheduler::loading(uint view) const
+	{
+		return view < _viewSlots.size() && _viewSlots[view] >= 0 && _slots[_viewSlots[view]].state == SlotState::LOADING;
+	}
+
+	size_t ResidencyScheduler::residentCount() const
+	{
+		size_t count = 0;
+		for (const Slot & slot : _slots) {
+			count += (slot.state == SlotState::RESIDENT) ? 1 : 0;
+		}
+		return count;
+	}
+
+	int ResidencyScheduler::pickSlot() const
+	{
+		int best = -1;
+		for (size_t s = 0; s < _slots.size(); ++s) {
+			const Slot & slot = _slots[s];
+			if (slot.state == SlotState::FREE) {
+				return int(s);
+			}
+			if (slot.state == SlotState::RESIDENT && slot.lastUsed < _frame && (best < 0 || slot.lastUsed < _slots[best].lastUsed)) {
+				best = int(s);
+			}
+		}
+		return best;
+	}
+
+}
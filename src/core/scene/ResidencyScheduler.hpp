@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+#include "core/scene/Config.hpp"
+#include "core/system/Config.hpp"
+
+namespace sibr {
+
+	/** Parameters of a ResidencyScheduler.
+	\ingroup sibr_scene
+	*/
+	struct SIBR_SCENE_EXPORT ResidencyOptions {
+		size_t byteBudget = 0; ///< Maximum size of the resident slices, 0 for no limit.
+		size_t maxResident = 0; ///< Maximum number of resident views, 0 for no limit.
+		size_t maxRequestsPerFrame = 2; ///< Maximum number of views streamed in per frame, bounds the per frame cost.
+	};
+
+	/** Residency policy of input views in a fixed number of GPU slots (texture array layers), without any OpenGL call.
+	 Each frame the views wanted for rendering are given by decreasing relevance: the missing ones are assigned a slot,
+	 free or holding the least recently used view, and requested. A requested view is loading until loaded() is
+	 called, then it is resident. Loading views and views wanted in the current frame are never evicted.
+	\sa ResidentInputTextures
+	\ingroup sibr_scene
+	*/
+	class SIBR_SCENE_EXPORT ResidencyScheduler {
+		SIBR_CLASS_PTR(ResidencyScheduler);
+
+	public:
+
+		/** A view to stream in a slot. */
+		struct Request {
+			uint view; ///< View index.
+			uint slot; ///< Destination slot.
+		};
+
+		/** Counters, since the creation or the last reset. */
+		struct Stats {
+			size_t hits = 0; ///< Wanted views that were resident.
+			size_t misses = 0; ///< Wanted views that were not resident.
+			size_t requests = 0; ///< Views requested.
+			size_t evictions = 0; ///< Resident views evicted.
+		};
+
+		/** Constructor.
+		\param viewsCount the number of views
+		\param sliceBytes the memory size of a resident view
+		\param options the residency parameters
+		*/
+		ResidencyScheduler(size_t viewsCount, size_t sliceBytes, const ResidencyOptions & options = {});
+
+		/** Number of slots allowed by a budget.
+		\param viewsCount the number of views
+		\param sliceBytes the memory size of a resident view
+		\param options the residency parameters
+		\return the number of slots, at least one
+		*/
+		static size_t slotsCount(size_t viewsCount, size_t sliceBytes, const ResidencyOptions & options);
+
+		/** \return the number of slots. */
+		size_t slotsCount() const { return _slots.size(); }
+
+		/** Start a new frame.
+		\param wanted the views to render, by decreasing relevance; only as many as there are slots are considered
+		\return the views to stream in, with their destination slot
+		*/
+		const std::vector<Request> & update(const std::vector<uint> & wanted);
+
+		/** Mark a requested view as resident, once its data is in its slot.
+		\param view the view index
+		*/
+		void loaded(uint view);
+
+		/** Evict all views, loading views included. */
+		void reset();
+
+		/** \return the slot of a resident view, -1 if it is not resident (or still loading).
+		\param view the view index
+		*/
+		int slot(uint view) const;
+
+		/** \return true if a view has been requested but is not loaded yet.
+		\param view the view index
+		*/
+		bool loading(uint view) const;
+
+		/** \return the number of resident views. */
+		size_t residentCount() const;
+
+		/** \return the requests of the last frame. */
+		const std::vector<Request> & requests() const { return _requests; }
+
+		/** \return the counters. */
+		const Stats & stats() const { return _stats; }
+
+	private:
+
+		/** State of a slot. */
+		enum class SlotState { FREE, LOADING, RESIDENT };
+
+		/** A slot. */
+		struct Slot {
+			int view = -1; ///< View in the slot.
+			SlotState state = SlotState::FREE; ///< Current state.
+			size_t lastUsed = 0; ///< Last frame the view was wanted.
+		};
+
+		/** \return a free slot if any, else the least recently used resident slot not wanted this frame, else -1. */
+		int pickSlot() const;
+
+		std::vector<Slot> _slots; ///< Slots.
+		std::vector<int> _viewSlots; ///< Slot of each view, -1 if none.
+		std::vector<Request> _requests; ///< Requests of the last frame.
+		size_t _maxRequests; ///< Maximum number of requests per frame.
+		size_t _frame = 0; ///< Current frame.
+		Stats _stats; ///< Counters.
+	};
+
+}
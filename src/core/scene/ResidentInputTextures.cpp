@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "ResidentInputTextures.hpp"
+
+namespace sibr {
+
+	ResidentInputTextures::ResidentInputTextures(ICalibratedCameras::Ptr cams, IInputImages::Ptr imgs, IProxyMesh::Ptr proxies,
+		const ResidencyOptions & options, uint width, int flags, bool faceCull) :
+		RTTextureSize(width), _cams(cams), _imgs(imgs), _proxies(proxies), _faceCull(faceCull)
+	{
+		const std::vector<InputCamera::Ptr> & inputCams = cams->inputCameras();
+		if (imgs->inputImages().size() < inputCams.size()) {
+			SIBR_ERR << "[ResidentInputTextures] The input images are not loaded." << std::endl;
+		}
+		// Same resolution as the other texture arrays: the one of the first active camera.
+		for (int i = 0; i < int(inputCams.size()); ++i) {
+			if (inputCams[i]->isActive()) {
+				_initActiveCam = i;
+				break;
+			}
+		}
+		initSize(inputCams[_initActiveCam]->w(), inputCams[_initActiveCam]->h());
+
+		// RGB8 and float depth, the mipmaps add a third.
+		size_t rgbBytes = size_t(_width) * size_t(_height) * 3;
+		if (flags & SIBR_GPU_AUTOGEN_MIPMAP) {
+			rgbBytes += rgbBytes / 3;
+		}
+		_sliceBytes = rgbBytes + size_t(_width) * size_t(_height) * sizeof(float);
+
+		_scheduler.reset(new ResidencyScheduler(inputCams.size(), _sliceBytes, options));
+		const uint slots = uint(_scheduler->slotsCount());
+		SIBR_LOG << "[ResidentInputTextures] " << slots << " resident views out of " << inputCams.size()
+			<< ", " << (slots * _sliceBytes) / (1024 * 1024) << "MB." << std::endl;
+
+		_inputRGBArrayPtr.reset(new Texture2DArrayRGB(_width, _height, slots, flags));
+		_inputDepthMapArrayPtr.reset(new Texture2DArrayLum32F(_width, _height, slots, SIBR_GPU_LINEAR_SAMPLING));
+
+		if (!proxies->hasProxy()) {
+			SIBR_WRG << "[ResidentInputTextures] No proxy, the depth maps will stay empty." << std::endl;
+		}
+		_depthShader.init("DepthOnly",
+			loadFile(Resources::Instance()->getResourceFilePathName("depthonly.vp")),
+			loadFile(Resources::Instance()->getResourceFilePathName("depthonly.fp")));
+		_depthProj.init(_depthShader, "proj");
+		_depthRT.reset(new RenderTargetLum32F(_width, _height));
+
+		_loader = std::thread(&ResidentInputTextures::loaderLoop, this);
+	}
+
+	ResidentInputTextures::~ResidentInputTextures()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+		_requestReady.notify_all();
+		_loader.join();
+	}
+
+	void ResidentInputTextures::update(const std::vector<uint> & wanted)
+	{
+		// Upload the views prepared since the last frame, they are resident from now on.
+		std::deque<LoadedView> loaded;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			loaded.swap(_loaded);
+		}
+		for (const LoadedView & view : loaded) {
+			_inputRGBArrayPtr->updateSlice(view.image, view.slot);
+			renderDepth(view.view, view.slot);
+			_scheduler->loaded(view.view);
+		}
+
+		const std::vector<ResidencyScheduler::Request> & requests = _scheduler->update(wanted);
+		if (requests.empty()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_pending.insert(_pending.end(), requests.begin(), requests.end());
+		}
+		_requestReady.notify_one();
+	}
+
+	void ResidentInputTextures::loaderLoop()
+	{
+		while (true) {
+			ResidencyScheduler::Request request;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_requestReady.wait(lock, [this]() { return _stop || !_pending.empty(); });
+				if (_stop) {
+					return;
+				}
+				request = _pending.front();
+				_pending.pop_front();
+			}
+
+			const ImageRGB & input = *_imgs->inputImages()[request.view];
+			LoadedView view;
+			view.view = request.view;
+			view.slot = request.slot;
+			if (input.w() == _width && input.h() == _height) {
+				view.image = input.clone();
+			} else {
+				view.image = input.resized(int(_width), int(_height));
+			}
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			_loaded.push_back(std::move(view));
+		}
+	}
+
+	void ResidentInputTextures::renderDepth(uint view, uint slot)
+	{
+		if (!_proxies->hasProxy()) {
+			return;
+		}
+		// Same as DepthInputTextureArray::initDepthTextureArrays, for a single slice.
+		const InputCamera & cam = *_cams->inputCameras()[view];
+		glViewport(0, 0, _width, _height);
+
+		_depthRT->bind();
+		glEnable(GL_DEPTH_TEST);
+		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+		glDepthMask(GL_TRUE);
+
+		_depthShader.begin();
+		_depthProj.set(cam.viewproj());
+		_proxies->renderForView(cam, float(_height), true, _faceCull);
+		_depthShader.end();
+
+		_depthRT->unbind();
+
+		glCopyImageSubData(
+			_depthRT->handle(), GL_TEXTURE_2D, 0, 0, 0, 0,
+			_inputDepthMapArrayPtr->handle(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, slot,
+			_width, _height, 1);
+		CHECK_GL_ERROR;
+	}
+
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+#include "core/scene/RenderTargetTextures.hpp"
+#include "core/scene/ResidencyScheduler.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace sibr {
+
+	/** Input RGB images and depth maps texture arrays holding only a bounded number of views, instead of one
+	 slice per input camera as RGBInputTextureArray and DepthInputTextureArray.
+	 Each frame the renderer gives the views it needs (see update()), the ResidencyScheduler decides which ones
+	 are streamed in and which least recently used ones are evicted. Requested images are resized on a background
+	 thread, the render thread only uploads them and renders their depth maps. A view can be sampled once slot()
+	 returns a valid layer index.
+	\ingroup sibr_scene
+	*/
+	class SIBR_SCENE_EXPORT ResidentInputTextures : public virtual RTTextureSize {
+		SIBR_CLASS_PTR(ResidentInputTextures);
+
+	public:
+
+		/** Constructor, allocates the texture arrays, no view is resident.
+		\param cams the input cameras
+		\param imgs the input images, kept in memory
+		\param proxies the proxy, used for the depth maps
+		\param options the residency parameters
+		\param width the constrained width of the slices (0 for the input images width)
+		\param flags the RGB texture array flags
+		\param faceCull should backfaces be culled when rendering the depth maps
+		*/
+		ResidentInputTextures(ICalibratedCameras::Ptr cams, IInputImages::Ptr imgs, IProxyMesh::Ptr proxies,
+			const ResidencyOptions & options, uint width = 0, int flags = 0, bool faceCull = true);
+
+		/** Destructor, stops the loading thread. */
+		~ResidentInputTextures();
+
+		/** Upload the views loaded since the last call, then request the missing ones.
+		\param wanted the views to render, by decreasing relevance
+		*/
+		void update(const std::vector<uint> & wanted);
+
+		/** \return the layer of a resident view, -1 if it is not resident yet.
+		\param view the view index
+		*/
+		int slot(uint view) const { return _scheduler->slot(view); }
+
+		/** \return the RGB texture array. */
+		const Texture2DArrayRGB::Ptr & getInputRGBTextureArrayPtr() const { return _inputRGBArrayPtr; }
+
+		/** \return the depth texture array. */
+		const Texture2DArrayLum32F::Ptr & getInputDepthMapArrayPtr() const { return _inputDepthMapArrayPtr; }
+
+		/** \return the residency policy. */
+		const ResidencyScheduler & scheduler() const { return *_scheduler; }
+
+		/** \return the memory size of a slot, in bytes. */
+		size_t sliceBytes() const { return _sliceBytes; }
+
+	private:
+
+		/** A view prepared by the loading thread. */
+		struct LoadedView {
+			uint view; ///< View index.
+			uint slot; ///< Destination slot.
+			ImageRGB image; ///< Image at the slices resolution.
+		};
+
+		/** Loading thread loop: resize the requested images. */
+		void loaderLoop();
+
+		/** Render the depth map of a view in a slot.
+		\param view the view index
+		\param slot the slot
+		*/
+		void renderDepth(uint view, uint slot);
+
+		ICalibratedCameras::Ptr _cams; ///< Input cameras.
+		IInputImages::Ptr _imgs; ///< Input images.
+		IProxyMesh::Ptr _proxies; ///< Proxy.
+		bool _faceCull = true; ///< Backface culling for the depth maps.
+		size_t _sliceBytes = 0; ///< Memory size of a slot.
+
+		ResidencyScheduler::UPtr _scheduler; ///< Residency policy.
+		Texture2DArrayRGB::Ptr _inputRGBArrayPtr; ///< Resident images.
+		Texture2DArrayLum32F::Ptr _inputDepthMapArrayPtr; ///< Resident depth maps.
+		RenderTargetLum32F::UPtr _depthRT; ///< Depth maps rendering.
+		GLShader _depthShader; ///< Depth maps shader.
+		GLParameter _depthProj; ///< Depth maps view projection uniform.
+
+		std::deque<ResidencyScheduler::Request> _pending; ///< Requests waiting for the loading thread.
+		std::deque<LoadedView> _loaded; ///< Views waiting for upload.
+		std::mutex _mutex; ///< Protects both queues and the flag below.
+		std::condition_variable _requestReady; ///< Signaled when a request is queued or on destruction.
+		bool _stop = false; ///< Stop the loading thread.
+		std::thread _loader; ///< Loading thread.
+	};
+
+}
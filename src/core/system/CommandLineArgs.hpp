@@ -356,6 +356,7 @@ namespace sibr
 		Arg<bool> noExit = {"noExit", "dont exit after rendering path "};
 		Arg<std::string> pathFile = { "pathFile", "", "filename of path to render offline; app renders path and exits" }; // app needs to handle this; if it does default behavior is to render the path and exit
 		Arg<std::string> outPath = { "outPath", "pathOutput", "Path of directory to store path output default relative the input path directory " }; // app needs to handle this; if it does default behavior is to render the path and exit
+		Arg<std::string> pathVideo = { "pathVideo", "", "encode the offline path to this video file instead of saving images" };
 
 	};
 
@@ -370,6 +371,7 @@ namespace sibr
 		Arg<bool> no_gui = { "nogui", "do not use ImGui" };
 		Arg<bool> gl_debug = { "gldebug", "enable OpenGL error callback" };
 		Arg<bool> offscreen = { "offscreen", "do not open window" };
+		Arg<std::string> shader_cache = { "shader-cache", "", "directory where linked GPU programs are stored, to skip shader compilation in later runs" };
 	};
 
 	/// Combination of window and application arguments.
@@ -384,10 +386,17 @@ namespace sibr
 		Arg<std::string> scene_metadata_filename = { "scene", "scene_metadata.txt", "scene metadata file" };
 		Arg<Vector2i> rendering_size = { "rendering-size", { 0, 0 }, "size at which rendering is performed" };
 		Arg<int> texture_width = { "texture-width", 0 , "size of the input data in memory"};
+		Arg<int> texture_budget = { "texture-budget", 0, "GPU memory budget for the input images and depth maps in MB, only the most relevant ones are streamed in (0 to load all of them)" };
+		Arg<std::string> texture_compression = { "texture-compression", "", "upload the input images block compressed (bc1 or bc7), encoded once on the CPU and cached in the dataset directory" };
+		Arg<bool> cpu_depth = { "cpu-depth", "raycast the input depth maps on the CPU instead of rasterizing them, cached in the dataset directory" };
 		Arg<float> texture_ratio = { "texture-ratio", 1.0f };
 		Arg<int> rendering_mode = { "rendering-mode", RENDERMODE_MONO, "select mono (0) or stereo (1) rendering mode" };
 		Arg<sibr::Vector3f> focal_pt = { "focal-pt", {0.0f, 0.0f, 0.0f} };
 		Arg<Switch> colmap_fovXfovY_flag = { "colmap_fovXfovY_flag", false };
+		Arg<bool> optimize_proxy = { "optimize-proxy", "reorder the proxy triangles and vertices for GPU vertex cache efficiency" };
+		Arg<bool> lod_proxy = { "lod-proxy", "render the proxy depth with a clustered level of detail (cached next to the mesh)" };
+		Arg<float> lod_pixel_error = { "lod-pixel-error", 1.0f, "maximum screen space error of the level of detail proxy, in pixels" };
+		Arg<bool> input_rt_16 = { "input-rt-16", "store the RGBD input rendertargets on 16 bits per channel instead of 32 bits floats" };
 	};
 
 	/// Dataset related arguments.
@@ -13,6 +13,9 @@
 #pragma once
 
 # include <vector>
+# include <cstdint>
+# include <istream>
+# include <ostream>
 # include "core/system/Config.hpp"
 # include "core/system/String.hpp"
 
@@ -153,6 +156,58 @@ namespace sibr
 		std::cout << s << " : " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
 	};
 
+	/** Write raw values to a binary stream.
+	 *\param stream the destination stream
+	 *\param data the values to write
+	 *\param count the number of values
+	 */
+	template<typename T>
+	void writeRaw(std::ostream & stream, const T * data, size_t count) {
+		stream.write(reinterpret_cast<const char*>(data), std::streamsize(sizeof(T) * count));
+	}
+
+	/** Read raw values from a binary stream.
+	 *\param stream the source stream
+	 *\param data will contain the values read
+	 *\param count the number of values
+	 *\return true if all values were read
+	 */
+	template<typename T>
+	bool readRaw(std::istream & stream, T * data, size_t count) {
+		stream.read(reinterpret_cast<char*>(data), std::streamsize(sizeof(T) * count));
+		return bool(stream);
+	}
+
+	/** Initial value of a FNV-1a hash, used for on-disk cache signatures. */
+	static const uint64_t fnv1aSeed = 14695981039346656037ull;
+
+	/** Update a FNV-1a hash with raw bytes.
+	 *\param hash the current hash, fnv1aSeed to start a new one
+	 *\param data the bytes to hash
+	 *\param count the number of bytes
+	 *\return the updated hash
+	 */
+	inline uint64_t hashBytes(uint64_t hash, const void * data, size_t count) {
+		const unsigned char * bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < count; ++i) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	/** Update a FNV-1a hash one 32-bit word at a time, faster than hashBytes on large geometry or image buffers.
+	 *\param hash the current hash, fnv1aSeed to start a new one
+	 *\param words the words to hash
+	 *\param count the number of words
+	 *\return the updated hash
+	 */
+	inline uint64_t hashWords(uint64_t hash, const uint32_t * words, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			hash = (hash ^ words[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
 
 	/*** @} */
 } // namespace sibr
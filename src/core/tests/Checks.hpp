@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include <cstdlib>
+# include <iostream>
+
+/** Check a condition in a headless test executable: failures are logged and counted,
+ and the executable keeps running. main should return sibr::checks::result().
+\ingroup sibr_system
+*/
+# define SIBR_CHECK(condition) sibr::checks::check((condition), #condition, __FILE__, __LINE__)
+
+namespace sibr
+{
+	namespace checks
+	{
+		/** \return the number of failed checks so far. */
+		inline int & failures()
+		{
+			static int count = 0;
+			return count;
+		}
+
+		/** Log and count a failed check.
+		\param condition the checked value
+		\param expression the checked expression, for the log
+		\param file the source file of the check
+		\param line the source line of the check
+		\return the condition
+		*/
+		inline bool check(bool condition, const char * expression, const char * file, int line)
+		{
+			if (!condition) {
+				std::cerr << "[CHECK] " << file << ":" << line << ": " << expression << " failed." << std::endl;
+				++failures();
+			}
+			return condition;
+		}
+
+		/** \return the exit code of a test executable, after a summary. */
+		inline int result()
+		{
+			if (failures() > 0) {
+				std::cerr << "[CHECK] " << failures() << " check(s) failed." << std::endl;
+				return EXIT_FAILURE;
+			}
+			std::cout << "[CHECK] All checks passed." << std::endl;
+			return EXIT_SUCCESS;
+		}
+	}
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <core/system/Config.hpp>
+#include <core/video/FrameStreamRecorder.hpp>
+#include "../Checks.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+using namespace sibr;
+
+/* Check the ordering and back-pressure of FrameStreamRecorder without any GL context:
+ the readbacks come from a mock with a controllable latency, and the consumer can be held. */
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	/** Readback source whose requests are available a fixed time after being made.
+	 Each frame is a 1x1 image containing the request index. */
+	class MockReadback : public IAsyncReadback
+	{
+	public:
+		typedef std::shared_ptr<MockReadback> Ptr;
+
+		/** Constructor.
+		\param capacity the maximum number of pending requests
+		\param latency the time before a request is available
+		*/
+		MockReadback(size_t capacity, std::chrono::milliseconds latency) : _capacity(capacity), _latency(latency) {}
+
+		void request(void) override {
+			if (full()) {
+				++misuses;
+				return;
+			}
+			_pending.push_back({ requested++, Clock::now() + _latency });
+			maxPending = std::max(maxPending, _pending.size());
+		}
+
+		bool retrieve(cv::Mat & frame, bool wait) override {
+			if (_pending.empty()) {
+				return false;
+			}
+			const Request & oldest = _pending.front();
+			if (Clock::now() < oldest.ready) {
+				if (!wait) {
+					return false;
+				}
+				std::this_thread::sleep_until(oldest.ready);
+			}
+			frame = cv::Mat(1, 1, CV_32SC1, cv::Scalar(oldest.index));
+			_pending.pop_front();
+			return true;
+		}
+
+		size_t pending(void) const override { return _pending.size(); }
+
+		size_t capacity(void) const override { return _capacity; }
+
+		int requested = 0; ///< Number of requests.
+		size_t maxPending = 0; ///< Highest number of pending requests.
+		int misuses = 0; ///< Requests made while full.
+
+	private:
+
+		/** A pending request. */
+		struct Request {
+			int index; ///< Request index.
+			Clock::time_point ready; ///< Time at which it is available.
+		};
+
+		size_t _capacity; ///< Maximum number of pending requests.
+		std::chrono::milliseconds _latency; ///< Time before a request is available.
+		std::deque<Request> _pending; ///< Pending requests, oldest first.
+	};
+
+	/** Consumer recording the frames indices, that can be held until released. */
+	struct GatedSink {
+		std::mutex mutex; ///< Protects the members below.
+		std::condition_variable released; ///< Signaled when the gate opens.
+		bool open = true; ///< Frames are consumed only when open.
+		std::vector<int> frames; ///< Consumed frames indices.
+
+		/** Close or open the gate.
+		\param state true to let the frames through
+		*/
+		void setOpen(bool state) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				open = state;
+			}
+			released.notify_all();
+		}
+
+		/** \return the sink for a recorder. */
+		FrameStreamRecorder::FrameSink sink() {
+			return [this](const cv::Mat & frame) {
+				std::unique_lock<std::mutex> lock(mutex);
+				released.wait(lock, [this]() { return open; });
+				frames.push_back(frame.at<int>(0, 0));
+				return frames.back() % 5 != 4;
+			};
+		}
+
+		/** \return true if the consumed frames are in increasing order. */
+		bool ordered() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return std::is_sorted(frames.begin(), frames.end()) && std::adjacent_find(frames.begin(), frames.end()) == frames.end();
+		}
+	};
+
+	const int framesCount = 20;
+
+	/** All frames reach the consumer in order, failures are counted. */
+	void checkOrder()
+	{
+		MockReadback::Ptr readback(new MockReadback(3, std::chrono::milliseconds(2)));
+		GatedSink sink;
+		FrameStreamRecorder recorder(readback, sink.sink());
+		for (int f = 0; f < framesCount; ++f) {
+			recorder.capture();
+		}
+		recorder.finish();
+		recorder.capture();
+
+		const FrameStreamStats stats = recorder.stats();
+		SIBR_CHECK(recorder.finished() && readback->pending() == 0);
+		SIBR_CHECK(readback->requested == framesCount && stats.requested == size_t(framesCount));
+		SIBR_CHECK(sink.frames.size() == size_t(framesCount) && sink.ordered());
+		SIBR_CHECK(stats.written + stats.failed == size_t(framesCount) && stats.failed == size_t(framesCount / 5));
+		SIBR_CHECK(stats.dropped == 0);
+	}
+
+	/** A full readback ring makes the render loop wait for the oldest request, never request more. */
+	void checkReadbackPressure()
+	{
+		MockReadback::Ptr readback(new MockReadback(2, std::chrono::milliseconds(10)));
+		GatedSink sink;
+		FrameStreamRecorder recorder(readback, sink.sink());
+		for (int f = 0; f < 6; ++f) {
+			recorder.capture();
+		}
+		recorder.finish();
+
+		SIBR_CHECK(readback->misuses == 0 && readback->maxPending == 2);
+		SIBR_CHECK(recorder.stats().readbackWait > 0.0);
+		SIBR_CHECK(sink.frames.size() == 6 && sink.ordered());
+	}
+
+	/** Without dropping, a full queue blocks the render loop until the consumer catches up. */
+	void checkQueueBlocks()
+	{
+		MockReadback::Ptr readback(new MockReadback(3, std::chrono::milliseconds(0)));
+		GatedSink sink;
+		sink.setOpen(false);
+		FrameStreamOptions options;
+		options.queueSize = 2;
+		options.dropWhenFull = false;
+		FrameStreamRecorder recorder(readback, sink.sink(), options);
+
+		std::atomic<int> captured(0);
+		std::thread renderLoop([&]() {
+			for (int f = 0; f < framesCount; ++f) {
+				recorder.capture();
+				++captured;
+			}
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		// One frame held by the consumer, a full queue, and the render loop stuck on the next one.
+		SIBR_CHECK(captured < framesCount);
+		SIBR_CHECK(recorder.queued() == options.queueSize);
+
+		sink.setOpen(true);
+		renderLoop.join();
+		recorder.finish();
+
+		const FrameStreamStats stats = recorder.stats();
+		SIBR_CHECK(readback->misuses == 0);
+		SIBR_CHECK(stats.dropped == 0 && stats.queueWait > 0.0);
+		SIBR_CHECK(sink.frames.size() == size_t(framesCount) && sink.ordered());
+	}
+
+	/** When dropping, a full queue never blocks the render loop, and the kept frames stay in order. */
+	void checkQueueDrops()
+	{
+		MockReadback::Ptr readback(new MockReadback(3, std::chrono::milliseconds(0)));
+		GatedSink sink;
+		sink.setOpen(false);
+		FrameStreamOptions options;
+		options.queueSize = 2;
+		options.dropWhenFull = true;
+		FrameStreamRecorder recorder(readback, sink.sink(), options);
+
+		for (int f = 0; f < framesCount; ++f) {
+			recorder.capture();
+		}
+		// At most one frame held by the consumer and a full queue, the last frame is still pending.
+		SIBR_CHECK(recorder.queued() <= options.queueSize);
+		SIBR_CHECK(recorder.stats().dropped >= framesCount - 2 - options.queueSize && recorder.stats().queueWait == 0.0);
+
+		sink.setOpen(true);
+		recorder.finish();
+
+		const FrameStreamStats stats = recorder.stats();
+		SIBR_CHECK(readback->misuses == 0);
+		SIBR_CHECK(stats.written + stats.failed + stats.dropped == size_t(framesCount));
+		SIBR_CHECK(sink.frames.size() == stats.written + stats.failed && sink.ordered());
+	}
+}
+
+int main(int ac, char ** av)
+{
+	checkOrder();
+	checkReadbackPressure();
+	checkQueueBlocks();
+	checkQueueDrops();
+	return checks::result();
+}
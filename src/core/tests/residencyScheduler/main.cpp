@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <core/system/Config.hpp>
+#include <core/scene/ResidencyScheduler.hpp>
+#include "../Checks.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <set>
+
+using namespace sibr;
+
+/* Replay a scripted camera path against a ResidencyScheduler with a byte budget,
+ without any GL context: the views are on a circle, the wanted views are the closest
+ ones to the current camera, and requested views are loaded one frame later. */
+
+namespace
+{
+	const size_t viewsCount = 24;
+	const size_t wantedCount = 6;
+	const size_t sliceBytes = 1920 * 1080 * 4;
+
+	/** \return the angular distance between two angles in degrees. */
+	float angleDistance(float a, float b)
+	{
+		const float d = std::fmod(std::abs(a - b), 360.0f);
+		return std::min(d, 360.0f - d);
+	}
+
+	/** \return the views closest to a camera at a given angle, by decreasing relevance. */
+	std::vector<uint> wantedViews(float cameraAngle)
+	{
+		std::vector<uint> views(viewsCount);
+		std::iota(views.begin(), views.end(), 0);
+		const float spacing = 360.0f / float(viewsCount);
+		std::stable_sort(views.begin(), views.end(), [&](uint a, uint b) {
+			return angleDistance(a * spacing, cameraAngle) < angleDistance(b * spacing, cameraAngle);
+		});
+		views.resize(wantedCount);
+		return views;
+	}
+
+	/** Budget and slot count. */
+	void checkSlotsCount()
+	{
+		ResidencyOptions options;
+		SIBR_CHECK(ResidencyScheduler::slotsCount(viewsCount, sliceBytes, options) == viewsCount);
+		options.byteBudget = 8 * sliceBytes + sliceBytes / 2;
+		SIBR_CHECK(ResidencyScheduler::slotsCount(viewsCount, sliceBytes, options) == 8);
+		options.maxResident = 5;
+		SIBR_CHECK(ResidencyScheduler::slotsCount(viewsCount, sliceBytes, options) == 5);
+		options.maxResident = 0;
+		options.byteBudget = sliceBytes / 2;
+		SIBR_CHECK(ResidencyScheduler::slotsCount(viewsCount, sliceBytes, options) == 1);
+	}
+
+	/** Least recently used eviction, and no eviction of loading views. */
+	void checkEviction()
+	{
+		ResidencyOptions options;
+		options.byteBudget = 3 * sliceBytes;
+		ResidencyScheduler scheduler(viewsCount, sliceBytes, options);
+		SIBR_CHECK(scheduler.slotsCount() == 3);
+
+		for (uint view = 0; view < 3; ++view) {
+			SIBR_CHECK(scheduler.update({ view }).size() == 1);
+			scheduler.loaded(view);
+		}
+		// Use view 0 again, view 1 becomes the least recently used.
+		SIBR_CHECK(scheduler.update({ 0 }).empty());
+		const int slot1 = scheduler.slot(1);
+		const std::vector<ResidencyScheduler::Request> requests = scheduler.update({ 3 });
+		SIBR_CHECK(requests.size() == 1 && int(requests[0].slot) == slot1);
+		SIBR_CHECK(scheduler.slot(1) < 0 && scheduler.loading(3));
+		SIBR_CHECK(scheduler.slot(0) >= 0 && scheduler.slot(2) >= 0);
+		SIBR_CHECK(scheduler.stats().evictions == 1);
+
+		// The loading view can't be evicted, view 2 is.
+		SIBR_CHECK(scheduler.update({ 4 }).size() == 1);
+		SIBR_CHECK(scheduler.slot(2) < 0 && scheduler.loading(3) && scheduler.loading(4));
+		// Only view 0 is evictable, and it is wanted: nothing is requested.
+		SIBR_CHECK(scheduler.update({ 0, 5 }).empty());
+		SIBR_CHECK(scheduler.slot(0) >= 0);
+	}
+
+	/** Scripted camera path: turn around the views, stop, then turn back. */
+	void checkCameraPath()
+	{
+		ResidencyOptions options;
+		options.byteBudget = 8 * sliceBytes + sliceBytes / 2;
+		options.maxRequestsPerFrame = 2;
+		ResidencyScheduler scheduler(viewsCount, sliceBytes, options);
+
+		std::vector<float> path;
+		for (int f = 0; f < 180; ++f) {
+			path.push_back(2.0f * float(f));
+		}
+		path.insert(path.end(), 20, path.back());
+		for (int f = 0; f < 90; ++f) {
+			path.push_back(path.back() - 3.0f);
+		}
+		path.insert(path.end(), 20, path.back());
+
+		std::vector<ResidencyScheduler::Request> pending;
+		for (size_t f = 0; f < path.size(); ++f) {
+			// Previous frame requests are now uploaded.
+			for (const ResidencyScheduler::Request & request : pending) {
+				scheduler.loaded(request.view);
+			}
+
+			const std::vector<uint> wanted = wantedViews(path[f]);
+			std::vector<int> wantedSlots;
+			for (uint view : wanted) {
+				wantedSlots.push_back(scheduler.slot(view));
+			}
+
+			pending = scheduler.update(wanted);
+
+			// Bounded per frame cost, distinct destination slots.
+			SIBR_CHECK(pending.size() <= options.maxRequestsPerFrame);
+			std::set<uint> slots;
+			for (const ResidencyScheduler::Request & request : pending) {
+				SIBR_CHECK(request.slot < scheduler.slotsCount());
+				SIBR_CHECK(slots.insert(request.slot).second);
+				SIBR_CHECK(scheduler.loading(request.view));
+			}
+
+			// Wanted resident views stay where they are.
+			for (size_t k = 0; k < wanted.size(); ++k) {
+				SIBR_CHECK(wantedSlots[k] < 0 || scheduler.slot(wanted[k]) == wantedSlots[k]);
+			}
+
+			// Budget cap: resident and loading views fit in the budget.
+			size_t used = 0;
+			for (uint view = 0; view < viewsCount; ++view) {
+				used += (scheduler.slot(view) >= 0 || scheduler.loading(view)) ? 1 : 0;
+			}
+			SIBR_CHECK(used <= scheduler.slotsCount());
+			SIBR_CHECK(used * sliceBytes <= options.byteBudget);
+			SIBR_CHECK(scheduler.residentCount() <= scheduler.slotsCount());
+
+			// A few frames after the camera stops, all wanted views are resident.
+			const bool still = f >= 4 && path[f] == path[f - 4];
+			if (still) {
+				SIBR_CHECK(pending.empty());
+				for (uint view : wanted) {
+					SIBR_CHECK(scheduler.slot(view) >= 0);
+				}
+			}
+		}
+
+		const ResidencyScheduler::Stats & stats = scheduler.stats();
+		SIBR_CHECK(stats.hits + stats.misses == path.size() * wantedCount);
+		SIBR_CHECK(stats.requests >= viewsCount && stats.evictions > 0);
+		SIBR_CHECK(stats.requests - stats.evictions <= scheduler.slotsCount());
+
+		scheduler.reset();
+		SIBR_CHECK(scheduler.residentCount() == 0 && scheduler.stats().requests == 0);
+	}
+}
+
+int main(int ac, char ** av)
+{
+	checkSlotsCount();
+	checkEviction();
+	checkCameraPath();
+	return checks::result();
+}
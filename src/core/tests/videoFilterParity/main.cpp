@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <core/system/Config.hpp>
+#include <core/video/VolumeFilter.hpp>
+#include <core/video/VideoUtils.hpp>
+#include "../Checks.hpp"
+
+using namespace sibr;
+
+/* Compare the temporal filter engine (VolumeFilter) with the OpenCV loops it replaced,
+ on random volumes. Frames are 37x11 RGB so that each row spans several filter chunks. */
+
+namespace
+{
+	const int frameW = 37;
+	const int frameH = 11;
+
+	/** \return a random volume of l frames, one frame per row. */
+	cv::Mat randomVolume(int l, int depth, int w = frameW, int h = frameH)
+	{
+		cv::Mat volume(l, w * h * 3, depth);
+		if (depth == CV_8U) {
+			cv::randu(volume, 0, 256);
+		} else {
+			cv::randu(volume, -1.0f, 1.0f);
+		}
+		return volume;
+	}
+
+	/** \return true if both volumes have the same number of values and depth, and differ by at most tolerance. */
+	bool sameVolume(const cv::Mat & a, const cv::Mat & b, double tolerance)
+	{
+		if (a.depth() != b.depth() || a.total() * a.channels() != b.total() * b.channels()) {
+			return false;
+		}
+		return cv::norm(a.reshape(1, 1), b.reshape(1, 1), cv::NORM_INF) <= tolerance;
+	}
+
+	/** Old temporal blur: 5x1 binomial filter2D over the volume, reflect-101 border. */
+	cv::Mat referenceTemporalBlur(const cv::Mat & volume, float scaling)
+	{
+		const cv::Mat kernel = (scaling / 16.0f)*(cv::Mat_<float>(5, 1) << 1, 4, 6, 4, 1);
+		cv::Mat out;
+		cv::filter2D(volume, out, -1, kernel, { -1,-1 }, 0.0, cv::BORDER_DEFAULT);
+		return out;
+	}
+
+	/** Old temporalBlurBoundaryConditions: naive loop with constant values outside of the volume. */
+	cv::Mat referenceBoundaryBlur(const cv::Mat & volume, float scaling, double left, double right)
+	{
+		const float weights[5] = { 1, 4, 6, 4, 1 };
+		cv::Mat out(volume.size(), volume.type());
+		const int l = volume.rows;
+		for (int x = 0; x < volume.cols; ++x) {
+			for (int t = 0; t < l; ++t) {
+				double res = 0;
+				for (int dt = -2; dt <= 2; ++dt) {
+					const int u = t + dt;
+					const double val = u < 0 ? left : (u >= l ? right : double(volume.at<uchar>(u, x)));
+					res += (scaling / 16.0f) * weights[2 + dt] * val;
+				}
+				out.at<uchar>(t, x) = cv::saturate_cast<uchar>(res);
+			}
+		}
+		return out;
+	}
+
+	/** Old extendedTemporalBlur: 25 frames box filter, replicated border. */
+	cv::Mat referenceExtendedBlur(const cv::Mat & volume)
+	{
+		cv::Mat out;
+		cv::boxFilter(volume, out, -1, cv::Size(1, 25), cv::Point(-1, -1), true, cv::BORDER_REPLICATE);
+		return out;
+	}
+
+	/** Old decimate: pyrDown of the even frames. */
+	cv::Mat referenceDecimate(const cv::Mat & volume, int w, int h)
+	{
+		const int dw = (w + 1) / 2, dh = (h + 1) / 2;
+		cv::Mat out((volume.rows + 1) / 2, 3 * dw * dh, CV_32FC1);
+		for (int t = 0; t < out.rows; ++t) {
+			cv::Mat sliceDecimated = out.row(t).reshape(3, dh);
+			cv::pyrDown(volume.row(2 * t).reshape(3, h), sliceDecimated);
+		}
+		return out;
+	}
+
+	/** Old downscale: temporal blur of all frames, then pyrDown of the even ones. */
+	cv::Mat referenceDownscale(const cv::Mat & volume, int w, int h)
+	{
+		return referenceDecimate(referenceTemporalBlur(volume, 1.0f), w, h);
+	}
+
+	/** Old upscale, with the odd frames explicitly zeroed: pyrUp into the even frames, then temporal blur x2. */
+	cv::Mat referenceUpscale(const cv::Mat & volumeDown, int wDown, int hDown, int w, int h, int l)
+	{
+		cv::Mat out = cv::Mat::zeros(l, 3 * w * h, CV_32FC1);
+		for (int t = 0; t < volumeDown.rows && 2 * t < l; ++t) {
+			cv::Mat sliceUp = out.row(2 * t).reshape(3, h);
+			cv::pyrUp(volumeDown.row(t).reshape(3, hDown), sliceUp, sliceUp.size());
+		}
+		return referenceTemporalBlur(out, 2.0f);
+	}
+}
+
+int main(int ac, char ** av)
+{
+	cv::theRNG().state = 2020;
+	const double floatTolerance = 1e-3;
+	const double byteTolerance = 1.0;
+	const PyramidParameters params;
+
+	for (int l = 1; l <= 33; ++l) {
+
+		const cv::Mat volume = randomVolume(l, CV_32F);
+		const PyramidLayer layer(volume, frameW, frameH);
+
+		// Binomial blur, reflect-101 border.
+		cv::Mat filtered;
+		filterTemporal<float>(volume, filtered, FilterKernel::binomial5(0.75f));
+		SIBR_CHECK(sameVolume(filtered, referenceTemporalBlur(volume, 0.75f), floatTolerance));
+		SIBR_CHECK(sameVolume(temporalBlur(layer, params).volume, referenceTemporalBlur(volume, 1.0f), floatTolerance));
+
+		// Decimation with and without temporal blur.
+		cv::Mat decimated;
+		pyrDownFrames(volume, frameW, frameH, 3, decimated, 2);
+		SIBR_CHECK(sameVolume(decimated, referenceDecimate(volume, frameW, frameH), floatTolerance));
+		SIBR_CHECK(sameVolume(decimate(layer, params).volume, referenceDecimate(volume, frameW, frameH), floatTolerance));
+
+		const PyramidLayer down = downscale(layer, params);
+		SIBR_CHECK(down.l == (l + 1) / 2 && down.w == (frameW + 1) / 2 && down.h == (frameH + 1) / 2);
+		SIBR_CHECK(sameVolume(down.volume, referenceDownscale(volume, frameW, frameH), floatTolerance));
+
+		// Zero insertion upsampling, temporal then spatial.
+		const int lowL = (l + 1) / 2;
+		const cv::Mat low = randomVolume(lowL, CV_32F);
+		cv::Mat upsampled;
+		upsampleTemporal<float>(low, l, upsampled, FilterKernel::binomial5(2.0f));
+		cv::Mat zeroInserted = cv::Mat::zeros(l, low.cols, CV_32FC1);
+		for (int t = 0; t < lowL; ++t) {
+			low.row(t).copyTo(zeroInserted.row(2 * t));
+		}
+		SIBR_CHECK(sameVolume(upsampled, referenceTemporalBlur(zeroInserted, 2.0f), floatTolerance));
+
+		const int lowW = (frameW + 1) / 2, lowH = (frameH + 1) / 2;
+		const cv::Mat lowFrames = randomVolume(lowL, CV_32F, lowW, lowH);
+		cv::Mat upFrames;
+		pyrUpFrames(lowFrames, lowW, lowH, 3, frameW, frameH, upFrames);
+		for (int t = 0; t < lowL; ++t) {
+			cv::Mat expected;
+			cv::pyrUp(lowFrames.row(t).reshape(3, lowH), expected, cv::Size(frameW, frameH));
+			SIBR_CHECK(sameVolume(upFrames.row(t), expected.reshape(1, 1), floatTolerance));
+		}
+
+		const PyramidLayer up = upscale(layer, PyramidLayer(lowFrames, lowW, lowH), params);
+		SIBR_CHECK(sameVolume(up.volume, referenceUpscale(lowFrames, lowW, lowH, frameW, frameH, l), floatTolerance));
+
+		// 8 bits volumes: constant and replicated borders, and decimation.
+		const cv::Mat bytes = randomVolume(l, CV_8U);
+		Volume3u video(bytes, frameW, frameH);
+
+		cv::Mat constant;
+		filterTemporal<uchar>(bytes, constant, FilterKernel::binomial5(), FilterBorder::CONSTANT, 1, 32.0, 224.0);
+		SIBR_CHECK(sameVolume(constant, referenceBoundaryBlur(bytes, 1.0f, 32.0, 224.0), byteTolerance));
+
+		Volume3u bounded = video.clone();
+		bounded.temporalBlurBoundaryConditions(1.0f, 32.0, 224.0);
+		SIBR_CHECK(sameVolume(bounded.mat, referenceBoundaryBlur(bytes, 1.0f, 32.0, 224.0), byteTolerance));
+
+		Volume3u extended = video.clone();
+		extended.extendedTemporalBlur();
+		SIBR_CHECK(sameVolume(extended.mat, referenceExtendedBlur(bytes), byteTolerance));
+
+		const cv::Mat extendedRef = referenceExtendedBlur(bytes);
+		const Volume3u extendedDown = video.extendedDownScaleTemporal();
+		SIBR_CHECK(extendedDown.l == (l + 1) / 2);
+		for (int t = 0; t < extendedDown.l; ++t) {
+			SIBR_CHECK(sameVolume(extendedDown.mat.row(t), extendedRef.row(2 * t), byteTolerance));
+		}
+
+		const Volume3u temporalDown = video.pyrDownTemporal();
+		const cv::Mat blurredRef = referenceTemporalBlur(bytes, 1.0f);
+		SIBR_CHECK(temporalDown.l == (l + 1) / 2);
+		for (int t = 0; t < temporalDown.l; ++t) {
+			SIBR_CHECK(sameVolume(temporalDown.mat.row(t), blurredRef.row(2 * t), byteTolerance));
+		}
+	}
+
+	return checks::result();
+}
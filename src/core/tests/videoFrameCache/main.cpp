@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <core/system/Config.hpp>
+#include <core/video/FFmpegVideoEncoder.hpp>
+#include <core/video/FFmpegVideoDecoder.hpp>
+#include <core/video/VideoFrameCache.hpp>
+#include "../Checks.hpp"
+
+#include <boost/filesystem.hpp>
+
+using namespace sibr;
+
+/* Check the hits, misses, eviction and prefetching of VideoFrameCache on a synthetic video
+ written with FFVideoEncoder: each frame is uniform, with a gray level given by its index. */
+
+namespace
+{
+	const int framesCount = 60;
+	const int frameW = 64;
+	const int frameH = 48;
+
+	/** \return the gray level of a frame. */
+	int frameLevel(int index)
+	{
+		return 4 * index;
+	}
+
+	/** \return true if a decoded frame is the expected one. */
+	bool isFrame(const cv::Mat & frame, int index)
+	{
+		return !frame.empty() && std::abs(cv::mean(frame)[0] - frameLevel(index)) < 2.0;
+	}
+
+	/** Write the synthetic video.
+	\param path the destination file
+	\return a success flag
+	*/
+	bool writeVideo(const std::string & path)
+	{
+		FFVideoEncoder encoder(path, 25.0, { frameW, frameH });
+		if (!encoder.isFine()) {
+			return false;
+		}
+		for (int f = 0; f < framesCount; ++f) {
+			const uchar level = uchar(frameLevel(f));
+			if (!(encoder << cv::Mat(frameH, frameW, CV_8UC3, cv::Scalar(level, level, level)))) {
+				return false;
+			}
+		}
+		return encoder.close();
+	}
+
+	/** \return a cache reading the video. */
+	VideoFrameCache::Ptr openCache(const std::string & path, const FrameCacheOptions & options)
+	{
+		FFVideoFrameSource::Ptr source(new FFVideoFrameSource(path));
+		SIBR_CHECK(source->isValid());
+		return VideoFrameCache::Ptr(new VideoFrameCache(source, options));
+	}
+
+	const size_t frameBytes = size_t(frameW) * size_t(frameH) * 3;
+
+	/** Hits, misses, seeking, end of the video. */
+	void checkHitsAndMisses(const std::string & path)
+	{
+		FrameCacheOptions options;
+		options.prefetch = false;
+		VideoFrameCache::Ptr cache = openCache(path, options);
+
+		cv::Mat frame;
+		SIBR_CHECK(cache->get(10, frame) && isFrame(frame, 10));
+		SIBR_CHECK(cache->hits() == 0 && cache->misses() == 1);
+		SIBR_CHECK(cache->get(10, frame) && isFrame(frame, 10));
+		SIBR_CHECK(cache->hits() == 1 && cache->misses() == 1);
+		// Sequential, then backward.
+		SIBR_CHECK(cache->get(11, frame) && isFrame(frame, 11));
+		SIBR_CHECK(cache->get(3, frame) && isFrame(frame, 3));
+		SIBR_CHECK(cache->misses() == 3 && cache->size() == 3 && cache->memoryUsage() == 3 * frameBytes);
+		SIBR_CHECK(cache->contains(3) && cache->contains(10) && cache->contains(11) && !cache->contains(4));
+		SIBR_CHECK(cache->prefetched() == 0);
+
+		SIBR_CHECK(cache->get(framesCount - 1, frame) && isFrame(frame, framesCount - 1));
+		SIBR_CHECK(!cache->get(framesCount, frame));
+		SIBR_CHECK(!cache->get(-1, frame));
+
+		cache->clear();
+		SIBR_CHECK(cache->size() == 0 && cache->hits() == 0 && cache->misses() == 0);
+	}
+
+	/** Least recently used eviction under the memory budget. */
+	void checkEviction(const std::string & path)
+	{
+		FrameCacheOptions options;
+		options.prefetch = false;
+		options.memoryBudget = 5 * frameBytes;
+		VideoFrameCache::Ptr cache = openCache(path, options);
+
+		cv::Mat frame;
+		for (int f = 0; f < 10; ++f) {
+			cache->get(f, frame);
+		}
+		SIBR_CHECK(cache->size() == 5 && cache->memoryUsage() <= options.memoryBudget);
+		SIBR_CHECK(!cache->contains(4) && cache->contains(5) && cache->contains(9));
+
+		// Using 5 again makes 6 and 7 the next evicted ones.
+		SIBR_CHECK(cache->get(5, frame) && isFrame(frame, 5));
+		cache->get(10, frame);
+		cache->get(11, frame);
+		SIBR_CHECK(cache->contains(5) && !cache->contains(6) && !cache->contains(7) && cache->contains(8));
+		SIBR_CHECK(cache->memoryUsage() <= options.memoryBudget);
+	}
+
+	/** Background decoding around the requested frame, in both directions. */
+	void checkPrefetch(const std::string & path)
+	{
+		FrameCacheOptions options;
+		options.prefetchBefore = 4;
+		options.prefetchAfter = 8;
+		VideoFrameCache::Ptr cache = openCache(path, options);
+
+		cv::Mat frame;
+		SIBR_CHECK(cache->get(20, frame) && isFrame(frame, 20));
+		cache->waitPrefetch();
+		SIBR_CHECK(cache->prefetched() == 12 && cache->size() == 13);
+		for (int f = 16; f <= 28; ++f) {
+			SIBR_CHECK(cache->contains(f));
+		}
+		SIBR_CHECK(!cache->contains(15) && !cache->contains(29));
+
+		// Moving forward in the window: only the frames after the previous window are decoded.
+		SIBR_CHECK(cache->get(24, frame) && isFrame(frame, 24));
+		cache->waitPrefetch();
+		SIBR_CHECK(cache->prefetched() == 16 && cache->contains(32) && !cache->contains(33));
+
+		// Scrubbing back: only the frames before the previous window are decoded.
+		SIBR_CHECK(cache->get(16, frame) && isFrame(frame, 16));
+		cache->waitPrefetch();
+		SIBR_CHECK(cache->prefetched() == 20 && cache->contains(12) && !cache->contains(11));
+		SIBR_CHECK(cache->misses() == 1 && cache->hits() == 2);
+
+		// Near the end, the window is clamped to the video.
+		SIBR_CHECK(cache->get(framesCount - 2, frame) && isFrame(frame, framesCount - 2));
+		cache->waitPrefetch();
+		SIBR_CHECK(cache->contains(framesCount - 1) && cache->contains(framesCount - 6) && !cache->contains(framesCount));
+		SIBR_CHECK(cache->misses() == 2);
+	}
+}
+
+int main(int ac, char ** av)
+{
+	const boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("sibr_frame_cache_%%%%%%%%.mp4");
+	if (!writeVideo(path.string())) {
+		SIBR_WRG << "Could not write the test video " << path.string() << "." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	checkHitsAndMisses(path.string());
+	checkEviction(path.string());
+	checkPrefetch(path.string());
+
+	boost::filesystem::remove(path);
+	return checks::result();
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "ChunkedVideoVolume.hpp"
+
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace sibr {
+
+	struct VolumeScratchFile::Internal {
+		boost::interprocess::file_mapping mapping;
+	};
+
+	VolumeScratchFile::VolumeScratchFile(const std::string & directory, size_t size)
+	{
+		makeDirectory(directory);
+		_path = (boost::filesystem::path(directory) / boost::filesystem::unique_path("sibr_volume_%%%%-%%%%-%%%%-%%%%.bin")).string();
+
+		// Grow the file to its final size, the content is zero and most file systems will not allocate it until written.
+		{
+			std::filebuf file;
+			if (!file.open(_path, std::ios_base::in | std::ios_base::out | std::ios_base::trunc | std::ios_base::binary)) {
+				SIBR_ERR << "Unable to create scratch file " << _path << std::endl;
+			}
+			if (size > 0) {
+				file.pubseekoff(std::streamoff(size - 1), std::ios_base::beg);
+				file.sputc(0);
+			}
+		}
+
+		_internal.reset(new Internal());
+		_internal->mapping = boost::interprocess::file_mapping(_path.c_str(), boost::interprocess::read_write);
+	}
+
+	VolumeScratchFile::~VolumeScratchFile()
+	{
+		_internal.reset();
+		boost::system::error_code ec;
+		boost::filesystem::remove(_path, ec);
+		if (ec) {
+			SIBR_WRG << "Unable to remove scratch file " << _path << std::endl;
+		}
+	}
+
+	std::shared_ptr<void> VolumeScratchFile::map(size_t offset, size_t size)
+	{
+		using boost::interprocess::mapped_region;
+		std::shared_ptr<mapped_region> region = std::make_shared<mapped_region>(_internal->mapping, boost::interprocess::read_write, boost::interprocess::offset_t(offset), size);
+		// The returned pointer keeps the region alive.
+		return std::shared_ptr<void>(region, region->get_address());
+	}
+
+	ChunkedVolume3u loadChunkedVideoVolume(sibr::Video & video, const ChunkedVolumeOptions & options, int starting_frame, int ending_frame)
+	{
+		const int numFrames = video.getNumFrames();
+		if (ending_frame < 0 || ending_frame > numFrames) {
+			ending_frame = numFrames;
+		}
+		if (starting_frame < 0 || starting_frame >= ending_frame) {
+			SIBR_WRG << "Invalid frame range [" << starting_frame << ", " << ending_frame << ") for a video of " << numFrames << " frames." << std::endl;
+			return ChunkedVolume3u();
+		}
+		const int currentFrame = video.getCurrentFrameNumber();
+		video.setCurrentFrame(starting_frame);
+		ChunkedVolume3u volume(ending_frame - starting_frame, video.getResolution()[0], video.getResolution()[1], options);
+		// Decode in a separate matrix: the decoder can reallocate its output, and the frame count of some containers is an estimate.
+		cv::Mat decoded;
+		int decodedCount = 0;
+		bool ended = false;
+		for (int b = 0; b < volume.bricksCount() && !ended; ++b) {
+			Volume3u brick = volume.brickVolume(b);
+			for (int t = 0; t < brick.l; ++t) {
+				video.getCVvideo() >> decoded;
+				if (decoded.empty()) {
+					ended = true;
+					break;
+				}
+				cv::Mat frame = brick.frame(t);
+				if (decoded.size() != frame.size() || decoded.type() != frame.type()) {
+					SIBR_WRG << "Frame " << starting_frame + decodedCount << " has an unexpected size or format, it is left black." << std::endl;
+					frame.setTo(cv::Scalar::all(0));
+				} else {
+					decoded.copyTo(frame);
+				}
+				++decodedCount;
+			}
+		}
+		video.setCurrentFrame(currentFrame);
+		if (decodedCount < volume.l) {
+			SIBR_WRG << "End of video reached after " << decodedCount << " frames instead of " << volume.l << ", the volume is truncated." << std::endl;
+			volume.truncate(decodedCount);
+		}
+		return volume;
+	}
+
+	ChunkedVolume3u loadChunkedVideoVolume(const std::string & filepath, const ChunkedVolumeOptions & options, int starting_frame, int ending_frame)
+	{
+		Video video(filepath);
+		if (video.exists()) {
+			return loadChunkedVideoVolume(video, options, starting_frame, ending_frame);
+		} else {
+			SIBR_WRG << filepath << " does not exists" << std::endl;
+			return ChunkedVolume3u();
+		}
+	}
+
+} // namespace sibr
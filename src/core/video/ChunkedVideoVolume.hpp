@@ -0,0 +1,552 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+#include "Config.hpp"
+#include "VideoUtils.hpp"
+#include <memory>
+
+namespace sibr {
+
+	/**
+	* \addtogroup sibr_video
+	* @{
+	*/
+
+	/** Storage parameters of a ChunkedVideoVolume. */
+	struct SIBR_VIDEO_EXPORT ChunkedVolumeOptions {
+		int brickLength = 16; ///< Number of frames per temporal brick.
+		size_t maxResidentBytes = size_t(1) << 30; ///< Maximum size of the bricks mapped in memory at the same time (only when spilling).
+		std::string scratchDirectory = ""; ///< If not empty, bricks are stored in a memory-mapped scratch file in this directory. Otherwise they are kept in RAM.
+	};
+
+	/** Scratch file backing the bricks of a ChunkedVideoVolume. The file is created when
+	 the object is constructed, and deleted when it is destroyed.
+	*/
+	class SIBR_VIDEO_EXPORT VolumeScratchFile {
+		SIBR_CLASS_PTR(VolumeScratchFile);
+
+	public:
+
+		/** Create a scratch file with a unique name.
+		\param directory the directory in which the file is created
+		\param size the file size in bytes
+		*/
+		VolumeScratchFile(const std::string & directory, size_t size);
+
+		/** Destructor, remove the file. */
+		~VolumeScratchFile();
+
+		/** Map a region of the file in memory.
+		\param offset the region start, in bytes
+		\param size the region size, in bytes
+		\return the region address, the region is unmapped when the last copy of the pointer is released
+		*/
+		std::shared_ptr<void> map(size_t offset, size_t size);
+
+		/** \return the file path. */
+		const std::string & path() const { return _path; }
+
+	private:
+		struct Internal;
+		std::unique_ptr<Internal> _internal; ///< File mapping handle.
+		std::string _path; ///< File path.
+	};
+
+	/** Video volume split in fixed-size temporal bricks, for clips that do not fit in memory.
+	 The layout of each brick is the same as VideoVolume::mat (one row of w*h*N values per frame).
+	 Bricks can be spilled to a memory-mapped scratch file (see ChunkedVolumeOptions): in that case at most
+	 maxResidentBytes of bricks are mapped at the same time, and the least recently used ones are unmapped when
+	 another brick is accessed. Processing operations stream over bricks and never hold more than a brick
+	 (and a few halo frames) of each volume. The pyramid builders of VideoUtils (gaussianPyramid,
+	 laplacianPyramidTemporal, collapseLaplacianPyramidTemporal...) accept chunked volumes as well.
+	 Copies share the same bricks, as for VideoVolume. Access is not thread-safe, and the matrix
+	 returned by frame() is only valid until another brick of the volume is accessed.
+	*/
+	template<typename T, uint N = 3>
+	class ChunkedVideoVolume {
+	public:
+		using CVpixel = typename VideoVolume<T, N>::CVpixel;
+		using Volume = VideoVolume<T, N>;
+
+		// data
+		int w = 0, h = 0, l = 0;
+
+		// methods
+		ChunkedVideoVolume() {}
+
+		/** Constructor (content is uninitialized if kept in RAM, zero if spilled).
+		\param _l number of frames
+		\param _w frame width
+		\param _h frame height
+		\param options storage parameters
+		*/
+		ChunkedVideoVolume(int _l, int _w, int _h, const ChunkedVolumeOptions & options) : w(_w), h(_h), l(_l) {
+			_storage = std::make_shared<Storage>();
+			_storage->options = options;
+			_storage->brickLength = std::max(1, options.brickLength);
+			const int bricksCount = (l + _storage->brickLength - 1) / _storage->brickLength;
+			_storage->bricks.resize(bricksCount);
+			if (options.scratchDirectory.empty()) {
+				for (int b = 0; b < bricksCount; ++b) {
+					_storage->bricks[b].mat = cv::Mat_<T>(framesInBrick(b), frameSize());
+				}
+				_storage->maxResident = bricksCount;
+			} else {
+				_storage->scratch.reset(new VolumeScratchFile(options.scratchDirectory, size_t(l) * brickRowBytes()));
+				const size_t brickBytes = size_t(_storage->brickLength) * brickRowBytes();
+				_storage->maxResident = (int)std::max(size_t(1), options.maxResidentBytes / std::max(size_t(1), brickBytes));
+			}
+		}
+
+		/** Constructor.
+		\param _l number of frames
+		\param _w frame width
+		\param _h frame height
+		\param value initial value
+		\param options storage parameters
+		*/
+		ChunkedVideoVolume(int _l, int _w, int _h, double value, const ChunkedVolumeOptions & options) : ChunkedVideoVolume(_l, _w, _h, options) {
+			for (int b = 0; b < bricksCount(); ++b) {
+				brick(b).setTo(cv::Scalar::all(value));
+			}
+		}
+
+		/** Copy a dense volume into bricks.
+		\param volume the dense volume
+		\param options storage parameters
+		\return the chunked volume
+		*/
+		static ChunkedVideoVolume fromVolume(const Volume & volume, const ChunkedVolumeOptions & options) {
+			ChunkedVideoVolume out(volume.l, volume.w, volume.h, options);
+			for (int b = 0; b < out.bricksCount(); ++b) {
+				volume.mat.rowRange(out.brickStart(b), out.brickStart(b) + out.framesInBrick(b)).copyTo(out.brick(b));
+			}
+			return out;
+		}
+
+		/** \return a dense copy of the whole volume. */
+		Volume toVolume() const {
+			return window(0, l);
+		}
+
+		/** Dense copy of a range of frames.
+		\param t_start first frame
+		\param t_end frame after the last one
+		\return the dense volume
+		*/
+		Volume window(int t_start, int t_end) const {
+			Volume out(t_end - t_start, w, h);
+			for (int t = t_start; t < t_end; ++t) {
+				row(t).copyTo(out.mat.row(t - t_start));
+			}
+			return out;
+		}
+
+		/** Copy a dense volume in a range of frames.
+		\param t_start first frame to overwrite
+		\param volume the frames to copy
+		*/
+		void setWindow(int t_start, const Volume & volume) {
+			for (int t = 0; t < volume.l; ++t) {
+				volume.mat.row(t).copyTo(row(t_start + t));
+			}
+		}
+
+		/** \return a volume with the same size and storage parameters, without sharing the data. */
+		ChunkedVideoVolume clone() const {
+			ChunkedVideoVolume out(l, w, h, options());
+			for (int b = 0; b < bricksCount(); ++b) {
+				brick(b).copyTo(out.brick(b));
+			}
+			return out;
+		}
+
+		template<typename U, uint M = N> ChunkedVideoVolume<U, M> convertTo() const {
+			ChunkedVideoVolume<U, M> out(l, w, h, options());
+			for (int t = 0; t < l; ++t) {
+				cvConvertMatTo<U, M>(frame(t)).copyTo(out.frame(t));
+			}
+			return out;
+		}
+
+		template<typename U>
+		void add(const ChunkedVideoVolume<U, N> & other) {
+			for (int t = 0; t < l; ++t) {
+				cv::Mat_<T> r = row(t);
+				cv::add(r, other.row(t), r, cv::noArray(), Volume::cv_type);
+			}
+		}
+
+		template<typename U>
+		void substract(const ChunkedVideoVolume<U, N> & other) {
+			for (int t = 0; t < l; ++t) {
+				cv::Mat_<T> r = row(t);
+				cv::subtract(r, other.row(t), r, cv::noArray(), Volume::cv_type);
+			}
+		}
+
+		void shift(double d) {
+			for (int b = 0; b < bricksCount(); ++b) {
+				brick(b) += d;
+			}
+		}
+
+		void scale(double d) {
+			for (int b = 0; b < bricksCount(); ++b) {
+				brick(b) *= d;
+			}
+		}
+
+		template<typename U, uint M>
+		void applyMaskInPlace(const ChunkedVideoVolume<U, M> & mask) {
+			for (int t = 0; t < l; ++t) {
+				cv::multiply(cvConvertMatTo<float, N>(frame(t)), cvConvertMatTo<float, N>(mask.frame(t)), frame(t), 1 / 255.0, Volume::cv_type);
+			}
+		}
+
+		void toggle(double d = 255) {
+			for (int b = 0; b < bricksCount(); ++b) {
+				cv::subtract(d, brick(b), brick(b));
+			}
+		}
+
+		/** Filter the volume along the time axis, in place, one brick at a time.
+		\param kernel the temporal kernel (odd number of coefficients)
+		\param borderType how frames outside the volume are extrapolated (OpenCV border type)
+		*/
+		void temporalFilter(const cv::Mat1f & kernel, int borderType = cv::BORDER_DEFAULT) {
+			filterInto(*this, kernel, borderType, 1);
+		}
+
+		void temporalBlur(float scaling = 1.0f) {
+			temporalFilter((scaling / 16.0f)*(cv::Mat1f(5, 1) << 1, 4, 6, 4, 1));
+		}
+
+		ChunkedVideoVolume pyrDownSpacial() const {
+			ChunkedVideoVolume out(l, (w + 1) / 2, (h + 1) / 2, options());
+			for (int b = 0; b < bricksCount(); ++b) {
+				const Volume src = brickVolume(b);
+				Volume dst = out.brickVolume(b);
+#pragma omp parallel for
+				for (int f = 0; f < src.l; ++f) {
+					cv::pyrDown(src.frame(f), dst.frame(f));
+				}
+			}
+			return out;
+		}
+
+		ChunkedVideoVolume pyrDownTemporal() const {
+			ChunkedVideoVolume out((l + 1) / 2, w, h, options());
+			filterInto(out, (1.0f / 16.0f)*(cv::Mat1f(5, 1) << 1, 4, 6, 4, 1), cv::BORDER_DEFAULT, 2);
+			return out;
+		}
+
+		ChunkedVideoVolume pyrDown() const {
+			return pyrDownSpacial().pyrDownTemporal();
+		}
+
+		ChunkedVideoVolume pyrUpSpacial(int _w, int _h) const {
+			ChunkedVideoVolume out(l, _w, _h, options());
+			for (int b = 0; b < bricksCount(); ++b) {
+				const Volume src = brickVolume(b);
+				Volume dst = out.brickVolume(b);
+#pragma omp parallel for
+				for (int f = 0; f < src.l; ++f) {
+					cv::pyrUp(src.frame(f), dst.frame(f), cv::Size(_w, _h));
+				}
+			}
+			return out;
+		}
+
+		/** Linear resampling along the time axis, matching cv::resize with INTER_LINEAR on the dense volume (up to rounding).
+		\param _l the new number of frames
+		\return the resampled volume
+		*/
+		ChunkedVideoVolume temporalResize(int _l) const {
+			ChunkedVideoVolume out(_l, w, h, options());
+			const double ratio = l / double(_l);
+			for (int t = 0; t < _l; ++t) {
+				const double src = std::max(0.0, (t + 0.5) * ratio - 0.5);
+				int t0 = (int)src;
+				double a = src - t0;
+				if (t0 >= l - 1) {
+					t0 = l - 1;
+					a = 0;
+				}
+				cv::Mat_<T> dst = out.row(t);
+				if (a == 0) {
+					row(t0).copyTo(dst);
+				} else {
+					// Both source frames have to be copied out, as they can belong to different bricks.
+					const cv::Mat_<T> f0 = row(t0).clone();
+					cv::addWeighted(f0, 1.0 - a, row(t0 + 1), a, 0.0, dst, Volume::cv_type);
+				}
+			}
+			return out;
+		}
+
+		ChunkedVideoVolume pyrUpTemporal(int _l) const {
+			ChunkedVideoVolume out = temporalResize(_l);
+			out.temporalBlur(1.0f);
+			return out;
+		}
+
+		ChunkedVideoVolume pyrUp(int _l, int _w, int _h) const {
+			return pyrUpTemporal(_l).pyrUpSpacial(_w, _h);
+		}
+
+		void play(int delay = 30, const sibr::Vector2i & res = { -1,-1 }, double scale = 1.0) const {
+			playVolume(*this, delay, res, scale);
+		}
+
+		void saveToVideoFile(const std::string & filepath, double framerate = 30.0) const {
+			Path file = filepath;
+			makeDirectory(file.parent_path().string());
+
+			VideoEncoderOptions options;
+			options.async = true;
+			sibr::FFVideoEncoder output(filepath, framerate, { w,h }, options);
+			for (int f = 0; f < l; ++f) {
+				output << sibr::cvConvertMatTo<uchar, 3>(frame(f));
+			}
+			output.close();
+		}
+
+		/** \return the frame t, valid until another brick is accessed. */
+		cv::Mat_<CVpixel> frame(int t) {
+			return row(t).reshape(N, h);
+		}
+		/** \return the frame t, valid until another brick is accessed. */
+		const cv::Mat_<CVpixel> frame(int t) const {
+			return row(t).reshape(N, h);
+		}
+
+		/** \return a copy of the values of a pixel channel over time, gathered brick by brick. */
+		cv::Mat_<T> time_sequence(int i, int j, int c = 0) const {
+			cv::Mat_<T> out(l, 1);
+			const int col = N*(w*i + j) + c;
+			for (int b = 0; b < bricksCount(); ++b) {
+				brick(b).col(col).copyTo(out.rowRange(brickStart(b), brickStart(b) + framesInBrick(b)));
+			}
+			return out;
+		}
+		/** \return a copy of the values of a pixel over time, gathered brick by brick. */
+		cv::Mat_<CVpixel> time_sequence_pixels(int i, int j) const {
+			cv::Mat_<CVpixel> out(l, 1);
+			const int col = N*(w*i + j);
+			for (int b = 0; b < bricksCount(); ++b) {
+				brick(b).colRange(col, col + N).reshape(N, 0).copyTo(out.rowRange(brickStart(b), brickStart(b) + framesInBrick(b)));
+			}
+			return out;
+		}
+
+		/** Drop the frames after a given one, releasing the bricks that become empty.
+		 Other copies of the volume must not be used afterwards.
+		\param frames the new number of frames
+		*/
+		void truncate(int frames) {
+			if (!_storage || frames >= l) {
+				return;
+			}
+			Storage & s = *_storage;
+			l = std::max(0, frames);
+			const int count = (l + s.brickLength - 1) / s.brickLength;
+			for (int b = count; b < (int)s.bricks.size(); ++b) {
+				if (s.scratch && !s.bricks[b].mat.empty()) {
+					--s.residentCount;
+				}
+			}
+			s.bricks.resize(count);
+			if (count > 0 && !s.bricks[count - 1].mat.empty()) {
+				Brick & last = s.bricks[count - 1];
+				if (s.scratch) {
+					// Mapped again with its new size on the next access.
+					last.mat.release();
+					last.mapping.reset();
+					--s.residentCount;
+				} else {
+					last.mat = last.mat.rowRange(0, framesInBrick(count - 1));
+				}
+			}
+		}
+
+		/** \return the number of bricks. */
+		int bricksCount() const {
+			return _storage ? (int)_storage->bricks.size() : 0;
+		}
+
+		/** \return the number of frames per brick (the last brick can be shorter). */
+		int brickLength() const {
+			return _storage ? _storage->brickLength : 0;
+		}
+
+		/** \return the index of the first frame of a brick. */
+		int brickStart(int b) const {
+			return b * brickLength();
+		}
+
+		/** \return the number of frames of a brick. */
+		int framesInBrick(int b) const {
+			return std::min(brickLength(), l - brickStart(b));
+		}
+
+		/** Make a brick resident and access it, as a matrix with one row per frame.
+		\param b the brick index
+		\return the brick data, valid until another brick is accessed
+		*/
+		cv::Mat_<T> brick(int b) const {
+			Storage & s = *_storage;
+			Brick & brk = s.bricks[b];
+			brk.lastUse = ++s.clock;
+			if (!brk.mat.empty()) {
+				return brk.mat;
+			}
+			if (s.residentCount >= s.maxResident) {
+				int lru = -1;
+				for (int o = 0; o < (int)s.bricks.size(); ++o) {
+					if (!s.bricks[o].mat.empty() && (lru < 0 || s.bricks[o].lastUse < s.bricks[lru].lastUse)) {
+						lru = o;
+					}
+				}
+				s.bricks[lru].mat.release();
+				s.bricks[lru].mapping.reset();
+				--s.residentCount;
+			}
+			brk.mapping = s.scratch->map(size_t(brickStart(b)) * brickRowBytes(), size_t(framesInBrick(b)) * brickRowBytes());
+			brk.mat = cv::Mat_<T>(framesInBrick(b), frameSize(), static_cast<T*>(brk.mapping.get()));
+			++s.residentCount;
+			return brk.mat;
+		}
+
+		/** \return a brick as a dense volume sharing its data, valid until another brick is accessed. */
+		Volume brickVolume(int b) const {
+			return Volume(brick(b), w, h);
+		}
+
+		/** \return the storage parameters. */
+		const ChunkedVolumeOptions & options() const {
+			return _storage->options;
+		}
+
+		bool isValid() const {
+			return l > 0 && bricksCount() > 0;
+		}
+
+		void cout() const {
+			std::cout << l << " x " << w << " x " << h << " (" << bricksCount() << " bricks of " << brickLength() << " frames)" << std::endl;
+		}
+
+	private:
+
+		template<typename U, uint M> friend class ChunkedVideoVolume;
+
+		/** A temporal brick. */
+		struct Brick {
+			cv::Mat_<T> mat; ///< Brick data, empty if not resident.
+			std::shared_ptr<void> mapping; ///< Mapped file region (when spilling).
+			uint64_t lastUse = 0; ///< Last access time.
+		};
+
+		/** Bricks shared by the copies of a volume. */
+		struct Storage {
+			ChunkedVolumeOptions options; ///< Storage parameters.
+			int brickLength = 1; ///< Frames per brick.
+			int maxResident = 1; ///< Maximum number of resident bricks.
+			int residentCount = 0; ///< Current number of resident bricks (when spilling).
+			uint64_t clock = 0; ///< Access counter.
+			std::vector<Brick> bricks; ///< Bricks.
+			VolumeScratchFile::Ptr scratch; ///< Scratch file (when spilling).
+		};
+
+		/** \return the number of values per frame. */
+		int frameSize() const {
+			return w*h*N;
+		}
+
+		/** \return the size of a frame in bytes. */
+		size_t brickRowBytes() const {
+			return size_t(frameSize()) * sizeof(T);
+		}
+
+		/** \return the frame t as one row of values. */
+		cv::Mat_<T> row(int t) const {
+			const int b = t / brickLength();
+			return brick(b).row(t - brickStart(b));
+		}
+
+		/** Filter along the time axis, streaming over the bricks of the destination.
+		 The destination frame t receives the filtered source frame step*t. The destination can be
+		 the volume itself when step is 1: the original values of the frames preceding the current brick are kept aside.
+		\param dst the destination volume
+		\param kernel the temporal kernel
+		\param borderType how frames outside the volume are extrapolated
+		\param step the temporal decimation factor
+		*/
+		void filterInto(ChunkedVideoVolume & dst, const cv::Mat1f & kernel, int borderType, int step) const {
+			const int radius = kernel.rows / 2;
+			const bool inPlace = dst._storage == _storage;
+			cv::Mat_<T> previous(radius, frameSize());
+			for (int b = 0; b < dst.bricksCount(); ++b) {
+				const int t0 = step * dst.brickStart(b);
+				const int t1 = step * (dst.brickStart(b) + dst.framesInBrick(b) - 1) + 1;
+				// Gather the source frames needed by this brick, with halos.
+				cv::Mat_<T> tmp(t1 - t0 + 2 * radius, frameSize());
+				for (int u = t0 - radius; u < t1 + radius; ++u) {
+					const int src = cv::borderInterpolate(u, l, borderType);
+					if (inPlace && src < t0) {
+						previous.row(src - (t0 - radius)).copyTo(tmp.row(u - (t0 - radius)));
+					} else {
+						row(src).copyTo(tmp.row(u - (t0 - radius)));
+					}
+				}
+				if (inPlace && radius > 0) {
+					tmp.rowRange(t1 - t0, t1 - t0 + radius).copyTo(previous);
+				}
+				cv::filter2D(tmp, tmp, -1, kernel, cv::Point(-1, -1), 0.0, cv::BORDER_DEFAULT);
+				cv::Mat_<T> out = dst.brick(b);
+				for (int f = 0; f < out.rows; ++f) {
+					tmp.row(radius + step * f).copyTo(out.row(f));
+				}
+			}
+		}
+
+		std::shared_ptr<Storage> _storage; ///< Shared bricks.
+	};
+
+	using ChunkedVolume3f = ChunkedVideoVolume<float, 3>;
+	using ChunkedVolume1f = ChunkedVideoVolume<float, 1>;
+	using ChunkedVolume3u = ChunkedVideoVolume<uchar, 3>;
+	using ChunkedVolume1u = ChunkedVideoVolume<uchar, 1>;
+
+	/** Decode a range of frames of a video directly into bricks, without loading the whole clip.
+	\param video the video
+	\param options storage parameters
+	\param starting_frame first frame
+	\param ending_frame frame after the last one (-1 for the end of the video)
+	\return the chunked volume
+	*/
+	SIBR_VIDEO_EXPORT ChunkedVolume3u loadChunkedVideoVolume(sibr::Video & video, const ChunkedVolumeOptions & options, int starting_frame = 0, int ending_frame = -1);
+
+	/** Decode a range of frames of a video directly into bricks, without loading the whole clip.
+	\param filepath the video path
+	\param options storage parameters
+	\param starting_frame first frame
+	\param ending_frame frame after the last one (-1 for the end of the video)
+	\return the chunked volume
+	*/
+	SIBR_VIDEO_EXPORT ChunkedVolume3u loadChunkedVideoVolume(const std::string & filepath, const ChunkedVolumeOptions & options, int starting_frame = 0, int ending_frame = -1);
+
+	/** }@ */
+
+} // namespace sibr
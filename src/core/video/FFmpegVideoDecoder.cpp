@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "FFmpegVideoDecoder.hpp"
+
+#include <algorithm>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+
+// Disable ffmpeg deprecation warning.
+#pragma warning(disable : 4996)
+
+namespace sibr {
+
+	/** \return true if the luma of a frame with this pixel format is stored as 8 bits in its first plane. */
+	static bool hasLumaPlane(int format)
+	{
+		switch (format) {
+		case AV_PIX_FMT_GRAY8:
+		case AV_PIX_FMT_YUV420P:
+		case AV_PIX_FMT_YUVJ420P:
+		case AV_PIX_FMT_YUV422P:
+		case AV_PIX_FMT_YUVJ422P:
+		case AV_PIX_FMT_YUV444P:
+		case AV_PIX_FMT_YUVJ444P:
+		case AV_PIX_FMT_NV12:
+		case AV_PIX_FMT_NV21:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	/** \return the timestamp of a packet, in stream time base. */
+	static int64_t packetTimestamp(const AVPacket * packet)
+	{
+		return packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+	}
+
+	FFVideoDecoder::FFVideoDecoder(const std::string & filepath, Output output, int threadsCount) :
+		_filepath(filepath), _output(output)
+	{
+		if (avformat_open_input(&_format, filepath.c_str(), NULL, NULL) != 0) {
+			SIBR_WRG << "[FFMPEG] Could not open " << filepath << "." << std::endl;
+			_format = nullptr;
+			return;
+		}
+		if (avformat_find_stream_info(_format, NULL) < 0) {
+			SIBR_WRG << "[FFMPEG] Could not read stream info of " << filepath << "." << std::endl;
+			close();
+			return;
+		}
+		_streamIndex = av_find_best_stream(_format, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+		if (_streamIndex < 0) {
+			SIBR_WRG << "[FFMPEG] No video stream in " << filepath << "." << std::endl;
+			close();
+			return;
+		}
+		AVStream * stream = _format->streams[_streamIndex];
+		// Only decode the video stream.
+		for (unsigned int s = 0; s < _format->nb_streams; ++s) {
+			_format->streams[s]->discard = int(s) == _streamIndex ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+		}
+
+		const AVCodec * decoder = avcodec_find_decoder(stream->codecpar->codec_id);
+		if (!decoder) {
+			SIBR_WRG << "[FFMPEG] No decoder for " << filepath << "." << std::endl;
+			close();
+			return;
+		}
+		AVCodecContext * codec = avcodec_alloc_context3(decoder);
+		if (!codec || avcodec_parameters_to_context(codec, stream->codecpar) < 0) {
+			avcodec_free_context(&codec);
+			close();
+			return;
+		}
+		codec->thread_count = std::max(0, threadsCount);
+		codec->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+		if (avcodec_open2(codec, decoder, NULL) < 0) {
+			SIBR_WRG << "[FFMPEG] Could not open decoder for " << filepath << "." << std::endl;
+			avcodec_free_context(&codec);
+			close();
+			return;
+		}
+		_codec = codec;
+		_frame = av_frame_alloc();
+		_packet = av_packet_alloc();
+
+		_resolution = { _codec->width, _codec->height };
+		const AVRational rate = av_guess_frame_rate(_format, stream, NULL);
+		if (rate.num > 0 && rate.den > 0) {
+			_frameRate = av_q2d(rate);
+		}
+	}
+
+	FFVideoDecoder::~FFVideoDecoder()
+	{
+		close();
+	}
+
+	void FFVideoDecoder::close()
+	{
+		if (_sws) {
+			sws_freeContext(_sws);
+			_sws = nullptr;
+		}
+		av_packet_free(&_packet);
+		av_frame_free(&_frame);
+		avcodec_free_context(&_codec);
+		if (_format) {
+			avformat_close_input(&_format);
+		}
+		_pending = false;
+	}
+
+	bool FFVideoDecoder::read(cv::Mat & frame)
+	{
+		return read(frame, _output);
+	}
+
+	bool FFVideoDecoder::read(cv::Mat & frame, Output output)
+	{
+		if (!isFine()) {
+			return false;
+		}
+		if (_pending) {
+			_pending = false;
+		} else if (!decodeNext()) {
+			return false;
+		}
+		convert(frame, output);
+		++_currentFrame;
+		return true;
+	}
+
+	bool FFVideoDecoder::decodeNext()
+	{
+		while (true) {
+			const int ret = avcodec_receive_frame(_codec, _frame);
+			if (ret == 0) {
+				return true;
+			}
+			if (ret != AVERROR(EAGAIN)) {
+				// End of stream or decoding error.
+				return false;
+			}
+			// The decoder needs more data.
+			if (av_read_frame(_format, _packet) < 0) {
+				if (_draining) {
+					return false;
+				}
+				// End of file, flush the frames still in the decoder.
+				_draining = true;
+				avcodec_send_packet(_codec, NULL);
+				continue;
+			}
+			if (_packet->stream_index == _streamIndex) {
+				avcodec_send_packet(_codec, _packet);
+			}
+			av_packet_unref(_packet);
+		}
+	}
+
+	void FFVideoDecoder::buildIndex()
+	{
+		if (_indexed || !isFine()) {
+			return;
+		}
+		_indexed = true;
+		_framesPts.clear();
+		_keyframesPts.clear();
+		_keyframesDts.clear();
+
+		// Demux only, no decoding.
+		avformat_seek_file(_format, _streamIndex, INT64_MIN, INT64_MIN, INT64_MAX, 0);
+		while (av_read_frame(_format, _packet) >= 0) {
+			if (_packet->stream_index == _streamIndex) {
+				const int64_t pts = packetTimestamp(_packet);
+				_framesPts.push_back(pts);
+				if (_packet->flags & AV_PKT_FLAG_KEY) {
+					_keyframesPts.push_back(pts);
+					_keyframesDts.push_back(_packet->dts != AV_NOPTS_VALUE ? _packet->dts : pts);
+				}
+			}
+			av_packet_unref(_packet);
+		}
+		// Frames are stored in decoding order, display order is given by the presentation timestamps.
+		std::sort(_framesPts.begin(), _framesPts.end());
+		SIBR_LOG << "[FFMPEG] Indexed " << _framesPts.size() << " frames and " << _keyframesPts.size() << " keyframes in " << _filepath << "." << std::endl;
+		// The demuxer is now at the end of the file, the caller has to seek.
+		_currentFrame = -1;
+	}
+
+	bool FFVideoDecoder::seek(int index)
+	{
+		if (!isFine()) {
+			return false;
+		}
+		if (index == _currentFrame) {
+			return true;
+		}
+		buildIndex();
+		if (_framesPts.empty()) {
+			return false;
+		}
+		index = std::max(0, std::min(index, int(_framesPts.size()) - 1));
+		const int64_t target = _framesPts[index];
+
+		// Restart from the closest keyframe displayed before the target.
+		size_t key = std::upper_bound(_keyframesPts.begin(), _keyframesPts.end(), target) - _keyframesPts.begin();
+		key = key > 0 ? key - 1 : 0;
+		const int64_t seekDts = _keyframesDts.empty() ? target : _keyframesDts[key];
+
+		if (av_seek_frame(_format, _streamIndex, seekDts, AVSEEK_FLAG_BACKWARD) < 0) {
+			SIBR_WRG << "[FFMPEG] Seek failed in " << _filepath << "." << std::endl;
+			return false;
+		}
+		avcodec_flush_buffers(_codec);
+		_draining = false;
+		_pending = false;
+
+		// Decode and drop the frames between the keyframe and the target.
+		while (decodeNext()) {
+			const int64_t pts = _frame->best_effort_timestamp;
+			if (pts == AV_NOPTS_VALUE || pts >= target) {
+				_pending = true;
+				break;
+			}
+		}
+		_currentFrame = index;
+		return _pending;
+	}
+
+	int FFVideoDecoder::numFrames()
+	{
+		if (!_indexed) {
+			const int current = _currentFrame;
+			buildIndex();
+			seek(current);
+		}
+		return int(_framesPts.size());
+	}
+
+	void FFVideoDecoder::convert(cv::Mat & frame, Output output)
+	{
+		const int w = _frame->width;
+		const int h = _frame->height;
+		const AVPixelFormat srcFormat = AVPixelFormat(_frame->format);
+
+		if (output == Output::GRAY && hasLumaPlane(srcFormat)) {
+			// Zero copy, the header points to the decoded luma plane.
+			frame = cv::Mat(h, w, CV_8UC1, _frame->data[0], size_t(_frame->linesize[0]));
+			return;
+		}
+
+		if (output == Output::YUV420 && (srcFormat == AV_PIX_FMT_YUV420P || srcFormat == AV_PIX_FMT_YUVJ420P)) {
+			frame.create(h + h / 2, w, CV_8UC1);
+			cv::Mat(h, w, CV_8UC1, _frame->data[0], size_t(_frame->linesize[0])).copyTo(frame.rowRange(0, h));
+			// U and V planes are stored one after the other, each w/2 x h/2.
+			const cv::Mat chroma = frame.rowRange(h, h + h / 2);
+			cv::Mat uPlane(h / 2, w / 2, CV_8UC1, chroma.data);
+			cv::Mat vPlane(h / 2, w / 2, CV_8UC1, chroma.data + (w / 2) * (h / 2));
+			cv::Mat(h / 2, w / 2, CV_8UC1, _frame->data[1], size_t(_frame->linesize[1])).copyTo(uPlane);
+			cv::Mat(h / 2, w / 2, CV_8UC1, _frame->data[2], size_t(_frame->linesize[2])).copyTo(vPlane);
+			return;
+		}
+
+		// Generic path through swscale, writing directly in the destination.
+		AVPixelFormat dstFormat = AV_PIX_FMT_BGR24;
+		uint8_t * dstData[4] = { NULL, NULL, NULL, NULL };
+		int dstLinesize[4] = { 0, 0, 0, 0 };
+		if (output == Output::BGR) {
+			frame.create(h, w, CV_8UC3);
+			dstData[0] = frame.data;
+			dstLinesize[0] = int(frame.step[0]);
+		} else if (output == Output::GRAY) {
+			dstFormat = AV_PIX_FMT_GRAY8;
+			frame.create(h, w, CV_8UC1);
+			dstData[0] = frame.data;
+			dstLinesize[0] = int(frame.step[0]);
+		} else {
+			dstFormat = AV_PIX_FMT_YUV420P;
+			frame.create(h + h / 2, w, CV_8UC1);
+			dstData[0] = frame.data;
+			dstData[1] = frame.data + w * h;
+			dstData[2] = dstData[1] + (w / 2) * (h / 2);
+			dstLinesize[0] = w;
+			dstLinesize[1] = w / 2;
+			dstLinesize[2] = w / 2;
+		}
+		_sws = sws_getCachedContext(_sws, w, h, srcFormat, w, h, dstFormat, SWS_BILINEAR, NULL, NULL, NULL);
+		if (!_sws) {
+			SIBR_WRG << "[FFMPEG] Unsupported pixel format conversion." << std::endl;
+			frame = cv::Mat();
+			return;
+		}
+		sws_scale(_sws, _frame->data, _frame->linesize, 0, h, dstData, dstLinesize);
+	}
+
+}
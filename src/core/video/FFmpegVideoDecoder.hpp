@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+
+#include <string>
+#include <opencv2/opencv.hpp>
+#include <core/system/Vector.hpp>
+#include "Config.hpp"
+#include "VideoDecodeService.hpp"
+
+// Forward libav declarations.
+struct AVFrame;
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVPacket;
+struct SwsContext;
+
+namespace sibr {
+
+	/** Video decoder using ffmpeg directly, without going through cv::VideoCapture.
+	 Compared to cv::VideoCapture it provides:
+	 - frame accurate seeking, using an index of the frames and keyframes built by demuxing the file on the first seek;
+	 - control over the codec threading (frame and slice threads);
+	 - luma or YUV 4:2:0 output, skipping the conversion to BGR. Luma is handed out as a cv::Mat header on the
+	 decoded frame without any copy when the codec outputs 8 bits planar YUV (most videos), it is then valid until the next read or seek.
+	 Note that luma is then in the range of the video (usually [16,235]) instead of the full range of cv::COLOR_BGR2GRAY.
+	\ingroup sibr_video
+	*/
+	class SIBR_VIDEO_EXPORT FFVideoDecoder {
+
+	public:
+
+		/** Output format of decoded frames. */
+		enum class Output {
+			BGR, ///< 8 bits BGR (CV_8UC3), as cv::VideoCapture.
+			GRAY, ///< 8 bits luma (CV_8UC1).
+			YUV420 ///< 8 bits I420 planes in a single (3h/2 x w) CV_8UC1 matrix, as expected by cv::COLOR_YUV2BGR_I420.
+		};
+
+		/** Constructor.
+		\param filepath the video file
+		\param output the default output format
+		\param threadsCount number of decoding threads (0 to let ffmpeg decide based on the number of cores)
+		*/
+		FFVideoDecoder(const std::string & filepath, Output output = Output::BGR, int threadsCount = 0);
+
+		/// Destructor.
+		~FFVideoDecoder();
+
+		/** \return true if the video was properly opened. */
+		bool isFine() const { return _codec != nullptr; }
+
+		/** Close the file. */
+		void close();
+
+		/** Decode the next frame in the default output format.
+		\param frame will contain the frame. For BGR output, if frame already has the right size and type, the frame is converted in place.
+		\return false at the end of the video or on error
+		*/
+		bool read(cv::Mat & frame);
+
+		/** Decode the next frame.
+		\param frame will contain the frame. For BGR output, if frame already has the right size and type, the frame is converted in place.
+		\param output the output format
+		\return false at the end of the video or on error
+		*/
+		bool read(cv::Mat & frame, Output output);
+
+		/** Seek a frame. Decoding restarts at the closest preceding keyframe, the frames up to the target are decoded and dropped.
+		\param index the index of the next frame to read
+		\return a success flag
+		*/
+		bool seek(int index);
+
+		/** \return the index of the next frame to read. */
+		int currentFrame() const { return _currentFrame; }
+
+		/** \return the number of frames (builds the frame index if needed). */
+		int numFrames();
+
+		/** \return the frame rate. */
+		double frameRate() const { return _frameRate; }
+
+		/** \return the frame size. */
+		const sibr::Vector2i & resolution() const { return _resolution; }
+
+		/** Set the default output format.
+		\param output the new format
+		*/
+		void setOutput(Output output) { _output = output; }
+
+	protected:
+
+		/** Decode the next frame in the internal frame.
+		\return false at the end of the video
+		*/
+		bool decodeNext();
+
+		/** Demux the whole file to list the frames timestamps and keyframes, then go back to the current frame. */
+		void buildIndex();
+
+		/** Convert the internal frame to the requested output.
+		\param frame the destination
+		\param output the output format
+		*/
+		void convert(cv::Mat & frame, Output output);
+
+		std::string _filepath; ///< Video path.
+		Output _output = Output::BGR; ///< Default output format.
+		int _streamIndex = -1; ///< Index of the video stream.
+		int _currentFrame = 0; ///< Index of the next frame.
+		double _frameRate = 30.0; ///< Frame rate.
+		sibr::Vector2i _resolution = { 0, 0 }; ///< Frame size.
+		bool _draining = false; ///< End of file reached, the decoder is flushing its last frames.
+		bool _pending = false; ///< The internal frame holds the next frame (after a seek).
+
+		bool _indexed = false; ///< Has the index been built.
+		std::vector<int64_t> _framesPts; ///< Presentation timestamps of all frames, sorted.
+		std::vector<int64_t> _keyframesPts; ///< Presentation timestamps of keyframes, sorted.
+		std::vector<int64_t> _keyframesDts; ///< Decoding timestamps of keyframes, used for seeking.
+
+		AVFormatContext * _format = nullptr; ///< Demuxer.
+		AVCodecContext * _codec = nullptr; ///< Decoder.
+		AVFrame * _frame = nullptr; ///< Decoded frame.
+		AVPacket * _packet = nullptr; ///< Demuxed packet.
+		SwsContext * _sws = nullptr; ///< Pixel format conversion.
+	};
+
+	/** Frame source for the VideoDecodeService using a FFVideoDecoder.
+	\ingroup sibr_video
+	*/
+	class SIBR_VIDEO_EXPORT FFVideoFrameSource : public FrameSource {
+		SIBR_CLASS_PTR(FFVideoFrameSource);
+
+	public:
+
+		/** Constructor.
+		\param path the video path
+		\param threadsCount number of decoding threads of the codec (0 to let ffmpeg decide)
+		*/
+		FFVideoFrameSource(const std::string & path, int threadsCount = 0) : _decoder(path, FFVideoDecoder::Output::BGR, threadsCount) {}
+
+		bool read(cv::Mat & frame) override { return _decoder.read(frame); }
+
+		void seek(int index) override { _decoder.seek(index); }
+
+		double frameRate() const override { return _decoder.frameRate(); }
+
+		/** \return true if the video could be opened. */
+		bool isValid() const { return _decoder.isFine(); }
+
+	private:
+		FFVideoDecoder _decoder; ///< Decoder.
+	};
+
+}
@@ -18,6 +18,7 @@ extern "C"
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libswscale/swscale.h>
+#include <libavutil/opt.h>
 }
 
 #define QQ(rat) (rat.num/(double)rat.den)
@@ -34,7 +35,20 @@ namespace sibr {
 		double _fps,
 		const sibr::Vector2i & size,
 		bool forceResize
-	) : filepath(_filepath), fps(_fps), _forceResize(forceResize)
+	) : FFVideoEncoder(_filepath, _fps, size, [forceResize]() {
+		VideoEncoderOptions options;
+		options.forceResize = forceResize;
+		return options;
+	}())
+	{
+	}
+
+	FFVideoEncoder::FFVideoEncoder(
+		const std::string & _filepath,
+		double _fps,
+		const sibr::Vector2i & size,
+		const VideoEncoderOptions & options
+	) : filepath(_filepath), fps(_fps), _forceResize(options.forceResize), _options(options)
 	{
 		/** Init FFMPEG, registering available codec plugins. */
 		if (!ffmpegInitDone) {
@@ -61,15 +75,51 @@ namespace sibr {
 		}
 		
 		init(sizeFix);
+
+		if (initWasFine && _options.async) {
+			const int convertersCount = std::max(1, _options.conversionThreads);
+			for (int t = 0; t < convertersCount; ++t) {
+				_converters.emplace_back(&FFVideoEncoder::convertLoop, this);
+			}
+			_writer = std::thread(&FFVideoEncoder::writeLoop, this);
+		}
 	}
 
 	bool FFVideoEncoder::isFine() const
 	{
-		return initWasFine;
+		return initWasFine && !_failed;
 	}
 
-	void FFVideoEncoder::close()
+	bool FFVideoEncoder::close()
 	{
+		// Wait for the queued frames.
+		if (_writer.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_stopping = true;
+			}
+			_convertReady.notify_all();
+			_encodeReady.notify_all();
+			for (std::thread & converter : _converters) {
+				converter.join();
+			}
+			_converters.clear();
+			_writer.join();
+		}
+
+		const bool success = isFine();
+		if (initWasFine) {
+			// Get the frames delayed by the encoder.
+			encode(NULL);
+			av_packet_free(&pkt);
+			if (_failed) {
+				SIBR_WRG << "[FFMPEG] Encoding to " << filepath << " failed after " << _encodedCount << " frames, the next ones were dropped." << std::endl;
+			} else if (_encodedCount > 0) {
+				_encodingTime = _timer.deltaTimeFromLastTic<Timer::micro>() / 1000000.0;
+				SIBR_LOG << "[FFMPEG] Encoded " << _encodedCount << " frames to " << filepath << " at " << throughput() << " fps." << std::endl;
+			}
+		}
+
 		if (av_write_trailer(pFormatCtx) < 0) {
 			SIBR_WRG << "[FFMPEG] Can not av_write_trailer " << std::endl;
 		}
@@ -81,7 +131,9 @@ namespace sibr {
 		avio_close(pFormatCtx->pb);
 		avformat_free_context(pFormatCtx);
 
+		initWasFine = false;
 		needFree = false;
+		return success;
 	}
 
 	FFVideoEncoder::~FFVideoEncoder()
@@ -92,6 +144,15 @@ namespace sibr {
 
 	}
 
+	double FFVideoEncoder::throughput() const
+	{
+		const double time = _encodingTime >= 0.0 ? _encodingTime : _timer.deltaTimeFromLastTic<Timer::micro>() / 1000000.0;
+		if (_encodedCount == 0 || time <= 0.0) {
+			return 0.0;
+		}
+		return double(_encodedCount) / time;
+	}
+
 	void FFVideoEncoder::init(const sibr::Vector2i & size)
 	{
 		w = size[0];
@@ -105,24 +166,33 @@ namespace sibr {
 		fmt = av_guess_format(NULL, out_file, NULL);
 		pFormatCtx->oformat = fmt;
 
-		const bool isH264 = pFormatCtx->oformat->video_codec == AV_CODEC_ID_H264;
-		if(isH264){
-			SIBR_LOG << "[FFMPEG] Found H264 codec." << std::endl;
-		} else {
-			SIBR_LOG << "[FFMPEG] Found codec with ID " << pFormatCtx->oformat->video_codec << " (not H264)." << std::endl;
-		}
-		
 		if (avio_open(&pFormatCtx->pb, out_file, AVIO_FLAG_READ_WRITE) < 0) {
 			SIBR_WRG << "[FFMPEG] Could not open file " << filepath << std::endl;
 			return;
 		}
 
-		pCodec = avcodec_find_encoder(pFormatCtx->oformat->video_codec);
+		pCodec = NULL;
+		if (!_options.codec.empty()) {
+			pCodec = avcodec_find_encoder_by_name(_options.codec.c_str());
+			if (!pCodec) {
+				SIBR_WRG << "[FFMPEG] Could not find encoder " << _options.codec << ", using the default one." << std::endl;
+			}
+		}
+		if (!pCodec) {
+			pCodec = avcodec_find_encoder(pFormatCtx->oformat->video_codec);
+		}
 		if (!pCodec) {
 			SIBR_WRG << "[FFMPEG] Could not find codec." << std::endl;
 			return;
 		}
 
+		const bool isH264 = pCodec->id == AV_CODEC_ID_H264;
+		if(isH264){
+			SIBR_LOG << "[FFMPEG] Found H264 codec (" << pCodec->name << ")." << std::endl;
+		} else {
+			SIBR_LOG << "[FFMPEG] Found codec " << pCodec->name << " (not H264)." << std::endl;
+		}
+
 		video_st = avformat_new_stream(pFormatCtx, pCodec);
 
 		if (video_st == NULL) {
@@ -131,30 +201,37 @@ namespace sibr {
 		}
 
 		pCodecCtx = video_st->codec;
-		pCodecCtx->codec_id = fmt->video_codec;
+		pCodecCtx->codec_id = pCodec->id;
 		pCodecCtx->codec_type = AVMEDIA_TYPE_VIDEO;
 		pCodecCtx->pix_fmt = AV_PIX_FMT_YUV420P;
 		pCodecCtx->width = w;
 		pCodecCtx->height = h;
-		pCodecCtx->gop_size = 10;
+		pCodecCtx->gop_size = _options.gopSize;
 		pCodecCtx->time_base.num = 1;
 		pCodecCtx->time_base.den = (int)std::round(fps);
+		pCodecCtx->thread_count = std::max(0, _options.threadsCount);
+		pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 
 		// Required for the header to be well-formed and compatible with Powerpoint/MediaPlayer/...
 		if (pFormatCtx->oformat->flags & AVFMT_GLOBALHEADER) {
 			pCodecCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
 		}
 
-		//H.264 specific options.
+		// Codec specific options, only set if the encoder supports them.
 		AVDictionary *param = 0;
-		if (pCodecCtx->codec_id == AV_CODEC_ID_H264) {
-			av_dict_set(&param, "preset", "slow", 0);
-			av_dict_set(&param, "tune", "zerolatency", 0);
-		}
+		auto setOption = [&param, this](const char * name, const std::string & value) {
+			if (!value.empty() && av_opt_find((void*)&pCodec->priv_class, name, NULL, 0, AV_OPT_SEARCH_FAKE_OBJ)) {
+				av_dict_set(&param, name, value.c_str(), 0);
+			}
+		};
+		setOption("preset", _options.preset);
+		setOption("tune", _options.tune);
+		setOption("crf", _options.crf >= 0 ? std::to_string(_options.crf) : "");
 
 		av_dump_format(pFormatCtx, 0, out_file, 1);
 
 		int res = avcodec_open2(pCodecCtx, pCodec, &param);
+		av_dict_free(&param);
 		if(res < 0){
 			SIBR_WRG << "[FFMPEG] Failed to open encoder, error: " << res << std::endl;
 			return;
@@ -183,49 +260,139 @@ namespace sibr {
 
 	bool FFVideoEncoder::operator<<(cv::Mat frame)
 	{
-		if (!video_st) {
+		if (!video_st || !initWasFine) {
 			return false;
 		}
-		cv::Mat local;
-		if (frame.cols != w || frame.rows != h) {
-			if(_forceResize) {
-				cv::resize(frame, local, cv::Size(w,h));
-			} else {
-				SIBR_WRG << "[FFMPEG] Frame doesn't have the same dimensions as the video." << std::endl;
+		if ((frame.cols != w || frame.rows != h) && !_forceResize) {
+			SIBR_WRG << "[FFMPEG] Frame doesn't have the same dimensions as the video." << std::endl;
+			return false;
+		}
+		const int index = frameCount++;
+		if (index == 0) {
+			_timer.tic();
+		}
+
+		if (!_options.async) {
+			convert(frame, cvFrameYUV);
+			return encodeYUV(cvFrameYUV, index);
+		}
+
+		// The caller can reuse its buffer as soon as we return.
+		cv::Mat copy = frame.clone();
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_spaceReady.wait(lock, [this] { return _inFlight < std::max(size_t(1), _options.queueSize) || _failed; });
+			if (_failed) {
 				return false;
 			}
+			++_inFlight;
+			_toConvert.emplace_back(index, std::move(copy));
+		}
+		_convertReady.notify_one();
+		return true;
+	}
+
+	bool FFVideoEncoder::operator<<(const sibr::ImageRGB & frame){
+		return (*this)<<(frame.toOpenCVBGR());
+	}
+
+	void FFVideoEncoder::convert(const cv::Mat & frame, cv::Mat & yuv) const
+	{
+		if (frame.cols != w || frame.rows != h) {
+			cv::Mat local;
+			cv::resize(frame, local, cv::Size(w, h));
+			cv::cvtColor(local, yuv, cv::COLOR_BGR2YUV_I420);
 		} else {
-			local = frame;
+			cv::cvtColor(frame, yuv, cv::COLOR_BGR2YUV_I420);
 		}
+	}
 
-		cv::cvtColor(local, cvFrameYUV, cv::COLOR_BGR2YUV_I420);
-		frameYUV->data[0] = cvFrameYUV.data;
+	bool FFVideoEncoder::encodeYUV(const cv::Mat & yuv, int index)
+	{
+		frameYUV->data[0] = yuv.data;
 		frameYUV->data[1] = frameYUV->data[0] + yuSize[0];
 		frameYUV->data[2] = frameYUV->data[1] + yuSize[1];
 
 		//frameYUV->pts = (1.0 / std::round(fps)) *frameCount * 90;
-		frameYUV->pts = (int)(frameCount*(video_st->time_base.den) / ((video_st->time_base.num) * std::round(fps)));
-		++frameCount;
+		frameYUV->pts = (int)(index*(video_st->time_base.den) / ((video_st->time_base.num) * std::round(fps)));
 
 		return encode(frameYUV);
 	}
 
-	bool FFVideoEncoder::operator<<(const sibr::ImageRGB & frame){
-		return (*this)<<(frame.toOpenCVBGR());
+	void FFVideoEncoder::convertLoop()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (true) {
+			_convertReady.wait(lock, [this] { return !_toConvert.empty() || _stopping; });
+			if (_toConvert.empty()) {
+				// Stopping and nothing left to convert.
+				return;
+			}
+			std::pair<int, cv::Mat> job = std::move(_toConvert.front());
+			_toConvert.pop_front();
+
+			lock.unlock();
+			cv::Mat yuv;
+			convert(job.second, yuv);
+			lock.lock();
+
+			_toEncode[job.first] = yuv;
+			_encodeReady.notify_all();
+		}
 	}
 
-	bool FFVideoEncoder::encode(AVFrame * frame)
+	void FFVideoEncoder::writeLoop()
 	{
-		int got_picture = 0;
+		int next = 0;
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (true) {
+			// Frames are converted out of order, wait for the next one.
+			_encodeReady.wait(lock, [this, next] {
+				return _toEncode.count(next) > 0 || (_stopping && _inFlight == 0);
+			});
+			auto frame = _toEncode.find(next);
+			if (frame == _toEncode.end()) {
+				return;
+			}
+			cv::Mat yuv = frame->second;
+			_toEncode.erase(frame);
+
+			lock.unlock();
+			const bool encoded = encodeYUV(yuv, next);
+			lock.lock();
+
+			if (!encoded) {
+				// Drop the pending frames and release the producers, close() reports the failure.
+				SIBR_WRG << "[FFMPEG] Failed to encode frame " << next << ", stopping the encoder." << std::endl;
+				_failed = true;
+				_toConvert.clear();
+				_toEncode.clear();
+				_inFlight = 0;
+				_spaceReady.notify_all();
+				return;
+			}
+			++next;
+			--_inFlight;
+			_spaceReady.notify_one();
+		}
+	}
 
-		int ret = avcodec_encode_video2(pCodecCtx, pkt, frameYUV, &got_picture);
+	bool FFVideoEncoder::encode(AVFrame * frame)
+	{
+		int ret = avcodec_send_frame(pCodecCtx, frame);
 		if (ret < 0) {
 			SIBR_WRG << "[FFMPEG] Failed to encode frame." << std::endl;
 			return false;
 		}
-		if (got_picture == 1) {
+		if (frame) {
+			++_encodedCount;
+		}
+		// Write all the packets available, when flushing this empties the encoder.
+		while (avcodec_receive_packet(pCodecCtx, pkt) == 0) {
 			pkt->stream_index = video_st->index;
-			ret = av_write_frame(pFormatCtx, pkt);
+			if (av_write_frame(pFormatCtx, pkt) < 0) {
+				SIBR_WRG << "[FFMPEG] Failed to write packet." << std::endl;
+			}
 			av_packet_unref(pkt);
 		}
 
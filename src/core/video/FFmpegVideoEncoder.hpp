@@ -14,7 +14,14 @@
 
 
 #include <string>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <core/graphics/Image.hpp>
+#include <core/system/SimpleTimer.hpp>
 #include "Video.hpp"
 #include "Config.hpp"
 
@@ -29,6 +36,21 @@ struct AVPacket;
 
 namespace sibr {
 
+	/** Encoding parameters of a FFVideoEncoder.
+	\ingroup sibr_video
+	*/
+	struct SIBR_VIDEO_EXPORT VideoEncoderOptions {
+		std::string codec; ///< Encoder name (libx264, libx265, h264_nvenc,...), empty for the default codec of the container.
+		int crf = -1; ///< Constant rate factor (x264/x265, lower is better), negative for the codec default.
+		std::string preset = "slow"; ///< Encoder preset, empty for the codec default.
+		std::string tune = "zerolatency"; ///< Encoder tuning, empty for none. Note that zerolatency disables x264 frame threading.
+		int gopSize = 10; ///< Maximum distance between keyframes.
+		int threadsCount = 0; ///< Codec threads, 0 to let ffmpeg decide.
+		bool async = false; ///< Convert and encode frames on background threads, operator<< only queues them.
+		size_t queueSize = 16; ///< Maximum number of frames in flight in asynchronous mode, operator<< blocks when it is reached.
+		int conversionThreads = 2; ///< Number of colour conversion threads in asynchronous mode.
+		bool forceResize = false; ///< Resize frames that are not at the target dimensions instead of ignoring them.
+	};
 	
 	/** Video encoder using ffmpeg.
 	Adapted from https://github.com/leixiaohua1020/simplest_ffmpeg_video_encoder/blob/master/simplest_ffmpeg_video_encoder/simplest_ffmpeg_video_encoder.cpp
@@ -51,15 +73,32 @@ namespace sibr {
 			bool forceResize = false
 		);
 
-		/** \return true if the encoder was properly setup. */
+		/** Constructor.
+		\param _filepath destination file, the extension will be used to infer the container type.
+		\param fps target video framerate
+		\param size target video size, should be even else a resize will happen
+		\param options encoding parameters
+		*/
+		FFVideoEncoder(
+			const std::string & _filepath,
+			double fps,
+			const sibr::Vector2i & size,
+			const VideoEncoderOptions & options
+		);
+
+		/** \return true if the encoder was properly setup and no asynchronous encoding failed. */
 		bool isFine() const;
 
-		/** Close the file. */
-		void close();
+		/** Encode the remaining frames and close the file.
+		\return false if the encoder was not setup or a frame could not be encoded in asynchronous mode
+		*/
+		bool close();
 
 		/** Encode a frame.
 		\param frame the frame to encode
 		\return a success flag 
+		\note In asynchronous mode the frame is copied and queued, blocking if the queue is full.
+		 Once an encoding has failed, the queued frames are dropped and the next ones are refused.
 		*/
 		bool operator << (cv::Mat frame);
 
@@ -69,18 +108,43 @@ namespace sibr {
 		*/
 		bool operator << (const sibr::ImageRGB & frame);
 
+		/** \return the number of frames encoded so far. */
+		int encodedFrames() const { return _encodedCount; }
+
+		/** \return the encoding throughput since the first frame, in frames per second. */
+		double throughput() const;
+
 		/// Destructor.
 		~FFVideoEncoder();
 
 	protected:
 
+		/** Resize and convert a frame to YUV 4:2:0.
+		\param frame the BGR frame
+		\param yuv will contain the I420 planes
+		*/
+		void convert(const cv::Mat & frame, cv::Mat & yuv) const;
+
+		/** Encode a converted frame.
+		\param yuv the I420 planes
+		\param index the frame index
+		\return a success flag
+		*/
+		bool encodeYUV(const cv::Mat & yuv, int index);
+
+		/** Colour conversion thread loop (asynchronous mode). */
+		void convertLoop();
+
+		/** Encoding thread loop (asynchronous mode), encodes the converted frames in order. */
+		void writeLoop();
+
 		/** Setup the encoder.
 		\param size the video target size, prfer using power of two.
 		*/
 		void init(const sibr::Vector2i & size);
 		
 		/** Encode a frame to the file.
-		\param frame the frame to encode
+		\param frame the frame to encode, NULL to flush the encoder
 		\return a success flag.
 		*/
 		bool encode(AVFrame *frame);
@@ -92,6 +156,7 @@ namespace sibr {
 		int frameCount = 0; ///< Current frame.
 		double fps; ///< Framerate.
 		bool _forceResize = false; ///< Resize frames.
+		VideoEncoderOptions _options; ///< Encoding parameters.
 		
 		AVFrame * frameYUV = NULL; ///< Working frame.
 		cv::Mat cvFrameYUV; ///< Working frame data.
@@ -103,6 +168,22 @@ namespace sibr {
 		AVCodecContext* pCodecCtx; ///< Codec context.
 		AVCodec* pCodec; ///< Codec.
 		AVPacket * pkt; ///< Encoding packet.
+
+		std::deque<std::pair<int, cv::Mat>> _toConvert; ///< Frames waiting for conversion (asynchronous mode).
+		std::map<int, cv::Mat> _toEncode; ///< Converted frames waiting to be encoded, by index (asynchronous mode).
+		size_t _inFlight = 0; ///< Number of queued frames not encoded yet.
+		bool _stopping = false; ///< Stop the background threads once the queues are empty.
+		std::atomic<bool> _failed = { false }; ///< A frame could not be encoded in asynchronous mode, encoding stopped.
+		std::vector<std::thread> _converters; ///< Colour conversion threads.
+		std::thread _writer; ///< Encoding thread.
+		std::mutex _mutex; ///< Protects the queues.
+		std::condition_variable _convertReady; ///< Signaled when a frame is queued for conversion.
+		std::condition_variable _encodeReady; ///< Signaled when a frame has been converted.
+		std::condition_variable _spaceReady; ///< Signaled when a frame has been encoded.
+
+		std::atomic<int> _encodedCount = { 0 }; ///< Number of encoded frames.
+		sibr::Timer _timer; ///< Started at the first frame, for throughput measurement.
+		double _encodingTime = -1.0; ///< Time between the first frame and the end of encoding, in seconds (once closed).
 		
 		static bool ffmpegInitDone; ///< FFMPEG initialization status.
 
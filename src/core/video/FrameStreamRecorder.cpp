@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "FrameStreamRecorder.hpp"
+#include "core/system/SimpleTimer.hpp"
+
+namespace sibr
+{
+	FrameStreamRecorder::FrameStreamRecorder(const IAsyncReadback::Ptr & readback, const FrameSink & sink, const FrameStreamOptions & options) :
+		_readback(readback), _sink(sink), _options(options)
+	{
+		_options.queueSize = std::max(_options.queueSize, size_t(1));
+		_consumer = std::thread(&FrameStreamRecorder::consumerLoop, this);
+	}
+
+	FrameStreamRecorder::~FrameStreamRecorder()
+	{
+		finish();
+	}
+
+	void FrameStreamRecorder::capture()
+	{
+		if (_finished) {
+			return;
+		}
+		collect(false);
+		if (_readback->full()) {
+			// The consumer of the readbacks is us: wait for the oldest one to free its slot.
+			sibr::Timer timer;
+			timer.tic();
+			collect(true);
+			const double elapsed = timer.deltaTimeFromLastTic();
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stats.readbackWait += elapsed;
+		}
+		_readback->request();
+		std::lock_guard<std::mutex> lock(_mutex);
+		++_stats.requested;
+	}
+
+	void FrameStreamRecorder::finish()
+	{
+		if (_finished) {
+			return;
+		}
+		_finished = true;
+		while (_readback->pending() > 0) {
+			collect(true);
+		}
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_done = true;
+		}
+		_frameReady.notify_all();
+		_consumer.join();
+	}
+
+	size_t FrameStreamRecorder::queued() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _queue.size();
+	}
+
+	FrameStreamStats FrameStreamRecorder::stats() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _stats;
+	}
+
+	FrameStreamRecorder::FrameSink FrameStreamRecorder::encoderSink(const std::shared_ptr<FFVideoEncoder> & encoder)
+	{
+		return [encoder](const cv::Mat & frame) {
+			return (*encoder) << frame;
+		};
+	}
+
+	void FrameStreamRecorder::collect(bool waitOne)
+	{
+		cv::Mat frame;
+		bool wait = waitOne;
+		while (_readback->pending() > 0 && _readback->retrieve(frame, wait)) {
+			push(std::move(frame));
+			frame = cv::Mat();
+			wait = false;
+		}
+	}
+
+	void FrameStreamRecorder::push(cv::Mat && frame)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (_queue.size() >= _options.queueSize) {
+			if (_options.dropWhenFull) {
+				++_stats.dropped;
+				return;
+			}
+			sibr::Timer timer;
+			timer.tic();
+			_spaceReady.wait(lock, [this]() { return _queue.size() < _options.queueSize; });
+			_stats.queueWait += timer.deltaTimeFromLastTic();
+		}
+		_queue.push_back(std::move(frame));
+		lock.unlock();
+		_frameReady.notify_one();
+	}
+
+	void FrameStreamRecorder::consumerLoop()
+	{
+		while (true) {
+			cv::Mat frame;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_frameReady.wait(lock, [this]() { return _done || !_queue.empty(); });
+				if (_queue.empty()) {
+					return;
+				}
+				frame = std::move(_queue.front());
+				_queue.pop_front();
+			}
+			_spaceReady.notify_one();
+
+			const bool success = _sink(frame);
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (success) {
+				++_stats.written;
+			} else {
+				++_stats.failed;
+			}
+		}
+	}
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+#include "Config.hpp"
+#include "core/graphics/RenderTarget.hpp"
+#include "core/video/FFmpegVideoEncoder.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace sibr
+{
+	/**
+	* \addtogroup sibr_video
+	* @{
+	*/
+
+	/** Parameters of a FrameStreamRecorder. */
+	struct SIBR_VIDEO_EXPORT FrameStreamOptions {
+		size_t queueSize = 8; ///< Maximum number of retrieved frames waiting for the consumer.
+		bool dropWhenFull = false; ///< Drop frames instead of blocking the render loop when the queue is full.
+	};
+
+	/** Counters of a FrameStreamRecorder, durations in milliseconds. */
+	struct SIBR_VIDEO_EXPORT FrameStreamStats {
+		size_t requested = 0; ///< Number of readbacks requested.
+		size_t written = 0; ///< Number of frames successfully consumed.
+		size_t failed = 0; ///< Number of frames the consumer could not handle.
+		size_t dropped = 0; ///< Number of frames dropped because the queue was full.
+		double readbackWait = 0.0; ///< Time the render loop was blocked by a full readback ring.
+		double queueWait = 0.0; ///< Time the render loop was blocked by a full queue.
+	};
+
+	/** Stream frames read back asynchronously to a consumer thread, without accumulating them.
+	 Each call to capture() requests a readback and moves the already available ones to a bounded queue,
+	 emptied by a consumer thread (typically encoding a video). Back-pressure: when the readback source
+	 is full the render loop waits for its oldest request, and when the queue is full it either waits for
+	 the consumer or drops the frame, see FrameStreamOptions. The order of the frames is preserved.
+	 The readback source is only used on the calling thread (the one owning the OpenGL context for a
+	 PixelPackReadback), the sink only on the consumer thread.
+	*/
+	class SIBR_VIDEO_EXPORT FrameStreamRecorder {
+		SIBR_CLASS_PTR(FrameStreamRecorder);
+
+	public:
+
+		/** Frame consumer, returning false on failure. */
+		typedef std::function<bool(const cv::Mat &)> FrameSink;
+
+		/** Constructor, starts the consumer thread.
+		\param readback the readback source
+		\param sink the frame consumer
+		\param options queueing parameters
+		*/
+		FrameStreamRecorder(const IAsyncReadback::Ptr & readback, const FrameSink & sink, const FrameStreamOptions & options = {});
+
+		/** Destructor, finishes the stream. */
+		~FrameStreamRecorder();
+
+		/** Request the readback of the current frame, and queue the frames already read back. */
+		void capture();
+
+		/** Wait for all pending readbacks, then for the consumer to process all queued frames, and stop it.
+		 Further captures are ignored. */
+		void finish();
+
+		/** \return true once finish() has been called. */
+		bool finished() const { return _finished; }
+
+		/** \return the number of frames waiting for the consumer. */
+		size_t queued() const;
+
+		/** \return the counters. */
+		FrameStreamStats stats() const;
+
+		/** Sink sending the frames to a video encoder, that should be created with forceResize if the
+		 frames size can change. The encoder is not closed when the stream is finished.
+		\param encoder the video encoder
+		\return the sink
+		*/
+		static FrameSink encoderSink(const std::shared_ptr<FFVideoEncoder> & encoder);
+
+	private:
+
+		/** Move the frames read back to the queue.
+		\param waitOne block until the oldest pending readback is available
+		*/
+		void collect(bool waitOne);
+
+		/** Add a frame to the queue, waiting for space or dropping it when the queue is full.
+		\param frame the frame
+		*/
+		void push(cv::Mat && frame);
+
+		/** Consumer thread loop. */
+		void consumerLoop();
+
+		IAsyncReadback::Ptr _readback; ///< Readback source.
+		FrameSink _sink; ///< Frames consumer.
+		FrameStreamOptions _options; ///< Queueing parameters.
+		bool _finished = false; ///< The stream is finished.
+
+		std::deque<cv::Mat> _queue; ///< Frames waiting for the consumer.
+		mutable std::mutex _mutex; ///< Protects the queue, the counters and the flag below.
+		std::condition_variable _frameReady; ///< Signaled when a frame is queued or the stream is finished.
+		std::condition_variable _spaceReady; ///< Signaled when a frame is dequeued.
+		bool _done = false; ///< No more frames will be queued.
+		FrameStreamStats _stats; ///< Counters.
+		std::thread _consumer; ///< Consumer thread.
+	};
+
+	/** @} */
+}
@@ -75,18 +75,53 @@ namespace sibr
 			}
 		}
 
+		/** Update a set of video players to the frames to present at a given time.
+		\param videos the video players to udpate
+		\param timestamp the presentation time, in seconds
+		\note Internally calls both updateCPU and updateGPU. Meant for players using asynchronous decoding
+		(see VideoPlayer::enableAsyncDecoding, ideally with a shared VideoDecodeService): the videos stay
+		synchronized even if some of them are decoded late.
+		*/
+		void update(const std::vector<sibr::VideoPlayer::Ptr> & videos, double timestamp) {
+			updateCPU(videos, timestamp);
+			updateGPU(videos);
+
+			loadingTexArray = (loadingTexArray + 1) % 2;
+
+			if (first) {
+				first = false;
+			} else {
+				displayTexArray = (displayTexArray + 1) % 2;
+			}
+		}
+
 		/** Load the next frame on the CPU for a set of video players.
 		\param videos the video players to udpate
 		*/
 		void updateCPU(const std::vector<sibr::VideoPlayer::Ptr> & videos) {
-			size_t numVids = videos.size();
+			const int numVids = (int)videos.size();
 
-			for (size_t i = 0; i < numVids; ++i) {
+#pragma omp parallel for
+			for (int i = 0; i < numVids; ++i) {
 				videos[i]->updateCPU();
 			}
 
 		}
 
+		/** Load the frames to present at a given time on the CPU for a set of video players.
+		Players that have no new frame ready keep their current one.
+		\param videos the video players to udpate
+		\param timestamp the presentation time, in seconds
+		*/
+		void updateCPU(const std::vector<sibr::VideoPlayer::Ptr> & videos, double timestamp) {
+			const int numVids = (int)videos.size();
+
+#pragma omp parallel for
+			for (int i = 0; i < numVids; ++i) {
+				videos[i]->updateCPU(timestamp);
+			}
+		}
+
 		/** Upload the next frame to the GPU for a set of video players.
 		\param videos the video players to udpate
 		*/
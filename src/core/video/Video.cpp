@@ -12,6 +12,7 @@
 
 #include "Video.hpp"
 #include "VideoUtils.hpp"
+#include "FFmpegVideoDecoder.hpp"
 
 namespace sibr
 {
@@ -26,11 +27,33 @@ namespace sibr
 			resolution[0] = (int)cap.get(cv::VideoCaptureProperties::CAP_PROP_FRAME_WIDTH);
 			resolution[1] = (int)cap.get(cv::VideoCaptureProperties::CAP_PROP_FRAME_HEIGHT);
 			codec = (int)cap.get(cv::VideoCaptureProperties::CAP_PROP_FOURCC);
+			if (backend == Backend::FFMPEG) {
+				openDecoder();
+			}
 			SIBR_LOG << "[Video] " << path << " loaded." << std::endl;
 		}
 		return loaded;
 	}
 
+	void Video::setBackend(Backend _backend)
+	{
+		backend = _backend;
+		decoder.reset();
+		if (loaded && backend == Backend::FFMPEG) {
+			openDecoder();
+		}
+	}
+
+	void Video::openDecoder()
+	{
+		decoder.reset(new FFVideoDecoder(filepath.string()));
+		if (!decoder->isFine()) {
+			SIBR_WRG << "[Video] Could not open " << filepath << " with FFMPEG, using OpenCV." << std::endl;
+			decoder.reset();
+			backend = Backend::OPENCV;
+		}
+	}
+
 	const sibr::Vector2i & Video::getResolution() { 
 		checkLoad();  
 		return resolution; 
@@ -43,11 +66,18 @@ namespace sibr
 
 	int Video::getCurrentFrameNumber() { 
 		checkLoad();  
+		if (decoder) {
+			return decoder->currentFrame();
+		}
 		return (int)cap.get(cv::VideoCaptureProperties::CAP_PROP_POS_FRAMES); 
 	}
 	
 	void Video::setCurrentFrame(int i){ 
 		checkLoad(); 
+		if (decoder) {
+			decoder->seek(i);
+			return;
+		}
 		cap.set(cv::VideoCaptureProperties::CAP_PROP_POS_FRAMES, i); 
 	}
 	
@@ -77,6 +107,7 @@ namespace sibr
 	void Video::release()
 	{
 		cap = cv::VideoCapture();
+		decoder.reset();
 		loaded = false;
 	}
 
@@ -102,7 +133,13 @@ namespace sibr
 		cv::Mat volume(L, N, CV_8UC1);
 		setCurrentFrame(starting_frame);
 		for (int i = 0; i < L; ++i) {
-			cap >> volume.row(i).reshape(3, h);
+			cv::Mat frame = volume.row(i).reshape(3, h);
+			if (decoder) {
+				// Converted in place in the volume.
+				decoder->read(frame);
+			} else {
+				cap >> frame;
+			}
 		}
 		setCurrentFrame(0);
 
@@ -113,10 +150,29 @@ namespace sibr
 	{
 		checkLoad();
 		cv::Mat frame;
-		cap >> frame;
+		if (decoder) {
+			decoder->read(frame, FFVideoDecoder::Output::BGR);
+		} else {
+			cap >> frame;
+		}
 		return frame;
 	}
 
+	cv::Mat Video::nextGrey()
+	{
+		checkLoad();
+		cv::Mat frame;
+		if (decoder) {
+			decoder->read(frame, FFVideoDecoder::Output::GRAY);
+			return frame;
+		}
+		cap >> frame;
+		if (frame.empty()) {
+			return frame;
+		}
+		return VideoUtils::getGrey(frame);
+	}
+
 	cv::VideoCapture & Video::getCVvideo()
 	{
 		checkLoad();
@@ -147,6 +203,7 @@ namespace sibr
 
 	bool VideoPlayer::load(const std::string & path) {
 		VideoPlayer other;
+		other.backend = backend;
 		if (other.Video::load(path)) {
 			*this = other;
 			return true;
@@ -164,7 +221,10 @@ namespace sibr
 		checkLoad();
 
 		if (first) {
-			loadNext();
+			if (!loadNext() && asyncDecoding()) {
+				// Nothing decoded yet, try again next time.
+				return;
+			}
 			loadingTex = (loadingTex + 1) % 2;
 			first = false;
 			return;
@@ -174,7 +234,10 @@ namespace sibr
 			return;
 		}
 
-		loadNext();
+		if (!loadNext() && asyncDecoding()) {
+			// Keep displaying the current frame until the next one is ready.
+			return;
+		}
 
 		displayTex = (displayTex + 1) % 2;
 		loadingTex = (loadingTex + 1) % 2;
@@ -195,17 +258,38 @@ namespace sibr
 		}
 		ImGui::SameLine();
 		ImGui::Checkbox("Repeat when finished", &repeat_when_end);
+		ImGui::SameLine();
+		if (ImGui::Checkbox("Cache when scrubbing", &cache_when_scrubbing) && !cache_when_scrubbing) {
+			disableFrameCache();
+		}
 
-		current_frame_slider = getCurrentFrameNumber();
+		current_frame_slider = getLoadedFrameNumber();
 		ImGui::Separator();
 		ImGui::PushScaledItemWidth(500);
 		if (ImGui::SliderInt("timeline", &current_frame_slider, 1, getNumFrames())) {
-			setCurrentFrame(current_frame_slider);
+			// Scrubbing back and forth reuses the frames decoded around the slider position.
+			if (cache_when_scrubbing && !asyncDecoding() && !frameCache) {
+				enableFrameCache();
+			}
+			if (asyncDecoding()) {
+				decodeService->seek(*decodeStream, current_frame_slider);
+			} else if (frameCache) {
+				cacheFrameIndex = current_frame_slider;
+			} else {
+				setCurrentFrame(current_frame_slider);
+			}
 			loadingTex = displayTex;
 			first = true;
 		}
 		ImGui::PopItemWidth();
 
+		if (frameCache) {
+			const std::string cacheInfos = "cache : " + std::to_string(frameCache->size()) + " frames, " +
+				std::to_string(frameCache->memoryUsage() >> 20) + " MB, hits " + std::to_string(frameCache->hits()) +
+				", misses " + std::to_string(frameCache->misses());
+			ImGui::Text(cacheInfos.c_str());
+		}
+
 		ImGui::Separator();
 
 		if (getDisplayTex() && getDisplayTex()->handle() ) {
@@ -226,6 +310,35 @@ namespace sibr
 
 		checkLoad();
 
+		if (asyncDecoding()) {
+			DecodedFrame frame;
+			if (!decodeService->acquireNext(*decodeStream, frame)) {
+				return false;
+			}
+			tmpFrame = frame.image;
+			asyncFrameIndex = frame.index;
+			return true;
+		}
+
+		if (frameCache) {
+			cv::Mat frame;
+			if (frameCache->get(cacheFrameIndex, frame)) {
+				tmpFrame = transformation(frame);
+				++cacheFrameIndex;
+				return true;
+			}
+			if (cacheFrameIndex == 0) {
+				SIBR_WRG << "[Video] Could not load next frames." << std::endl;
+				return false;
+			}
+			if (repeat_when_end) {
+				cacheFrameIndex = 0;
+				return updateCPU();
+			}
+			mode = PAUSE;
+			return false;
+		}
+
 		bool alreayEmpty = tmpFrame.empty();
 		tmpFrame = next();
 		if (!tmpFrame.empty()) {
@@ -246,6 +359,108 @@ namespace sibr
 		}	
 	}
 
+	bool VideoPlayer::updateCPU(double timestamp)
+	{
+		if (!asyncDecoding()) {
+			return updateCPU();
+		}
+
+		checkLoad();
+		DecodedFrame frame;
+		if (!decodeService->acquire(*decodeStream, timestamp, frame)) {
+			return false;
+		}
+		tmpFrame = frame.image;
+		asyncFrameIndex = frame.index;
+		return true;
+	}
+
+	void VideoPlayer::enableAsyncDecoding(const VideoDecodeService::Ptr & service, const DecodeStreamOptions & options)
+	{
+		checkLoad();
+		disableAsyncDecoding();
+		disableFrameCache();
+
+		decodeService = service ? service : VideoDecodeService::Ptr(new VideoDecodeService(1));
+		DecodeStreamOptions streamOptions = options;
+		streamOptions.loop = repeat_when_end;
+		streamOptions.transformation = transformation;
+		int stream = -1;
+		if (backend == Backend::FFMPEG) {
+			FFVideoFrameSource::Ptr source(new FFVideoFrameSource(getFilepath().string()));
+			if (source->isValid()) {
+				stream = decodeService->addStream(source, streamOptions);
+			}
+		} else {
+			stream = decodeService->addStream(getFilepath().string(), streamOptions);
+		}
+		if (stream < 0) {
+			decodeService.reset();
+			return;
+		}
+		// Start from the current position of the synchronous capture.
+		decodeService->seek(stream, getCurrentFrameNumber());
+		VideoDecodeService::Ptr owner = decodeService;
+		decodeStream = std::shared_ptr<int>(new int(stream), [owner](int * id) {
+			owner->removeStream(*id);
+			delete id;
+		});
+	}
+
+	void VideoPlayer::disableAsyncDecoding()
+	{
+		if (asyncDecoding()) {
+			// Resume synchronous decoding after the last displayed frame.
+			setCurrentFrame(asyncFrameIndex + 1);
+		}
+		decodeStream.reset();
+		decodeService.reset();
+	}
+
+	void VideoPlayer::enableFrameCache(const FrameCacheOptions & options)
+	{
+		checkLoad();
+		disableAsyncDecoding();
+		disableFrameCache();
+
+		FrameSource::Ptr source;
+		if (backend == Backend::FFMPEG) {
+			FFVideoFrameSource::Ptr ffSource(new FFVideoFrameSource(getFilepath().string()));
+			if (ffSource->isValid()) {
+				source = ffSource;
+			}
+		} else {
+			VideoFrameSource::Ptr cvSource(new VideoFrameSource(getFilepath().string()));
+			if (cvSource->isValid()) {
+				source = cvSource;
+			}
+		}
+		if (!source) {
+			SIBR_WRG << "[Video] Could not open " << getFilepath().string() << " for caching." << std::endl;
+			return;
+		}
+		// Start from the current position of the synchronous capture.
+		cacheFrameIndex = getCurrentFrameNumber();
+		frameCache = VideoFrameCache::Ptr(new VideoFrameCache(source, options));
+	}
+
+	void VideoPlayer::disableFrameCache()
+	{
+		if (frameCache) {
+			// Resume synchronous decoding after the last displayed frame.
+			setCurrentFrame(cacheFrameIndex);
+		}
+		frameCache.reset();
+	}
+
+	int VideoPlayer::getLoadedFrameNumber()
+	{
+		if (asyncDecoding()) {
+			return asyncFrameIndex;
+		}
+		return frameCache ? cacheFrameIndex : getCurrentFrameNumber();
+	}
+
 	void VideoPlayer::updateGPU()
 	{
 		if (getLoadingTex().get()) {
@@ -255,11 +470,13 @@ namespace sibr
 		}
 	}
 
-	void VideoPlayer::loadNext()
+	bool VideoPlayer::loadNext()
 	{
 		if (updateCPU()) {
 			updateGPU();
+			return true;
 		}
+		return false;
 	}
 
 } // namespace sibr
@@ -13,6 +13,8 @@
 #pragma once
 
 #include "Config.hpp"
+#include "VideoDecodeService.hpp"
+#include "VideoFrameCache.hpp"
 
 #include <core/graphics/Texture.hpp>
 #include <core/graphics/GUI.hpp>
@@ -24,6 +26,7 @@
 
 namespace sibr
 {
+	class FFVideoDecoder;
 
 	/** Video loaded from a file using OpenCV VideoCapture and FFMPEG.
 	* \ingroup sibr_video
@@ -34,12 +37,28 @@ namespace sibr
 		
 	public:
 
+		/** Decoding backend. */
+		enum class Backend {
+			OPENCV, ///< cv::VideoCapture.
+			FFMPEG ///< FFVideoDecoder: frame accurate seeking, threaded decoding and direct luma access.
+		};
+
 		/** Constructor.
 		\param path the path to the video file
 		\note No loading will be performed at construction. Call load.
 		*/
 		Video(const std::string & path = "") : filepath(path) {}
 
+		/** Select the decoding backend used by next, nextGrey, getVolume and frame seeking.
+		If the video is already loaded, reading restarts at the first frame.
+		\param backend the new backend
+		\note The capture object returned by getCVvideo is not affected.
+		*/
+		void setBackend(Backend backend);
+
+		/** \return the decoding backend. */
+		Backend getBackend() const { return backend; }
+
 		/** Load from a given file on disk.
 		\param path path to the video
 		\return a success flag
@@ -97,6 +116,12 @@ namespace sibr
 		/** \return the next frame. */
 		cv::Mat next();
 
+		/** \return the luma of the next frame.
+		\note With the FFMPEG backend, the colour conversion is skipped and the returned matrix usually points
+		to the decoder memory: it is only valid until the next read, clone it to keep it.
+		*/
+		cv::Mat nextGrey();
+
 		/** \return the underlying VideoCapture object. */
 		cv::VideoCapture & getCVvideo();
 
@@ -108,7 +133,12 @@ namespace sibr
 		/** Check if the video is loaded. */
 		virtual void checkLoad();
 
+		/** Open the FFMPEG decoder, falling back to OpenCV on failure. */
+		void openDecoder();
+
 		cv::VideoCapture cap; ///< Internal capture object.
+		Backend backend = Backend::OPENCV; ///< Decoding backend.
+		std::shared_ptr<FFVideoDecoder> decoder; ///< Decoder for the FFMPEG backend.
 
 		Path filepath; ///< The path to the video.
 		sibr::Vector2i resolution; ///< Video resolution.
@@ -165,16 +195,51 @@ namespace sibr
 		*/
 		void update();
 
-		/** Display playback GUI.
+		/** Display playback GUI. Moving the timeline enables the frame cache, unless disabled in the GUI or decoding asynchronously.
 		\param ratio_display a scaling factor that determine the size of the video on screen based on the video intrinsic size.
 		*/
 		void onGui(float ratio_display);
 		
 		/** Load the next frame to the CPU.
 		\return a success flag
+		\note With asynchronous decoding, returns false if the next frame is not decoded yet (SKIP policy).
 		*/
 		bool updateCPU();
 
+		/** Load the frame to present at a given time to the CPU, skipping late frames.
+		\param timestamp the presentation time in seconds, keeps increasing when the video loops
+		\return true if a new frame was loaded
+		\note Without asynchronous decoding, the next frame is loaded.
+		*/
+		bool updateCPU(double timestamp);
+
+		/** Decode frames ahead on background threads, updateCPU will then only pick up ready frames.
+		The current transformation and repeat mode are applied by the decoding threads.
+		\param service the decoding service, can be shared by several players (a new one is created if null)
+		\param options decoding parameters
+		*/
+		void enableAsyncDecoding(const VideoDecodeService::Ptr & service = nullptr, const DecodeStreamOptions & options = {});
+
+		/** Go back to decoding on the calling thread. */
+		void disableAsyncDecoding();
+
+		/** \return true if frames are decoded on background threads. */
+		bool asyncDecoding() const { return decodeStream != nullptr; }
+
+		/** Keep decoded frames in a cache, with background prefetching around the current position: moving the
+		timeline back and forth then reuses decoded frames instead of seeking and decoding from the previous keyframe.
+		Disables asynchronous decoding.
+		\param options cache parameters
+		\note The transformation is applied to the cached frames when they are loaded, it should not modify its input in place.
+		*/
+		void enableFrameCache(const FrameCacheOptions & options = {});
+
+		/** Stop caching decoded frames. */
+		void disableFrameCache();
+
+		/** \return the frame cache, null if disabled. */
+		const VideoFrameCache::Ptr & getFrameCache() const { return frameCache; }
+
 		/** Load the next frame to the GPU.
 		\note You should call updateCPU first.
 		*/
@@ -188,18 +253,29 @@ namespace sibr
 		/** \return the current loading texture on the GPU. */
 		std::shared_ptr<sibr::Texture2DRGB> & getLoadingTex() { return loadingTex ? ping : pong; }
 		
-		/// Load the next frame, on the CPU then the GPU.
-		void loadNext();
+		/** Load the next frame, on the CPU then the GPU.
+		\return true if a new frame was loaded
+		*/
+		bool loadNext();
+
+		/** \return the index of the last loaded frame. */
+		int getLoadedFrameNumber();
 
 		Mode mode = PAUSE; ///< Play mode.
 		bool first = true; ///< Are we at the first frame.
 		bool repeat_when_end = true; ///< Loop when reaching the end.
+		bool cache_when_scrubbing = true; ///< Enable the frame cache when the timeline is moved (unless decoding asynchronously).
 		int displayTex = 1; ///< Index of the display texture.
 		int loadingTex = 1; ///< Index of the loading texture.
 		std::shared_ptr<sibr::Texture2DRGB> ping,pong; ///< Double buffer textures.
 		cv::Mat tmpFrame; ///< Scratch frame.
 		Transformation transformation; ///< Transformation to apply to each frame.
 		int current_frame_slider; ///< Slider position.
+		VideoDecodeService::Ptr decodeService; ///< Background decoding service (asynchronous mode).
+		std::shared_ptr<int> decodeStream; ///< Stream ID in the decoding service, removed from it when the last copy is released.
+		int asyncFrameIndex = 0; ///< Index of the last frame picked up from the decoding service.
+		VideoFrameCache::Ptr frameCache; ///< Decoded frames cache.
+		int cacheFrameIndex = 0; ///< Index of the next frame loaded from the cache.
 	};
 
 	
@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "VideoDecodeService.hpp"
+
+namespace sibr
+{
+	FrameRingBuffer::FrameRingBuffer(size_t capacity) : _frames(std::max(size_t(1), capacity))
+	{
+	}
+
+	bool FrameRingBuffer::push(DecodedFrame && frame)
+	{
+		if (full()) {
+			return false;
+		}
+		_frames[(_head + _count) % _frames.size()] = std::move(frame);
+		++_count;
+		return true;
+	}
+
+	void FrameRingBuffer::pop(DecodedFrame * frame)
+	{
+		if (empty()) {
+			return;
+		}
+		if (frame) {
+			*frame = std::move(_frames[_head]);
+		}
+		_frames[_head] = DecodedFrame();
+		_head = (_head + 1) % _frames.size();
+		--_count;
+	}
+
+	int FrameRingBuffer::popUntil(double timestamp, DecodedFrame & frame, double tolerance)
+	{
+		if (empty() || front().timestamp > timestamp + tolerance) {
+			return -1;
+		}
+		int skipped = 0;
+		while (_count >= 2 && _frames[(_head + 1) % _frames.size()].timestamp <= timestamp + tolerance) {
+			pop();
+			++skipped;
+		}
+		pop(&frame);
+		return skipped;
+	}
+
+	void FrameRingBuffer::clear()
+	{
+		while (!empty()) {
+			pop();
+		}
+		_head = 0;
+	}
+
+	VideoFrameSource::VideoFrameSource(const std::string & path) : _cap(path)
+	{
+		if (_cap.isOpened()) {
+			const double fps = _cap.get(cv::CAP_PROP_FPS);
+			if (fps > 0.0) {
+				_frameRate = fps;
+			}
+		}
+	}
+
+	bool VideoFrameSource::read(cv::Mat & frame)
+	{
+		_cap >> frame;
+		return !frame.empty();
+	}
+
+	void VideoFrameSource::seek(int index)
+	{
+		_cap.set(cv::CAP_PROP_POS_FRAMES, index);
+	}
+
+	VideoDecodeService::VideoDecodeService(uint threadsCount)
+	{
+		if (threadsCount == 0) {
+			threadsCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+		for (uint t = 0; t < threadsCount; ++t) {
+			_workers.emplace_back(&VideoDecodeService::work, this);
+		}
+	}
+
+	VideoDecodeService::~VideoDecodeService()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+		_workAvailable.notify_all();
+		_frameReady.notify_all();
+		for (std::thread & worker : _workers) {
+			worker.join();
+		}
+	}
+
+	int VideoDecodeService::addStream(const FrameSource::Ptr & source, const DecodeStreamOptions & options)
+	{
+		std::unique_ptr<Stream> stream(new Stream());
+		stream->source = source;
+		stream->options = options;
+		stream->ring = FrameRingBuffer(options.ringSize);
+		stream->frameRate = source->frameRate();
+
+		int id;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			id = (int)_streams.size();
+			_streams.push_back(std::move(stream));
+		}
+		_workAvailable.notify_all();
+		return id;
+	}
+
+	int VideoDecodeService::addStream(const std::string & path, const DecodeStreamOptions & options)
+	{
+		VideoFrameSource::Ptr source(new VideoFrameSource(path));
+		if (!source->isValid()) {
+			SIBR_WRG << "[VideoDecodeService] Could not open video " << path << std::endl;
+			return -1;
+		}
+		return addStream(source, options);
+	}
+
+	void VideoDecodeService::removeStream(int stream)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		Stream & s = *_streams[stream];
+		s.removed = true;
+		s.ring.clear();
+		// A worker currently decoding this stream still uses the source, it will release it.
+		if (!s.busy) {
+			s.source.reset();
+		}
+		_frameReady.notify_all();
+	}
+
+	void VideoDecodeService::seek(int stream, int index)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			Stream & s = *_streams[stream];
+			s.ring.clear();
+			s.pendingSeek = std::max(0, index);
+			s.ended = false;
+			++s.generation;
+		}
+		_workAvailable.notify_all();
+	}
+
+	bool VideoDecodeService::acquireNext(int stream, DecodedFrame & frame)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		Stream & s = *_streams[stream];
+		if (s.options.policy == DecodeSyncPolicy::WAIT) {
+			_frameReady.wait(lock, [&s, this] { return !s.ring.empty() || s.ended || s.removed || _stop; });
+		}
+		if (s.ring.empty()) {
+			return false;
+		}
+		s.ring.pop(&frame);
+		lock.unlock();
+		_workAvailable.notify_all();
+		return true;
+	}
+
+	bool VideoDecodeService::acquire(int stream, double timestamp, DecodedFrame & frame)
+	{
+		const double tolerance = 1e-4;
+		std::unique_lock<std::mutex> lock(_mutex);
+		Stream & s = *_streams[stream];
+		if (s.options.policy == DecodeSyncPolicy::WAIT) {
+			// Wait until the frame covering the timestamp has been decoded.
+			while (!(!s.ring.empty() && s.ring.back().timestamp + tolerance >= timestamp) && !s.ended && !s.removed && !_stop) {
+				// All the buffered frames are late, free some space for the decoder.
+				if (s.ring.full()) {
+					s.ring.pop();
+					++s.skipped;
+					_workAvailable.notify_all();
+				}
+				_frameReady.wait(lock);
+			}
+		}
+		const int skipped = s.ring.popUntil(timestamp, frame, tolerance);
+		if (skipped < 0) {
+			return false;
+		}
+		s.skipped += size_t(skipped);
+		lock.unlock();
+		_workAvailable.notify_all();
+		return true;
+	}
+
+	std::vector<bool> VideoDecodeService::acquireSynchronized(const std::vector<int> & streams, double timestamp, std::vector<DecodedFrame> & frames)
+	{
+		frames.resize(streams.size());
+		std::vector<bool> acquired(streams.size());
+		for (size_t i = 0; i < streams.size(); ++i) {
+			acquired[i] = acquire(streams[i], timestamp, frames[i]);
+		}
+		return acquired;
+	}
+
+	size_t VideoDecodeService::readyFrames(int stream)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _streams[stream]->ring.size();
+	}
+
+	size_t VideoDecodeService::skippedFrames(int stream)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _streams[stream]->skipped;
+	}
+
+	double VideoDecodeService::frameRate(int stream)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _streams[stream]->frameRate;
+	}
+
+	int VideoDecodeService::pickStream()
+	{
+		const size_t count = _streams.size();
+		for (size_t i = 0; i < count; ++i) {
+			const size_t id = (_nextStream + i) % count;
+			const Stream & s = *_streams[id];
+			if (!s.removed && !s.busy && !s.ended && (!s.ring.full() || s.pendingSeek >= 0)) {
+				_nextStream = id + 1;
+				return int(id);
+			}
+		}
+		return -1;
+	}
+
+	void VideoDecodeService::work()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (!_stop) {
+			const int id = pickStream();
+			if (id < 0) {
+				_workAvailable.wait(lock);
+				continue;
+			}
+			Stream & s = *_streams[id];
+			s.busy = true;
+			const uint generation = s.generation;
+			const int seekTo = s.pendingSeek;
+			s.pendingSeek = -1;
+			if (seekTo >= 0) {
+				s.nextIndex = seekTo;
+				s.loopCount = 0;
+			}
+			int index = s.nextIndex;
+
+			// Decode without holding the lock, no other worker uses this stream.
+			lock.unlock();
+			if (seekTo >= 0) {
+				s.source->seek(seekTo);
+			}
+			cv::Mat image;
+			bool success = s.source->read(image);
+			bool looped = false;
+			if (!success && s.options.loop && index > 0) {
+				s.source->seek(0);
+				looped = true;
+				success = s.source->read(image);
+			}
+			if (success && s.options.transformation) {
+				image = s.options.transformation(image);
+			}
+			lock.lock();
+
+			s.busy = false;
+			if (s.removed) {
+				s.source.reset();
+			} else if (generation == s.generation) {
+				if (looped) {
+					s.loopLength = index;
+					++s.loopCount;
+					index = 0;
+				}
+				if (success) {
+					DecodedFrame frame;
+					frame.image = image;
+					frame.index = index;
+					frame.timestamp = (double(s.loopCount) * double(s.loopLength) + double(index)) / s.frameRate;
+					s.ring.push(std::move(frame));
+					s.nextIndex = index + 1;
+				} else {
+					s.ended = true;
+				}
+			}
+			_frameReady.notify_all();
+		}
+	}
+
+} // namespace sibr
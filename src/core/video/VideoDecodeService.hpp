@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+#include "Config.hpp"
+#include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace sibr
+{
+	/**
+	* \addtogroup sibr_video
+	* @{
+	*/
+
+	/** A decoded video frame. */
+	struct SIBR_VIDEO_EXPORT DecodedFrame {
+		cv::Mat image; ///< Frame content.
+		int index = -1; ///< Frame index in the video.
+		double timestamp = 0.0; ///< Presentation time in seconds, keeps increasing when the video loops.
+	};
+
+	/** Bounded FIFO of decoded frames, with timestamp based selection. Not thread-safe, see VideoDecodeService. */
+	class SIBR_VIDEO_EXPORT FrameRingBuffer {
+
+	public:
+
+		/** Constructor.
+		\param capacity the maximum number of frames
+		*/
+		FrameRingBuffer(size_t capacity = 8);
+
+		/** \return the maximum number of frames. */
+		size_t capacity() const { return _frames.size(); }
+
+		/** \return the number of frames. */
+		size_t size() const { return _count; }
+
+		/** \return true if no frame is available. */
+		bool empty() const { return _count == 0; }
+
+		/** \return true if the buffer is full. */
+		bool full() const { return _count == _frames.size(); }
+
+		/** Add a frame at the back.
+		\param frame the frame
+		\return false if the buffer is full
+		*/
+		bool push(DecodedFrame && frame);
+
+		/** \return the oldest frame, the buffer should not be empty. */
+		const DecodedFrame & front() const { return _frames[_head]; }
+
+		/** \return the newest frame, the buffer should not be empty. */
+		const DecodedFrame & back() const { return _frames[(_head + _count - 1) % _frames.size()]; }
+
+		/** Remove the oldest frame.
+		\param frame if not null, will contain the removed frame
+		*/
+		void pop(DecodedFrame * frame = nullptr);
+
+		/** Select the frame to present at a given time: the newest frame with a timestamp up to the given time.
+		 This frame and all older ones are removed.
+		\param timestamp the presentation time
+		\param frame will contain the selected frame
+		\param tolerance timestamps up to this value past the presentation time are accepted, to absorb rounding
+		\return the number of older frames that were skipped, or -1 if no frame is ready for this time
+		*/
+		int popUntil(double timestamp, DecodedFrame & frame, double tolerance = 1e-4);
+
+		/** Remove all frames. */
+		void clear();
+
+	private:
+		std::vector<DecodedFrame> _frames; ///< Storage.
+		size_t _head = 0; ///< Index of the oldest frame.
+		size_t _count = 0; ///< Number of frames.
+	};
+
+	/** Source of frames decoded by the VideoDecodeService. */
+	class SIBR_VIDEO_EXPORT FrameSource {
+		SIBR_CLASS_PTR(FrameSource);
+
+	public:
+
+		/** Destructor. */
+		virtual ~FrameSource() = default;
+
+		/** Decode the next frame.
+		\param frame will contain the frame
+		\return false at the end of the video
+		*/
+		virtual bool read(cv::Mat & frame) = 0;
+
+		/** Seek a frame.
+		\param index the index of the next frame to read
+		*/
+		virtual void seek(int index) = 0;
+
+		/** \return the frame rate. */
+		virtual double frameRate() const = 0;
+	};
+
+	/** Frame source reading a video file, with its own capture object. */
+	class SIBR_VIDEO_EXPORT VideoFrameSource : public FrameSource {
+		SIBR_CLASS_PTR(VideoFrameSource);
+
+	public:
+
+		/** Constructor.
+		\param path the video path
+		*/
+		VideoFrameSource(const std::string & path);
+
+		bool read(cv::Mat & frame) override;
+
+		void seek(int index) override;
+
+		double frameRate() const override { return _frameRate; }
+
+		/** \return true if the video could be opened. */
+		bool isValid() const { return _cap.isOpened(); }
+
+	private:
+		cv::VideoCapture _cap; ///< Capture.
+		double _frameRate = 30.0; ///< Frame rate.
+	};
+
+	/** What to do when the consumer asks for a frame that is not decoded yet. */
+	enum class DecodeSyncPolicy {
+		SKIP, ///< Do not block: keep the previous frame, and skip frames that are late once they arrive.
+		WAIT ///< Block until the requested frame is decoded (no frame is ever skipped when playing frame by frame).
+	};
+
+	/** Per-stream decoding parameters. */
+	struct SIBR_VIDEO_EXPORT DecodeStreamOptions {
+		size_t ringSize = 8; ///< Number of frames decoded ahead.
+		bool loop = true; ///< Restart at the beginning at the end of the video.
+		DecodeSyncPolicy policy = DecodeSyncPolicy::SKIP; ///< Policy when a frame is not ready.
+		std::function<cv::Mat(cv::Mat)> transformation; ///< Optional processing applied on the decoding thread.
+	};
+
+	/** Background decoding of a set of videos. Each video (stream) has a bounded ring buffer of decoded
+	 frames, filled by a pool of worker threads: several videos are decoded in parallel, and each video
+	 is decoded ahead of the display until its buffer is full. The render loop only picks up ready frames,
+	 either the next one (frame by frame playback) or the one matching a presentation time (synchronized playback).
+	 No OpenGL call is made, uploading the frames is left to the caller.
+	*/
+	class SIBR_VIDEO_EXPORT VideoDecodeService {
+		SIBR_CLASS_PTR(VideoDecodeService);
+
+	public:
+
+		/** Constructor.
+		\param threadsCount number of decoding threads (0 for the number of cores)
+		*/
+		VideoDecodeService(uint threadsCount = 0);
+
+		/** Destructor, stops the decoding threads. */
+		~VideoDecodeService();
+
+		/** Add a stream. Decoding starts immediately.
+		\param source the frame source
+		\param options decoding parameters
+		\return the stream ID
+		*/
+		int addStream(const FrameSource::Ptr & source, const DecodeStreamOptions & options);
+
+		/** Add a stream reading a video file.
+		\param path the video path
+		\param options decoding parameters
+		\return the stream ID, or -1 if the video could not be opened
+		*/
+		int addStream(const std::string & path, const DecodeStreamOptions & options);
+
+		/** Stop decoding a stream and free its frames.
+		\param stream the stream ID
+		*/
+		void removeStream(int stream);
+
+		/** Restart decoding at a given frame, discarding the frames already decoded.
+		\param stream the stream ID
+		\param index the frame index
+		*/
+		void seek(int stream, int index);
+
+		/** Get the next frame of a stream, without skipping any.
+		\param stream the stream ID
+		\param frame will contain the frame
+		\return false if no frame is ready (SKIP policy) or the video has ended
+		*/
+		bool acquireNext(int stream, DecodedFrame & frame);
+
+		/** Get the frame of a stream to present at a given time. Older frames are skipped.
+		\param stream the stream ID
+		\param timestamp the presentation time, in seconds (see DecodedFrame::timestamp)
+		\param frame will contain the frame
+		\return false if no new frame should be presented
+		*/
+		bool acquire(int stream, double timestamp, DecodedFrame & frame);
+
+		/** Get the frames of several streams for the same presentation time.
+		\param streams the stream IDs
+		\param timestamp the presentation time, in seconds
+		\param frames for each stream, will contain the frame to present if a new one is available
+		\return for each stream, true if a new frame was acquired
+		*/
+		std::vector<bool> acquireSynchronized(const std::vector<int> & streams, double timestamp, std::vector<DecodedFrame> & frames);
+
+		/** \return the number of frames ready for a stream. */
+		size_t readyFrames(int stream);
+
+		/** \return the number of frames skipped for a stream since it was added. */
+		size_t skippedFrames(int stream);
+
+		/** \return the frame rate of a stream. */
+		double frameRate(int stream);
+
+	private:
+
+		/** Decoding state of a video. */
+		struct Stream {
+			FrameSource::Ptr source; ///< Frame source.
+			DecodeStreamOptions options; ///< Parameters.
+			FrameRingBuffer ring; ///< Decoded frames.
+			double frameRate = 30.0; ///< Source frame rate.
+			int nextIndex = 0; ///< Index of the next frame to decode.
+			int loopCount = 0; ///< Number of times the video looped.
+			int loopLength = 0; ///< Number of frames in a loop (known after the first loop).
+			int pendingSeek = -1; ///< Seek requested by the consumer.
+			uint generation = 0; ///< Incremented at each seek, to discard frames decoded before it.
+			size_t skipped = 0; ///< Skipped frames count.
+			bool busy = false; ///< A worker is decoding this stream.
+			bool ended = false; ///< End of the video reached (no loop).
+			bool removed = false; ///< The stream was removed.
+		};
+
+		/** Worker thread loop. */
+		void work();
+
+		/** Pick a stream to decode, with the lock held.
+		\return the stream ID or -1
+		*/
+		int pickStream();
+
+		std::vector<std::unique_ptr<Stream>> _streams; ///< Streams.
+		std::vector<std::thread> _workers; ///< Decoding threads.
+		std::mutex _mutex; ///< Protects the streams.
+		std::condition_variable _workAvailable; ///< Signaled when a worker can decode a frame.
+		std::condition_variable _frameReady; ///< Signaled when a frame has been decoded.
+		size_t _nextStream = 0; ///< Round robin start.
+		bool _stop = false; ///< Stop the workers.
+	};
+
+	/** }@ */
+
+} // namespace sibr
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "VideoFrameCache.hpp"
+
+#include <limits>
+
+namespace sibr
+{
+	VideoFrameCache::VideoFrameCache(const FrameSource::Ptr & source, const FrameCacheOptions & options) :
+		_source(source), _options(options)
+	{
+		if (_options.prefetch) {
+			_prefetchThread = std::thread(&VideoFrameCache::prefetchLoop, this);
+		}
+	}
+
+	VideoFrameCache::~VideoFrameCache()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_cacheMutex);
+			_stop = true;
+		}
+		_prefetchRequested.notify_all();
+		_prefetchDone.notify_all();
+		if (_prefetchThread.joinable()) {
+			_prefetchThread.join();
+		}
+	}
+
+	bool VideoFrameCache::get(int index, cv::Mat & frame)
+	{
+		if (index < 0) {
+			return false;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_cacheMutex);
+			// Interrupt the prefetching of the previous window as soon as possible.
+			_center = index;
+			++_generation;
+
+			auto it = _frames.find(index);
+			if (it != _frames.end()) {
+				_usage.splice(_usage.begin(), _usage, it->second.usage);
+				frame = it->second.frame;
+				++_hits;
+			} else {
+				frame = cv::Mat();
+				++_misses;
+				// Keep the prefetching thread away from the source until this frame is decoded.
+				++_pendingMisses;
+			}
+		}
+		if (!frame.empty()) {
+			_prefetchRequested.notify_one();
+			return true;
+		}
+
+		bool decoded = true;
+		{
+			std::lock_guard<std::mutex> sourceLock(_sourceMutex);
+			std::unique_lock<std::mutex> lock(_cacheMutex);
+			// The prefetching thread might have decoded it while we were waiting for the source.
+			auto it = _frames.find(index);
+			if (it != _frames.end()) {
+				_usage.splice(_usage.begin(), _usage, it->second.usage);
+				frame = it->second.frame;
+			} else {
+				lock.unlock();
+				decoded = decode(index, frame);
+				lock.lock();
+				if (decoded) {
+					insert(index, frame);
+				}
+			}
+			--_pendingMisses;
+		}
+		_prefetchRequested.notify_one();
+		return decoded;
+	}
+
+	bool VideoFrameCache::contains(int index)
+	{
+		std::lock_guard<std::mutex> lock(_cacheMutex);
+		return _frames.count(index) > 0;
+	}
+
+	void VideoFrameCache::clear()
+	{
+		std::lock_guard<std::mutex> lock(_cacheMutex);
+		_frames.clear();
+		_usage.clear();
+		_memoryUsage = 0;
+		_hits = 0;
+		_misses = 0;
+		_prefetched = 0;
+	}
+
+	void VideoFrameCache::waitPrefetch()
+	{
+		std::unique_lock<std::mutex> lock(_cacheMutex);
+		if (!_prefetchThread.joinable()) {
+			return;
+		}
+		_prefetchDone.wait(lock, [this]() { return _stop || _doneGeneration == _generation; });
+	}
+
+	size_t VideoFrameCache::size()
+	{
+		std::lock_guard<std::mutex> lock(_cacheMutex);
+		return _frames.size();
+	}
+
+	size_t VideoFrameCache::memoryUsage()
+	{
+		std::lock_guard<std::mutex> lock(_cacheMutex);
+		return _memoryUsage;
+	}
+
+	bool VideoFrameCache::decode(int index, cv::Mat & frame)
+	{
+		if (_endIndex >= 0 && index >= _endIndex) {
+			return false;
+		}
+		// Consecutive frames are read without seeking.
+		if (index != _sourceIndex) {
+			_source->seek(index);
+		}
+		if (!_source->read(frame)) {
+			_sourceIndex = -1;
+			if (_endIndex < 0 || index < _endIndex) {
+				_endIndex = index;
+			}
+			return false;
+		}
+		_sourceIndex = index + 1;
+		return true;
+	}
+
+	void VideoFrameCache::insert(int index, const cv::Mat & frame)
+	{
+		Entry & entry = _frames[index];
+		entry.frame = frame;
+		_usage.push_front(index);
+		entry.usage = _usage.begin();
+
+		_frameSize = frame.total() * frame.elemSize();
+		_memoryUsage += _frameSize;
+
+		// Always keep the frame just added.
+		while (_memoryUsage > _options.memoryBudget && _usage.size() > 1) {
+			auto oldest = _frames.find(_usage.back());
+			_memoryUsage -= oldest->second.frame.total() * oldest->second.frame.elemSize();
+			_frames.erase(oldest);
+			_usage.pop_back();
+		}
+	}
+
+	void VideoFrameCache::prefetchLoop()
+	{
+		std::unique_lock<std::mutex> lock(_cacheMutex);
+		while (true) {
+			_prefetchRequested.wait(lock, [this]() { return _stop || (_doneGeneration != _generation && _pendingMisses == 0); });
+			if (_stop) {
+				return;
+			}
+			const unsigned int generation = _generation;
+			const int center = _center;
+
+			// Shrink the window if it does not fit in the budget, the frames would evict each other.
+			int after = std::max(0, _options.prefetchAfter);
+			int before = std::max(0, _options.prefetchBefore);
+			if (_frameSize > 0) {
+				const int capacity = int(std::min(_options.memoryBudget / _frameSize, size_t(std::numeric_limits<int>::max())));
+				after = std::min(after, std::max(0, (capacity - 1) / 2));
+				before = std::min(before, std::max(0, capacity - 1 - after));
+			}
+
+			// Frames after the current one first, then the ones before it, each range in decoding order.
+			std::vector<int> indices;
+			for (int i = center + 1; i <= center + after; ++i) {
+				indices.push_back(i);
+			}
+			for (int i = std::max(0, center - before); i < center; ++i) {
+				indices.push_back(i);
+			}
+
+			for (int index : indices) {
+				if (_stop || _generation != generation || _pendingMisses > 0) {
+					break;
+				}
+				if (_frames.count(index) > 0) {
+					continue;
+				}
+				// Same locking order as get: source, then cache.
+				lock.unlock();
+				std::lock_guard<std::mutex> sourceLock(_sourceMutex);
+				cv::Mat frame;
+				const bool decoded = decode(index, frame);
+				// Insert before releasing the source, so that a concurrent miss finds the frame instead of decoding it again.
+				lock.lock();
+				if (decoded && _frames.count(index) == 0) {
+					insert(index, frame);
+					++_prefetched;
+				}
+			}
+
+			if (_generation == generation) {
+				_doneGeneration = generation;
+				_prefetchDone.notify_all();
+			}
+		}
+	}
+
+} // namespace sibr
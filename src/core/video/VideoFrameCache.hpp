@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+#include "Config.hpp"
+#include "VideoDecodeService.hpp"
+
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+namespace sibr
+{
+	/**
+	* \addtogroup sibr_video
+	* @{
+	*/
+
+	/** Parameters of a VideoFrameCache. */
+	struct SIBR_VIDEO_EXPORT FrameCacheOptions {
+		size_t memoryBudget = size_t(512) << 20; ///< Maximum size of the cached frames, in bytes.
+		int prefetchBefore = 8; ///< Number of frames decoded in the background before the last requested one.
+		int prefetchAfter = 24; ///< Number of frames decoded in the background after the last requested one.
+		bool prefetch = true; ///< Run the background prefetching thread.
+	};
+
+	/** Cache of decoded frames keyed by frame index, with least recently used eviction under a memory budget.
+	 Frames around the last requested index are decoded ahead on a background thread, in both directions,
+	 so that scrubbing back and forth does not seek and decode from the previous keyframe at each step.
+	 Consecutive reads are decoded without seeking. All methods are thread-safe.
+	*/
+	class SIBR_VIDEO_EXPORT VideoFrameCache {
+		SIBR_CLASS_PTR(VideoFrameCache);
+
+	public:
+
+		/** Constructor.
+		\param source the frame source, owned by the cache from now on
+		\param options cache parameters
+		*/
+		VideoFrameCache(const FrameSource::Ptr & source, const FrameCacheOptions & options = {});
+
+		/** Destructor, stops the prefetching thread. */
+		~VideoFrameCache();
+
+		/** Get a frame, decoding it if it is not cached, and prefetch the frames around it.
+		\param index the frame index
+		\param frame will contain the frame (shared with the cache, do not modify it)
+		\return false if the frame is past the end of the video
+		*/
+		bool get(int index, cv::Mat & frame);
+
+		/** Check if a frame is cached, without decoding nor updating the usage order.
+		\param index the frame index
+		\return true if the frame is cached
+		*/
+		bool contains(int index);
+
+		/** Remove all frames and reset the counters. */
+		void clear();
+
+		/** Wait until the prefetching of the frames around the last requested one is done. */
+		void waitPrefetch();
+
+		/** \return the number of get calls served from the cache. */
+		size_t hits() const { return _hits; }
+
+		/** \return the number of get calls that had to decode the frame. */
+		size_t misses() const { return _misses; }
+
+		/** \return the number of frames decoded by the prefetching thread. */
+		size_t prefetched() const { return _prefetched; }
+
+		/** \return the number of cached frames. */
+		size_t size();
+
+		/** \return the size of the cached frames, in bytes. */
+		size_t memoryUsage();
+
+		/** \return the source frame rate. */
+		double frameRate() const { return _source->frameRate(); }
+
+	private:
+
+		/** A cached frame. */
+		struct Entry {
+			cv::Mat frame; ///< Frame content.
+			std::list<int>::iterator usage; ///< Position in the usage order.
+		};
+
+		/** Decode a frame, with the source lock held.
+		\param index the frame index
+		\param frame will contain the frame
+		\return false past the end of the video
+		*/
+		bool decode(int index, cv::Mat & frame);
+
+		/** Add a frame as the most recently used one and evict the least recently used ones over budget, with the cache lock held.
+		\param index the frame index
+		\param frame the frame
+		*/
+		void insert(int index, const cv::Mat & frame);
+
+		/** Prefetching thread loop. */
+		void prefetchLoop();
+
+		FrameSource::Ptr _source; ///< Frame source.
+		FrameCacheOptions _options; ///< Parameters.
+
+		std::unordered_map<int, Entry> _frames; ///< Cached frames.
+		std::list<int> _usage; ///< Frame indices, most recently used first.
+		size_t _memoryUsage = 0; ///< Size of the cached frames.
+		size_t _frameSize = 0; ///< Size of a frame, known after the first decode.
+		std::mutex _cacheMutex; ///< Protects the cached frames and the prefetching state.
+
+		std::mutex _sourceMutex; ///< Protects the source and the two members below.
+		int _sourceIndex = 0; ///< Index of the next frame read by the source, -1 if unknown.
+		int _endIndex = -1; ///< Number of frames, known once the end of the video has been reached.
+
+		std::thread _prefetchThread; ///< Background decoding.
+		std::condition_variable _prefetchRequested; ///< Signaled when the requested frame changes.
+		std::condition_variable _prefetchDone; ///< Signaled when the prefetching of a window is complete.
+		int _center = -1; ///< Last requested frame.
+		unsigned int _generation = 0; ///< Incremented at each new request, to interrupt outdated prefetching.
+		unsigned int _doneGeneration = 0; ///< Last request whose window has been prefetched.
+		int _pendingMisses = 0; ///< Number of get calls decoding a missing frame, prefetching waits for them.
+		bool _stop = false; ///< Stop the prefetching thread.
+
+		std::atomic<size_t> _hits{ 0 }; ///< Cache hits.
+		std::atomic<size_t> _misses{ 0 }; ///< Cache misses.
+		std::atomic<size_t> _prefetched{ 0 }; ///< Frames decoded ahead.
+	};
+
+	/** }@ */
+
+} // namespace sibr
@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "VideoLaplacianBlending.hpp"
+
+#include <map>
+
+namespace sibr
+{
+	namespace {
+
+		/** Size of a pyramid level. */
+		struct LevelSize {
+			int w, h, l;
+		};
+
+		using FrameCache = std::map<int, cv::Mat3f>;
+		using FrameReader = std::function<cv::Mat()>;
+
+		/** Drop all frames with an index below a bound. */
+		void evictBelow(FrameCache & cache, int index)
+		{
+			cache.erase(cache.begin(), cache.lower_bound(index));
+		}
+
+		/** Lowest index of the level k+1 frames read when temporally upsampling level k frames from first onward. */
+		int lowestUpsampledIndex(int first)
+		{
+			return std::max(0, (first - 2) / 2);
+		}
+
+		/** Gaussian pyramid of a video, computed frame by frame and in order at each level.
+		 Matches downscale (and upscale for the upsampled frames), one frame at a time. */
+		class StreamingGaussianPyramid {
+
+		public:
+
+			/** Constructor.
+			\param reader returns the next input frame
+			\param sizes levels sizes
+			\param spatialDS spatial downscaling between levels
+			\param withUpsampled also keep the frames of each level spatially upsampled to the level below
+			*/
+			StreamingGaussianPyramid(const FrameReader & reader, const std::vector<LevelSize> & sizes, bool spatialDS, bool withUpsampled)
+				: _reader(reader), _sizes(sizes), _spatialDS(spatialDS), _withUpsampled(withUpsampled),
+				_levels(sizes.size()), _upsampled(sizes.size()), _next(sizes.size(), 0)
+			{
+			}
+
+			/** \return frame t of level k, computed if needed. */
+			const cv::Mat3f & frame(int k, int t)
+			{
+				ensure(k, t);
+				return _levels[k].at(t);
+			}
+
+			/** \return frame t of level k (k>0), spatially upsampled to the size of level k-1. */
+			const cv::Mat3f & upsampled(int k, int t)
+			{
+				ensure(k, t);
+				return _upsampled[k].at(t);
+			}
+
+			/** \return the number of frames computed so far at level k. */
+			int computed(int k) const
+			{
+				return _next[k];
+			}
+
+			/** Release frames that won't be read anymore.
+			\param k the level
+			\param first lowest frame index still needed at this level
+			\param firstUpsampled lowest upsampled frame index still needed at this level
+			*/
+			void evict(int k, int first, int firstUpsampled)
+			{
+				evictBelow(_levels[k], first);
+				evictBelow(_upsampled[k], firstUpsampled);
+			}
+
+			/** \return the number of frames held. */
+			size_t framesCount() const
+			{
+				size_t count = 0;
+				for (size_t k = 0; k < _levels.size(); ++k) {
+					count += _levels[k].size() + _upsampled[k].size();
+				}
+				return count;
+			}
+
+		private:
+
+			/** Compute the frames of level k up to index t. */
+			void ensure(int k, int t)
+			{
+				while (_next[k] <= t) {
+					computeNext(k);
+				}
+			}
+
+			/** Compute the next frame of level k. */
+			void computeNext(int k)
+			{
+				const int t = _next[k];
+				const LevelSize & size = _sizes[k];
+				cv::Mat3f out;
+
+				if (k == 0) {
+					cv::Mat input = _reader();
+					if (input.empty()) {
+						// Frame counts reported by containers can be too large, repeat the last frame.
+						SIBR_WRG << "[Video] Missing frame " << t << ", repeating the previous one." << std::endl;
+						if (t == 0) {
+							out = cv::Mat3f(size.h, size.w, cv::Vec3f(0, 0, 0));
+						} else {
+							out = _levels[0].at(t - 1);
+						}
+					} else {
+						if (input.channels() == 1) {
+							cv::cvtColor(input, input, cv::COLOR_GRAY2BGR);
+						}
+						if (input.cols != size.w || input.rows != size.h) {
+							cv::resize(input, input, cv::Size(size.w, size.h));
+						}
+						input.convertTo(out, CV_32FC3);
+					}
+				} else {
+					// Temporal binomial blur at the even frame 2t of the level below, then spatial reduction.
+					const LevelSize & below = _sizes[k - 1];
+					ensure(k - 1, std::min(2 * t + 2, below.l - 1));
+					const FilterKernel kernel = FilterKernel::binomial5();
+					const int radius = kernel.radius();
+					cv::Mat3f blurred(below.h, below.w, cv::Vec3f(0, 0, 0));
+					for (int j = -radius; j <= radius; ++j) {
+						const int u = filterBorderIndex(2 * t + j, below.l, FilterBorder::REFLECT_101);
+						cv::scaleAdd(_levels[k - 1].at(u), kernel.weights[j + radius], blurred, blurred);
+					}
+					if (_spatialDS) {
+						cv::pyrDown(blurred, out, cv::Size(size.w, size.h));
+					} else {
+						out = blurred;
+					}
+				}
+
+				if (k > 0 && _withUpsampled) {
+					if (_spatialDS) {
+						cv::Mat3f up;
+						cv::pyrUp(out, up, cv::Size(_sizes[k - 1].w, _sizes[k - 1].h));
+						_upsampled[k][t] = up;
+					} else {
+						_upsampled[k][t] = out;
+					}
+				}
+				_levels[k][t] = out;
+				++_next[k];
+			}
+
+			FrameReader _reader;
+			std::vector<LevelSize> _sizes;
+			bool _spatialDS;
+			bool _withUpsampled;
+			std::vector<FrameCache> _levels;
+			std::vector<FrameCache> _upsampled;
+			std::vector<int> _next;
+		};
+
+		/** Laplacian blending of two frame streams. The collapsed result of each level is also computed
+		 in order; after each output frame, the caches are trimmed to the frames that the temporal filters
+		 can still reach, which bounds memory by a window of a few frames per level. */
+		class StreamingLaplacianBlender {
+
+		public:
+
+			/** Constructor.
+			\param readerA first video frames
+			\param readerB second video frames
+			\param readerMask mask frames (0-255)
+			\param w frames width
+			\param h frames height
+			\param l number of frames
+			\param params pyramid parameters
+			*/
+			StreamingLaplacianBlender(const FrameReader & readerA, const FrameReader & readerB, const FrameReader & readerMask,
+				int w, int h, int l, const PyramidParameters & params)
+				: _sizes(levelSizes(w, h, l, params)),
+				_pyrA(readerA, _sizes, params.splacialDS, true),
+				_pyrB(readerB, _sizes, params.splacialDS, true),
+				_pyrM(readerMask, _sizes, params.splacialDS, false),
+				_results(_sizes.size()), _nextResult(_sizes.size(), 0), _spatialDS(params.splacialDS)
+			{
+			}
+
+			/** Blend all frames.
+			\param output the destination encoder
+			\return the number of frames written
+			*/
+			int run(FFVideoEncoder & output)
+			{
+				size_t maxFramesHeld = 0;
+				cv::Mat frame;
+				for (int t = 0; t < _sizes[0].l; ++t) {
+					result(0, t).convertTo(frame, CV_8UC3);
+					output << frame;
+					_nextResult[0] = t + 1;
+					maxFramesHeld = std::max(maxFramesHeld, framesCount());
+					evict();
+				}
+				SIBR_LOG << "[Video] Streamed Laplacian blending of " << _sizes[0].l << " frames, at most "
+					<< maxFramesHeld << " frames held by the pyramids." << std::endl;
+				return _sizes[0].l;
+			}
+
+		private:
+
+			/** \return the sizes of the pyramid levels. */
+			static std::vector<LevelSize> levelSizes(int w, int h, int l, const PyramidParameters & params)
+			{
+				std::vector<LevelSize> sizes = { { w, h, l } };
+				for (int k = 1; k < params.num_levels; ++k) {
+					LevelSize size = sizes.back();
+					if (params.splacialDS) {
+						size.w = (size.w + 1) / 2;
+						size.h = (size.h + 1) / 2;
+					}
+					size.l = (size.l + 1) / 2;
+					sizes.push_back(size);
+				}
+				return sizes;
+			}
+
+			/** Temporal upsampling at frame s of level k, from level k+1 frames already spatially upsampled (see upscale). */
+			template<typename UpsampledFrame>
+			void addUpsampled(int k, int s, const UpsampledFrame & upsampledFrame, cv::Mat3f & dst)
+			{
+				const FilterKernel kernel = FilterKernel::binomial5(2.0f);
+				const int radius = kernel.radius();
+				for (int j = -radius; j <= radius; ++j) {
+					const int u = filterBorderIndex(s + j, _sizes[k].l, FilterBorder::REFLECT_101);
+					// Odd frames of the upsampled sequence are zero.
+					if (u % 2 != 0) {
+						continue;
+					}
+					cv::scaleAdd(upsampledFrame(u / 2), kernel.weights[j + radius], dst, dst);
+				}
+			}
+
+			/** \return frame s of the Laplacian level k of a pyramid. */
+			cv::Mat3f laplacian(StreamingGaussianPyramid & pyr, int k, int s)
+			{
+				cv::Mat3f lap = pyr.frame(k, s).clone();
+				if (k + 1 < int(_sizes.size())) {
+					cv::Mat3f up(lap.size(), cv::Vec3f(0, 0, 0));
+					addUpsampled(k, s, [&pyr, k](int u) -> const cv::Mat3f & { return pyr.upsampled(k + 1, u); }, up);
+					lap -= up;
+				}
+				return lap;
+			}
+
+			/** \return frame s of the collapsed blended pyramid at level k. */
+			cv::Mat3f result(int k, int s)
+			{
+				const cv::Mat3f lapA = laplacian(_pyrA, k, s);
+				const cv::Mat3f lapB = laplacian(_pyrB, k, s);
+				const cv::Mat3f & mask = _pyrM.frame(k, s);
+				cv::Mat3f out = lapA.mul(mask, 1.0 / 255.0) + lapB.mul(cv::Scalar::all(255.0) - mask, 1.0 / 255.0);
+
+				if (k + 1 < int(_sizes.size())) {
+					ensureResult(k + 1, std::min((s + 2) / 2, _sizes[k + 1].l - 1));
+					addUpsampled(k, s, [this, k](int u) -> const cv::Mat3f & { return _results[k + 1].at(u); }, out);
+				}
+				return out;
+			}
+
+			/** Compute the collapsed frames of level k (k>0) up to index s, kept spatially upsampled to level k-1. */
+			void ensureResult(int k, int s)
+			{
+				while (_nextResult[k] <= s) {
+					const int t = _nextResult[k];
+					cv::Mat3f res = result(k, t);
+					if (_spatialDS) {
+						cv::Mat3f up;
+						cv::pyrUp(res, up, cv::Size(_sizes[k - 1].w, _sizes[k - 1].h));
+						_results[k][t] = up;
+					} else {
+						_results[k][t] = res;
+					}
+					++_nextResult[k];
+				}
+			}
+
+			/** Release all frames that the remaining output frames won't need. */
+			void evict()
+			{
+				const int n = int(_sizes.size());
+				for (int k = 0; k < n; ++k) {
+					// Upsampled frames of level k are read for level k-1 frames from _nextResult[k-1] onward.
+					const int firstUpsampled = k > 0 ? lowestUpsampledIndex(_nextResult[k - 1]) : 0;
+					if (k > 0) {
+						evictBelow(_results[k], firstUpsampled);
+					}
+					for (StreamingGaussianPyramid * pyr : { &_pyrA, &_pyrB, &_pyrM }) {
+						// Frames of level k are read by the blending of the next frames at this level,
+						// and by the temporal blur of the next frames of level k+1.
+						int first = _nextResult[k];
+						if (k + 1 < n) {
+							first = std::min(first, 2 * pyr->computed(k + 1) - 2);
+						}
+						pyr->evict(k, std::max(0, first), firstUpsampled);
+					}
+				}
+			}
+
+			/** \return the number of frames held. */
+			size_t framesCount() const
+			{
+				size_t count = _pyrA.framesCount() + _pyrB.framesCount() + _pyrM.framesCount();
+				for (const FrameCache & cache : _results) {
+					count += cache.size();
+				}
+				return count;
+			}
+
+			std::vector<LevelSize> _sizes;
+			StreamingGaussianPyramid _pyrA, _pyrB, _pyrM;
+			std::vector<FrameCache> _results;
+			std::vector<int> _nextResult;
+			bool _spatialDS;
+		};
+
+		/** \return a reader returning the frames of a video from the first one. */
+		FrameReader videoReader(sibr::Video & vid)
+		{
+			vid.setCurrentFrame(0);
+			return [&vid]() { return vid.next(); };
+		}
+
+		int blendStreaming(sibr::Video & vidA, sibr::Video & vidB, const FrameReader & readerMask, int maskFrames,
+			FFVideoEncoder & output, const PyramidParameters & params)
+		{
+			const cv::Size size = vidA.getResolutionCV();
+			if (vidB.getResolutionCV() != size) {
+				SIBR_WRG << "[Video] Blended videos have different resolutions." << std::endl;
+				return 0;
+			}
+			int l = std::min(vidA.getNumFrames(), vidB.getNumFrames());
+			if (maskFrames >= 0) {
+				l = std::min(l, maskFrames);
+			}
+			if (l <= 0 || params.num_levels < 1) {
+				return 0;
+			}
+
+			StreamingLaplacianBlender blender(videoReader(vidA), videoReader(vidB), readerMask, size.width, size.height, l, params);
+			return blender.run(output);
+		}
+
+	}
+
+	int videoLaplacianBlendingStreaming(sibr::Video & vidA, sibr::Video & vidB, sibr::Video & mask, FFVideoEncoder & output, const PyramidParameters & params)
+	{
+		return blendStreaming(vidA, vidB, videoReader(mask), mask.getNumFrames(), output, params);
+	}
+
+	int videoLaplacianBlendingStreaming(sibr::Video & vidA, sibr::Video & vidB, const cv::Mat & mask, FFVideoEncoder & output, const PyramidParameters & params)
+	{
+		const cv::Mat maskFrame = mask;
+		return blendStreaming(vidA, vidB, [maskFrame]() { return maskFrame; }, -1, output, params);
+	}
+
+} // namespace sibr
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+#include "Config.hpp"
+#include "VideoUtils.hpp"
+
+namespace sibr
+{
+	/**
+	* \addtogroup sibr_video
+	* @{
+	*/
+
+	/** Video Laplacian blending, computed in a sliding temporal window: same result as videoLaplacianBlending
+	 on PyramidLayers, but the videos are read frame by frame and the blended frames are written to the encoder
+	 as soon as they are ready. Only the frames of each pyramid level still needed by the temporal filters are
+	 kept in memory, instead of the full pyramids of both videos and the mask.
+	\param vidA first video
+	\param vidB second video, with the same resolution
+	\param mask mask video (3 channels, 255 selects vidA, 0 selects vidB), with the same resolution
+	\param output the destination encoder
+	\param params pyramid parameters
+	\return the number of frames written
+	*/
+	SIBR_VIDEO_EXPORT int videoLaplacianBlendingStreaming(sibr::Video & vidA, sibr::Video & vidB, sibr::Video & mask,
+		FFVideoEncoder & output, const PyramidParameters & params = {});
+
+	/** Video Laplacian blending with a mask constant over time, see the overload above.
+	\param vidA first video
+	\param vidB second video, with the same resolution
+	\param mask mask image (3 channels, 255 selects vidA, 0 selects vidB), with the same resolution
+	\param output the destination encoder
+	\param params pyramid parameters
+	\return the number of frames written
+	*/
+	SIBR_VIDEO_EXPORT int videoLaplacianBlendingStreaming(sibr::Video & vidA, sibr::Video & vidB, const cv::Mat & mask,
+		FFVideoEncoder & output, const PyramidParameters & params = {});
+
+	/** }@ */
+
+} // namespace sibr
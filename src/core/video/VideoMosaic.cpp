@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "VideoMosaic.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace sibr
+{
+	VideoMosaic::VideoMosaic(const std::vector<Video::Ptr> & videos, const std::vector<std::string> & labels, const VideoMosaicOptions & options) :
+		_videos(videos), _labels(labels), _options(options), _ended(videos.size(), 0)
+	{
+		const int count = int(_videos.size());
+		if (count == 0) {
+			SIBR_WRG << "[VideoMosaic] No video to compose." << std::endl;
+			return;
+		}
+		_labels.resize(count);
+
+		const int columns = _options.columns > 0 ? std::min(_options.columns, count) : int(std::ceil(std::sqrt(double(count))));
+		const int rows = (count + columns - 1) / columns;
+		sibr::Vector2i cell = _options.cellSize;
+		if (cell[0] <= 0 || cell[1] <= 0) {
+			cell = _videos[0]->getResolution();
+		}
+		const int spacing = std::max(0, _options.spacing);
+
+		for (int i = 0; i < count; ++i) {
+			const int x = (i % columns) * (cell[0] + spacing);
+			const int y = (i / columns) * (cell[1] + spacing);
+			_cells.emplace_back(x, y, cell[0], cell[1]);
+		}
+		// Even dimensions, for the 4:2:0 chroma subsampling of the encoder.
+		const int w = columns * cell[0] + (columns - 1) * spacing;
+		const int h = rows * cell[1] + (rows - 1) * spacing;
+		_size = cv::Size(w + w % 2, h + h % 2);
+		_canvas = cv::Mat(_size, CV_8UC3, _options.background);
+
+		_numFrames = _options.holdLastFrame ? 0 : std::numeric_limits<int>::max();
+		for (const Video::Ptr & video : _videos) {
+			video->setCurrentFrame(0);
+			const int frames = video->getNumFrames();
+			_numFrames = _options.holdLastFrame ? std::max(_numFrames, frames) : std::min(_numFrames, frames);
+		}
+		const double fps = _videos[0]->getFrameRate();
+		if (fps > 0.0) {
+			_frameRate = fps;
+		}
+	}
+
+	const cv::Mat & VideoMosaic::next()
+	{
+		if (_currentFrame >= _numFrames) {
+			return _empty;
+		}
+
+		// Cells are disjoint, each video is decoded and drawn independently.
+#pragma omp parallel for
+		for (int i = 0; i < int(_videos.size()); ++i) {
+			drawCell(i);
+		}
+
+		++_currentFrame;
+		return _canvas;
+	}
+
+	void VideoMosaic::drawCell(int i)
+	{
+		// Videos that ended keep their last frame in the canvas.
+		if (_ended[i]) {
+			return;
+		}
+		cv::Mat frame = _videos[i]->next();
+		if (frame.empty()) {
+			_ended[i] = 1;
+			return;
+		}
+		if (frame.channels() == 1) {
+			cv::cvtColor(frame, frame, cv::COLOR_GRAY2BGR);
+		}
+		if (frame.depth() != CV_8U) {
+			frame.convertTo(frame, CV_8U);
+		}
+
+		// Fit in the cell, preserving the aspect ratio.
+		const cv::Rect & cell = _cells[i];
+		const double scale = std::min(double(cell.width) / frame.cols, double(cell.height) / frame.rows);
+		const cv::Size fitted(std::max(1, int(scale * frame.cols)), std::max(1, int(scale * frame.rows)));
+		cv::Mat cellMat = _canvas(cell);
+		if (fitted != cell.size()) {
+			cellMat.setTo(_options.background);
+		}
+		cv::Mat target = cellMat(cv::Rect((cell.width - fitted.width) / 2, (cell.height - fitted.height) / 2, fitted.width, fitted.height));
+		cv::resize(frame, target, fitted, 0, 0, scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+
+		if (!_labels[i].empty()) {
+			const int thickness = std::max(1, int(std::round(2.0 * _options.labelScale)));
+			int baseline = 0;
+			const cv::Size textSize = cv::getTextSize(_labels[i], cv::FONT_HERSHEY_SIMPLEX, _options.labelScale, thickness, &baseline);
+			const cv::Point origin(textSize.height / 2, textSize.height + textSize.height / 2);
+			// Outline in the background color, to keep the label readable on any content.
+			cv::putText(cellMat, _labels[i], origin, cv::FONT_HERSHEY_SIMPLEX, _options.labelScale, _options.background, 3 * thickness, cv::LINE_AA);
+			cv::putText(cellMat, _labels[i], origin, cv::FONT_HERSHEY_SIMPLEX, _options.labelScale, _options.labelColor, thickness, cv::LINE_AA);
+		}
+	}
+
+	int VideoMosaic::write(FFVideoEncoder & encoder)
+	{
+		int written = 0;
+		while (true) {
+			const cv::Mat & frame = next();
+			if (frame.empty()) {
+				break;
+			}
+			if (encoder << frame) {
+				++written;
+			}
+		}
+		return written;
+	}
+
+	int VideoMosaic::save(const std::string & path, const VideoEncoderOptions & options)
+	{
+		FFVideoEncoder encoder(path, _frameRate, { _size.width, _size.height }, options);
+		if (!encoder.isFine()) {
+			SIBR_WRG << "[VideoMosaic] Could not open " << path << " for writing." << std::endl;
+			return 0;
+		}
+		const int written = write(encoder);
+		encoder.close();
+		SIBR_LOG << "[VideoMosaic] Saved " << written << " frames of " << _size.width << "x" << _size.height << " to " << path << std::endl;
+		return written;
+	}
+
+	VideoEncoderOptions VideoMosaic::mosaicEncoderOptions()
+	{
+		VideoEncoderOptions options;
+		options.async = true;
+		return options;
+	}
+
+} // namespace sibr
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+#include "Config.hpp"
+#include "Video.hpp"
+#include "FFmpegVideoEncoder.hpp"
+
+namespace sibr
+{
+	/**
+	* \addtogroup sibr_video
+	* @{
+	*/
+
+	/** Layout and style of a VideoMosaic. */
+	struct SIBR_VIDEO_EXPORT VideoMosaicOptions {
+		int columns = 0; ///< Number of columns, 0 for a grid as square as possible.
+		sibr::Vector2i cellSize = { 0, 0 }; ///< Size of a cell, 0 to use the resolution of the first video.
+		int spacing = 4; ///< Pixels between cells.
+		cv::Scalar background = cv::Scalar(0, 0, 0); ///< Color of the spacing and of the letterboxing.
+		cv::Scalar labelColor = cv::Scalar(255, 255, 255); ///< Color of the labels.
+		double labelScale = 1.0; ///< Font scale of the labels.
+		bool holdLastFrame = true; ///< Keep showing the last frame of the videos that ended until the longest one ends, instead of stopping at the shortest.
+	};
+
+	/** Side by side comparison of several videos. The videos are read frame by frame and each frame of the
+	 grid is composed in place in a single canvas, then sent to the encoder: memory usage does not depend on the
+	 videos length, unlike concatenating full VideoVolume or PyramidLayer.
+	*/
+	class SIBR_VIDEO_EXPORT VideoMosaic {
+		SIBR_CLASS_PTR(VideoMosaic);
+
+	public:
+
+		/** Constructor. Reading starts at the first frame of each video.
+		\param videos the videos, in row-major order in the grid (distinct objects, they are read in parallel)
+		\param labels text drawn in the top left corner of each cell, can be empty or shorter than videos
+		\param options layout and style
+		*/
+		VideoMosaic(const std::vector<Video::Ptr> & videos, const std::vector<std::string> & labels = {},
+			const VideoMosaicOptions & options = {});
+
+		/** \return the mosaic resolution (even dimensions, for chroma subsampling). */
+		const cv::Size & size() const { return _size; }
+
+		/** \return the number of frames of the mosaic. */
+		int numFrames() const { return _numFrames; }
+
+		/** \return the frame rate of the first video. */
+		double frameRate() const { return _frameRate; }
+
+		/** Compose the next frame.
+		\return the mosaic frame, only valid until the next call; empty once all frames have been composed
+		*/
+		const cv::Mat & next();
+
+		/** Compose all remaining frames and send them to an encoder.
+		\param encoder the destination, with a resolution of size()
+		\return the number of frames written
+		*/
+		int write(FFVideoEncoder & encoder);
+
+		/** Compose all remaining frames and save them to a video file.
+		\param path the destination file
+		\param options encoding parameters, asynchronous by default so that decoding, composition and encoding overlap
+		\return the number of frames written
+		*/
+		int save(const std::string & path, const VideoEncoderOptions & options = mosaicEncoderOptions());
+
+		/** \return the default encoding parameters of save. */
+		static VideoEncoderOptions mosaicEncoderOptions();
+
+	private:
+
+		/** Read the next frame of a video and draw it in its cell.
+		\param i the video index
+		*/
+		void drawCell(int i);
+
+		std::vector<Video::Ptr> _videos; ///< Sources.
+		std::vector<std::string> _labels; ///< Cells labels.
+		VideoMosaicOptions _options; ///< Layout and style.
+		std::vector<cv::Rect> _cells; ///< Cells in the canvas.
+		std::vector<char> _ended; ///< Videos that reached their end (not a vector<bool>, cells are drawn in parallel).
+		cv::Mat _canvas; ///< Current mosaic frame.
+		cv::Mat _empty; ///< Returned when all frames have been composed.
+		cv::Size _size; ///< Mosaic resolution.
+		int _numFrames = 0; ///< Number of frames.
+		int _currentFrame = 0; ///< Number of frames composed.
+		double _frameRate = 30.0; ///< Output frame rate.
+	};
+
+	/** }@ */
+
+} // namespace sibr
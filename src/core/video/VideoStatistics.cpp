@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "VideoStatistics.hpp"
+
+#include <future>
+
+namespace sibr {
+
+	void MeanVarianceAccumulator::reset(int w, int h)
+	{
+		_mean = cv::Mat3f(h, w, cv::Vec3f(0, 0, 0));
+		_m2 = cv::Mat3f(h, w, cv::Vec3f(0, 0, 0));
+		_rowCount.assign(h, 0);
+	}
+
+	void MeanVarianceAccumulator::add(const cv::Mat3b & frame, int rowStart, int rowEnd)
+	{
+		const int valuesCount = 3 * frame.cols;
+		for (int i = rowStart; i < rowEnd; ++i) {
+			const float invCount = 1.0f / float(++_rowCount[i]);
+			const uchar * x = frame.ptr<uchar>(i);
+			float * mean = _mean.ptr<float>(i);
+			float * m2 = _m2.ptr<float>(i);
+			for (int k = 0; k < valuesCount; ++k) {
+				const float value = float(x[k]);
+				const float delta = value - mean[k];
+				mean[k] += delta * invCount;
+				m2[k] += delta * (value - mean[k]);
+			}
+		}
+	}
+
+	cv::Mat3f MeanVarianceAccumulator::variance() const
+	{
+		if (count() == 0) {
+			return cv::Mat3f(_m2.size(), cv::Vec3f(0, 0, 0));
+		}
+		return _m2 / float(count());
+	}
+
+	cv::Mat3f MeanVarianceAccumulator::standardDeviation() const
+	{
+		cv::Mat3f stdDev;
+		cv::sqrt(variance(), stdDev);
+		return stdDev;
+	}
+
+	void MinMaxAccumulator::reset(int w, int h)
+	{
+		_min = cv::Mat3b(h, w, cv::Vec3b(255, 255, 255));
+		_max = cv::Mat3b(h, w, cv::Vec3b(0, 0, 0));
+	}
+
+	void MinMaxAccumulator::add(const cv::Mat3b & frame, int rowStart, int rowEnd)
+	{
+		const cv::Mat band = frame.rowRange(rowStart, rowEnd);
+		cv::Mat minBand = _min.rowRange(rowStart, rowEnd);
+		cv::Mat maxBand = _max.rowRange(rowStart, rowEnd);
+		cv::min(band, minBand, minBand);
+		cv::max(band, maxBand, maxBand);
+	}
+
+	HistogramMedianAccumulator::HistogramMedianAccumulator(int numBins) : _numBins(sibr::clamp(numBins, 2, 256))
+	{
+	}
+
+	void HistogramMedianAccumulator::reset(int w, int h)
+	{
+		_w = w;
+		_h = h;
+		_bins.assign(size_t(w) * size_t(h) * 3 * size_t(_numBins), 0);
+	}
+
+	void HistogramMedianAccumulator::add(const cv::Mat3b & frame, int rowStart, int rowEnd)
+	{
+		const int valuesCount = 3 * _w;
+		for (int i = rowStart; i < rowEnd; ++i) {
+			const uchar * x = frame.ptr<uchar>(i);
+			uint16_t * rowBins = &_bins[size_t(i) * size_t(valuesCount) * size_t(_numBins)];
+			for (int k = 0; k < valuesCount; ++k) {
+				uint16_t * bins = rowBins + size_t(k) * _numBins;
+				if (++bins[(int(x[k]) * _numBins) >> 8] == std::numeric_limits<uint16_t>::max()) {
+					for (int b = 0; b < _numBins; ++b) {
+						bins[b] /= 2;
+					}
+				}
+			}
+		}
+	}
+
+	cv::Mat3b HistogramMedianAccumulator::percentile(float q) const
+	{
+		cv::Mat3b result(_h, _w);
+		const int valuesCount = 3 * _w;
+		const float binWidth = 256.0f / float(_numBins);
+
+#pragma omp parallel for
+		for (int i = 0; i < _h; ++i) {
+			const uint16_t * rowBins = &_bins[size_t(i) * size_t(valuesCount) * size_t(_numBins)];
+			uchar * out = result.ptr<uchar>(i);
+			for (int k = 0; k < valuesCount; ++k) {
+				const uint16_t * bins = rowBins + size_t(k) * _numBins;
+				uint total = 0;
+				for (int b = 0; b < _numBins; ++b) {
+					total += bins[b];
+				}
+				const float target = q * float(total);
+				float cumulated = 0.0f, value = 0.0f;
+				for (int b = 0; b < _numBins; ++b) {
+					if (bins[b] > 0 && cumulated + float(bins[b]) >= target) {
+						value = binWidth * (float(b) + (target - cumulated) / float(bins[b]));
+						break;
+					}
+					cumulated += float(bins[b]);
+				}
+				out[k] = cv::saturate_cast<uchar>(value);
+			}
+		}
+		return result;
+	}
+
+	cv::Mat3b HistogramMedianAccumulator::mode() const
+	{
+		cv::Mat3b result(_h, _w);
+		const int valuesCount = 3 * _w;
+		const float binWidth = 256.0f / float(_numBins);
+
+#pragma omp parallel for
+		for (int i = 0; i < _h; ++i) {
+			const uint16_t * rowBins = &_bins[size_t(i) * size_t(valuesCount) * size_t(_numBins)];
+			uchar * out = result.ptr<uchar>(i);
+			for (int k = 0; k < valuesCount; ++k) {
+				const uint16_t * bins = rowBins + size_t(k) * _numBins;
+				const int best = int(std::max_element(bins, bins + _numBins) - bins);
+				out[k] = cv::saturate_cast<uchar>(binWidth * (float(best) + 0.5f));
+			}
+		}
+		return result;
+	}
+
+	void VideoStatistics::addAccumulator(const VideoAccumulator::Ptr & accumulator)
+	{
+		_accumulators.push_back(accumulator);
+	}
+
+	void VideoStatistics::clearAccumulators()
+	{
+		_accumulators.clear();
+	}
+
+	int VideoStatistics::run(sibr::Video & vid, float time_skiped_begin, float time_skiped_end)
+	{
+		const int starting_frame = (int)(time_skiped_begin * vid.getFrameRate());
+		const int ending_frame = vid.getNumFrames() - (int)(time_skiped_end*vid.getFrameRate());
+		const int currentFrame = vid.getCurrentFrameNumber();
+		const int count = run(vid.getCVvideo(), starting_frame, ending_frame);
+		vid.setCurrentFrame(currentFrame);
+		return count;
+	}
+
+	int VideoStatistics::run(cv::VideoCapture & cap, int starting_frame, int ending_frame, const sibr::Vector2i & finalSize, bool blur)
+	{
+		if (ending_frame < 0) {
+			ending_frame = (int)cap.get(cv::CAP_PROP_FRAME_COUNT);
+		}
+		cap.set(cv::VideoCaptureProperties::CAP_PROP_POS_FRAMES, starting_frame);
+
+		auto decode = [&cap, &finalSize, blur]() {
+			cv::Mat frame;
+			cap >> frame;
+			if (frame.empty()) {
+				return cv::Mat3b();
+			}
+			if (frame.channels() == 1) {
+				cv::cvtColor(frame, frame, cv::COLOR_GRAY2BGR);
+			} else if (frame.channels() == 4) {
+				cv::cvtColor(frame, frame, cv::COLOR_BGRA2BGR);
+			}
+			if (finalSize[0] > 0 && finalSize[1] > 0 && (frame.cols != finalSize[0] || frame.rows != finalSize[1])) {
+				cv::resize(frame, frame, cv::Size(finalSize[0], finalSize[1]));
+			}
+			if (blur) {
+				cv::GaussianBlur(frame, frame, cv::Size(3, 3), 0);
+			}
+			return cv::Mat3b(frame);
+		};
+
+		cv::Mat3b current = starting_frame < ending_frame ? decode() : cv::Mat3b();
+		if (current.empty()) {
+			return 0;
+		}
+		for (const auto & accumulator : _accumulators) {
+			accumulator->reset(current.cols, current.rows);
+		}
+
+		const cv::Size size = current.size();
+
+		// Each job is a band of rows for one accumulator.
+		const int bandHeight = 16;
+		const int bandsCount = (current.rows + bandHeight - 1) / bandHeight;
+		const int jobsCount = bandsCount * (int)_accumulators.size();
+
+		int frameCount = 0;
+		while (!current.empty()) {
+			++frameCount;
+			// Decode the next frame while the current one is accumulated.
+			const bool hasNext = starting_frame + frameCount < ending_frame;
+			std::future<cv::Mat3b> next;
+			if (hasNext) {
+				next = std::async(std::launch::async, decode);
+			}
+
+#pragma omp parallel for schedule(dynamic)
+			for (int job = 0; job < jobsCount; ++job) {
+				const int band = job % bandsCount;
+				const int rowStart = band * bandHeight;
+				const int rowEnd = std::min(current.rows, rowStart + bandHeight);
+				_accumulators[job / bandsCount]->add(current, rowStart, rowEnd);
+			}
+
+			current = hasNext ? next.get() : cv::Mat3b();
+			if (!current.empty() && current.size() != size) {
+				SIBR_WRG << "Frame size changed during the video, stopping." << std::endl;
+				break;
+			}
+		}
+		return frameCount;
+	}
+
+} // namespace sibr
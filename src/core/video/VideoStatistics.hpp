@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+#include "Config.hpp"
+#include "Video.hpp"
+#include <opencv2/opencv.hpp>
+
+namespace sibr {
+
+	/**
+	* \addtogroup sibr_video
+	* @{
+	*/
+
+	/** Per-pixel statistic computed online, one frame at a time. Frames are fed by horizontal bands,
+	 so that different bands of the same frame can be processed concurrently.
+	*/
+	class SIBR_VIDEO_EXPORT VideoAccumulator {
+		SIBR_CLASS_PTR(VideoAccumulator);
+
+	public:
+
+		/** Destructor. */
+		virtual ~VideoAccumulator() = default;
+
+		/** Reset the accumulator for frames of a given size.
+		\param w the frames width
+		\param h the frames height
+		*/
+		virtual void reset(int w, int h) = 0;
+
+		/** Accumulate a band of a frame.
+		\param frame the frame (8 bits, 3 channels)
+		\param rowStart the first row of the band
+		\param rowEnd the row after the last one
+		*/
+		virtual void add(const cv::Mat3b & frame, int rowStart, int rowEnd) = 0;
+
+		/** Accumulate a whole frame.
+		\param frame the frame
+		*/
+		void add(const cv::Mat3b & frame) { add(frame, 0, frame.rows); }
+	};
+
+	/** Mean and variance per pixel, using Welford's update (numerically stable, no sum of squares). */
+	class SIBR_VIDEO_EXPORT MeanVarianceAccumulator : public VideoAccumulator {
+		SIBR_CLASS_PTR(MeanVarianceAccumulator);
+
+	public:
+
+		void reset(int w, int h) override;
+
+		void add(const cv::Mat3b & frame, int rowStart, int rowEnd) override;
+		using VideoAccumulator::add;
+
+		/** \return the number of accumulated frames. */
+		int count() const { return _rowCount.empty() ? 0 : _rowCount.front(); }
+
+		/** \return the mean frame (CV_32FC3). */
+		const cv::Mat3f & mean() const { return _mean; }
+
+		/** \return the population variance (CV_32FC3). */
+		cv::Mat3f variance() const;
+
+		/** \return the standard deviation (CV_32FC3). */
+		cv::Mat3f standardDeviation() const;
+
+	private:
+		cv::Mat3f _mean; ///< Running mean.
+		cv::Mat3f _m2; ///< Running sum of squared differences to the mean.
+		std::vector<int> _rowCount; ///< Number of frames accumulated per row, as bands are updated independently.
+	};
+
+	/** Minimum and maximum per pixel and channel. */
+	class SIBR_VIDEO_EXPORT MinMaxAccumulator : public VideoAccumulator {
+		SIBR_CLASS_PTR(MinMaxAccumulator);
+
+	public:
+
+		void reset(int w, int h) override;
+
+		void add(const cv::Mat3b & frame, int rowStart, int rowEnd) override;
+		using VideoAccumulator::add;
+
+		/** \return the minimum frame. */
+		const cv::Mat3b & minimum() const { return _min; }
+
+		/** \return the maximum frame. */
+		const cv::Mat3b & maximum() const { return _max; }
+
+	private:
+		cv::Mat3b _min; ///< Running minimum.
+		cv::Mat3b _max; ///< Running maximum.
+	};
+
+	/** Approximate per-channel median (or any percentile) from a per pixel histogram, without storing the frames.
+	 Memory usage is w*h*3*numBins*2 bytes (about 600MB for a 1080p video and 50 bins). Counts are halved
+	 for a pixel when one of its bins saturates, which keeps the ranks approximately valid for long videos.
+	 The result is interpolated linearly inside the bin, the error is at most 256/numBins/2 per channel.
+	*/
+	class SIBR_VIDEO_EXPORT HistogramMedianAccumulator : public VideoAccumulator {
+		SIBR_CLASS_PTR(HistogramMedianAccumulator);
+
+	public:
+
+		/** Constructor.
+		\param numBins number of bins per channel, in [2, 256]
+		*/
+		HistogramMedianAccumulator(int numBins = 50);
+
+		void reset(int w, int h) override;
+
+		void add(const cv::Mat3b & frame, int rowStart, int rowEnd) override;
+		using VideoAccumulator::add;
+
+		/** \return the approximate median frame. */
+		cv::Mat3b median() const { return percentile(0.5f); }
+
+		/** Approximate percentile.
+		\param q the percentile in [0,1]
+		\return the frame of the values below which a fraction q of the samples falls
+		*/
+		cv::Mat3b percentile(float q) const;
+
+		/** \return the per-channel mode (middle of the most populated bin). */
+		cv::Mat3b mode() const;
+
+	private:
+		int _numBins; ///< Bins per channel.
+		int _w = 0, _h = 0; ///< Frame size.
+		std::vector<uint16_t> _bins; ///< Histograms, numBins consecutive counts per pixel channel.
+	};
+
+	/** Single-pass statistics over a video: each frame is decoded once, while the previous one is fed to all
+	 the registered accumulators. Accumulators and frame bands are processed in parallel.
+	*/
+	class SIBR_VIDEO_EXPORT VideoStatistics {
+
+	public:
+
+		/** Register an accumulator, it will be reset at the beginning of each run.
+		\param accumulator the accumulator
+		*/
+		void addAccumulator(const VideoAccumulator::Ptr & accumulator);
+
+		/** Remove all accumulators. */
+		void clearAccumulators();
+
+		/** Decode a video and feed the frames to the accumulators.
+		\param vid the video
+		\param time_skiped_begin time skipped at the beginning, in seconds
+		\param time_skiped_end time skipped at the end, in seconds
+		\return the number of processed frames
+		*/
+		int run(sibr::Video & vid, float time_skiped_begin = 0, float time_skiped_end = 0);
+
+		/** Decode a range of frames of a capture and feed them to the accumulators.
+		\param cap the capture
+		\param starting_frame first frame
+		\param ending_frame frame after the last one (-1 for the end of the video)
+		\param finalSize if positive, frames are resized to this size before being accumulated
+		\param blur if true, frames are blurred with a 3x3 Gaussian kernel (as in VideoUtils::getMeanVariance2)
+		\return the number of processed frames
+		*/
+		int run(cv::VideoCapture & cap, int starting_frame = 0, int ending_frame = -1, const sibr::Vector2i & finalSize = { -1, -1 }, bool blur = false);
+
+	private:
+		std::vector<VideoAccumulator::Ptr> _accumulators; ///< Registered accumulators.
+	};
+
+	/** }@ */
+
+} // namespace sibr
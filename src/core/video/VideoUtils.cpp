@@ -14,6 +14,8 @@
 
 #include <core/graphics/Utils.hpp>
 #include <algorithm>
+#include <fstream>
+#include <thread>
 
 
 #include <opencv2/ximgproc/edge_filter.hpp>
@@ -612,6 +614,153 @@ namespace sibr {
 		std::cout << "done " << std::endl;
 	}
 
+	/** \return the optical flow from prev to next. */
+	static cv::Mat computeFlow(const cv::Mat & prev, const cv::Mat & next, FlowMethod method)
+	{
+		cv::Mat flow;
+		if (method == FlowMethod::SIMPLE_FLOW) {
+			cv::optflow::calcOpticalFlowSF(prev, next, flow, 3, 2, 4);
+		} else {
+			// DenseOpticalFlow instances are not thread safe, one per call.
+			cv::optflow::createOptFlow_DeepFlow()->calc(prev, next, flow);
+		}
+		return flow;
+	}
+
+	int VideoUtils::computeSaveFlowBatch(sibr::Video & vid, std::function<std::string(int flow_id)> naming_f, const FlowBatchOptions & options)
+	{
+		const bool grey = options.method == FlowMethod::DEEP_FLOW;
+		const int batchSize = std::max(1, options.batchSize);
+		const int threadsCount = options.threadsCount > 0 ? options.threadsCount : std::max(1, int(std::thread::hardware_concurrency()));
+
+		vid.setCurrentFrame(0);
+		auto readFrame = [&]() {
+			// nextGrey may point to the decoder memory, always make our own copy.
+			const cv::Mat frame = grey ? vid.nextGrey() : vid.next();
+			cv::Mat out;
+			if (frame.empty()) {
+				return out;
+			}
+			if (options.ratio != 1.0f) {
+				cv::resize(frame, out, cv::Size((int)(options.ratio*frame.cols), (int)(options.ratio*frame.rows)));
+			} else {
+				out = frame.clone();
+			}
+			return out;
+		};
+
+		// frames[0] is the last frame of the previous batch.
+		std::vector<cv::Mat> frames;
+		cv::Mat first = readFrame();
+		if (first.empty()) {
+			return 0;
+		}
+		frames.push_back(first);
+
+		int flowId = 0;
+		int savedCount = 0;
+		bool ended = false;
+		while (!ended) {
+			// Decoding is sequential, done once per frame.
+			while (int(frames.size()) < batchSize + 1) {
+				cv::Mat frame = readFrame();
+				if (frame.empty()) {
+					ended = true;
+					break;
+				}
+				frames.push_back(frame);
+			}
+
+			const int pairsCount = int(frames.size()) - 1;
+			if (pairsCount <= 0) {
+				break;
+			}
+			std::vector<std::string> paths(pairsCount);
+			for (int p = 0; p < pairsCount; ++p) {
+				paths[p] = naming_f(flowId + p);
+			}
+
+			// Pairs are independent: compute and write them in parallel.
+			std::vector<int> saved(pairsCount, 0);
+#pragma omp parallel for num_threads(threadsCount) schedule(dynamic)
+			for (int p = 0; p < pairsCount; ++p) {
+				const cv::Mat flow = computeFlow(frames[p], frames[p + 1], options.method);
+				saved[p] = saveFlow(paths[p], flow, options.format) ? 1 : 0;
+			}
+
+			for (int p = 0; p < pairsCount; ++p) {
+				if (!saved[p]) {
+					SIBR_WRG << "[VideoUtils] Unable to write flow to " << paths[p] << std::endl;
+				}
+				savedCount += saved[p];
+			}
+			flowId += pairsCount;
+			frames.erase(frames.begin(), frames.end() - 1);
+			std::cout << "." << std::flush;
+		}
+		std::cout << " done" << std::endl;
+
+		SIBR_LOG << "[VideoUtils] Saved " << savedCount << " flow fields out of " << flowId << "." << std::endl;
+		return savedCount;
+	}
+
+	bool VideoUtils::saveFlow(const std::string & path, const cv::Mat & flow, FlowFormat format)
+	{
+		if (flow.empty() || flow.type() != CV_32FC2) {
+			return false;
+		}
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			return false;
+		}
+
+		const int32_t w = flow.cols;
+		const int32_t h = flow.rows;
+		cv::Mat data = flow;
+		if (format == FlowFormat::FLO16) {
+			file.write("FL16", 4);
+			flow.convertTo(data, CV_16FC2);
+		} else {
+			file.write("PIEH", 4);
+		}
+		file.write(reinterpret_cast<const char*>(&w), sizeof(int32_t));
+		file.write(reinterpret_cast<const char*>(&h), sizeof(int32_t));
+		const size_t rowSize = size_t(w) * data.elemSize();
+		for (int i = 0; i < h; ++i) {
+			file.write(data.ptr<char>(i), rowSize);
+		}
+		return file.good();
+	}
+
+	cv::Mat VideoUtils::loadFlow(const std::string & path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			return cv::Mat();
+		}
+
+		char tag[4];
+		int32_t w = 0, h = 0;
+		file.read(tag, 4);
+		file.read(reinterpret_cast<char*>(&w), sizeof(int32_t));
+		file.read(reinterpret_cast<char*>(&h), sizeof(int32_t));
+		const bool half = std::equal(tag, tag + 4, "FL16");
+		if (!file.good() || w <= 0 || h <= 0 || (!half && !std::equal(tag, tag + 4, "PIEH"))) {
+			SIBR_WRG << "[VideoUtils] " << path << " is not a flow file." << std::endl;
+			return cv::Mat();
+		}
+
+		cv::Mat data(h, w, half ? CV_16FC2 : CV_32FC2);
+		file.read(data.ptr<char>(), size_t(w) * size_t(h) * data.elemSize());
+		if (!file.good()) {
+			return cv::Mat();
+		}
+		if (half) {
+			data.convertTo(data, CV_32FC2);
+		}
+		return data;
+	}
+
 	void VideoUtils::computeSaveVideoMaskF(Video & vid, int threshold, bool viz)
 	{
 		sibr::Volume3u volume = sibr::loadVideoVolume(vid);
@@ -1019,10 +1168,16 @@ namespace sibr {
 	}
 
 	cv::Mat VideoUtils::applyFlow(const cv::Mat & prev, const cv::Mat & flow) {
-		cv::Mat out, realFlow = flow;
-		for (int i = 0; i < prev.rows; ++i) {
-			for (int j = 0; j < prev.cols; ++j) {
-				realFlow.at<cv::Vec2f>(i, j) += cv::Vec2f(j + 0.5f, i + 0.5f);
+		// Absolute sampling positions, built row by row without modifying the input flow.
+		cv::Mat out, realFlow(flow.size(), CV_32FC2);
+#pragma omp parallel for
+		for (int i = 0; i < flow.rows; ++i) {
+			const float * f = flow.ptr<float>(i);
+			float * m = realFlow.ptr<float>(i);
+			const float y = float(i) + 0.5f;
+			for (int j = 0; j < flow.cols; ++j) {
+				m[2 * j] = f[2 * j] + float(j) + 0.5f;
+				m[2 * j + 1] = f[2 * j + 1] + y;
 			}
 		}
 		cv::remap(prev, out, realFlow, cv::Mat(), cv::INTER_LINEAR);
@@ -1130,6 +1285,60 @@ namespace sibr {
 
 	}
 
+	void VideoUtils::deepFlow(sibr::Video & vid, float ratio,
+		std::function<bool(cv::Mat prev, cv::Mat next, cv::Mat flow, int flow_id)> f,
+		std::function<void(void)> end_function)
+	{
+		vid.setCurrentFrame(0);
+
+		auto deepFlow = cv::optflow::createOptFlow_DeepFlow();
+		cv::Mat flow, prevGrey;
+		int flow_id = 0;
+		while (true) {
+			// May point to the decoder memory, the resize makes our own copy.
+			const cv::Mat grey = vid.nextGrey();
+			if (grey.empty()) {
+				break;
+			}
+
+			cv::Mat nextGrey;
+			auto size = cv::Size((int)(ratio*grey.size().width), (int)(ratio*grey.size().height));
+			cv::resize(grey, nextGrey, size);
+
+			if (!prevGrey.empty()) {
+				deepFlow->calc(prevGrey, nextGrey, flow);
+
+				if (!f(prevGrey, nextGrey, flow, flow_id)) {
+					break;
+				}
+				++flow_id;
+			}
+
+			prevGrey = nextGrey;
+		}
+
+		end_function();
+	}
+
+	void VideoUtils::deepFlowViz(sibr::Video & vid, float ratio)
+	{
+		deepFlow(vid, ratio, [](cv::Mat prev, cv::Mat next, cv::Mat flow, int flow_id) {
+			cv::Mat viz = getFlowViz(flow);
+			cv::Mat diff = applyFlow(prev, flow);
+			cv::imshow("deepflow", viz);
+			cv::imshow("frame", prev);
+			cv::imshow("applyFlow", diff);
+			int key = cv::waitKey(1);
+			if (key == 27) {
+				return false;
+			}
+			return true;
+		}, []() {
+			cv::destroyAllWindows();
+		}
+		);
+	}
+
 	void VideoUtils::deepFlowViz(cv::VideoCapture & cap, float ratio)
 	{
 		deepFlow(cap, ratio, [](cv::Mat prev, cv::Mat next, cv::Mat flow, int flow_id) {
@@ -1206,7 +1415,9 @@ namespace sibr {
 
 	void PyramidLayer::saveToVideoFile(const std::string & filename, double framerate)
 	{
-		sibr::FFVideoEncoder output(filename, framerate, { w,h });
+		VideoEncoderOptions options;
+		options.async = true;
+		sibr::FFVideoEncoder output(filename, framerate, { w,h }, options);
 		for (int f = 0; f < l; ++f) {
 			cv::Mat frame;
 			volume.row(f).reshape(3, h).convertTo(frame, CV_8UC3);
@@ -1401,172 +1612,80 @@ namespace sibr {
 			}
 		}
 
-		temporalBlur(out, params);
+		temporalBlurInPlace(out, params);
 
 		return out;
 	}
 
-	//	PyramidLayer temporalBlur(const PyramidLayer & layer, const PyramidParameters &  params, float scaling)
-	//	{
-	//		//cv::Mat kernel = cv::Mat::ones(cv::Size(2 * params.temporal_radius + 1, 1), CV_32FC1);
-	//		//kernel = kernel / cv::norm(kernel, cv::NORM_L1);
-	//
-	//		const cv::Mat kernel = (scaling / 16.0f)*(cv::Mat_<float>(1, 5) << 1, 4, 6, 4, 1);
-	//
-	//		//layer.show(0);
-	//
-	//		cv::Mat vol = layer.volume.t();
-	//
-	//		//std::cout << vol.row(3 * (0 * layer.w + 0) + 0) << std::endl;
-	//		//std::cout << vol.row(3 * (0 * layer.w + 0) + 1) << std::endl;
-	//		//std::cout << vol.row(3 * (0 * layer.w + 0) + 2) << std::endl;
-	//
-	//		cv::filter2D(vol, vol, -1, kernel, { 2,0 }, 0, cv::BORDER_DEFAULT);
-	//
-	////#pragma omp parallel for
-	////		for (int i = 0; i < layer.h; ++i) {
-	////			for (int j = 0; j < layer.w; ++j) {
-	////				for (int c = 0; c < 3; ++c) {
-	////					cv::Mat slice = vol.row(3 * (i*layer.w + j) + c);
-	////					cv::filter2D(slice, slice, -1, kernel, { 2,0 }, 0, cv::BORDER_DEFAULT); // cv::Point(-1,-1) BORDER_ISOLATED  cv::BORDER_REPLICATE
-	////				}
-	////			}
-	////		}
-	//
-	//		//std::cout << vol.row(3 * (0 * layer.w + 0) + 0) << std::endl;
-	//		//std::cout << vol.row(3 * (0 * layer.w + 0) + 1) << std::endl;
-	//		//std::cout << vol.row(3 * (0 * layer.w + 0) + 2) << std::endl;
-	//
-	//		PyramidLayer out(vol.t(), layer.w, layer.h);
-	//		//out.cout();
-	//		//out.show(0);
-	//
-	//		return out;
-	//	}
+	/** \return the volume of a layer as 32 bits floats. */
+	static cv::Mat floatVolume(const PyramidLayer & layer)
+	{
+		if (layer.volume.type() == CV_32FC1) {
+			return layer.volume;
+		}
+		cv::Mat volume;
+		layer.volume.convertTo(volume, CV_32FC1);
+		return volume;
+	}
 
 	PyramidLayer temporalBlur(const PyramidLayer & layer, const PyramidParameters &  params, float scaling)
 	{
-		const cv::Mat kernel = (scaling / 16.0f)*(cv::Mat_<float>(5, 1) << 1, 4, 6, 4, 1);
-		cv::Mat vol = layer.volume.clone();
-		cv::filter2D(vol, vol, -1, kernel, { -1,-1 }, 0.0, cv::BORDER_DEFAULT);
-		return PyramidLayer(vol, layer.w, layer.h);
+		PyramidLayer out;
+		out.copySizeFrom(layer);
+		filterTemporal<float>(floatVolume(layer), out.volume, FilterKernel::binomial5(scaling));
+		return out;
 	}
 
 	void temporalBlurInPlace(PyramidLayer & layer, const PyramidParameters & params, float scaling)
 	{
-		const cv::Mat kernel = (scaling / 16.0f)*(cv::Mat_<float>(5, 1) << 1, 4, 6, 4, 1);
-		cv::filter2D(layer.volume, layer.volume, -1, kernel, { -1,-1 }, 0.0, cv::BORDER_DEFAULT);
+		filterTemporal<float>(floatVolume(layer), layer.volume, FilterKernel::binomial5(scaling));
 	}
 
 	PyramidLayer decimate(const PyramidLayer & layer, const PyramidParameters &  params)
 	{
-
-		PyramidLayer out((layer.w + 1) / 2, (layer.h + 1) / 2, (layer.l + 1) / 2);
-
-#pragma omp parallel for
-		for (int t = 0; t < out.l; ++t) {
-			cv::Mat sliceCurrent = layer.volume.row(2 * t).reshape(3, layer.h);
-			cv::Mat sliceDecimated = out.volume.row(t).reshape(3, out.h);
-
-			cv::pyrDown(sliceCurrent, sliceDecimated);
-			//cv::resize(sliceCurrent, sliceDecimated, sliceDecimated.size(), 0, 0, CV_INTER_NN);
-
-		}
-
+		PyramidLayer out;
+		out.w = (layer.w + 1) / 2;
+		out.h = (layer.h + 1) / 2;
+		out.l = (layer.l + 1) / 2;
+		// Keep one frame out of two.
+		pyrDownFrames(floatVolume(layer), layer.w, layer.h, 3, out.volume, 2);
 		return out;
-
 	}
 
 	PyramidLayer upscale(const PyramidLayer & layerUp, const PyramidLayer & layerDown, const PyramidParameters &  params)
 	{
-		//std::cout << layerUp.w << " " << layerUp.h << " " << layerUp.l << std::endl;
-		//std::cout << layerDown.w << " " << layerDown.h << " " << layerDown.l << std::endl;
-
-		PyramidLayer out(layerUp.w, layerUp.h, layerUp.l);
-		//#pragma omp parallel for
-		for (int t = 0; t < layerDown.l; ++t) {
-			//if (2 * t + 1 >= layerUp.l) {
-			//	continue;
-			//}
-			//cv::Mat sliceUp = out.volume.row(2 * t + 1).reshape(3, layerUp.h);
-			cv::Mat sliceUp = out.volume.row(2 * t).reshape(3, layerUp.h);
-			cv::Mat sliceDown = layerDown.volume.row(t).reshape(3, layerDown.h);
-
-			if (params.splacialDS) {
-				cv::pyrUp(sliceDown, sliceUp, sliceUp.size());
-			} else {
-				sliceDown.copyTo(sliceUp);
-			}
-
-
-			//	if (2 * t + 1 < layerUp.l) {
-			//		sliceUp.copyTo(out.volume.row(2 * t + 1).reshape(3, layerUp.h));
-			//	}
+		// Spatial upsampling of the low resolution frames only, the zero frames inserted
+		// in between by the temporal upsampling are implicit.
+		cv::Mat frames;
+		if (params.splacialDS) {
+			pyrUpFrames(floatVolume(layerDown), layerDown.w, layerDown.h, 3, layerUp.w, layerUp.h, frames);
+		} else {
+			frames = floatVolume(layerDown);
 		}
-		temporalBlurInPlace(out, params, 2.0f);
+
+		PyramidLayer out;
+		out.copySizeFrom(layerUp);
+		upsampleTemporal<float>(frames, layerUp.l, out.volume, FilterKernel::binomial5(2.0f));
 		return out;
 	}
 
 	PyramidLayer downscale(const PyramidLayer & layer, const PyramidParameters &  params)
 	{
-
-		PyramidLayer blured = temporalBlur(layer, params);
-		//std::cout << " temporal blur " << std::endl;
-		//blured.show();
-		//std::cout << " temporal blur end" << std::endl;
+		// Temporal blur, computed for the kept frames only.
+		cv::Mat blurred;
+		filterTemporal<float>(floatVolume(layer), blurred, FilterKernel::binomial5(), FilterBorder::REFLECT_101, 2);
 
 		PyramidLayer out;
-
+		out.l = blurred.rows;
 		if (params.splacialDS) {
-			out = PyramidLayer((layer.w + 1) / 2, (layer.h + 1) / 2, (layer.l + 1) / 2);
+			out.w = (layer.w + 1) / 2;
+			out.h = (layer.h + 1) / 2;
+			pyrDownFrames(blurred, layer.w, layer.h, 3, out.volume);
 		} else {
-			out = PyramidLayer(layer.w, layer.h, (layer.l + 1) / 2);
+			out.w = layer.w;
+			out.h = layer.h;
+			out.volume = blurred;
 		}
-
-		//#pragma omp parallel for
-		for (int t = 0; t < out.l; ++t) {
-			//if (2 * t + 1 >= layer.l) {
-			//	continue;
-			//}
-			//cv::Mat sliceCurrent = blured.volume.row(2 * t + 1).reshape(3, layer.h);
-			cv::Mat sliceCurrent = blured.volume.row(2 * t).reshape(3, layer.h);
-			cv::Mat sliceDecimated = out.volume.row(t).reshape(3, out.h);
-
-			if (params.splacialDS) {
-				cv::pyrDown(sliceCurrent, sliceDecimated);
-			} else {
-				sliceCurrent.copyTo(sliceDecimated);
-			}
-
-		}
-
-		//PyramidLayer blur (layer.w, layer.h, (layer.l + 1) / 2);
-
-		//for (int i = 0; i < blur.volume.rows; ++i) {
-		//	cv::pyrDown(layer.volume.row(i), blur.volume.row(i), blur.volume.row(i).size());
-		//}
-
-		//PyramidLayer out;
-		//if (params.splacialDS) {
-		//	out = PyramidLayer((layer.w + 1) / 2, (layer.h + 1) / 2, blur.l);
-		//} else {
-		//	out = PyramidLayer(layer.w, layer.h, blur.l);
-		//}
-
-		//for (int t = 0; t < out.l; ++t) {
-		//	if (2 * t + 1 >= layer.l) {
-		//		continue;
-		//	}
-		//	cv::Mat sliceCurrent = blur.volume.row(2 * t + 1).reshape(3, layer.h);
-		//	cv::Mat sliceDecimated = out.volume.row(t).reshape(3, out.h);
-
-		//	if (params.splacialDS) {
-		//		cv::pyrDown(sliceCurrent, sliceDecimated);
-		//	} else {
-		//		sliceCurrent.copyTo(sliceDecimated);
-		//	}
-		//}
-
 		return out;
 	}
 
@@ -16,6 +16,7 @@
 #include <opencv2/opencv.hpp>
 #include <functional>
 #include "FFmpegVideoEncoder.hpp"
+#include "VolumeFilter.hpp"
 
 namespace sibr {
 	
@@ -56,6 +57,44 @@ namespace sibr {
 		return out;
 	}
 
+	/** Play a volume in an OpenCV window, frame by frame, until Escape is pressed.
+	\param volume a VideoVolume or a ChunkedVideoVolume
+	\param delay delay between frames in milliseconds
+	\param res display resolution (negative to use the volume one)
+	\param scale values scaling before display
+	*/
+	template<typename VolumeType>
+	void playVolume(const VolumeType & volume, int delay, const sibr::Vector2i & res, double scale) {
+		bool playing = true;
+		int t = 0;
+
+		const std::string win_name = "playing";
+		auto disp_frame = [&] {
+			if ((res.array() >= 0).all()) {
+				cv::Mat m;
+				cv::resize(cvConvertMatTo<uchar, 3>(volume.frame(t), scale), m, cv::Size(res[0],res[1]), 0,0, cv::INTER_NEAREST);
+				cv::imshow(win_name, m);
+			} else {
+				cv::imshow(win_name, cvConvertMatTo<uchar, 3>(volume.frame(t), scale));
+			}
+		};
+
+		auto true_cb = [&](int new_t) {
+			t = new_t;
+			disp_frame();
+		};
+		auto cb_wrapper = [](int new_t, void * arg) { (*static_cast<decltype(true_cb)*>(arg))(new_t); };
+
+		while (playing) {
+			disp_frame();
+			cv::createTrackbar("timestamp", win_name, &t, volume.l - 1, cb_wrapper, &true_cb);
+			playing = (cv::waitKey(delay) != 27);
+			t = (t + 1) % volume.l;
+		}
+
+		cv::destroyWindow(win_name);
+	}
+
 	template<typename T, uint N = 3>
 	class VideoVolume;
 
@@ -248,49 +287,29 @@ namespace sibr {
 		}
 
 		void temporalBlur(float scaling = 1.0f) {
-			const cv::Mat1f kernel = (scaling / 16.0f)*(cv::Mat1f(5, 1) << 1, 4, 6, 4, 1);
-			cv::filter2D(mat, mat, -1, kernel, cv::Point(-1, -1), 0.0, cv::BORDER_DEFAULT);
+			filterTemporalInPlace(FilterKernel::binomial5(scaling), FilterBorder::REFLECT_101);
 		}
 
 		void temporalBlurBoundaryConditions(float scaling, double left, double right) {
-			const cv::Mat1f kernel = (scaling / 16.0f)*(cv::Mat1f(5, 1) << 1, 4, 6, 4, 1);
-
-			VideoVolume tmp(l, w, h);
-			for (int i = 0; i < h; ++i) {
-				for (int j = 0; j < w; ++j) {
-					for (int c = 0; c < N; ++c) {					
-						for (int t = 0; t < l; ++t) {
-							double res = 0;
-							for (int dt = -2; dt <= 2; ++dt) {
-								int u = t + dt;
-								double w = kernel(2 + dt), val;
-								if (u < 0) {
-									val = left;
-								} else if (u >= l) {
-									val = right;
-								} else {
-									val = valueAt(u, i, j, c);
-								}
-								res += w * val;
-							}
-							tmp.valueAt(t, i, j, c) = cv::saturate_cast<T>(res) ;
-						}
-					}				
-				}
-			}
-			std::swap(mat, tmp.mat);
+			filterTemporalInPlace(FilterKernel::binomial5(scaling), FilterBorder::CONSTANT, left, right);
 		}
 
 		void extendedTemporalBlur() {
-			//const cv::Mat kernel = (1 / 5.0f)*(cv::Mat_<float>(5, 1) << 1, 1, 1, 1, 1);
-			//cv::filter2D(mat, mat, -1, kernel, cv::Point(-1, -1), cv::BORDER_REPLICATE);
-			cv::boxFilter(mat, mat, -1, cv::Size(1, 25), cv::Point(-1, -1), true, cv::BORDER_REPLICATE);
+			filterTemporalInPlace(FilterKernel::box(25), FilterBorder::REPLICATE);
+		}
+
+		void filterTemporalInPlace(const FilterKernel & kernel, FilterBorder border, double left = 0.0, double right = 0.0) {
+			cv::Mat out;
+			filterTemporal<T>(mat, out, kernel, border, 1, left, right);
+			mat = out;
 		}
 
 		VideoVolume pyrDownSpacial() const {
 			VideoVolume out(l, (w + 1) / 2, (h + 1) / 2);
+#pragma omp parallel for
 			for (int f = 0; f < l; ++f) {
-				cv::pyrDown(frame(f), out.frame(f));
+				cv::Mat_<CVpixel> frameOut = out.frame(f);
+				cv::pyrDown(frame(f), frameOut);
 			}
 			return out;
 		}
@@ -305,8 +324,10 @@ namespace sibr {
 		}
 
 		VideoVolume pyrDownTemporal() const {
-			VideoVolume tmp(mat.clone(), w, h);
-			return tmp.pyrDownTemporalModif();
+			// Only the kept frames are filtered.
+			cv::Mat decimated;
+			filterTemporal<T>(mat, decimated, FilterKernel::binomial5(), FilterBorder::REFLECT_101, 2);
+			return VideoVolume(decimated, w, h);
 		}
 
 		VideoVolume pyrDownTemporalBox() const {
@@ -320,13 +341,9 @@ namespace sibr {
 		}
 
 		VideoVolume extendedDownScaleTemporal() const {
-			VideoVolume tmp(mat.clone(), w, h);
-			tmp.extendedTemporalBlur();
-			VideoVolume out((l + 1) / 2, w, h);
-			for (int f = 0; f < out.l; ++f) {
-				tmp.frame(2 * f).copyTo(out.frame(f));
-			}
-			return out;
+			cv::Mat decimated;
+			filterTemporal<T>(mat, decimated, FilterKernel::box(25), FilterBorder::REPLICATE, 2);
+			return VideoVolume(decimated, w, h);
 		}
 
 		VideoVolume pyrDown() const {
@@ -335,6 +352,7 @@ namespace sibr {
 
 		VideoVolume pyrUpSpacial(int _w, int _h) const {
 			VideoVolume out(l, _w, _h);
+#pragma omp parallel for
 			for (int f = 0; f < l; ++f) {
 				cv::pyrUp(frame(f), out.frame(f), cv::Size(_w, _h));
 			}
@@ -361,10 +379,10 @@ namespace sibr {
 		}
 
 		VideoVolume pyrDownBoundaryConditions(double left, double right) const {
-			VideoVolume tmp = clone();
-			tmp.temporalBlurBoundaryConditions(1.0f, left, right);
+			cv::Mat blurred;
+			filterTemporal<T>(mat, blurred, FilterKernel::binomial5(), FilterBorder::CONSTANT, 1, left, right);
 			VideoVolume out((l + 1) / 2, w, h);
-			cv::resize(tmp.mat, out.mat, out.mat.size(), 0, 0, cv::INTER_LINEAR);
+			cv::resize(blurred, out.mat, out.mat.size(), 0, 0, cv::INTER_LINEAR);
 			return out;
 		}
 
@@ -373,34 +391,7 @@ namespace sibr {
 		}
 
 		void play(int delay = 30, const sibr::Vector2i & res = { -1,-1 }, double scale = 1.0) const {
-			bool playing = true;
-			int t = 0;
-
-			const std::string win_name = "playing";
-			auto disp_frame = [&] {
-				if ((res.array() >= 0).all()) {
-					cv::Mat m;
-					cv::resize(cvConvertMatTo<uchar, 3>(frame(t), scale), m, cv::Size(res[0],res[1]), 0,0, cv::INTER_NEAREST);
-					cv::imshow(win_name, m);
-				} else {
-					cv::imshow(win_name, cvConvertMatTo<uchar, 3>(frame(t), scale));
-				}
-			};
-			
-			auto true_cb = [&](int new_t) {
-				t = new_t;
-				disp_frame();
-			};
-			auto cb_wrapper = [](int new_t, void * arg) { (*static_cast<decltype(true_cb)*>(arg))(new_t); };
-
-			while (playing) {					
-				disp_frame(); 
-				cv::createTrackbar("timestamp", win_name, &t, l - 1, cb_wrapper, &true_cb);	
-				playing = (cv::waitKey(delay) != 27);
-				t = (t + 1) % l;
-			}
-
-			cv::destroyWindow(win_name);
+			playVolume(*this, delay, res, scale);
 		}
 
 		void playStd(double scale = 1.0) const {
@@ -411,7 +402,9 @@ namespace sibr {
 			Path file = filepath;
 			makeDirectory(file.parent_path().string());
 
-			sibr::FFVideoEncoder output(filepath, framerate, { w,h });
+			VideoEncoderOptions options;
+			options.async = true;
+			sibr::FFVideoEncoder output(filepath, framerate, { w,h }, options);
 			for (int f = 0; f < l; ++f) {
 				output << sibr::cvConvertMatTo<uchar,3>(frame(f));
 			}
@@ -576,26 +569,29 @@ namespace sibr {
 		return out;
 	}
 
-	template<uint M>
-	std::vector<sibr::VideoVolume<uchar, M>> gaussianPyramid(const sibr::VideoVolume<uchar, M> & vid, uint num_levels = 0) {
+	/** Gaussian pyramid, decimated in space and time.
+	 The pyramid builders below accept a VideoVolume or a ChunkedVideoVolume, which streams over its bricks.
+	*/
+	template<template<typename, uint> class VolumeType, typename T, uint M>
+	std::vector<VolumeType<T, M>> gaussianPyramid(const VolumeType<T, M> & vid, uint num_levels = 0) {
 		if (num_levels == 0) {
 			num_levels = optimal_num_levels(vid.l);
 		}
 
-		std::vector<sibr::VideoVolume<uchar, M>> out(1, vid);
+		std::vector<VolumeType<T, M>> out(1, vid);
 		for (uint i = 1; i < num_levels; ++i) {
 			out.push_back(out.back().pyrDown());
 		}
 		return out;
 	}
 
-	template<typename T, uint M>
-	std::vector<sibr::VideoVolume<T, M>> gaussianPyramidTemporal (const sibr::VideoVolume<T, M> & vid, uint num_levels = 0) {
+	template<template<typename, uint> class VolumeType, typename T, uint M>
+	std::vector<VolumeType<T, M>> gaussianPyramidTemporal (const VolumeType<T, M> & vid, uint num_levels = 0) {
 		if (num_levels == 0) {
 			num_levels = optimal_num_levels(vid.l);
 		}
 
-		std::vector<sibr::VideoVolume<T, M>> out(1, vid);
+		std::vector<VolumeType<T, M>> out(1, vid);
 		for (uint i = 1; i < num_levels; ++i) {
 			out.push_back(out.back().pyrDownTemporal());
 		}
@@ -620,18 +616,18 @@ namespace sibr {
 	SIBR_VIDEO_EXPORT std::vector<sibr::Volume3u> laplacianPyramidTemporalDouble(const sibr::Volume3u & vid, uint num_levels = 0);
 
 
-	template< typename U, typename T = U>
-	std::vector<VideoVolume<T,3>> laplacianPyramidTemporal(const VideoVolume<U, 3>& vid, uint num_levels = 0)
+	template< typename U, typename T = U, template<typename, uint> class VolumeType>
+	std::vector<VolumeType<T,3>> laplacianPyramidTemporal(const VolumeType<U, 3>& vid, uint num_levels = 0)
 	{
 		if (num_levels == 0) {
 			num_levels = optimal_num_levels(vid.l);
 		}
 
-		std::vector<VideoVolume<T, 3>> out;
+		std::vector<VolumeType<T, 3>> out;
 
 		//std::cout << " num_levels : " << num_levels << std::endl;
 
-		sibr::Volume3f current_v = vid.convertTo<float>(), down, up;
+		VolumeType<float, 3> current_v = vid.template convertTo<float>(), down, up;
 		for (int i = 0; i < (int)num_levels - 1; ++i) {
 			//std::cout << i << " " << current_v.l << std::endl;
 			down = current_v.pyrDownTemporal();
@@ -640,20 +636,20 @@ namespace sibr {
 			//up.play(30, { 1200,800 });
 			current_v.substract(up);
 			current_v.shift(128);
-			out.push_back(current_v.convertTo<T>());
+			out.push_back(current_v.template convertTo<T>());
 			std::swap(current_v, down);
 		}
-		out.push_back(current_v.convertTo<T>());
+		out.push_back(current_v.template convertTo<T>());
 		return out;
 	}
 
 	SIBR_VIDEO_EXPORT sibr::Volume3u collapseLaplacianPyramid(const std::vector<sibr::Volume3u> & pyr, double shift = 0);
 
-	template<typename T>
-	sibr::VideoVolume<T,3> collapseLaplacianPyramidTemporal(const std::vector<sibr::VideoVolume<T, 3>>& pyr, double shift,
+	template<template<typename, uint> class VolumeType, typename T>
+	VolumeType<T,3> collapseLaplacianPyramidTemporal(const std::vector<VolumeType<T, 3>>& pyr, double shift,
 		bool debug = false)
 	{
-		sibr::Volume3f v = pyr.back().convertTo<float>();
+		VolumeType<float, 3> v = pyr.back().template convertTo<float>();
 		for (int i = (int)pyr.size() - 2; i >= 0; --i) {
 			if (debug) {
 				v.play();
@@ -670,7 +666,7 @@ namespace sibr {
 				}
 			}
 		}
-		return v.convertTo<T>();
+		return v.template convertTo<T>();
 	}
 
 	//SIBR_VIDEO_EXPORT sibr::Volume3u collapseLaplacianPyramidTemporal(const std::vector<sibr::Volume3u> & pyr, double shift = 0);
@@ -678,11 +674,11 @@ namespace sibr {
 	//SIBR_VIDEO_EXPORT sibr::Volume3u laplacianBlendingTemporal(const sibr::Volume3u & vA, const sibr::Volume3u & vB, std::vector<sibr::Volume1u> & pyrM);
 	SIBR_VIDEO_EXPORT sibr::Volume3u laplacianBlending(const sibr::Volume3u & vA, const sibr::Volume3u & vB, std::vector<sibr::Volume1u> & pyrM);
 
-	template<typename T_V, typename T_M>
-	sibr::VideoVolume<T_V, 3> laplacianBlendingTemporal(
-		const sibr::VideoVolume<T_V,3> & vA,
-		const sibr::VideoVolume<T_V, 3> & vB,
-		std::vector<sibr::VideoVolume<T_M, 1>> & pyrM)
+	template<template<typename, uint> class VolumeType, typename T_V, typename T_M>
+	VolumeType<T_V, 3> laplacianBlendingTemporal(
+		const VolumeType<T_V,3> & vA,
+		const VolumeType<T_V, 3> & vB,
+		std::vector<VolumeType<T_M, 1>> & pyrM)
 	{
 		uint num_levels = (uint)pyrM.size();
 
@@ -1042,6 +1038,27 @@ namespace sibr {
 		int numBins = 50;
 	};
 
+	/** Optical flow algorithms. */
+	enum class FlowMethod {
+		SIMPLE_FLOW, ///< cv::optflow::calcOpticalFlowSF on color frames.
+		DEEP_FLOW ///< cv::optflow DeepFlow on grey frames.
+	};
+
+	/** Binary optical flow file formats. */
+	enum class FlowFormat {
+		FLO, ///< Middlebury .flo: "PIEH" tag, width, height, then interleaved 32 bits float (u,v) pairs.
+		FLO16 ///< Same layout with a "FL16" tag and 16 bits floats, half the size.
+	};
+
+	/** Options for VideoUtils::computeSaveFlowBatch. */
+	struct SIBR_VIDEO_EXPORT FlowBatchOptions {
+		FlowMethod method = FlowMethod::DEEP_FLOW; ///< Flow algorithm.
+		FlowFormat format = FlowFormat::FLO; ///< Output file format.
+		float ratio = 1.0f; ///< Frames scaling before computing the flow.
+		int threadsCount = 0; ///< Number of frame pairs processed in parallel, 0 for the number of cores.
+		int batchSize = 32; ///< Number of frame pairs decoded before processing them, bounds memory usage.
+	};
+
 	class SIBR_VIDEO_EXPORT VideoUtils {
 
 	public:
@@ -1052,6 +1069,7 @@ namespace sibr {
 		static void loopAndDisplay(cv::VideoCapture & cap, float ratio, FunType f, const OtherArgsTypes &... args);
 
 		static void deepFlowViz(cv::VideoCapture & cap, float ratio);
+		static void deepFlowViz(sibr::Video & vid, float ratio);
 
 		static cv::Mat getGrey(const cv::Mat & mat);
 
@@ -1075,6 +1093,30 @@ namespace sibr {
 
 		static void computeSaveSimpleFlow(sibr::Video & vid, bool viz = false);
 
+		/** Compute the optical flow between all consecutive frames of a video and save each field in a binary file.
+		 The video is decoded once, by batches of frame pairs, and the pairs of a batch are processed in parallel.
+		\param vid the video
+		\param naming_f returns the file path of the flow between frames flow_id and flow_id+1
+		\param options flow method, output format and parallelism
+		\return the number of flow fields saved
+		*/
+		static int computeSaveFlowBatch(sibr::Video & vid, std::function<std::string(int flow_id)> naming_f,
+			const FlowBatchOptions & options = FlowBatchOptions());
+
+		/** Save an optical flow field.
+		\param path destination file
+		\param flow the flow, CV_32FC2
+		\param format file format
+		\return true if the file was written
+		*/
+		static bool saveFlow(const std::string & path, const cv::Mat & flow, FlowFormat format = FlowFormat::FLO);
+
+		/** Load an optical flow field saved with saveFlow (any FlowFormat).
+		\param path the file
+		\return the flow as CV_32FC2, empty on failure
+		*/
+		static cv::Mat loadFlow(const std::string & path);
+
 		static cv::Mat getTemporalSpatialRatio(sibr::Video & vid, PyramidLayer & out_ratio, const sibr::ImageRGB & spatial_ratio,
 			int numBins = 50, float time_skip_begin = 0, float time_skip_end = 0);
 
@@ -1109,6 +1151,12 @@ namespace sibr {
 			std::function<bool(cv::Mat prev, cv::Mat next, cv::Mat flow, int flow_id)> f,
 			std::function<void(void)> end_function = []() {}
 		);
+
+		/** Same as above, reading luma frames with Video::nextGrey (no colour conversion with the FFMPEG backend). */
+		static void deepFlow(sibr::Video & vid, float ratio,
+			std::function<bool(cv::Mat prev, cv::Mat next, cv::Mat flow, int flow_id)> f,
+			std::function<void(void)> end_function = []() {}
+		);
 	};
 
 	template<typename FunType, typename... OtherArgsTypes>
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "VolumeFilter.hpp"
+
+namespace sibr
+{
+	FilterKernel FilterKernel::binomial5(float scaling)
+	{
+		FilterKernel kernel;
+		const float norm = scaling / 16.0f;
+		kernel.weights = { norm, 4.0f * norm, 6.0f * norm, 4.0f * norm, norm };
+		return kernel;
+	}
+
+	FilterKernel FilterKernel::box(int size)
+	{
+		FilterKernel kernel;
+		size = std::max(1, size | 1);
+		kernel.weights.assign(size, 1.0f / float(size));
+		return kernel;
+	}
+
+	void pyrDownFrames(const cv::Mat & src, int w, int h, int channels, cv::Mat & dst, int step)
+	{
+		const int dw = (w + 1) / 2;
+		const int dh = (h + 1) / 2;
+		cv::Mat out((src.rows + step - 1) / step, dw * dh * channels, src.depth());
+
+#pragma omp parallel for
+		for (int t = 0; t < out.rows; ++t) {
+			cv::Mat frameOut = out.row(t).reshape(channels, dh);
+			cv::pyrDown(src.row(t * step).reshape(channels, h), frameOut);
+		}
+		dst = out;
+	}
+
+	void pyrUpFrames(const cv::Mat & src, int w, int h, int channels, int dstW, int dstH, cv::Mat & dst)
+	{
+		cv::Mat out(src.rows, dstW * dstH * channels, src.depth());
+
+#pragma omp parallel for
+		for (int t = 0; t < src.rows; ++t) {
+			cv::Mat frameOut = out.row(t).reshape(channels, dstH);
+			cv::pyrUp(src.row(t).reshape(channels, h), frameOut, cv::Size(dstW, dstH));
+		}
+		dst = out;
+	}
+
+} // namespace sibr
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+#include "Config.hpp"
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace sibr
+{
+	/**
+	* \addtogroup sibr_video
+	* @{
+	*/
+
+	/** How samples outside of the volume are defined when filtering along time. */
+	enum class FilterBorder {
+		REFLECT_101, ///< gfedcb|abcdefgh|gfedcba, as cv::BORDER_DEFAULT.
+		REPLICATE, ///< aaaaaa|abcdefgh|hhhhhhh, as cv::BORDER_REPLICATE.
+		CONSTANT ///< Fixed values before the first and after the last frame.
+	};
+
+	/** 1D centered filtering kernel, with an odd number of taps. */
+	struct SIBR_VIDEO_EXPORT FilterKernel {
+
+		std::vector<float> weights; ///< Taps, from -radius to +radius.
+
+		/** \return the kernel radius. */
+		int radius() const { return int(weights.size()) / 2; }
+
+		/** 5-tap binomial kernel (1 4 6 4 1)/16, used by the gaussian pyramids.
+		\param scaling multiplier applied to the weights
+		\return the kernel
+		*/
+		static FilterKernel binomial5(float scaling = 1.0f);
+
+		/** Normalized box kernel.
+		\param size number of taps, should be odd
+		\return the kernel
+		*/
+		static FilterKernel box(int size);
+	};
+
+	/** Map a frame index to the valid range according to a border mode.
+	\param u the frame index
+	\param length the number of frames
+	\param border the border mode
+	\return the index in [0, length[, or -1 (before the first frame) / -2 (after the last frame) for FilterBorder::CONSTANT
+	*/
+	inline int filterBorderIndex(int u, int length, FilterBorder border)
+	{
+		if (u >= 0 && u < length) {
+			return u;
+		}
+		if (border == FilterBorder::CONSTANT) {
+			return u < 0 ? -1 : -2;
+		}
+		if (border == FilterBorder::REPLICATE || length == 1) {
+			return u < 0 ? 0 : length - 1;
+		}
+		while (u < 0 || u >= length) {
+			u = u < 0 ? -u : 2 * (length - 1) - u;
+		}
+		return u;
+	}
+
+	/** Number of values processed together by the temporal filters. */
+	static const int filterChunkSize = 1024;
+
+	/** Filter a volume along time. The volume stores one frame per row (any width and channels count,
+	 all values of a row being contiguous); each output value is a weighted sum of the values at the same
+	 position in the neighbouring frames. The work is split in chunks of rows, processed in parallel, with
+	 vectorizable inner loops.
+	\param src the input volume, with elements of type T
+	\param dst will contain the output volume, can be src
+	\param kernel the filter
+	\param border border mode
+	\param step temporal decimation: only the frames 0, step, 2*step... are computed and kept
+	\param left value before the first frame (FilterBorder::CONSTANT)
+	\param right value after the last frame (FilterBorder::CONSTANT)
+	*/
+	template<typename T>
+	void filterTemporal(const cv::Mat & src, cv::Mat & dst, const FilterKernel & kernel,
+		FilterBorder border = FilterBorder::REFLECT_101, int step = 1, double left = 0.0, double right = 0.0)
+	{
+		CV_Assert(src.elemSize1() == sizeof(T) && step >= 1);
+		const int l = src.rows;
+		const int rowSize = src.cols * src.channels();
+		const int outL = (l + step - 1) / step;
+		const int radius = kernel.radius();
+		cv::Mat out(outL, src.cols, src.type());
+
+		const int chunksCount = (rowSize + filterChunkSize - 1) / filterChunkSize;
+		const int jobsCount = outL * chunksCount;
+
+#pragma omp parallel for
+		for (int job = 0; job < jobsCount; ++job) {
+			const int t = job / chunksCount;
+			const int start = (job % chunksCount) * filterChunkSize;
+			const int count = std::min(filterChunkSize, rowSize - start);
+
+			float acc[filterChunkSize];
+			for (int x = 0; x < count; ++x) {
+				acc[x] = 0.0f;
+			}
+			for (int k = -radius; k <= radius; ++k) {
+				const float weight = kernel.weights[k + radius];
+				const int u = filterBorderIndex(t * step + k, l, border);
+				if (u < 0) {
+					const float value = weight * float(u == -1 ? left : right);
+					for (int x = 0; x < count; ++x) {
+						acc[x] += value;
+					}
+				} else {
+					const T * in = src.ptr<T>(u) + start;
+					for (int x = 0; x < count; ++x) {
+						acc[x] += weight * float(in[x]);
+					}
+				}
+			}
+			T * o = out.ptr<T>(t) + start;
+			for (int x = 0; x < count; ++x) {
+				o[x] = cv::saturate_cast<T>(acc[x]);
+			}
+		}
+		dst = out;
+	}
+
+	/** Upsample a volume along time: frames are interleaved with zero frames, then filtered (REFLECT_101 border).
+	 The zero frames are never built nor read. With FilterKernel::binomial5(2.0f), this is the temporal
+	 expansion step of a gaussian pyramid.
+	\param src the input volume, one frame per row, with elements of type T
+	\param length number of output frames (at most 2*src.rows)
+	\param dst will contain the output volume
+	\param kernel the filter
+	*/
+	template<typename T>
+	void upsampleTemporal(const cv::Mat & src, int length, cv::Mat & dst, const FilterKernel & kernel)
+	{
+		CV_Assert(src.elemSize1() == sizeof(T) && length <= 2 * src.rows);
+		const int rowSize = src.cols * src.channels();
+		const int radius = kernel.radius();
+		cv::Mat out(length, src.cols, src.type());
+
+		const int chunksCount = (rowSize + filterChunkSize - 1) / filterChunkSize;
+		const int jobsCount = length * chunksCount;
+
+#pragma omp parallel for
+		for (int job = 0; job < jobsCount; ++job) {
+			const int t = job / chunksCount;
+			const int start = (job % chunksCount) * filterChunkSize;
+			const int count = std::min(filterChunkSize, rowSize - start);
+
+			float acc[filterChunkSize];
+			for (int x = 0; x < count; ++x) {
+				acc[x] = 0.0f;
+			}
+			for (int k = -radius; k <= radius; ++k) {
+				const int u = filterBorderIndex(t + k, length, FilterBorder::REFLECT_101);
+				// Odd frames of the upsampled sequence are zero.
+				if (u % 2 != 0) {
+					continue;
+				}
+				const float weight = kernel.weights[k + radius];
+				const T * in = src.ptr<T>(u / 2) + start;
+				for (int x = 0; x < count; ++x) {
+					acc[x] += weight * float(in[x]);
+				}
+			}
+			T * o = out.ptr<T>(t) + start;
+			for (int x = 0; x < count; ++x) {
+				o[x] = cv::saturate_cast<T>(acc[x]);
+			}
+		}
+		dst = out;
+	}
+
+	/** Apply cv::pyrDown to each frame of a volume, in parallel.
+	\param src the input volume, one frame of w x h pixels per row
+	\param w frame width
+	\param h frame height
+	\param channels number of channels
+	\param dst will contain the output volume, with frames of (w+1)/2 x (h+1)/2 pixels
+	\param step temporal decimation: only the frames 0, step, 2*step... are processed and kept
+	*/
+	SIBR_VIDEO_EXPORT void pyrDownFrames(const cv::Mat & src, int w, int h, int channels, cv::Mat & dst, int step = 1);
+
+	/** Apply cv::pyrUp to each frame of a volume, in parallel.
+	\param src the input volume, one frame per row
+	\param w input frame width
+	\param h input frame height
+	\param channels number of channels
+	\param dstW output frame width
+	\param dstH output frame height
+	\param dst will contain the output volume, with frames of dstW x dstH pixels
+	*/
+	SIBR_VIDEO_EXPORT void pyrUpFrames(const cv::Mat & src, int w, int h, int channels, int dstW, int dstH, cv::Mat & dst);
+
+	/** }@ */
+
+} // namespace sibr
@@ -13,6 +13,7 @@
 
 # include "core/graphics/GUI.hpp"
 # include "core/view/MultiViewManager.hpp"
+# include "core/system/Utils.hpp"
 
 namespace sibr
 {
@@ -29,6 +30,11 @@ namespace sibr
 		_exportPath = "./screenshots";
 	}
 
+	MultiViewBase::~MultiViewBase()
+	{
+		finishVideoRecording("");
+	}
+
 	void MultiViewBase::onUpdate(Input& input)
 	{
 		if (input.key().isActivated(Key::LeftControl) && input.key().isPressed(Key::LeftAlt) && input.key().isPressed(Key::P)) {
@@ -215,17 +221,13 @@ namespace sibr
 			subview.render(_renderingMode, renderViewport);
 
 			// Offline video dumping, continued. We ignore additional rendering as those often are GUI overlays.
-			if (subview.handler != NULL && (subview.handler->getCamera().needVideoSave() || subview.handler->getCamera().needSave())) {
-				
+			if (subview.handler != NULL && subview.handler->getCamera().needSave()) {
 				ImageRGB frame;
-
 				subview.rt->readBack(frame);
-				
-				if (subview.handler->getCamera().needSave()) {
-					frame.save(subview.handler->getCamera().savePath());
-				}
-				_videoFrames.push_back(frame.toOpenCVBGR());
-				
+				frame.save(subview.handler->getCamera().savePath());
+			}
+			if (subview.handler != NULL && subview.handler->getCamera().needVideoSave()) {
+				recordVideoFrame(subview);
 			}
 			
 			// Additional rendering.
@@ -308,6 +310,60 @@ namespace sibr
 		return static_cast<int>(_subViews.size() + _ibrSubViews.size() + _subMultiViews.size());
 	}
 
+	void MultiViewBase::recordVideoFrame(SubView & subview)
+	{
+		if (!_videoRecorder) {
+			// Frames are encoded as they come, in a temporary file moved to its destination on export.
+			const boost::filesystem::path tmpPath = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("sibr_video_%%%%%%%%.mp4");
+			_videoRecordingPath = tmpPath.string();
+			VideoEncoderOptions options;
+			options.async = true;
+			options.forceResize = true;
+			_videoEncoder.reset(new FFVideoEncoder(_videoRecordingPath, 30, Vector2i(subview.rt->w(), subview.rt->h()), options));
+			if (!_videoEncoder->isFine()) {
+				SIBR_WRG << "Unable to record the video in " << _videoRecordingPath << "." << std::endl;
+				_videoEncoder.reset();
+				return;
+			}
+			_videoReadback.reset(new PixelPackReadback());
+			_videoRecorder.reset(new FrameStreamRecorder(_videoReadback, FrameStreamRecorder::encoderSink(_videoEncoder)));
+		}
+		_videoReadback->source(*subview.rt);
+		_videoRecorder->capture();
+	}
+
+	bool MultiViewBase::finishVideoRecording(const std::string & outputVideo)
+	{
+		if (!_videoRecorder) {
+			return false;
+		}
+		_videoRecorder->finish();
+		const FrameStreamStats stats = _videoRecorder->stats();
+		_videoEncoder->close();
+		_videoRecorder.reset();
+		_videoReadback.reset();
+		_videoEncoder.reset();
+
+		boost::system::error_code error;
+		if (outputVideo.empty() || stats.written == 0) {
+			boost::filesystem::remove(_videoRecordingPath, error);
+			return false;
+		}
+		// Renaming fails across file systems, copy instead.
+		boost::filesystem::rename(_videoRecordingPath, outputVideo, error);
+		if (error) {
+			if (!copyFile(_videoRecordingPath, outputVideo, true)) {
+				SIBR_WRG << "Unable to move the video to " << outputVideo << ", it is still available at " << _videoRecordingPath << "." << std::endl;
+				return false;
+			}
+			boost::filesystem::remove(_videoRecordingPath, error);
+		}
+		if (stats.failed > 0) {
+			SIBR_WRG << stats.failed << " frames could not be encoded." << std::endl;
+		}
+		return true;
+	}
+
 	void MultiViewBase::captureView(const std::string & subviewName, const std::string & path, const std::string & filename)
 	{
 		if (_subViews.count(subviewName)) {
@@ -608,15 +664,11 @@ namespace sibr
 					std::string saveFile;
 					if (showFilePicker(saveFile, FilePickerMode::Save)) {
 						const std::string outputVideo = saveFile + ".mp4";
-						if(!_videoFrames.empty()) {
+						if(_videoRecorder) {
 							SIBR_LOG << "Exporting video to : " << outputVideo << " ..." << std::flush;
-							FFVideoEncoder vdoEncoder(outputVideo, 30, Vector2i(_videoFrames[0].cols, _videoFrames[0].rows));
-							for (int i = 0; i < _videoFrames.size(); i++) {
-								vdoEncoder << _videoFrames[i];
+							if (finishVideoRecording(outputVideo)) {
+								std::cout << " Done." << std::endl;
 							}
-							_videoFrames.clear();
-							std::cout << " Done." << std::endl;
-							
 						} else {
 							SIBR_WRG << "No frames to export!! Check save frames in camera options for the view you want to render and play the path and re-export!" << std::endl;
 						}
@@ -30,6 +30,7 @@
 # include "core/graphics/Shader.hpp"
 # include "core/view/FPSCounter.hpp"
 #include "core/video/FFmpegVideoEncoder.hpp"
+#include "core/video/FrameStreamRecorder.hpp"
 #include "InteractiveCameraHandler.hpp"
 #include <random>
 #include <map>
@@ -73,6 +74,9 @@ namespace sibr
 		 */
 		MultiViewBase(const Vector2i & defaultViewRes = { 800, 600 });
 
+		/** Destructor, discards the video being recorded if it was not exported. */
+		virtual ~MultiViewBase();
+
 		/**
 		 * \brief Update subviews and the MultiViewBase.
 		 * \param input The input state to use.
@@ -367,6 +371,18 @@ namespace sibr
 		 *\note if the filename is empty, the name of the view is used, with a timestamp appended.
 		 **/
 		static void captureView(const SubView & view, const std::string & path = "./screenshots/", const std::string & filename = "");
+
+		/** Stream the content of a subview to the video being recorded, starting the recording if needed.
+		 * The frame is read back asynchronously and encoded on another thread.
+		 *\param subview the subview to record
+		 **/
+		void recordVideoFrame(SubView & subview);
+
+		/** Finish the video being recorded and move it to its destination.
+		 *\param outputVideo the destination path, if empty the video is discarded
+		 *\return false if no frame was recorded or the video could not be moved
+		 **/
+		bool finishVideoRecording(const std::string & outputVideo);
 		
 		IRenderingMode::Ptr _renderingMode = nullptr; ///< Rendering mode.
 		std::map<std::string, BasicSubView> _subViews; ///< Regular subviews.
@@ -376,7 +392,10 @@ namespace sibr
 		Vector2i _defaultViewResolution; ///< Default view resolution.
 
 		std::string _exportPath; ///< Capture output path.
-		std::vector<cv::Mat> _videoFrames; ///< Video frames.
+		std::shared_ptr<FFVideoEncoder> _videoEncoder; ///< Encoder of the video being recorded.
+		PixelPackReadback::Ptr _videoReadback; ///< Asynchronous readback of the recorded frames.
+		FrameStreamRecorder::Ptr _videoRecorder; ///< Streams the recorded frames to the encoder.
+		std::string _videoRecordingPath; ///< Temporary path of the video being recorded.
 
 		std::chrono::time_point<std::chrono::steady_clock> _timeLastFrame; ///< Last frame time point.
 		float _deltaTime; ///< Elapsed time.
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "core/view/OfflinePathRenderer.hpp"
+#include "core/graphics/RenderTarget.hpp"
+#include "core/system/SimpleTimer.hpp"
+#include "core/system/String.hpp"
+#include "core/system/Utils.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace sibr
+{
+	std::string OfflinePathTimings::toString() const
+	{
+		const double count = double(std::max(frames, size_t(1)));
+		std::ostringstream str;
+		str << std::fixed << std::setprecision(2);
+		str << frames << " frames in " << total / 1000.0 << "s (" << (total > 0.0 ? 1000.0 * double(frames) / total : 0.0) << " fps)" << std::endl;
+		str << "\trender:   " << render / count << " ms/frame" << std::endl;
+		str << "\treadback: " << readback / count << " ms/frame" << std::endl;
+		str << "\tencode:   " << encode / count << " ms/frame" << std::endl;
+		str << "\twrite:    " << write / count << " ms/frame" << std::endl;
+		str << "\twait:     " << wait / count << " ms/frame" << std::endl;
+		return str.str();
+	}
+
+	OfflinePathRenderer::OfflinePathRenderer(const OfflinePathOptions & options) :
+		_options(options)
+	{
+	}
+
+	OfflinePathTimings OfflinePathRenderer::render(const CameraRecorder & recorder, const std::string & outPathDir, const ViewBase::Ptr & view, const std::string & prefix)
+	{
+		// Same destination as CameraRecorder::recordOfflinePath.
+		std::string outpathd = outPathDir;
+		if (outPathDir == "pathOutput" && recorder.savingPath() != "") {
+			outpathd = recorder.savingPath() + "/" + "pathOutput";
+		}
+		outpathd = outpathd + "/" + prefix;
+
+		return render(recorder.cams(), recorder.offlineResolution(), outpathd, view);
+	}
+
+	OfflinePathTimings OfflinePathRenderer::render(const std::vector<Camera> & cameras, const Vector2u & size, const std::string & outputDir, const ViewBase::Ptr & view)
+	{
+		OfflinePathTimings timings;
+		sibr::Timer totalTimer;
+		totalTimer.tic();
+
+		std::unique_ptr<FFVideoEncoder> encoder;
+		if (!_options.videoPath.empty()) {
+			const std::string videoDir = parentDirectory(_options.videoPath);
+			if (!videoDir.empty()) {
+				makeDirectory(videoDir);
+			}
+			VideoEncoderOptions videoOptions = _options.videoOptions;
+			// Odd dimensions are rounded by the encoder.
+			videoOptions.forceResize = videoOptions.forceResize || (size.x() % 2 != 0) || (size.y() % 2 != 0);
+			encoder.reset(new FFVideoEncoder(_options.videoPath, _options.frameRate, Vector2i(int(size.x()), int(size.y())), videoOptions));
+			if (!encoder->isFine()) {
+				SIBR_WRG << "Unable to create the video " << _options.videoPath << "." << std::endl;
+				return timings;
+			}
+			std::cout << "Rendering path with " << cameras.size() << " cameras to " << _options.videoPath << std::endl;
+		} else {
+			makeDirectory(outputDir);
+			std::cout << "Rendering path with " << cameras.size() << " cameras to " << outputDir << std::endl;
+		}
+
+		// The video frames have to be encoded in order, by a single thread.
+		int workersCount = 1;
+		if (!encoder) {
+			workersCount = _options.workersCount > 0 ? _options.workersCount : std::max(1, int(std::thread::hardware_concurrency()) - 1);
+		}
+		const size_t queueSize = std::max(_options.queueSize, size_t(1));
+
+		_queue.clear();
+		_done = false;
+		std::vector<OfflinePathTimings> workersTimings(workersCount);
+		std::vector<std::thread> workers;
+		for (int w = 0; w < workersCount; ++w) {
+			workers.emplace_back(&OfflinePathRenderer::outputLoop, this, std::cref(outputDir), encoder.get(), std::ref(workersTimings[w]));
+		}
+
+		RenderTargetRGBA32F outFrame(size.x(), size.y());
+		sibr::Timer timer;
+		for (size_t i = 0; i < cameras.size(); ++i) {
+			timer.tic();
+			outFrame.clear();
+			view->onRenderIBR(outFrame, cameras[i]);
+			// Wait for the GPU, so that its work is not accounted as readback.
+			glFinish();
+			timings.render += timer.deltaTimeFromLastTic();
+
+			timer.tic();
+			ImageRGBA32F::Ptr image(new ImageRGBA32F(size.x(), size.y()));
+			outFrame.readBack(*image);
+			timings.readback += timer.deltaTimeFromLastTic();
+
+			timer.tic();
+			{
+				std::unique_lock<std::mutex> lock(_queueMutex);
+				_spaceReady.wait(lock, [this, queueSize]() { return _queue.size() < queueSize; });
+				_queue.push_back({ i, image });
+			}
+			_frameReady.notify_one();
+			timings.wait += timer.deltaTimeFromLastTic();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_queueMutex);
+			_done = true;
+		}
+		_frameReady.notify_all();
+		for (std::thread & worker : workers) {
+			worker.join();
+		}
+		for (const OfflinePathTimings & workerTimings : workersTimings) {
+			timings.encode += workerTimings.encode;
+			timings.write += workerTimings.write;
+		}
+		if (encoder) {
+			// Flush the frames still in the encoder.
+			timer.tic();
+			encoder->close();
+			timings.encode += timer.deltaTimeFromLastTic();
+		}
+
+		timings.frames = cameras.size();
+		timings.total = totalTimer.deltaTimeFromLastTic();
+		std::cout << "Done rendering path. " << timings.toString() << std::flush;
+		return timings;
+	}
+
+	void OfflinePathRenderer::outputLoop(const std::string & outputDir, FFVideoEncoder * encoder, OfflinePathTimings & timings)
+	{
+		sibr::Timer timer;
+		while (true) {
+			Frame frame;
+			{
+				std::unique_lock<std::mutex> lock(_queueMutex);
+				_frameReady.wait(lock, [this]() { return _done || !_queue.empty(); });
+				if (_queue.empty()) {
+					return;
+				}
+				frame = std::move(_queue.front());
+				_queue.pop_front();
+			}
+			_spaceReady.notify_one();
+
+			// Same conversion as ImageRGBA32F::save.
+			timer.tic();
+			if (encoder) {
+				cv::Mat bgr, bgr8;
+				cv::cvtColor(frame.image->toOpenCV(), bgr, cv::COLOR_RGBA2BGR);
+				bgr.convertTo(bgr8, CV_8UC3, 255.0);
+				(*encoder) << bgr8;
+				timings.encode += timer.deltaTimeFromLastTic();
+				continue;
+			}
+
+			cv::Mat bgra, bgra8;
+			cv::cvtColor(frame.image->toOpenCV(), bgra, cv::COLOR_RGBA2BGRA);
+			bgra.convertTo(bgra8, CV_8UC4, 255.0);
+			std::vector<uchar> buffer;
+			cv::imencode(".png", bgra8, buffer);
+			timings.encode += timer.deltaTimeFromLastTic();
+
+			timer.tic();
+			std::ostringstream ssZeroPad;
+			ssZeroPad << std::setw(8) << std::setfill('0') << frame.index;
+			const std::string outFileName = outputDir + "/" + ssZeroPad.str() + ".png";
+			std::ofstream file(outFileName, std::ios::binary);
+			file.write(reinterpret_cast<const char *>(buffer.data()), std::streamsize(buffer.size()));
+			if (!file) {
+				SIBR_WRG << "Unable to write " << outFileName << "." << std::endl;
+			}
+			timings.write += timer.deltaTimeFromLastTic();
+		}
+	}
+
+} // namespace sibr
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include "core/view/Config.hpp"
+# include "core/view/ViewBase.hpp"
+# include "core/assets/CameraRecorder.hpp"
+# include "core/video/FFmpegVideoEncoder.hpp"
+
+# include <condition_variable>
+# include <deque>
+# include <mutex>
+
+namespace sibr
+{
+
+	/** Parameters of an OfflinePathRenderer.
+	* \ingroup sibr_view
+	*/
+	struct SIBR_VIEW_EXPORT OfflinePathOptions {
+		size_t queueSize = 8; ///< Maximum number of rendered frames waiting for output, rendering blocks when it is reached.
+		int workersCount = 0; ///< Number of image encoding threads, 0 to use all cores but the rendering one.
+		std::string videoPath; ///< If not empty, stream the frames to this video file instead of saving images.
+		double frameRate = 30.0; ///< Video frame rate.
+		VideoEncoderOptions videoOptions; ///< Video encoding parameters.
+	};
+
+	/** Time spent in each stage of an offline rendering, in milliseconds.
+	* Encoding and writing happen on several threads, their durations are summed over all threads.
+	* \ingroup sibr_view
+	*/
+	struct SIBR_VIEW_EXPORT OfflinePathTimings {
+		size_t frames = 0; ///< Number of frames output.
+		double render = 0.0; ///< View rendering, GPU work included.
+		double readback = 0.0; ///< GPU to CPU transfer.
+		double encode = 0.0; ///< Conversion and PNG or video encoding.
+		double write = 0.0; ///< File writing, included in encode for videos.
+		double wait = 0.0; ///< Time the rendering thread was blocked by a full queue.
+		double total = 0.0; ///< Wall clock duration.
+
+		/** \return a human readable summary, with per frame averages. */
+		std::string toString() const;
+	};
+
+	/** Render a camera path offline, as CameraRecorder::recordOfflinePath, but with the output decoupled from the rendering:
+	* frames read back from the GPU are pushed in a bounded queue, and encoded and written by a pool of worker threads
+	* (a single one, preserving the order, when streaming to a video). Rendering only blocks when the queue is full.
+	* \ingroup sibr_view
+	*/
+	class SIBR_VIEW_EXPORT OfflinePathRenderer
+	{
+		SIBR_CLASS_PTR(OfflinePathRenderer);
+
+	public:
+
+		/** Constructor.
+		\param options output parameters
+		*/
+		OfflinePathRenderer(const OfflinePathOptions & options = {});
+
+		/** Render all cameras of a path, with the same output location and names as CameraRecorder::recordOfflinePath.
+		\param recorder the recorder, with a path loaded by CameraRecorder::loadPath
+		\param outPathDir the destination directory ("pathOutput" to use a directory next to the path file)
+		\param view the view to render
+		\param prefix the subdirectory for the frames
+		\return the stages timings
+		*/
+		OfflinePathTimings render(const CameraRecorder & recorder, const std::string & outPathDir, const ViewBase::Ptr & view, const std::string & prefix);
+
+		/** Render a list of cameras.
+		\param cameras the viewpoints
+		\param size the rendering resolution
+		\param outputDir the frames destination directory, ignored when streaming to a video
+		\param view the view to render
+		\return the stages timings
+		*/
+		OfflinePathTimings render(const std::vector<Camera> & cameras, const Vector2u & size, const std::string & outputDir, const ViewBase::Ptr & view);
+
+		/** \return the output parameters. */
+		OfflinePathOptions & options() { return _options; }
+
+	private:
+
+		/** A rendered frame waiting for output. */
+		struct Frame {
+			size_t index; ///< Position in the path.
+			ImageRGBA32F::Ptr image; ///< Read back content.
+		};
+
+		/** Output thread loop: pop frames and save them or send them to the encoder.
+		\param outputDir the frames destination directory
+		\param encoder the video encoder, or nullptr to save images
+		\param timings will accumulate the encode and write durations
+		*/
+		void outputLoop(const std::string & outputDir, FFVideoEncoder * encoder, OfflinePathTimings & timings);
+
+		OfflinePathOptions _options; ///< Output parameters.
+
+		std::deque<Frame> _queue; ///< Frames waiting for output.
+		std::mutex _queueMutex; ///< Protects the queue and the flag below.
+		std::condition_variable _frameReady; ///< Signaled when a frame is pushed or the rendering is done.
+		std::condition_variable _spaceReady; ///< Signaled when a frame is popped.
+		bool _done = false; ///< No more frames will be pushed.
+	};
+
+} // namespace sibr
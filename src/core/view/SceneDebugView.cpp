@@ -162,7 +162,7 @@ namespace sibr
 	}
 
 	void ImageCamViewer::renderImage(const Camera & eye, const InputCamera & cam,
-		const std::vector<RenderTargetRGBA32F::Ptr> & rts, int cam_id)
+		const std::vector<IRenderTarget::Ptr> & rts, int cam_id)
 	{
 		const auto quad = generateCamQuadWithUvs(cam, _cameraScaling);
 		if (cam_id < rts.size() && rts[cam_id]) {
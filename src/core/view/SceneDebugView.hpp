@@ -127,7 +127,7 @@ namespace sibr
 		 *\param rts input 2D textures list
 		 *\param cam_id the list index associated to the camera
 		 */
-		void renderImage(const Camera & eye, const InputCamera & cam, const std::vector<RenderTargetRGBA32F::Ptr> & rts, int cam_id);
+		void renderImage(const Camera & eye, const InputCamera & cam, const std::vector<IRenderTarget::Ptr> & rts, int cam_id);
 
 		/** Render one specific input image on a camera image plane.
 		 *\param eye the current viewpoint
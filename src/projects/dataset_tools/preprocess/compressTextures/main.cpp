@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <algorithm>
+#include <limits>
+#include "core/system/CommandLineArgs.hpp"
+#include "core/system/SimpleTimer.hpp"
+#include "core/graphics/BlockCompression.hpp"
+#include "core/scene/BasicIBRScene.hpp"
+
+using namespace sibr;
+
+/** Options for input images block compression. */
+struct CompressTexturesArgs : virtual BasicIBRAppArgs {
+	Arg<std::string> format = { "format", "bc7", "block format, bc1 or bc7" };
+	Arg<std::string> output = { "output", "", "cache file (defaults to the one read by --texture-compression)" };
+	Arg<bool> mipmaps = { "mipmaps", "also encode the mip levels, for texture arrays created with automatic mipmaps" };
+	Arg<bool> benchmark = { "benchmark", "report the throughput and PSNR of both formats without writing any cache" };
+};
+
+/** Encode all the input images and report the throughput and quality.
+\param images the input images
+\param w the compressed images width
+\param h the compressed images height
+\param options encoding parameters
+\param compressed will contain the compressed images
+*/
+void encodeAll(const std::vector<ImageRGB::Ptr> & images, uint w, uint h, const BlockEncoder::Options & options, std::vector<CompressedImage> & compressed)
+{
+	compressed.resize(images.size());
+	double totalTime = 0.0, psnrSum = 0.0, psnrMin = std::numeric_limits<double>::max();
+	size_t pixels = 0, bytes = 0;
+	for (size_t i = 0; i < images.size(); ++i) {
+		const ImageRGB resized = (images[i]->w() == w && images[i]->h() == h) ? images[i]->clone() : images[i]->resized(int(w), int(h), cv::INTER_AREA);
+		sibr::Timer timer(true);
+		compressed[i] = BlockEncoder::encode(resized, options);
+		totalTime += timer.deltaTimeFromLastTic();
+
+		const double psnr = BlockEncoder::psnr(resized, compressed[i]);
+		psnrSum += psnr;
+		psnrMin = std::min(psnrMin, psnr);
+		pixels += size_t(w) * size_t(h);
+		bytes += compressed[i].size();
+	}
+	const char * name = options.format == BlockFormat::BC1 ? "BC1" : "BC7";
+	SIBR_LOG << name << ": " << images.size() << " images (" << w << "x" << h << ") in " << totalTime << "ms, "
+		<< (totalTime > 0.0 ? double(pixels) / (totalTime * 1000.0) : 0.0) << " MPixels/s." << std::endl;
+	SIBR_LOG << name << ": PSNR mean " << (images.empty() ? 0.0 : psnrSum / double(images.size())) << "dB, min " << psnrMin
+		<< "dB, " << bytes / (1024 * 1024) << "MB instead of " << (3 * pixels) / (1024 * 1024) << "MB in RGB8." << std::endl;
+}
+
+int main(int ac, char ** av) {
+
+	CommandLineArgs::parseMainArgs(ac, av);
+	CompressTexturesArgs args;
+
+	if (!args.dataset_path.isInit()) {
+		std::cout << "Usage: " << std::endl;
+		std::cout << "\tRequired: --path path/to/dataset" << std::endl;
+		std::cout << "\tOptional: --format bc7 (or bc1) --texture-width 1920 --mipmaps --output path/to/cache.bin --benchmark" << std::endl;
+		return EXIT_SUCCESS;
+	}
+	if (args.format.get() != "bc1" && args.format.get() != "bc7") {
+		SIBR_WRG << "Unknown format \"" << args.format.get() << "\", expected bc1 or bc7." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	BasicIBRScene::SceneOptions opts;
+	opts.renderTargets = false;
+	opts.mesh = false;
+	opts.texture = false;
+	BasicIBRScene scene(args, opts);
+
+	// Same resolution as the RGB texture array of the viewers: the one of the first active camera, constrained by --texture-width.
+	const std::vector<InputCamera::Ptr> & cams = scene.cameras()->inputCameras();
+	const std::vector<ImageRGB::Ptr> & images = scene.images()->inputImages();
+	size_t first = 0;
+	while (first < cams.size() && !cams[first]->isActive()) {
+		++first;
+	}
+	if (images.empty() || first >= images.size()) {
+		SIBR_WRG << "No active input image to compress." << std::endl;
+		return EXIT_FAILURE;
+	}
+	scene.renderTargets()->initSize(images[first]->w(), images[first]->h());
+	const uint w = scene.renderTargets()->width();
+	const uint h = scene.renderTargets()->height();
+
+	BlockEncoder::Options options;
+	options.mipmaps = args.mipmaps;
+	// The viewers upload their input images with SIBR_FLIP_TEXTURE.
+	options.flip = true;
+
+	std::vector<CompressedImage> compressed;
+	if (args.benchmark) {
+		for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC7 }) {
+			options.format = format;
+			encodeAll(images, w, h, options, compressed);
+		}
+		return EXIT_SUCCESS;
+	}
+
+	options.format = args.format.get() == "bc1" ? BlockFormat::BC1 : BlockFormat::BC7;
+	encodeAll(images, w, h, options, compressed);
+	const std::string outputFile = args.output.get().empty() ? BlockEncoder::cachePath(scene.data()->basePathName(), options.format) : args.output.get();
+	if (!BlockEncoder::save(outputFile, compressed, BlockEncoder::signature(images, w, h, options))) {
+		return EXIT_FAILURE;
+	}
+	SIBR_LOG << "Saved " << compressed.size() << " compressed images to " << outputFile << std::endl;
+	return EXIT_SUCCESS;
+}
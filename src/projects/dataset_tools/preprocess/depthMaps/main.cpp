@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include "core/system/CommandLineArgs.hpp"
+#include "core/raycaster/InputDepthMaps.hpp"
+#include "core/scene/BasicIBRScene.hpp"
+
+using namespace sibr;
+
+/** Options for input depth maps raycasting. */
+struct DepthMapsArgs : virtual BasicIBRAppArgs {
+	Arg<std::string> output = { "output", "", "cache file (defaults to the one read by --cpu-depth)" };
+	Arg<bool> fullResolution = { "full-resolution", "use the resolution of the first camera, as the soft visibility maps do, instead of the texture arrays one" };
+};
+
+int main(int ac, char ** av) {
+
+	CommandLineArgs::parseMainArgs(ac, av);
+	DepthMapsArgs args;
+
+	if (!args.dataset_path.isInit()) {
+		std::cout << "Usage: " << std::endl;
+		std::cout << "\tRequired: --path path/to/dataset" << std::endl;
+		std::cout << "\tOptional: --texture-width 1920 --full-resolution --output path/to/cache.bin" << std::endl;
+		return EXIT_SUCCESS;
+	}
+
+	BasicIBRScene::SceneOptions opts;
+	opts.renderTargets = false;
+	opts.texture = false;
+	BasicIBRScene scene(args, opts);
+
+	const std::vector<InputCamera::Ptr> & cams = scene.cameras()->inputCameras();
+	if (cams.empty() || !scene.proxies()->hasProxy()) {
+		SIBR_WRG << "A proxy and cameras are required to compute depth maps." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	uint w = cams[0]->w();
+	uint h = cams[0]->h();
+	if (!args.fullResolution) {
+		// Same resolution as the depth texture array of the viewers: the one of the first active camera, constrained by --texture-width.
+		size_t first = 0;
+		while (first < cams.size() && !cams[first]->isActive()) {
+			++first;
+		}
+		if (first >= cams.size()) {
+			SIBR_WRG << "No active input camera." << std::endl;
+			return EXIT_FAILURE;
+		}
+		scene.renderTargets()->initSize(cams[first]->w(), cams[first]->h());
+		w = scene.renderTargets()->width();
+		h = scene.renderTargets()->height();
+	}
+
+	InputDepthMaps depthMaps;
+	depthMaps.compute(scene.proxies()->proxy(), cams, w, h);
+	const std::string outputFile = args.output.get().empty() ? InputDepthMaps::cachePath(scene.data()->basePathName(), w, h) : args.output.get();
+	if (!depthMaps.save(outputFile)) {
+		return EXIT_FAILURE;
+	}
+	SIBR_LOG << "Saved " << depthMaps.size() << " depth maps to " << outputFile << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use 
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+
+
+#include <core/system/Config.hpp>
+#include <core/graphics/Mesh.hpp>
+#include <core/graphics/MeshDecimator.hpp>
+#include <core/graphics/LODMesh.hpp>
+#include <core/graphics/MeshOptimizer.hpp>
+#include <core/system/CommandLineArgs.hpp>
+#include <core/system/SimpleTimer.hpp>
+
+
+using namespace sibr;
+
+/** Options for mesh simplification. */
+struct SimplifyMeshArgs : public AppArgs {
+	RequiredArg<std::string> path = { "path", "path to the mesh" };
+	Arg<std::string> output = { "output", "", "path to the output mesh" };
+	Arg<int> triangles = { "triangles", 0, "target triangle count (0 to only use the error bound)" };
+	Arg<float> ratio = { "ratio", 0.0f, "target triangle count as a fraction of the input (used if triangles is 0)" };
+	Arg<float> error = { "error", 0.0f, "maximum error, relative to the mesh bounding box diagonal (0 for unbounded)" };
+	Arg<bool> lockBorders = { "lock-borders", "do not simplify open borders" };
+	Arg<int> cellSize = { "cell-size", 100000, "approximate number of triangles per parallel cell" };
+	Arg<std::string> textureName = { "texture-name", "TEXTURE_NAME_TO_PUT_IN_THE_FILE", "name of the texture to reference in the output mesh (Meshlab compatible)" };
+	Arg<std::string> reorder = { "reorder", "", "reorder the output for vertex cache reuse (cache) or spatial locality, e.g. for raycasting (spatial)" };
+	Arg<bool> lod = { "lod", "build the clustered level of detail cache used by --lod-proxy instead of a simplified mesh" };
+	Arg<int> clusterSize = { "cluster-size", 4096, "maximum number of triangles per LOD cluster" };
+	Arg<int> levels = { "levels", 6, "maximum number of LOD levels" };
+};
+
+int main(int ac, char ** av){
+
+	CommandLineArgs::parseMainArgs(ac, av);
+	SimplifyMeshArgs args;
+	std::string outputFile = args.output;
+	if(outputFile.empty()) {
+		outputFile = args.lod ? LODMesh::cachePath(args.path) : sibr::removeExtension(args.path.get()) + "_simplified.ply";
+	}
+	sibr::makeDirectory(sibr::parentDirectory(outputFile));
+
+	Mesh mesh(false);
+	const bool loaded = sibr::getExtension(args.path) == "xml" ? mesh.loadMtsXML(args.path) : mesh.load(args.path);
+	if (!loaded || mesh.triangles().empty()) {
+		SIBR_WRG << "Unable to load a mesh from " << args.path.get() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (args.lod) {
+		LODMesh::Options lodOptions;
+		lodOptions.trianglesPerCluster = uint(std::max(64, args.clusterSize.get()));
+		lodOptions.levelsCount = uint(std::max(1, args.levels.get()));
+
+		sibr::Timer timer(true);
+		LODMesh lodMesh(false);
+		lodMesh.build(mesh, lodOptions);
+		SIBR_LOG << "Built " << lodMesh.clusters().size() << " clusters from " << mesh.triangles().size()
+			<< " triangles in " << timer.deltaTimeFromLastTic() << "ms." << std::endl;
+		return lodMesh.save(outputFile) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	MeshDecimator::Options options;
+	if (args.triangles > 0) {
+		options.targetTriangles = size_t(args.triangles);
+	} else if (args.ratio > 0.0f) {
+		options.targetTriangles = std::max(size_t(1), size_t(args.ratio * float(mesh.triangles().size())));
+	}
+	if (args.error > 0.0f) {
+		options.maxError = args.error;
+	}
+	if (options.targetTriangles == 0 && args.error <= 0.0f) {
+		SIBR_WRG << "Specify a target triangle count, ratio or maximum error." << std::endl;
+		return EXIT_FAILURE;
+	}
+	options.lockBorders = args.lockBorders;
+	options.trianglesPerCell = size_t(std::max(1000, args.cellSize.get()));
+
+	sibr::Timer timer(true);
+	MeshDecimator decimator;
+	Mesh::Ptr simplified = decimator.decimate(mesh, options);
+	SIBR_LOG << "Simplified from " << mesh.triangles().size() << " to " << simplified->triangles().size()
+		<< " triangles in " << timer.deltaTimeFromLastTic() << "ms (max error: " << decimator.error() << ")." << std::endl;
+
+	if (args.reorder.get() == "cache") {
+		MeshOptimizer::optimize(*simplified, MeshOptimizer::Order::CACHE);
+	} else if (args.reorder.get() == "spatial") {
+		MeshOptimizer::optimize(*simplified, MeshOptimizer::Order::SPATIAL);
+	} else if (!args.reorder.get().empty()) {
+		SIBR_WRG << "Unknown reordering \"" << args.reorder.get() << "\", expected cache or spatial." << std::endl;
+	}
+
+	simplified->save(outputFile, true, args.textureName);
+	return EXIT_SUCCESS;
+}
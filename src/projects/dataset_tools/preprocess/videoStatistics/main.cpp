@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+
+
+#include <core/system/Config.hpp>
+#include <core/system/CommandLineArgs.hpp>
+#include <core/system/SimpleTimer.hpp>
+#include <core/video/Video.hpp>
+#include <core/video/VideoUtils.hpp>
+#include <core/video/VideoStatistics.hpp>
+
+
+using namespace sibr;
+
+/** Options for video statistics computation. */
+struct VideoStatisticsArgs : public AppArgs {
+	RequiredArg<std::string> path = { "path", "path to the video" };
+	Arg<std::string> output = { "output", "", "output directory (default: next to the video)" };
+	Arg<int> bins = { "bins", 50, "number of histogram bins per channel for the median" };
+	Arg<float> skipBegin = { "skip-begin", 0.0f, "time skipped at the beginning of the video, in seconds" };
+	Arg<float> skipEnd = { "skip-end", 0.0f, "time skipped at the end of the video, in seconds" };
+	Arg<bool> benchmark = { "benchmark", "also run the VideoUtils implementations and compare timings and results (loads the whole video in memory)" };
+};
+
+/** \return the mean and maximum absolute difference between two images. */
+std::string difference(const cv::Mat & a, const cv::Mat & b)
+{
+	cv::Mat diff;
+	cv::absdiff(a, b, diff);
+	double maxDiff;
+	cv::minMaxLoc(diff.reshape(1), nullptr, &maxDiff);
+	const cv::Scalar meanDiff = cv::mean(diff);
+	return "mean abs. diff. " + std::to_string((meanDiff[0] + meanDiff[1] + meanDiff[2]) / 3.0) + ", max " + std::to_string(maxDiff);
+}
+
+int main(int ac, char ** av){
+
+	CommandLineArgs::parseMainArgs(ac, av);
+	VideoStatisticsArgs args;
+	std::string outputDir = args.output;
+	if (outputDir.empty()) {
+		outputDir = sibr::parentDirectory(args.path);
+	}
+	sibr::makeDirectory(outputDir);
+	const std::string baseName = outputDir + "/" + sibr::removeExtension(sibr::getFileName(args.path));
+
+	sibr::Video vid(args.path);
+	if (!vid.exists()) {
+		SIBR_WRG << args.path.get() << " does not exist." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	MeanVarianceAccumulator::Ptr meanVariance(new MeanVarianceAccumulator());
+	MinMaxAccumulator::Ptr minMax(new MinMaxAccumulator());
+	HistogramMedianAccumulator::Ptr median(new HistogramMedianAccumulator(args.bins));
+
+	VideoStatistics statistics;
+	statistics.addAccumulator(meanVariance);
+	statistics.addAccumulator(minMax);
+	statistics.addAccumulator(median);
+
+	sibr::Timer timer(true);
+	const int framesCount = statistics.run(vid, args.skipBegin, args.skipEnd);
+	const double singlePassTime = timer.deltaTimeFromLastTic();
+	SIBR_LOG << "Single pass statistics over " << framesCount << " frames in " << singlePassTime << "ms." << std::endl;
+
+	cv::Mat meanImg, stdDevImg;
+	meanVariance->mean().convertTo(meanImg, CV_8UC3);
+	// Same scaling as VideoUtils::getMeanVariance.
+	stdDevImg = meanVariance->standardDeviation();
+	stdDevImg.convertTo(stdDevImg, CV_8UC3, 5.0);
+	const cv::Mat3b medianImg = median->median();
+
+	cv::imwrite(baseName + "_mean.png", meanImg);
+	cv::imwrite(baseName + "_stddev.png", stdDevImg);
+	cv::imwrite(baseName + "_median.png", medianImg);
+	cv::imwrite(baseName + "_min.png", minMax->minimum());
+	cv::imwrite(baseName + "_max.png", minMax->maximum());
+
+	if (!args.benchmark) {
+		return EXIT_SUCCESS;
+	}
+
+	// The reference implementations decode the video once each.
+	timer.tic();
+	cv::Mat refMean, refVariance;
+	const int starting_frame = (int)(args.skipBegin * vid.getFrameRate());
+	VideoUtils::getMeanVariance2(vid.getCVvideo(), refMean, refVariance, vid.getResolution(), args.skipBegin);
+	const double meanVarianceTime = timer.deltaTimeFromLastTic();
+	std::cout << std::endl;
+
+	timer.tic();
+	const cv::Mat refMedian = VideoUtils::getMedian(vid, args.skipBegin, args.skipEnd);
+	const double medianTime = timer.deltaTimeFromLastTic();
+
+	timer.tic();
+	const cv::Mat refBackground = VideoUtils::getBackgroundImage(vid, args.bins, args.skipBegin, args.skipEnd);
+	const double backgroundTime = timer.deltaTimeFromLastTic();
+
+	// getMeanVariance2 blurs the frames and always runs to the end of the video, use the same setup for the comparison.
+	MeanVarianceAccumulator::Ptr blurredMeanVariance(new MeanVarianceAccumulator());
+	VideoStatistics blurredStatistics;
+	blurredStatistics.addAccumulator(blurredMeanVariance);
+	blurredStatistics.run(vid.getCVvideo(), starting_frame, -1, vid.getResolution(), true);
+	cv::Mat blurredMean, blurredStdDev;
+	blurredMeanVariance->mean().convertTo(blurredMean, CV_8UC3);
+	cv::Mat(blurredMeanVariance->standardDeviation()).convertTo(blurredStdDev, CV_8UC3, 5.0);
+
+	SIBR_LOG << "Reference timings: mean/variance " << meanVarianceTime << "ms, median " << medianTime << "ms, background "
+		<< backgroundTime << "ms, total " << (meanVarianceTime + medianTime + backgroundTime) << "ms (single pass: " << singlePassTime << "ms)." << std::endl;
+	SIBR_LOG << "Mean: " << difference(refMean, blurredMean) << std::endl;
+	SIBR_LOG << "Variance (x5 std. dev.): " << difference(refVariance, blurredStdDev) << std::endl;
+	SIBR_LOG << "Median (" << args.bins.get() << " bins): " << difference(refMedian, medianImg) << std::endl;
+	SIBR_LOG << "Background image vs. per channel histogram mode: " << difference(refBackground, median->mode()) << std::endl;
+
+	return EXIT_SUCCESS;
+}
@@ -13,6 +13,7 @@
 #include <fstream>
 #include <core/graphics/Window.hpp>
 #include <core/view/MultiViewManager.hpp>
+#include <core/view/OfflinePathRenderer.hpp>
 #include <projects/ulr/renderer/TexturedMeshView.hpp>
 #include <core/scene/BasicIBRScene.hpp>
 #include <core/raycaster/Raycaster.hpp>
@@ -175,7 +176,9 @@ int main( int ac, char** av )
 
 		if (myArgs.pathFile.get() !=  "" ) {
 			generalCamera->getCameraRecorder().loadPath(myArgs.pathFile.get(), usedResolution.x(), usedResolution.y());
-			generalCamera->getCameraRecorder().recordOfflinePath(myArgs.outPath, multiViewManager.getIBRSubView("TM view"), "texturedmesh");
+			OfflinePathOptions pathOptions;
+			pathOptions.videoPath = myArgs.pathVideo.get();
+			OfflinePathRenderer(pathOptions).render(generalCamera->getCameraRecorder(), myArgs.outPath, multiViewManager.getIBRSubView("TM view"), "texturedmesh");
 			if( !myArgs.noExit )
 				exit(0);
 		}
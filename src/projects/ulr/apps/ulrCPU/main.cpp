@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <core/assets/CameraRecorder.hpp>
+#include <core/scene/BasicIBRScene.hpp>
+#include <projects/ulr/renderer/ULRCPURenderer.hpp>
+
+#define PROGRAM_NAME "sibr_ulrCPU_app"
+using namespace sibr;
+
+const char* usage = ""
+	"Usage: " PROGRAM_NAME " -path <dataset-path> -pathFile <camera-path> [-outPath <output-dir>] [-rendering-size <w> <h>]"	"\n"
+	;
+
+
+/// Render a camera path with the CPU ULR renderer, without creating any window nor OpenGL context.
+int main(int ac, char** av)
+{
+	// Parse Command-line Args
+	CommandLineArgs::parseMainArgs(ac, av);
+	BasicIBRAppArgs myArgs;
+	myArgs.displayHelpIfRequired();
+
+	if (myArgs.pathFile.get().empty()) {
+		SIBR_ERR << "A camera path is required." << std::endl << usage;
+	}
+
+	// Load the cameras, images and proxy only: no rendertargets nor textures, they live on the GPU.
+	BasicIBRScene::SceneOptions sceneOptions;
+	sceneOptions.renderTargets = false;
+	sceneOptions.texture = false;
+	BasicIBRScene::Ptr scene(new BasicIBRScene(myArgs, sceneOptions));
+
+	// check rendering size
+	uint rendering_width = myArgs.rendering_size.get()[0];
+	uint rendering_height = myArgs.rendering_size.get()[1];
+	rendering_width = (rendering_width <= 0) ? scene->cameras()->inputCameras()[0]->w() : rendering_width;
+	rendering_height = (rendering_height <= 0) ? scene->cameras()->inputCameras()[0]->h() : rendering_height;
+
+	CameraRecorder recorder;
+	if (!recorder.loadPath(myArgs.pathFile.get(), rendering_width, rendering_height)) {
+		return EXIT_FAILURE;
+	}
+
+	// Same default output directory as CameraRecorder::recordOfflinePath.
+	std::string outputDir = myArgs.outPath;
+	if (outputDir == "pathOutput") {
+		outputDir = parentDirectory(myArgs.pathFile.get()) + "/pathOutput";
+	}
+
+	ULRCPURenderer renderer(scene);
+	renderer.renderPath(recorder.cams(), outputDir + "/ulr_cpu", rendering_width, rendering_height);
+
+	return EXIT_SUCCESS;
+}
@@ -14,14 +14,16 @@
 
 #include <core/graphics/Window.hpp>
 #include <core/view/MultiViewManager.hpp>
+#include <core/view/OfflinePathRenderer.hpp>
 #include <core/system/String.hpp>
 
 #include "projects/ulr/renderer/ULRView.hpp"
 #include <projects/ulr/renderer/ULRV2View.hpp>
 #include <projects/ulr/renderer/ULRV3View.hpp>
+#include <projects/ulr/renderer/SoftVisibility.hpp>
 
-#include <core/renderer/DepthRenderer.hpp>
 #include <core/raycaster/Raycaster.hpp>
+#include <core/raycaster/InputDepthMaps.hpp>
 #include <core/view/SceneDebugView.hpp>
 
 #define PROGRAM_NAME "sibr_ulrv2_app"
@@ -93,10 +95,31 @@ int main(int ac, char** av) {
 
 	const unsigned int sceneResWidth = usedResolution.x();
 	const unsigned int sceneResHeight = usedResolution.y();
-	scene->renderTargets()->initRGBandDepthTextureArrays(scene->cameras(), scene->images(), scene->proxies(), flags);
+	// With a memory budget, the input views are streamed in as needed instead of all living on the GPU.
+	ResidentInputTextures::Ptr residency;
+	if (myArgs.texture_budget > 0) {
+		ResidencyOptions residencyOptions;
+		residencyOptions.byteBudget = size_t(myArgs.texture_budget.get()) * 1024 * 1024;
+		residency.reset(new ResidentInputTextures(scene->cameras(), scene->images(), scene->proxies(), residencyOptions, myArgs.texture_width, flags));
+	} else {
+		const std::string & compression = myArgs.texture_compression.get();
+		if (compression == "bc1" || compression == "bc7") {
+			const BlockFormat format = compression == "bc1" ? BlockFormat::BC1 : BlockFormat::BC7;
+			scene->renderTargets()->compressedInputs(format, BlockEncoder::cachePath(scene->data()->basePathName(), format));
+		} else if (!compression.empty()) {
+			SIBR_WRG << "Unknown texture compression \"" << compression << "\", expected bc1 or bc7." << std::endl;
+		}
+		if (myArgs.cpu_depth) {
+			scene->renderTargets()->cpuDepthMaps(scene->data()->basePathName());
+		}
+		scene->renderTargets()->initRGBandDepthTextureArrays(scene->cameras(), scene->images(), scene->proxies(), flags);
+	}
 
 	// Create the ULR view.
 	ULRV3View::Ptr	ulrView(new ULRV3View(scene, sceneResWidth, sceneResHeight));
+	if (residency) {
+		ulrView->getULRrenderer()->setResidency(residency);
+	}
 
 	// Check if masks are provided and enabled.
 	if (myArgs.masks) {
@@ -136,7 +159,9 @@ int main(int ac, char** av) {
 
 	if (myArgs.pathFile.get() !=  "" ) {
 		generalCamera->getCameraRecorder().loadPath(myArgs.pathFile.get(), usedResolution.x(), usedResolution.y());
-		generalCamera->getCameraRecorder().recordOfflinePath(myArgs.outPath, multiViewManager.getIBRSubView("ULR view"), "ulr");
+		OfflinePathOptions pathOptions;
+		pathOptions.videoPath = myArgs.pathVideo.get();
+		OfflinePathRenderer(pathOptions).render(generalCamera->getCameraRecorder(), myArgs.outPath, multiViewManager.getIBRSubView("ULR view"), "ulr");
 		if( !myArgs.noExit )
 			exit(0);
 	}
@@ -214,33 +239,13 @@ int legacyV2main(ULRAppArgs & myArgs)
 		std::vector<sibr::ImageL32F>	depths3D(scene->cameras()->inputCameras().size());
 		if (myArgs.softVisibility) {
 
-			int numImages = (int)scene->cameras()->inputCameras().size();
-
-			for (int imId = 0; imId < numImages; ++imId) {
-
-				sibr::InputCamera cam = *scene->cameras()->inputCameras()[imId];
-				sibr::Vector3f camPos = cam.position();
-				int w = cam.w();
-				int h = cam.h();
-
-				sibr::DepthRenderer rendererDepth(cam.w(), cam.h());
-
-				sibr::ImageL32F depthMapSIBR(w, h);
-
-				rendererDepth.render(cam, scene->proxies()->proxy());
-				rendererDepth._depth_RT->readBack(depthMapSIBR);
-
-				depths3D[imId] = sibr::ImageL32F(w, h, 0);
-
-				for (int i = 0; i < w; i++) {
-					for (int j = 0; j < h; j++) {
-						sibr::Vector2i pixelPos(i, j);
-						sibr::Vector3f pos3dMesh(cam.unprojectImgSpaceInvertY(pixelPos, depthMapSIBR(i, j).x()));
-						depths3D[imId](i, j).x() = (camPos - pos3dMesh).norm();
-					}
-				}
-				//showFloat(depthMapSIBR);
-				//showFloat(depths3D[imId]);
+			// Distances to the camera centers, raycast once for all cameras at the resolution of the first one and cached.
+			const sibr::InputCamera & firstCam = *scene->cameras()->inputCameras()[0];
+			sibr::InputDepthMaps depthMaps;
+			depthMaps.loadOrCompute(scene->proxies()->proxy(), scene->cameras()->inputCameras(), firstCam.w(), firstCam.h(),
+				sibr::InputDepthMaps::cachePath(scene->data()->basePathName(), firstCam.w(), firstCam.h()));
+			for (uint imId = 0; imId < uint(depthMaps.size()); ++imId) {
+				depths3D[imId] = depthMaps.distance(imId);
 			}
 		}
 
@@ -266,21 +271,10 @@ int legacyV2main(ULRAppArgs & myArgs)
 
 		Texture2DArrayLum32F	soft_visibility_textures;
 		if (myArgs.softVisibility) {
-			int numImages = (int)scene->cameras()->inputCameras().size();
-			std::vector<sibr::ImageL32F>	softVisibilities(numImages);
-
-			int wSoft = depths3D[0].w();
-			int hSoft = depths3D[0].h();
-#pragma omp parallel for
-			for (int imId = 0; imId < numImages; ++imId) {
-
-				sibr::ImageRGBA tempVisibility;
-				ulrView->computeVisibilityMap(depths3D[imId], tempVisibility);
-				softVisibilities[imId] = std::move(sibr::convertRGBAtoL32F(tempVisibility));
-				cv::Mat temp;
-				cv::resize(softVisibilities[imId].toOpenCV(), temp, cv::Size(wSoft, hSoft), 0, 0, cv::INTER_NEAREST);
-				softVisibilities[imId].fromOpenCV(temp);
-			}
+			// All the depth maps have the same size, the soft visibility maps are computed at once and cached.
+			SoftVisibility::Options softOptions;
+			const std::vector<sibr::ImageL32F> softVisibilities = SoftVisibility::loadOrCompute(depths3D, softOptions,
+				SoftVisibility::cachePath(scene->data()->basePathName(), depths3D[0].w(), depths3D[0].h()));
 
 			soft_visibility_textures.createFromImages(softVisibilities, SIBR_GPU_LINEAR_SAMPLING | SIBR_FLIP_TEXTURE);
 
@@ -292,7 +286,9 @@ int legacyV2main(ULRAppArgs & myArgs)
 
 		if (myArgs.pathFile.get() !=  "" ) {
 			generalCamera->getCameraRecorder().loadPath(myArgs.pathFile.get(), usedResolution.x(), usedResolution.y());
-			generalCamera->getCameraRecorder().recordOfflinePath(myArgs.outPath, multiViewManager.getIBRSubView("ULR view"), "ulr");
+			OfflinePathOptions pathOptions;
+			pathOptions.videoPath = myArgs.pathVideo.get();
+			OfflinePathRenderer(pathOptions).render(generalCamera->getCameraRecorder(), myArgs.outPath, multiViewManager.getIBRSubView("ULR view"), "ulr");
 			if( !myArgs.noExit )
 				exit(0);
 		}
@@ -381,7 +377,9 @@ int legacyV1main(ULRAppArgs & myArgs)
 
 		if (myArgs.pathFile.get() !=  "" ) {
 			generalCamera->getCameraRecorder().loadPath(myArgs.pathFile.get(), usedResolution.x(), usedResolution.y());
-			generalCamera->getCameraRecorder().recordOfflinePath(myArgs.outPath, multiViewManager.getIBRSubView("ULR view"), "ulr");
+			OfflinePathOptions pathOptions;
+			pathOptions.videoPath = myArgs.pathVideo.get();
+			OfflinePathRenderer(pathOptions).render(generalCamera->getCameraRecorder(), myArgs.outPath, multiViewManager.getIBRSubView("ULR view"), "ulr");
 			if( !myArgs.noExit )
 				exit(0);
 		}
@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <emmintrin.h>
+#include "SoftVisibility.hpp"
+#include <core/system/SimpleTimer.hpp>
+#include <core/system/Utils.hpp>
+
+namespace sibr {
+
+	namespace {
+
+		const char		softVisibilityMagic[4] = { 'S', 'S', 'V', 'M' }; ///< Cache file signature.
+		const uint32_t	softVisibilityVersion = 1; ///< Cache file version.
+		const float		noFeature = 1e20f; ///< Squared distance of the pixels without any feature in sight.
+
+		/** Detect the edges of one row.
+		\param depth the depth map
+		\param y the row
+		\param threshold depth difference above which a pixel is on an edge
+		\param out the edges row, 0 on edges, 255 elsewhere
+		*/
+		void edgesRow(const sibr::ImageL32F & depth, int y, float threshold, unsigned char * out)
+		{
+			const int w = int(depth.w());
+			const int h = int(depth.h());
+			const float * cur = depth.toOpenCV().ptr<float>(y);
+			// Missing neighbors on the borders are replaced by the pixel itself, never an edge.
+			const float * up = depth.toOpenCV().ptr<float>(std::max(y - 1, 0));
+			const float * down = depth.toOpenCV().ptr<float>(std::min(y + 1, h - 1));
+
+			const auto isEdge = [&](int x) {
+				const float d = cur[x];
+				return (x > 0 && std::abs(cur[x - 1] - d) > threshold)
+					|| (x < w - 1 && std::abs(cur[x + 1] - d) > threshold)
+					|| std::abs(up[x] - d) > threshold
+					|| std::abs(down[x] - d) > threshold;
+			};
+
+			if (w > 0) {
+				out[0] = isEdge(0) ? 0 : 255;
+			}
+			// Four pixels at a time, with both horizontal neighbors in the row.
+			const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+			const __m128 limit = _mm_set1_ps(threshold);
+			int x = 1;
+			for (; x + 4 < w; x += 4) {
+				const __m128 d = _mm_loadu_ps(cur + x);
+				__m128 edge = _mm_cmpgt_ps(_mm_and_ps(_mm_sub_ps(_mm_loadu_ps(cur + x - 1), d), absMask), limit);
+				edge = _mm_or_ps(edge, _mm_cmpgt_ps(_mm_and_ps(_mm_sub_ps(_mm_loadu_ps(cur + x + 1), d), absMask), limit));
+				edge = _mm_or_ps(edge, _mm_cmpgt_ps(_mm_and_ps(_mm_sub_ps(_mm_loadu_ps(up + x), d), absMask), limit));
+				edge = _mm_or_ps(edge, _mm_cmpgt_ps(_mm_and_ps(_mm_sub_ps(_mm_loadu_ps(down + x), d), absMask), limit));
+				const int bits = _mm_movemask_ps(edge);
+				for (int i = 0; i < 4; ++i) {
+					out[x + i] = (bits >> i) & 1 ? 0 : 255;
+				}
+			}
+			for (; x < w; ++x) {
+				out[x] = isEdge(x) ? 0 : 255;
+			}
+		}
+
+		/** One dimensional squared distance transform, lower envelope of the parabolas rooted at each sample.
+		\param f the squared distances of the samples, 0 on features
+		\param n the number of samples
+		\param d will contain the squared distance transform
+		\param v scratch, n parabolas roots
+		\param z scratch, n+1 parabolas boundaries
+		*/
+		void distanceTransform1D(const float * f, int n, float * d, int * v, double * z)
+		{
+			int k = 0;
+			v[0] = 0;
+			z[0] = -std::numeric_limits<double>::infinity();
+			z[1] = std::numeric_limits<double>::infinity();
+			for (int q = 1; q < n; ++q) {
+				// Pop the parabolas hidden by the one rooted at q, z[0] stops the loop.
+				double s = 0.0;
+				while (true) {
+					const int r = v[k];
+					s = ((double(f[q]) + double(q) * q) - (double(f[r]) + double(r) * r)) / (2.0 * (q - r));
+					if (s > z[k]) {
+						break;
+					}
+					--k;
+				}
+				++k;
+				v[k] = q;
+				z[k] = s;
+				z[k + 1] = std::numeric_limits<double>::infinity();
+			}
+			k = 0;
+			for (int q = 0; q < n; ++q) {
+				while (z[k + 1] < q) {
+					++k;
+				}
+				const float dq = float(q - v[k]);
+				d[q] = dq * dq + f[v[k]];
+			}
+		}
+	}
+
+	void SoftVisibility::computeEdges(const sibr::ImageL32F & depth, float threshold, sibr::ImageL8 & edges)
+	{
+		edges = sibr::ImageL8(depth.w(), depth.h());
+		#pragma omp parallel for
+		for (int y = 0; y < int(depth.h()); ++y) {
+			edgesRow(depth, y, threshold, edges.toOpenCVnonConst().ptr<unsigned char>(y));
+		}
+	}
+
+	void SoftVisibility::distanceTransform(const sibr::ImageL8 & mask, sibr::ImageL32F & distance)
+	{
+		std::vector<sibr::ImageL8> masks(1);
+		masks[0] = mask.clone();
+		std::vector<sibr::ImageL32F> distances;
+		distancesTransform(masks, distances);
+		distance = std::move(distances[0]);
+	}
+
+	sibr::ImageL32F SoftVisibility::compute(const sibr::ImageL32F & depth, const Options & options)
+	{
+		std::vector<sibr::ImageL32F> depths(1);
+		depths[0] = depth.clone();
+		return std::move(compute(depths, options)[0]);
+	}
+
+	std::vector<sibr::ImageL32F> SoftVisibility::compute(const std::vector<sibr::ImageL32F> & depths, const Options & options)
+	{
+		sibr::Timer timer(true);
+
+		// All the rows of all the maps are processed at once.
+		std::vector<std::pair<int, int>> rows;
+		std::vector<sibr::ImageL8> edges(depths.size());
+		for (int i = 0; i < int(depths.size()); ++i) {
+			edges[i] = sibr::ImageL8(depths[i].w(), depths[i].h());
+			for (int y = 0; y < int(depths[i].h()); ++y) {
+				rows.emplace_back(i, y);
+			}
+		}
+		#pragma omp parallel for schedule(dynamic, 16)
+		for (int r = 0; r < int(rows.size()); ++r) {
+			const int i = rows[r].first;
+			const int y = rows[r].second;
+			edgesRow(depths[i], y, options.depthThreshold, edges[i].toOpenCVnonConst().ptr<unsigned char>(y));
+		}
+
+		std::vector<sibr::ImageL32F> maps;
+		distancesTransform(edges, maps);
+		SIBR_LOG << "[SoftVisibility] Computed " << depths.size() << " soft visibility maps in " << timer.deltaTimeFromLastTic() << "ms." << std::endl;
+		return maps;
+	}
+
+	void SoftVisibility::distancesTransform(const std::vector<sibr::ImageL8> & masks, std::vector<sibr::ImageL32F> & distances)
+	{
+		// Squared distances after the columns pass, stored in the output maps.
+		distances.resize(masks.size());
+		std::vector<std::pair<int, int>> columns, rows;
+		for (int i = 0; i < int(masks.size()); ++i) {
+			distances[i] = sibr::ImageL32F(masks[i].w(), masks[i].h());
+			for (int x = 0; x < int(masks[i].w()); ++x) {
+				columns.emplace_back(i, x);
+			}
+			for (int y = 0; y < int(masks[i].h()); ++y) {
+				rows.emplace_back(i, y);
+			}
+		}
+
+		#pragma omp parallel
+		{
+			std::vector<float> f, d;
+			std::vector<int> v;
+			std::vector<double> z;
+
+			#pragma omp for schedule(dynamic, 16)
+			for (int c = 0; c < int(columns.size()); ++c) {
+				const int i = columns[c].first;
+				const int x = columns[c].second;
+				const int h = int(masks[i].h());
+				f.resize(h); d.resize(h); v.resize(h); z.resize(h + 1);
+				for (int y = 0; y < h; ++y) {
+					f[y] = masks[i](x, y)[0] == 0 ? 0.0f : noFeature;
+				}
+				distanceTransform1D(f.data(), h, d.data(), v.data(), z.data());
+				for (int y = 0; y < h; ++y) {
+					distances[i](x, y)[0] = d[y];
+				}
+			}
+
+			#pragma omp for schedule(dynamic, 16)
+			for (int r = 0; r < int(rows.size()); ++r) {
+				const int i = rows[r].first;
+				const int y = rows[r].second;
+				const int w = int(masks[i].w());
+				const float maxDistance = float(masks[i].w() + masks[i].h());
+				float * row = distances[i].toOpenCVnonConst().ptr<float>(y);
+				f.assign(row, row + w);
+				d.resize(w); v.resize(w); z.resize(w + 1);
+				distanceTransform1D(f.data(), w, d.data(), v.data(), z.data());
+				for (int x = 0; x < w; ++x) {
+					row[x] = d[x] >= 0.5f * noFeature ? maxDistance : std::sqrt(d[x]);
+				}
+			}
+		}
+	}
+
+	bool SoftVisibility::save(const std::string & path, const std::vector<sibr::ImageL32F> & maps, uint64_t signature)
+	{
+		const uint32_t header[3] = { (uint32_t)maps.size(), maps.empty() ? 0 : maps[0].w(), maps.empty() ? 0 : maps[0].h() };
+		for (const sibr::ImageL32F & map : maps) {
+			if (map.w() != header[1] || map.h() != header[2]) {
+				SIBR_WRG << "Unable to cache soft visibility maps of different sizes." << std::endl;
+				return false;
+			}
+		}
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!file) {
+			SIBR_WRG << "Unable to write soft visibility cache to " << path << std::endl;
+			return false;
+		}
+		writeRaw(file, softVisibilityMagic, 4);
+		writeRaw(file, &softVisibilityVersion, 1);
+		writeRaw(file, header, 3);
+		writeRaw(file, &signature, 1);
+		for (const sibr::ImageL32F & map : maps) {
+			for (uint y = 0; y < map.h(); ++y) {
+				writeRaw(file, map.toOpenCV().ptr<float>(y), map.w());
+			}
+		}
+		return bool(file);
+	}
+
+	bool SoftVisibility::load(const std::string & path, uint64_t signature, std::vector<sibr::ImageL32F> & maps)
+	{
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+		char magic[4];
+		uint32_t version = 0;
+		uint32_t header[3];
+		uint64_t fileSignature = 0;
+		if (!readRaw(file, magic, 4) || !std::equal(magic, magic + 4, softVisibilityMagic)
+			|| !readRaw(file, &version, 1) || version != softVisibilityVersion
+			|| !readRaw(file, header, 3) || !readRaw(file, &fileSignature, 1)) {
+			SIBR_WRG << "Invalid soft visibility cache file " << path << std::endl;
+			return false;
+		}
+		if (fileSignature != signature) {
+			SIBR_LOG << "Soft visibility cache " << path << " does not match the depth maps, ignoring it." << std::endl;
+			return false;
+		}
+		std::vector<sibr::ImageL32F> loaded(header[0]);
+		for (sibr::ImageL32F & map : loaded) {
+			map = sibr::ImageL32F(header[1], header[2]);
+			for (uint y = 0; y < header[2]; ++y) {
+				if (!readRaw(file, map.toOpenCVnonConst().ptr<float>(y), header[1])) {
+					SIBR_WRG << "Truncated soft visibility cache file " << path << std::endl;
+					return false;
+				}
+			}
+		}
+		maps.swap(loaded);
+		return true;
+	}
+
+	std::vector<sibr::ImageL32F> SoftVisibility::loadOrCompute(const std::vector<sibr::ImageL32F> & depths, const Options & options, const std::string & path)
+	{
+		const uint64_t hash = signature(depths, options);
+		std::vector<sibr::ImageL32F> maps;
+		if (load(path, hash, maps) && maps.size() == depths.size()) {
+			SIBR_LOG << "Loaded " << maps.size() << " soft visibility maps from " << path << std::endl;
+			return maps;
+		}
+		maps = compute(depths, options);
+		save(path, maps, hash);
+		return maps;
+	}
+
+	uint64_t SoftVisibility::signature(const std::vector<sibr::ImageL32F> & depths, const Options & options)
+	{
+		// FNV-1a of each map in parallel, then of the parameters and the maps hashes.
+		std::vector<uint64_t> hashes(depths.size(), fnv1aSeed);
+		#pragma omp parallel for
+		for (int i = 0; i < int(depths.size()); ++i) {
+			const uint32_t size[2] = { depths[i].w(), depths[i].h() };
+			hashes[i] = hashWords(fnv1aSeed, size, 2);
+			for (uint y = 0; y < depths[i].h(); ++y) {
+				hashes[i] = hashWords(hashes[i], reinterpret_cast<const uint32_t*>(depths[i].toOpenCV().ptr<float>(y)), depths[i].w());
+			}
+		}
+		uint32_t params[2] = { (uint32_t)depths.size(), 0 };
+		std::memcpy(&params[1], &options.depthThreshold, sizeof(float));
+		uint64_t hash = hashWords(fnv1aSeed, params, 2);
+		if (!hashes.empty()) {
+			hash = hashWords(hash, reinterpret_cast<const uint32_t*>(hashes.data()), 2 * hashes.size());
+		}
+		return hash;
+	}
+
+	std::string SoftVisibility::cachePath(const std::string & datasetPath, uint w, uint h)
+	{
+		return datasetPath + "/soft_visibility_" + std::to_string(w) + "x" + std::to_string(h) + ".bin";
+	}
+
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include "Config.hpp"
+# include <core/graphics/Image.hpp>
+
+namespace sibr {
+
+	/**
+	 * \class SoftVisibility
+	 * \brief Soft visibility maps of the input views, used by ULRV2Renderer to fade out the input pixels close to depth discontinuities.
+	 * Each map holds, for each pixel, the distance in pixels to the closest depth edge: a pixel is an edge when one of its
+	 * four neighbors is further away than a threshold in distance to the camera center. Edges are detected with SSE,
+	 * four pixels at a time, and the exact Euclidean distance transform is computed with two separable passes
+	 * (Felzenszwalb and Huttenlocher, Distance Transforms of Sampled Functions). All the rows and columns of all
+	 * the maps are processed in parallel.
+	 * The maps can be cached in a binary file tagged with a hash of the depth maps, so that stale caches are ignored.
+	 * \ingroup sibr_ulr
+	 */
+	class SIBR_EXP_ULR_EXPORT SoftVisibility {
+
+	public:
+
+		/** Soft visibility parameters. */
+		struct Options {
+			float depthThreshold = 2.5f; ///< Depth difference between neighbors above which a pixel is on an edge.
+		};
+
+		/** Detect the depth edges of a map.
+		\param depth distances to the camera center
+		\param threshold depth difference between neighbors above which a pixel is on an edge
+		\param edges will contain 0 on edges, 255 elsewhere
+		*/
+		static void computeEdges(const sibr::ImageL32F & depth, float threshold, sibr::ImageL8 & edges);
+
+		/** Exact Euclidean distance transform.
+		\param mask 0 on the features, non zero elsewhere
+		\param distance will contain the distance in pixels to the closest feature, w+h if there is none
+		*/
+		static void distanceTransform(const sibr::ImageL8 & mask, sibr::ImageL32F & distance);
+
+		/** Compute the soft visibility map of a view.
+		\param depth distances to the camera center
+		\param options soft visibility parameters
+		\return the distance in pixels to the closest depth edge
+		*/
+		static sibr::ImageL32F compute(const sibr::ImageL32F & depth, const Options & options);
+
+		/** Compute the soft visibility maps of several views at once.
+		\param depths distances to the camera center, all of the same size
+		\param options soft visibility parameters
+		\return the distance in pixels to the closest depth edge, one map per view
+		*/
+		static std::vector<sibr::ImageL32F> compute(const std::vector<sibr::ImageL32F> & depths, const Options & options);
+
+		/** Save soft visibility maps to a binary cache file.
+		\param path the destination file
+		\param maps the maps, all of the same size
+		\param signature the signature of the inputs (see signature)
+		\return true if the file was written
+		*/
+		static bool save(const std::string & path, const std::vector<sibr::ImageL32F> & maps, uint64_t signature);
+
+		/** Load soft visibility maps from a binary cache file.
+		\param path the cache file
+		\param signature the expected signature of the inputs, the cache is rejected if it differs
+		\param maps will contain the maps
+		\return true if the file was loaded and is valid
+		*/
+		static bool load(const std::string & path, uint64_t signature, std::vector<sibr::ImageL32F> & maps);
+
+		/** Load soft visibility maps from a cache file if it was computed from the same depth maps, or compute them and update the cache.
+		\param depths distances to the camera center, all of the same size
+		\param options soft visibility parameters
+		\param path the cache file
+		\return the soft visibility maps, one per view
+		*/
+		static std::vector<sibr::ImageL32F> loadOrCompute(const std::vector<sibr::ImageL32F> & depths, const Options & options, const std::string & path);
+
+		/** Hash of the depth maps and parameters, stored in the cache file.
+		\param depths distances to the camera center
+		\param options soft visibility parameters
+		\return the signature
+		*/
+		static uint64_t signature(const std::vector<sibr::ImageL32F> & depths, const Options & options);
+
+		/** \return the default cache file path for the soft visibility maps of a dataset.
+		\param datasetPath the dataset directory
+		\param w the maps width
+		\param h the maps height
+		*/
+		static std::string cachePath(const std::string & datasetPath, uint w, uint h);
+
+	private:
+
+		/** Exact Euclidean distance transform of several masks at once, see distanceTransform. */
+		static void distancesTransform(const std::vector<sibr::ImageL8> & masks, std::vector<sibr::ImageL32F> & distances);
+	};
+
+}
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <projects/ulr/renderer/ULRCPURenderer.hpp>
+
+#include <iomanip>
+#include <thread>
+
+namespace {
+
+	// Same constants as the ulr_v3 shader.
+	const float INFTY_W = 100000.0f;
+	const float BETA = 1e-1f;
+
+	/** Ray through a pixel center, between the near and far planes.
+	 * \param invViewproj the inverse view projection matrix
+	 * \param x the pixel column
+	 * \param y the pixel row, from the top
+	 * \param w the image width
+	 * \param h the image height
+	 * \param orig will contain the ray origin, on the near plane
+	 * \param dir will contain the normalized ray direction
+	 * \return the ray length, up to the far plane
+	 */
+	float pixelRay(const sibr::Matrix4f & invViewproj, int x, int y, int w, int h, sibr::Vector3f & orig, sibr::Vector3f & dir)
+	{
+		const float ndcX = 2.0f * (float(x) + 0.5f) / float(w) - 1.0f;
+		const float ndcY = 1.0f - 2.0f * (float(y) + 0.5f) / float(h);
+		const sibr::Vector4f nearPt = invViewproj * sibr::Vector4f(ndcX, ndcY, -1.0f, 1.0f);
+		const sibr::Vector4f farPt = invViewproj * sibr::Vector4f(ndcX, ndcY, 1.0f, 1.0f);
+		orig = nearPt.head<3>() / nearPt.w();
+		dir = farPt.head<3>() / farPt.w() - orig;
+		const float length = dir.norm();
+		dir /= length;
+		return length;
+	}
+
+	/** Project a point in [0,1] window coordinates, as the shader project helper.
+	 * \param point the 3D point
+	 * \param viewproj the view projection matrix
+	 * \return the window coordinates and depth
+	 */
+	sibr::Vector3f project(const sibr::Vector3f & point, const sibr::Matrix4f & viewproj)
+	{
+		const sibr::Vector4f clip = viewproj * point.homogeneous();
+		return (clip.head<3>() / clip.w()) * 0.5f + sibr::Vector3f(0.5f, 0.5f, 0.5f);
+	}
+
+	/** Bilinear lookup in an 8 bits image, without rounding the result.
+	 * \param img the image
+	 * \param pos the continuous pixel position, pixel centers at half integers
+	 * \return the color in [0,1]
+	 */
+	sibr::Vector3f sampleRGB(const sibr::ImageRGB & img, const sibr::Vector2f & pos)
+	{
+		const int maxX = int(img.w()) - 1;
+		const int maxY = int(img.h()) - 1;
+		const float fx = pos.x() - 0.5f;
+		const float fy = pos.y() - 0.5f;
+		const int x0 = int(std::floor(fx));
+		const int y0 = int(std::floor(fy));
+		const float tx = fx - float(x0);
+		const float ty = fy - float(y0);
+		auto texel = [&](int x, int y) {
+			return img(uint(sibr::clamp(x, 0, maxX)), uint(sibr::clamp(y, 0, maxY))).cast<float>();
+		};
+		const sibr::Vector3f color =
+			texel(x0, y0) * (1.0f - tx) * (1.0f - ty) + texel(x0 + 1, y0) * tx * (1.0f - ty) +
+			texel(x0, y0 + 1) * (1.0f - tx) * ty + texel(x0 + 1, y0 + 1) * tx * ty;
+		return color / 255.0f;
+	}
+
+	/** A blending candidate. */
+	struct Candidate {
+		sibr::Vector3f color = sibr::Vector3f(0.0f, 0.0f, 0.0f);
+		float weight = INFTY_W;
+	};
+
+}
+
+sibr::ULRCPURenderer::ULRCPURenderer(const BasicIBRScene::Ptr & scene, const ULRCPUOptions & options) :
+	_options(options)
+{
+	if (!scene->proxies()->hasProxy()) {
+		SIBR_ERR << "[ULRCPURenderer] The scene has no proxy." << std::endl;
+	}
+	_raycaster.init();
+	_raycaster.addMesh(scene->proxies()->proxy());
+
+	const std::vector<InputCamera::Ptr> & cameras = scene->cameras()->inputCameras();
+	const std::vector<ImageRGB::Ptr> & images = scene->images()->inputImages();
+	if (images.size() < cameras.size()) {
+		SIBR_ERR << "[ULRCPURenderer] The scene images are not loaded." << std::endl;
+	}
+
+	_cameras.resize(cameras.size());
+	for (size_t i = 0; i < cameras.size(); ++i) {
+		const InputCamera & cam = *cameras[i];
+		CameraData & data = _cameras[i];
+		data.vp = cam.viewproj();
+		data.pos = cam.position();
+		data.dir = cam.dir();
+		data.image = images[i];
+		if (!cam.isActive()) {
+			continue;
+		}
+		_enabledIds.push_back(uint(i));
+		computeDepthMap(cam, data.image->w(), data.image->h(), data.depth);
+	}
+	SIBR_LOG << "[ULRCPURenderer] Computed the depth maps of " << _enabledIds.size() << " cameras." << std::endl;
+}
+
+void sibr::ULRCPURenderer::updateCameras(const std::vector<uint> & camIds)
+{
+	_enabledIds.clear();
+	for (const uint camId : camIds) {
+		// The depth maps of inactive cameras have not been computed.
+		if (_cameras[camId].depth.w() == 0) {
+			SIBR_WRG << "[ULRCPURenderer] Camera " << camId << " is not active, ignoring it." << std::endl;
+			continue;
+		}
+		_enabledIds.push_back(camId);
+	}
+}
+
+void sibr::ULRCPURenderer::process(const sibr::Camera & eye, ImageRGB & dst)
+{
+	const int w = int(dst.w());
+	const int h = int(dst.h());
+	const Matrix4f invViewproj = eye.viewproj().inverse();
+	const Vector3f eyePos = eye.position();
+
+#pragma omp parallel for num_threads(threadsCount()) schedule(dynamic)
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			Vector3f orig, dir, point;
+			const float length = pixelRay(invViewproj, x, y, w, h, orig, dir);
+			if (!castProxy(orig, dir, length, point)) {
+				continue;
+			}
+
+			// Keep the four best candidates, sorted by increasing penalty.
+			Candidate best[4];
+			bool atLeastOneValid = false;
+			for (const uint i : _enabledIds) {
+				const CameraData & cam = _cameras[i];
+				const Vector3f uvd = project(point, cam.vp);
+				const Vector2f ndc = (2.0f * uvd.head<2>() - Vector2f(1.0f, 1.0f)).cwiseAbs();
+				if (ndc.x() > 1.0f || ndc.y() > 1.0f || cam.dir.dot(point - cam.pos) <= 0.0f) {
+					continue;
+				}
+
+				// Window coordinates start at the bottom, images at the top.
+				const Vector2f pixel(uvd.x() * float(cam.image->w()), (1.0f - uvd.y()) * float(cam.image->h()));
+				Candidate candidate;
+				candidate.color = sampleRGB(*cam.image, pixel);
+				if (_options.discardBlackPixels && (candidate.color.array() == 0.0f).all()) {
+					continue;
+				}
+				if (_options.occTest && std::abs(uvd.z() - cam.depth.bilinear(pixel)[0]) >= _options.epsilonOcclusion) {
+					continue;
+				}
+
+				const Vector3f v1 = point - cam.pos;
+				const Vector3f v2 = point - eyePos;
+				const float distI2P = v1.norm();
+				const float distN2P = v2.norm();
+				const float cosAngle = sibr::clamp(v1.dot(v2) / (distI2P * distN2P), -1.0f, 1.0f);
+				const float penaltyAng = float(_options.occTest) * std::max(0.0001f, std::acos(cosAngle));
+				const float penaltyRes = std::max(0.0001f, (distI2P - distN2P) / distI2P);
+				candidate.weight = penaltyAng + BETA * penaltyRes;
+				atLeastOneValid = true;
+
+				// Insert at the appropriate rank.
+				for (int k = 0; k < 4; ++k) {
+					if (candidate.weight < best[k].weight) {
+						for (int s = 3; s > k; --s) {
+							best[s] = best[s - 1];
+						}
+						best[k] = candidate;
+						break;
+					}
+				}
+			}
+
+			if (!atLeastOneValid) {
+				continue;
+			}
+
+			Vector3f color = best[0].color;
+			if (!_options.winnerTakesAll) {
+				// Weights relative to the fourth candidate, which gets a negligible weight.
+				const float thresh = 1.0000001f * best[3].weight;
+				float weights[4];
+				for (int k = 0; k < 3; ++k) {
+					weights[k] = std::max(0.0f, 1.0f - best[k].weight / thresh);
+				}
+				weights[3] = 1.0f - 1.0f / 1.0000001f;
+				Vector3f sum(0.0f, 0.0f, 0.0f);
+				float weightsSum = 0.0f;
+				for (int k = 0; k < 4; ++k) {
+					sum += weights[k] * best[k].color;
+					weightsSum += weights[k];
+				}
+				color = sum / weightsSum;
+			}
+
+			for (int c = 0; c < 3; ++c) {
+				dst(x, y)[c] = uchar(sibr::clamp(std::round(color[c] * 255.0f), 0.0f, 255.0f));
+			}
+		}
+	}
+}
+
+int sibr::ULRCPURenderer::renderPath(const std::vector<sibr::Camera> & path, const std::string & outputDir, uint w, uint h)
+{
+	makeDirectory(outputDir);
+	SIBR_LOG << "[ULRCPURenderer] Rendering path with " << path.size() << " cameras to " << outputDir << std::endl;
+
+	for (size_t i = 0; i < path.size(); ++i) {
+		// Black background, as the cleared rendertarget of recordOfflinePath.
+		ImageRGB frame(w, h, uchar(0));
+		process(path[i], frame);
+		std::ostringstream ssZeroPad;
+		ssZeroPad << std::setw(8) << std::setfill('0') << i;
+		frame.save(outputDir + "/" + ssZeroPad.str() + ".png", false);
+	}
+	return int(path.size());
+}
+
+bool sibr::ULRCPURenderer::castProxy(const Vector3f & orig, const Vector3f & dir, float maxDist, Vector3f & point)
+{
+	const Ray ray(orig, dir);
+	float minDist = 0.0f;
+	// Skip back facing triangles, a few layers at most.
+	for (int layer = 0; layer < 8; ++layer) {
+		const RayHit hit = _raycaster.intersect(ray, minDist);
+		if (!hit.hitSomething() || hit.dist() > maxDist) {
+			return false;
+		}
+		if (!_options.backfaceCull || hit.normal().dot(dir) < 0.0f) {
+			point = orig + hit.dist() * dir;
+			return true;
+		}
+		minDist = hit.dist() * 1.00001f + 1e-6f;
+	}
+	return false;
+}
+
+void sibr::ULRCPURenderer::computeDepthMap(const InputCamera & cam, uint w, uint h, ImageL32F & depth)
+{
+	depth = ImageL32F(w, h, 1.0f);
+	const Matrix4f viewproj = cam.viewproj();
+	const Matrix4f invViewproj = viewproj.inverse();
+
+#pragma omp parallel for num_threads(threadsCount()) schedule(dynamic)
+	for (int y = 0; y < int(h); ++y) {
+		for (int x = 0; x < int(w); ++x) {
+			Vector3f orig, dir, point;
+			const float length = pixelRay(invViewproj, x, y, int(w), int(h), orig, dir);
+			if (castProxy(orig, dir, length, point)) {
+				depth(x, y)[0] = project(point, viewproj).z();
+			}
+		}
+	}
+}
+
+int sibr::ULRCPURenderer::threadsCount() const
+{
+	return _options.threadsCount > 0 ? _options.threadsCount : std::max(1, int(std::thread::hardware_concurrency()));
+}
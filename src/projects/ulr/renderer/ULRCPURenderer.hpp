@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include "Config.hpp"
+# include <core/system/Config.hpp>
+# include <core/graphics/Image.hpp>
+# include <core/raycaster/Raycaster.hpp>
+# include <core/scene/BasicIBRScene.hpp>
+
+namespace sibr {
+
+	/** Parameters of the CPU ULR renderer, same meaning as the corresponding ULRV3Renderer settings. */
+	struct SIBR_EXP_ULR_EXPORT ULRCPUOptions {
+		float epsilonOcclusion = 0.01f; ///< Occlusion threshold, in window depth units.
+		bool occTest = true; ///< Reject input cameras that do not see the proxy point.
+		bool discardBlackPixels = true; ///< Ignore black input pixels.
+		bool winnerTakesAll = false; ///< Only use the best ranked camera.
+		bool backfaceCull = true; ///< Ignore back facing proxy triangles, as the GPU depth passes do.
+		int threadsCount = 0; ///< Number of rendering threads, 0 to use all cores.
+	};
+
+	/**
+	 * \class ULRCPURenderer
+	 * \brief Multithreaded CPU implementation of per-pixel Unstructured Lumigraph Rendering, following ULRV3Renderer
+	 * and the ulr_v3 fragment shader: for each pixel the proxy is raycast, the hit point is reprojected in each selected
+	 * input camera, occluded cameras are rejected with the same depth epsilon, and the four best cameras by angle and
+	 * distance penalty are blended.
+	 * Input depth maps are raycast once at construction, at the resolution of the input images. No OpenGL call is made,
+	 * so the scene can be loaded without rendertargets nor textures (see SceneOptions), on machines without a GPU.
+	 * \note Input masks and the UV derivatives weighting mode are not supported.
+	 */
+	class SIBR_EXP_ULR_EXPORT ULRCPURenderer
+	{
+		SIBR_CLASS_PTR(ULRCPURenderer);
+
+	public:
+
+		/**
+		 * Constructor. All active cameras are enabled.
+		 * \param scene The scene, with cameras, images and proxy loaded.
+		 * \param options The rendering parameters.
+		 */
+		ULRCPURenderer(const BasicIBRScene::Ptr & scene, const ULRCPUOptions & options = {});
+
+		/**
+		 * Update which cameras should be used for rendering, based on the indices passed.
+		 * \param camIds The indices to enable.
+		 */
+		void updateCameras(const std::vector<uint> & camIds);
+
+		/**
+		 * Render a novel view.
+		 * \param eye The novel viewpoint.
+		 * \param dst The destination image, its size defines the rendering resolution. Pixels not covered by the proxy or
+		 * not seen by any input camera are left untouched.
+		 */
+		void process(const sibr::Camera & eye, ImageRGB & dst);
+
+		/**
+		 * Render each camera of a path, for instance loaded by CameraRecorder::loadPath, and save the results with the
+		 * same naming as CameraRecorder::recordOfflinePath.
+		 * \param path The novel viewpoints.
+		 * \param outputDir The destination directory, created if needed.
+		 * \param w The rendering width.
+		 * \param h The rendering height.
+		 * \return the number of frames rendered.
+		 */
+		int renderPath(const std::vector<sibr::Camera> & path, const std::string & outputDir, uint w, uint h);
+
+		/// \return the rendering parameters (changing backfaceCull only affects the novel views).
+		ULRCPUOptions & options() { return _options; }
+
+	private:
+
+		/**
+		 * Intersect a ray with the proxy.
+		 * \param orig The ray origin.
+		 * \param dir The normalized ray direction.
+		 * \param maxDist Hits further than this distance are ignored.
+		 * \param point Will contain the hit position.
+		 * \return true if the proxy was hit.
+		 */
+		bool castProxy(const Vector3f & orig, const Vector3f & dir, float maxDist, Vector3f & point);
+
+		/**
+		 * Compute the depth map of an input camera.
+		 * \param cam The input camera.
+		 * \param w The depth map width.
+		 * \param h The depth map height.
+		 * \param depth Will contain the window depth of the proxy for each pixel center, 1 where nothing is hit.
+		 */
+		void computeDepthMap(const InputCamera & cam, uint w, uint h, ImageL32F & depth);
+
+		/** \return the number of rendering threads. */
+		int threadsCount() const;
+
+		/** Input camera data. */
+		struct CameraData {
+			Matrix4f vp; ///< View projection matrix.
+			Vector3f pos; ///< Camera position.
+			Vector3f dir; ///< Camera viewing direction.
+			ImageRGB::Ptr image; ///< Input image.
+			ImageL32F depth; ///< Input depth map, same resolution as the image.
+		};
+
+		ULRCPUOptions _options; ///< Rendering parameters.
+		Raycaster _raycaster; ///< Proxy intersections.
+		std::vector<CameraData> _cameras; ///< Input cameras.
+		std::vector<uint> _enabledIds; ///< Enabled cameras.
+	};
+
+} /*namespace sibr*/
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <projects/ulr/renderer/ULRCameraCuller.hpp>
+
+#include <algorithm>
+
+
+sibr::ULRCameraCuller::ULRCameraCuller(const std::vector<InputCamera::Ptr> & cameras)
+{
+	_cameras.reserve(cameras.size());
+	Eigen::AlignedBox<float, 3> bounds;
+	for (const InputCamera::Ptr & cam : cameras) {
+		_cameras.push_back({ sibr::Frustum(cam->viewproj()), cam->position(), cam->dir().normalized() });
+		bounds.extend(cam->position());
+	}
+	if (!cameras.empty()) {
+		_extent = std::max(bounds.diagonal().norm(), 1e-6f);
+	}
+}
+
+const std::vector<uint> & sibr::ULRCameraCuller::cull(const sibr::Camera & eye, const std::vector<uint> & enabledIds, const ULRCullingOptions & options)
+{
+	// Novel frustum, optionally shortened: far planes of interactive cameras are usually very far.
+	sibr::Camera novel = eye;
+	if (options.maxDistance > 0.0f && options.maxDistance < novel.zfar()) {
+		novel.zfar(std::max(options.maxDistance, novel.znear() * 1.01f));
+	}
+	const sibr::Frustum novelFrustum(novel.viewproj());
+	const Vector3f novelPos = eye.position();
+	const Vector3f novelDir = eye.dir().normalized();
+	const float cosCone = std::cos(sibr::clamp(options.coneAngle, 0.0f, 180.0f) * float(M_PI) / 180.0f);
+
+	// Rank by angle between the viewing directions, then by distance.
+	auto score = [&](const CameraData & cam) {
+		const float angle = std::acos(sibr::clamp(cam.dir.dot(novelDir), -1.0f, 1.0f));
+		return angle + options.distanceWeight * (cam.position - novelPos).norm() / _extent;
+	};
+
+	_scores.clear();
+	for (const uint id : enabledIds) {
+		const CameraData & cam = _cameras[id];
+		if (cam.dir.dot(novelDir) < cosCone) {
+			continue;
+		}
+		if (!novelFrustum.overlaps(cam.frustum)) {
+			continue;
+		}
+		_scores.emplace_back(score(cam), id);
+	}
+	_visibleCount = _scores.size();
+
+	// Never leave the view empty, fall back to the best enabled cameras.
+	if (_scores.empty()) {
+		for (const uint id : enabledIds) {
+			_scores.emplace_back(score(_cameras[id]), id);
+		}
+	}
+
+	const size_t count = std::min(_scores.size(), size_t(std::max(0, options.maxCandidates)));
+	std::partial_sort(_scores.begin(), _scores.begin() + count, _scores.end());
+	_candidates.resize(count);
+	for (size_t c = 0; c < count; ++c) {
+		_candidates[c] = _scores[c].second;
+	}
+	return _candidates;
+}
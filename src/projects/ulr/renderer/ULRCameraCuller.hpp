@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#pragma once
+
+# include "Config.hpp"
+# include <core/system/Config.hpp>
+# include <core/assets/InputCamera.hpp>
+# include <core/graphics/Frustum.hpp>
+
+namespace sibr {
+
+	/** Parameters of the per-frame selection of the input cameras blended by ULR. */
+	struct SIBR_EXP_ULR_EXPORT ULRCullingOptions {
+		int maxCandidates = 32; ///< Maximum number of candidate cameras (K), the fragment shader loops over them only.
+		float coneAngle = 80.0f; ///< Cameras looking more than this angle (in degrees) away from the novel view direction are culled.
+		float maxDistance = 0.0f; ///< Depth of the novel frustum used for the overlap test, 0 to use the far plane of the novel view.
+		float distanceWeight = 0.1f; ///< Weight of the distance between the cameras (relative to the cameras extent) when ranking candidates by angle.
+	};
+
+	/**
+	 * \class ULRCameraCuller
+	 * \brief CPU pre-pass selecting, for a novel view, a bounded list of input cameras worth blending.
+	 * Cameras whose frustum does not overlap the novel view frustum (see Frustum::overlaps), or whose viewing direction is outside a cone around
+	 * the novel viewing direction, are discarded; the remaining ones are ranked by angle and distance to the novel view,
+	 * and the best K are kept. No OpenGL call is made.
+	 */
+	class SIBR_EXP_ULR_EXPORT ULRCameraCuller
+	{
+		SIBR_CLASS_PTR(ULRCameraCuller);
+
+	public:
+
+		/**
+		 * Constructor.
+		 * \param cameras The input cameras.
+		 */
+		ULRCameraCuller(const std::vector<InputCamera::Ptr> & cameras);
+
+		/**
+		 * Select the candidate cameras for a novel view.
+		 * \param eye The novel viewpoint.
+		 * \param enabledIds The cameras that can be selected.
+		 * \param options The culling parameters.
+		 * \return the candidate cameras indices, best first, at most options.maxCandidates.
+		 * \note If all cameras are culled, the best ranked enabled cameras are returned, so that the view is not left empty.
+		 */
+		const std::vector<uint> & cull(const sibr::Camera & eye, const std::vector<uint> & enabledIds, const ULRCullingOptions & options);
+
+		/** \return the candidates selected by the last call to cull. */
+		const std::vector<uint> & candidates() const { return _candidates; }
+
+		/** \return the number of enabled cameras that passed the frustum and cone tests in the last call to cull. */
+		size_t visibleCount() const { return _visibleCount; }
+
+	private:
+
+		/** Per camera data. */
+		struct CameraData {
+			sibr::Frustum frustum; ///< Camera frustum.
+			Vector3f position; ///< Camera position.
+			Vector3f dir; ///< Camera viewing direction.
+		};
+
+		std::vector<CameraData> _cameras; ///< Input cameras.
+		float _extent = 1.0f; ///< Diagonal of the bounding box of the cameras positions.
+		std::vector<std::pair<float, uint>> _scores; ///< Scratch ranking buffer.
+		std::vector<uint> _candidates; ///< Selected cameras.
+		size_t _visibleCount = 0; ///< Number of cameras that passed the tests.
+	};
+
+} /*namespace sibr*/
@@ -51,7 +51,7 @@ void
 ULRRenderer::process(std::vector<uint>& imgs_ulr, const sibr::Camera& eye,
 		const sibr::BasicIBRScene::Ptr scene,
 		std::shared_ptr<sibr::Mesh>& altMesh,
-		const std::vector<std::shared_ptr<RenderTargetRGBA32F> >& inputRTs,
+		const std::vector<IRenderTarget::Ptr>& inputRTs,
 		IRenderTarget& dst)
 {
 	// Get a new camera with z_near ~ 0
@@ -72,7 +72,7 @@ ULRRenderer::process(std::vector<uint>& imgs_ulr, const sibr::Camera& eye,
 	if( altMesh != nullptr )
 		altMesh->render( true, true); // enable depth test - disable back culling
 	else
-		scene->proxies()->proxy().render( true, true); // enable depth test - disable back culling
+		scene->proxies()->renderForView(new_cam, float(_depth_RT->h()), true, true); // enable depth test - disable back culling
 
     _depthShader.end();
     _depth_RT->unbind();
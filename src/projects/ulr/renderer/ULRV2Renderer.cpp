@@ -100,7 +100,7 @@ namespace sibr {
 			ULRV2Renderer::process(const std::vector<uint>& imgs_ulr, const sibr::Camera& eye,
 				const sibr::BasicIBRScene::Ptr& scene,
 				std::shared_ptr<sibr::Mesh>& altMesh,
-				const std::vector<std::shared_ptr<RenderTargetRGBA32F> >& inputRTs,
+				const std::vector<IRenderTarget::Ptr>& inputRTs,
 				IRenderTarget& dst)
 		{
 			// Get a new camera with z_near ~ 0
@@ -118,7 +118,7 @@ namespace sibr {
 			if (altMesh != nullptr) {
 				altMesh->render(true, _shouldCull); // enable depth test - disable back culling
 			} else {
-				scene->proxies()->proxy().render(true, _shouldCull);
+				scene->proxies()->renderForView(new_cam, float(_depthRT->h()), true, _shouldCull);
 			}
 			_depthShader.end();
 			_depthRT->unbind();
@@ -55,7 +55,7 @@ namespace sibr {
 		void process(const std::vector<uint>& imgs_ulr, const sibr::Camera& eye,
 			const sibr::BasicIBRScene::Ptr& scene,
 			std::shared_ptr<sibr::Mesh>& altMesh,
-			const std::vector<std::shared_ptr<RenderTargetRGBA32F> >& inputRTs,
+			const std::vector<IRenderTarget::Ptr>& inputRTs,
 			IRenderTarget& dst);
 
 		/** Should occlusion testing be performed.
@@ -14,6 +14,7 @@
 #include "Config.hpp"
 #include <core/assets/Resources.hpp>
 #include <projects/ulr/renderer/ULRV2View.hpp>
+#include <projects/ulr/renderer/SoftVisibility.hpp>
 #include <core/system/Vector.hpp>
 #include <core/graphics/Texture.hpp>
 #include <core/graphics/GUI.hpp>
@@ -151,32 +152,13 @@ void ULRV2View::onGUI() {
 
 void ULRV2View::computeVisibilityMap(const sibr::ImageL32F & depthMap, sibr::ImageRGBA & out)
 {
-	const float threshold_3d = 2.5f;
-	const std::vector<sibr::Vector2i> shifts = { { 1,0 },{ 0,1 },{ -1,0 },{ 0,-1 } };
-
-	sibr::ImageL8 edgeMap(depthMap.w(), depthMap.h(), 255);
-	for (uint i = 0; i < depthMap.h(); i++) {
-		for (uint j = 0; j < depthMap.w(); j++) {
-			sibr::Vector2i pos(j, i);
-			float currentDepth = depthMap(pos).x();
-			for (const auto & shift : shifts) {
-				Vector2i npos = pos + shift;
-				if (!depthMap.isInRange(npos)) { continue; }
-				if (std::abs(depthMap(npos).x() - currentDepth) > threshold_3d) {
-					edgeMap(pos).x() = 0;
-					break;
-				}
-			}
-		}
-	}
-
-	cv::Mat distance(depthMap.h(), depthMap.w(), CV_32FC1);
-	cv::distanceTransform(edgeMap.toOpenCVnonConst(), distance, cv::DIST_L2, cv::DIST_MASK_PRECISE);
-
-	sibr::ImageL32F outF;
-	outF.fromOpenCV(distance);
-	out = sibr::convertL32FtoRGBA(outF);
+	out = sibr::convertL32FtoRGBA(computeVisibilityMap(depthMap));
+}
 
+sibr::ImageL32F ULRV2View::computeVisibilityMap(const sibr::ImageL32F & depthMap)
+{
+	SoftVisibility::Options options;
+	return SoftVisibility::compute(depthMap, options);
 }
 
 	// -----------------------------------------------------------------------
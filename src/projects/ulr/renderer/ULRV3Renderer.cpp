@@ -31,7 +31,11 @@ sibr::ULRV3Renderer::ULRV3Renderer(const std::vector<InputCamera::Ptr> & cameras
 		_cameraInfos[i].pos = cam.position();
 		_cameraInfos[i].dir = cam.dir();
 		_cameraInfos[i].selected = cam.isActive();
+		if (cam.isActive()) {
+			_enabledIds.push_back(uint(i));
+		}
 	}
+	_culler.reset(new ULRCameraCuller(cameras));
 
 	// Compute the max number of cameras allowed.
 	GLint maxBlockSize = 0, maxSlicesSize = 0;
@@ -61,11 +65,33 @@ sibr::ULRV3Renderer::ULRV3Renderer(const std::vector<InputCamera::Ptr> & cameras
 
 void sibr::ULRV3Renderer::setupShaders(const std::string & fShader, const std::string & vShader)
 {
+	fragString = fShader;
+	vertexString = vShader;
+
+	// Bound the number of cameras visited per pixel, only worth it if there are more input cameras than candidates.
+	_maxCandidates = 0;
+	if (_residency) {
+		// Candidates are always needed to map cameras to layers, and at most one per layer can be resident.
+		size_t maxCandidates = std::min(_residency->scheduler().slotsCount(), _maxNumCams);
+		if (_cullingOptions.maxCandidates > 0) {
+			maxCandidates = std::min(maxCandidates, size_t(_cullingOptions.maxCandidates));
+		}
+		_maxCandidates = int(maxCandidates);
+	} else if (_cullingEnabled && _cullingOptions.maxCandidates > 0 && size_t(_cullingOptions.maxCandidates) < _maxNumCams) {
+		_maxCandidates = _cullingOptions.maxCandidates;
+	}
+
 	// Create shaders.
-	std::cout << "[ULRV3Renderer] Setting up shaders for " << _maxNumCams << " cameras." << std::endl;
+	std::cout << "[ULRV3Renderer] Setting up shaders for " << _maxNumCams << " cameras";
+	if (_maxCandidates > 0) {
+		std::cout << ", at most " << _maxCandidates << " per frame";
+	}
+	std::cout << "." << std::endl;
 	GLShader::Define::List defines;
 	defines.emplace_back("NUM_CAMS", _maxNumCams);
 	defines.emplace_back("ULR_STREAMING", 0);
+	defines.emplace_back("MAX_CANDIDATES", _maxCandidates);
+	defines.emplace_back("RESIDENT_SLOTS", _residency ? 1 : 0);
 
 	_ulrShader.init("ULRV3",
 		sibr::loadFile(sibr::getShadersDirectory("") + "/" + vShader + ".vert"),
@@ -89,9 +115,49 @@ void sibr::ULRV3Renderer::setupShaders(const std::string & fShader, const std::s
 	_camsCount.init(_ulrShader, "camsCount");
 	_gammaCorrection.init(_ulrShader, "gammaCorrection");
 
+	// Candidates UBO, indices are packed four by four in ivec4s.
+	if (_maxCandidates > 0) {
+		_candidatesCount.init(_ulrShader, "candidatesCount");
+		_candidateIds.assign(4 * ((_maxCandidates + 3) / 4), 0);
+		if (_candidatesUboIndex == 0) {
+			glGenBuffers(1, &_candidatesUboIndex);
+		}
+		glBindBuffer(GL_UNIFORM_BUFFER, _candidatesUboIndex);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(int)*_candidateIds.size(), &_candidateIds[0], GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	} else {
+		_candidateIds.clear();
+	}
+
+	// Layers of the candidates, same packing.
+	if (_residency) {
+		_candidateSlots.assign(_candidateIds.size(), 0);
+		if (_slotsUboIndex == 0) {
+			glGenBuffers(1, &_slotsUboIndex);
+		}
+		glBindBuffer(GL_UNIFORM_BUFFER, _slotsUboIndex);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(int)*_candidateSlots.size(), &_candidateSlots[0], GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	} else {
+		_candidateSlots.clear();
+	}
+
 	CHECK_GL_ERROR;
 }
 
+void sibr::ULRV3Renderer::setCameraCulling(bool enabled, const ULRCullingOptions & options)
+{
+	_cullingEnabled = enabled;
+	_cullingOptions = options;
+	setupShaders(fragString, vertexString);
+}
+
+void sibr::ULRV3Renderer::setResidency(const ResidentInputTextures::Ptr & residency)
+{
+	_residency = residency;
+	setupShaders(fragString, vertexString);
+}
+
 void sibr::ULRV3Renderer::process(
 	const sibr::Mesh & mesh,
 	const sibr::Camera & eye,
@@ -125,6 +191,8 @@ void sibr::ULRV3Renderer::process(
 	if (_profiling) {
 		_blendPassTimer.tic();
 	}
+	// Select the cameras to blend for this viewpoint.
+	updateCandidates(eye);
 	// Perform ULR blending.
 	renderBlending(eye, dst, inputRGBHandle, inputDepths, passthroughDepth);
 	if (_profiling) {
@@ -143,6 +211,7 @@ void sibr::ULRV3Renderer::updateCameras(const std::vector<uint> & camIds) {
 	for (const auto & camId : camIds) {
 		_cameraInfos[camId].selected = 1;
 	}
+	_enabledIds = camIds;
 
 	// Update the content of the UBO.
 	glBindBuffer(GL_UNIFORM_BUFFER, _uboIndex);
@@ -150,6 +219,51 @@ void sibr::ULRV3Renderer::updateCameras(const std::vector<uint> & camIds) {
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
+void sibr::ULRV3Renderer::updateCandidates(const sibr::Camera & eye)
+{
+	if (_maxCandidates == 0) {
+		_usedCandidates = _enabledIds.size();
+		return;
+	}
+	// No need to cull if all enabled cameras fit.
+	const std::vector<uint> * candidates = &_enabledIds;
+	if (_enabledIds.size() > size_t(_maxCandidates)) {
+		ULRCullingOptions options = _cullingOptions;
+		options.maxCandidates = _maxCandidates;
+		candidates = &_culler->cull(eye, _enabledIds, options);
+	}
+	std::fill(_candidateIds.begin(), _candidateIds.end(), 0);
+	if (_residency) {
+		// Request the candidates, and only blend the ones already resident.
+		_residency->update(*candidates);
+		std::fill(_candidateSlots.begin(), _candidateSlots.end(), 0);
+		size_t count = 0;
+		for (const uint camId : *candidates) {
+			const int slot = _residency->slot(camId);
+			if (slot < 0) {
+				continue;
+			}
+			_candidateIds[count] = int(camId);
+			_candidateSlots[count] = slot;
+			++count;
+		}
+		_candidatesCount = int(count);
+		_usedCandidates = count;
+
+		glBindBuffer(GL_UNIFORM_BUFFER, _slotsUboIndex);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(int)*_candidateSlots.size(), &_candidateSlots[0]);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	} else {
+		std::copy(candidates->begin(), candidates->end(), _candidateIds.begin());
+		_candidatesCount = int(candidates->size());
+		_usedCandidates = candidates->size();
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, _candidatesUboIndex);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(int)*_candidateIds.size(), &_candidateIds[0]);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
 void sibr::ULRV3Renderer::stopProfile()
 {
 	const std::vector<std::string> names = { "Depth Cost: ", "Blend Cost: "};
@@ -198,7 +312,11 @@ void sibr::ULRV3Renderer::renderProxyDepth(const sibr::Mesh & mesh, const sibr::
 	_depthShader.begin();
 	_nCamProj.set(eye.viewproj());
 
-	mesh.render(true, _backFaceCulling);
+	if (_lodProxy && &mesh == _lodSource.get()) {
+		_lodProxy->render(eye, float(_depthRT->h()), _lodPixelError, true, _backFaceCulling);
+	} else {
+		mesh.render(true, _backFaceCulling);
+	}
 	
 	_depthShader.end();
 	_depthRT->unbind();
@@ -233,6 +351,9 @@ void sibr::ULRV3Renderer::renderBlending(
 	_camsCount.send();
 	_winnerTakesAll.send();
 	_gammaCorrection.send();
+	if (_maxCandidates > 0) {
+		_candidatesCount.send();
+	}
 
 	// Textures.
 	glActiveTexture(GL_TEXTURE0);
@@ -253,6 +374,12 @@ void sibr::ULRV3Renderer::renderBlending(
 	// Bind UBO to shader, after all possible textures.
 	glBindBuffer(GL_UNIFORM_BUFFER, _uboIndex);
 	glBindBufferBase(GL_UNIFORM_BUFFER, 4, _uboIndex);
+	if (_maxCandidates > 0) {
+		glBindBufferBase(GL_UNIFORM_BUFFER, 5, _candidatesUboIndex);
+	}
+	if (_residency) {
+		glBindBufferBase(GL_UNIFORM_BUFFER, 6, _slotsUboIndex);
+	}
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
 	if (passthroughDepth) {
@@ -19,14 +19,18 @@
 # include <core/graphics/Mesh.hpp>
 # include <core/renderer/RenderMaskHolder.hpp>
 # include <core/scene/BasicIBRScene.hpp>
+# include <core/scene/ResidentInputTextures.hpp>
 # include <core/system/SimpleTimer.hpp>
+# include <projects/ulr/renderer/ULRCameraCuller.hpp>
 
 namespace sibr { 
 	
 	/**
 	 * \class ULRV3Renderer
-	 * \brief Perform per-pixel Unstructured Lumigraph Rendering (Buehler et al., 2001). No selection is done on the CPU side.
+	 * \brief Perform per-pixel Unstructured Lumigraph Rendering (Buehler et al., 2001).
 	 * Relies on texture arrays and uniform buffer objects to support a high number of cameras. 
+	 * By default a bounded list of candidate cameras is selected on the CPU for each frame (see ULRCameraCuller),
+	 * so that the cost of the blending pass does not grow with the number of input cameras.
 	 */
 	class SIBR_EXP_ULR_EXPORT ULRV3Renderer : public RenderMaskHolderArray
 	{
@@ -102,6 +106,38 @@ namespace sibr {
 		 **/
 		void updateCameras(const std::vector<uint> & camIds);
 
+		/**
+		 * Enable or disable the per-frame selection of candidate cameras, and set its parameters.
+		 * The shaders are rebuilt, as the number of candidates is a compile time constant.
+		 * \param enabled If false, every pixel loops over all enabled cameras.
+		 * \param options The culling parameters.
+		 */
+		void setCameraCulling(bool enabled, const ULRCullingOptions & options);
+
+		/// \return true if candidate cameras are selected on the CPU.
+		bool cameraCulling() const { return _cullingEnabled; }
+
+		/// \return the culling parameters (changing maxCandidates requires a call to setCameraCulling).
+		ULRCullingOptions & cullingOptions() { return _cullingOptions; }
+
+		/**
+		 * Stream the input images and depth maps through a residency manager instead of keeping all of them on the GPU:
+		 * the candidate cameras of each frame are requested, and only the resident ones are blended.
+		 * The texture arrays passed to process() must then be the ones of the residency manager.
+		 * Candidates selection is always enabled in this mode, the shaders are rebuilt.
+		 * \param residency The residency manager, nullptr to sample full texture arrays again.
+		 */
+		void setResidency(const ResidentInputTextures::Ptr & residency);
+
+		/// \return the residency manager, if any.
+		const ResidentInputTextures::Ptr & residency() const { return _residency; }
+
+		/// \return the number of candidate cameras used for the last frame.
+		size_t candidatesCount() const { return _usedCandidates; }
+
+		/// \return the number of enabled cameras.
+		size_t enabledCount() const { return _enabledIds.size(); }
+
 		/// Set the epsilon occlusion threshold.
 		float & epsilonOcclusion() { return _epsilonOcclusion.get(); }
 
@@ -126,6 +162,13 @@ namespace sibr {
 		/// Apply backface culling to the mesh.
 		bool & backfaceCull() { return _backFaceCulling; }
 
+		/** Use a level of detail proxy for the depth pass when process() is called with the mesh it was built from.
+		 *\param lodProxy the LOD proxy (nullptr to render the mesh)
+		 *\param source the mesh the LOD proxy was built from, other meshes passed to process() are rendered as is
+		 *\param pixelError the maximum screen space error, in pixels
+		 **/
+		void setLODProxy(const sibr::LODMesh::Ptr & lodProxy, const sibr::Mesh::Ptr & source, float pixelError = 1.0f) { _lodProxy = lodProxy; _lodSource = source; _lodPixelError = pixelError; }
+
 		/** Resize the internal rendertargets.
 		 *\param w the new width
 		 *\param h the new height
@@ -171,6 +214,13 @@ namespace sibr {
 
 
 	protected:
+
+		/**
+		 * Select the candidate cameras for a novel view and upload them to the GPU.
+		 * \param eye The novel viewpoint.
+		 */
+		void updateCandidates(const sibr::Camera & eye);
+
 		/// Shader names.
 		std::string fragString, vertexString;
 
@@ -197,6 +247,9 @@ namespace sibr {
 
 		GLuniform<float>					_epsilonOcclusion = 0.01f;
 		bool								_backFaceCulling = true;
+		sibr::LODMesh::Ptr					_lodProxy; ///< Optional LOD proxy for the depth pass.
+		sibr::Mesh::Ptr						_lodSource; ///< Mesh the LOD proxy was built from.
+		float								_lodPixelError = 1.0f; ///< LOD maximum screen space error.
 		bool								_clearDst = true;
 
 		/** Camera infos data structure shared between the CPU and GPU.
@@ -212,6 +265,19 @@ namespace sibr {
 		std::vector<CameraUBOInfos> _cameraInfos;
 		GLuint _uboIndex;
 
+		ULRCameraCuller::Ptr				_culler; ///< Per-frame candidate cameras selection.
+		ULRCullingOptions					_cullingOptions; ///< Culling parameters.
+		bool								_cullingEnabled = true; ///< Is the candidates selection enabled.
+		int									_maxCandidates = 0; ///< Number of candidates the current shaders were compiled for, 0 if disabled.
+		std::vector<uint>					_enabledIds; ///< Enabled cameras.
+		std::vector<int>					_candidateIds; ///< Candidates uploaded to the GPU, padded to a multiple of 4.
+		GLuint								_candidatesUboIndex = 0; ///< Candidates UBO.
+		GLuniform<int>						_candidatesCount = 0; ///< Number of valid candidates.
+		size_t								_usedCandidates = 0; ///< Number of cameras blended in the last frame.
+		ResidentInputTextures::Ptr			_residency; ///< Optional residency manager of the input views.
+		std::vector<int>					_candidateSlots; ///< Texture arrays layer of each candidate, with a residency manager.
+		GLuint								_slotsUboIndex = 0; ///< Candidates layers UBO.
+
 		bool		_profiling = false;
 		sibr::Timer	_depthPassTimer;
 		sibr::Timer	_blendPassTimer;
@@ -22,6 +22,9 @@ sibr::ULRV3View::ULRV3View(const sibr::BasicIBRScene::Ptr & ibrScene, uint rende
 
 	//  Renderers.
 	_ulrRenderer.reset(new ULRV3Renderer(ibrScene->cameras()->inputCameras(), w, h));
+	if (ibrScene->proxies()->hasLODProxy()) {
+		_ulrRenderer->setLODProxy(ibrScene->proxies()->lodProxyPtr(), ibrScene->proxies()->proxyPtr(), ibrScene->proxies()->lodPixelError());
+	}
 	_poissonRenderer.reset(new PoissonRenderer(w, h));
 	_poissonRenderer->enableFix() = true;
 
@@ -54,6 +57,9 @@ void sibr::ULRV3View::setScene(const sibr::BasicIBRScene::Ptr & newScene) {
 	}
 
 	_ulrRenderer.reset(new ULRV3Renderer(newScene->cameras()->inputCameras(), w, h, shaderName));
+	if (newScene->proxies()->hasLODProxy()) {
+		_ulrRenderer->setLODProxy(newScene->proxies()->lodProxyPtr(), newScene->proxies()->proxyPtr(), newScene->proxies()->lodPixelError());
+	}
 
 	// Tell the scene we are a priori using all active cameras.
 	std::vector<uint> imgs_ulr;
@@ -81,13 +87,18 @@ void sibr::ULRV3View::setMode(const WeightsMode mode) {
 
 void sibr::ULRV3View::onRenderIBR(sibr::IRenderTarget & dst, const sibr::Camera & eye)
 {
+	// Only some input views are on the GPU when they are streamed.
+	const ResidentInputTextures::Ptr & residency = _ulrRenderer->residency();
+	const Texture2DArrayRGB::Ptr & inputRGBs = residency ? residency->getInputRGBTextureArrayPtr() : _scene->renderTargets()->getInputRGBTextureArrayPtr();
+	const Texture2DArrayLum32F::Ptr & inputDepths = residency ? residency->getInputDepthMapArrayPtr() : _scene->renderTargets()->getInputDepthMapArrayPtr();
+
 	// Perform ULR rendering, either directly to the destination RT, or to the intermediate RT when poisson blending is enabled.
 	_ulrRenderer->process(
 			_scene->proxies()->proxy(),
 			eye, 
 			_poissonBlend ? *_blendRT : dst,
-			_scene->renderTargets()->getInputRGBTextureArrayPtr(),
-		_scene->renderTargets()->getInputDepthMapArrayPtr()
+			inputRGBs,
+			inputDepths
 		);
 
 	// Perform Poisson blending if enabled and copy to the destination RT.
@@ -147,6 +158,28 @@ void sibr::ULRV3View::onGUI()
 		ImGui::Checkbox("Occlusion Testing", &_ulrRenderer->occTest());
 		ImGui::Checkbox("Debug weights", &_ulrRenderer->showWeights());
 		ImGui::Checkbox("Gamma correction", &_ulrRenderer->gammaCorrection());
+
+		ImGui::Separator();
+		// Per-frame candidate cameras selection.
+		bool culling = _ulrRenderer->cameraCulling();
+		ULRCullingOptions & cullingOptions = _ulrRenderer->cullingOptions();
+		bool rebuild = ImGui::Checkbox("Camera culling", &culling);
+		if (culling) {
+			if (ImGui::InputInt("Max candidates", &cullingOptions.maxCandidates, 1, 8)) {
+				cullingOptions.maxCandidates = std::max(1, cullingOptions.maxCandidates);
+				rebuild = true;
+			}
+			ImGui::SliderFloat("Culling cone", &cullingOptions.coneAngle, 0.0f, 180.0f, "%.0f deg");
+			ImGui::InputFloat("Culling distance", &cullingOptions.maxDistance, 0.1f, 1.0f);
+		}
+		if (rebuild) {
+			_ulrRenderer->setCameraCulling(culling, cullingOptions);
+		}
+		ImGui::Text("Blended cameras: %d / %d", int(_ulrRenderer->candidatesCount()), int(_ulrRenderer->enabledCount()));
+		if (_ulrRenderer->residency()) {
+			const ResidencyScheduler & scheduler = _ulrRenderer->residency()->scheduler();
+			ImGui::Text("Resident views: %d / %d, %d evictions", int(scheduler.residentCount()), int(scheduler.slotsCount()), int(scheduler.stats().evictions));
+		}
 		ImGui::PopItemWidth();
 	}
 	ImGui::End();
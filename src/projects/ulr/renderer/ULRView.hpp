@@ -73,7 +73,7 @@ namespace sibr {
 		/** Set the input RGBD textures.
 		 *\param iRTs the new textures to use. 
 		 */
-		void	inputRTs(const std::vector<std::shared_ptr<RenderTargetRGBA32F> >& iRTs) { _inputRTs = iRTs;}
+		void	inputRTs(const std::vector<IRenderTarget::Ptr>& iRTs) { _inputRTs = iRTs;}
 
 		/** Set the masks for ignoring some regions of the input images.
 		 *\param masks the new masks
@@ -86,7 +86,7 @@ namespace sibr {
 		std::shared_ptr<sibr::BasicIBRScene> _scene; ///< Scene.
 		std::shared_ptr<sibr::Mesh>	_altMesh; ///< For the cases when using a different mesh than the scene
 		short int _numDistUlr, _numAnglUlr; ///< max number of selected cameras for each criterion.
-		std::vector<std::shared_ptr<RenderTargetRGBA32F> > _inputRTs; ///< input RTs -- usually RGB but can be alpha or other
+		std::vector<IRenderTarget::Ptr> _inputRTs; ///< input RTs -- usually RGB but can be alpha or other
 
 	};
 
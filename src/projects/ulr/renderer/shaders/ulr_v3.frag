@@ -14,6 +14,8 @@
 
 #define NUM_CAMS (12)
 #define ULR_STREAMING (0)
+#define MAX_CANDIDATES (0)
+#define RESIDENT_SLOTS (0)
 
 in vec2 vertex_coord;
 layout(location = 0) out vec4 out_color;
@@ -35,6 +37,25 @@ layout(std140, binding=4) uniform InputCameras
   CameraInfos cameras[NUM_CAMS];
 };
 
+#if MAX_CANDIDATES
+// Cameras selected on the CPU for the current view (see ULRCameraCuller), four indices per vector.
+layout(std140, binding=5) uniform CandidateCameras
+{
+  ivec4 candidates[(MAX_CANDIDATES + 3) / 4];
+};
+uniform int candidatesCount;
+#if RESIDENT_SLOTS
+// Texture arrays layer of each candidate, when only some input views are resident (see ResidentInputTextures).
+layout(std140, binding=6) uniform CandidateSlots
+{
+  ivec4 slots[(MAX_CANDIDATES + 3) / 4];
+};
+#endif
+#define CAMS_LOOP_COUNT MAX_CANDIDATES
+#else
+#define CAMS_LOOP_COUNT NUM_CAMS
+#endif
+
 // Uniforms.
 uniform int camsCount;
 uniform vec3 ncam_pos;
@@ -136,7 +157,21 @@ void main(void){
 
   bool atLeastOneValid = false;
   
-  for(int i = 0; i < NUM_CAMS; i++){
+  for(int c = 0; c < CAMS_LOOP_COUNT; c++){
+#if MAX_CANDIDATES
+	if(c >= candidatesCount){
+		break;
+	}
+	int i = candidates[c / 4][c % 4];
+#if RESIDENT_SLOTS
+	int layer = slots[c / 4][c % 4];
+#else
+	int layer = i;
+#endif
+#else
+	int i = c;
+	int layer = c;
+#endif
 	if(i>=camsCount){
 		continue;
 	}
@@ -152,7 +187,7 @@ void main(void){
 
 
 	if (frustumTest(point.xyz, ndc, i)){
-		vec3 xy_camid = vec3(uvd.xy,i);
+		vec3 xy_camid = vec3(uvd.xy,layer);
 		
 		
 		vec4 color = getRGBD(xy_camid);
@@ -160,7 +195,7 @@ void main(void){
 		
 
 		if(doMasking){        
-			float masked = getMask(xy_camid);
+			float masked = getMask(vec3(xy_camid.xy,i));
              
             if( invert_mask ){
                 masked = 1.0 - masked;
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2020, Inria
+ * GRAPHDECO research group, https://team.inria.fr/graphdeco
+ * All rights reserved.
+ *
+ * This software is free for non-commercial, research and evaluation use
+ * under the terms of the LICENSE.md file.
+ *
+ * For inquiries contact sibr@inria.fr and/or George.Drettakis@inria.fr
+ */
+
+
+#include <core/system/Config.hpp>
+#include <core/graphics/Frustum.hpp>
+#include <projects/ulr/renderer/ULRCameraCuller.hpp>
+#include <core/tests/Checks.hpp>
+
+using namespace sibr;
+
+/* Check the ULR candidate cameras selection on the CPU: cameras facing away from the novel view
+ or with a frustum disjoint from it are culled, the others are ranked and truncated to K. */
+
+namespace
+{
+	/** \return a camera at a position, looking at a target. */
+	Camera lookAt(const Vector3f & eye, const Vector3f & target, float fovDeg, float zfar)
+	{
+		Camera cam;
+		cam.setLookAt(eye, target, Vector3f(0.0f, 1.0f, 0.0f));
+		cam.perspective(fovDeg * float(M_PI) / 180.0f, 1.0f, 0.1f, zfar);
+		return cam;
+	}
+
+	/** \return an input camera at a position, looking at a target. */
+	InputCamera::Ptr inputLookAt(const Vector3f & eye, const Vector3f & target)
+	{
+		return InputCamera::Ptr(new InputCamera(lookAt(eye, target, 50.0f, 50.0f), 640, 640));
+	}
+
+	/** Frustum corners and overlap test. */
+	void checkFrustum()
+	{
+		const Camera eye = lookAt(Vector3f(0.0f, 0.0f, 0.0f), Vector3f(0.0f, 0.0f, -1.0f), 60.0f, 100.0f);
+		const Frustum fromCamera(eye);
+		const Frustum fromViewProj(eye.viewproj());
+		for (int c = 0; c < 8; ++c) {
+			const Vector3f & corner = fromViewProj.corners()[c];
+			SIBR_CHECK((fromCamera.corners()[c] - corner).norm() < 1e-3f * std::max(1.0f, corner.norm()));
+		}
+		SIBR_CHECK(fromViewProj.testSphere(Vector3f(0.0f, 0.0f, -10.0f), 1.0f) == Frustum::INSIDE);
+		SIBR_CHECK(fromViewProj.testSphere(Vector3f(0.0f, 0.0f, 10.0f), 1.0f) == Frustum::OUTSIDE);
+
+		// Same direction, side by side and far apart.
+		const Frustum beside(lookAt(Vector3f(5.0f, 0.0f, 0.0f), Vector3f(5.0f, 0.0f, -1.0f), 50.0f, 50.0f).viewproj());
+		const Frustum distant(lookAt(Vector3f(500.0f, 0.0f, 0.0f), Vector3f(500.0f, 0.0f, -1.0f), 50.0f, 50.0f).viewproj());
+		SIBR_CHECK(fromViewProj.overlaps(beside) && beside.overlaps(fromViewProj));
+		SIBR_CHECK(!fromViewProj.overlaps(distant) && !distant.overlaps(fromViewProj));
+		// Behind the novel view, looking away from it.
+		const Frustum behind(lookAt(Vector3f(0.0f, 0.0f, 1.0f), Vector3f(0.0f, 0.0f, 2.0f), 50.0f, 50.0f).viewproj());
+		SIBR_CHECK(!fromViewProj.overlaps(behind));
+	}
+
+	/** Culling, ranking and truncation of the candidates. */
+	void checkCuller()
+	{
+		// Ranked by angle to the novel direction: 0 (0 deg), 1 (~17 deg), 3 (~22 deg), 2 (~27 deg), 6 (40 deg).
+		std::vector<InputCamera::Ptr> cameras = {
+			inputLookAt(Vector3f(0.0f, 0.0f, 1.0f), Vector3f(0.0f, 0.0f, 0.0f)),
+			inputLookAt(Vector3f(1.0f, 0.0f, 0.0f), Vector3f(0.7f, 0.0f, -1.0f)),
+			inputLookAt(Vector3f(-1.0f, 0.0f, 0.0f), Vector3f(-0.5f, 0.0f, -1.0f)),
+			inputLookAt(Vector3f(0.0f, 1.0f, 0.0f), Vector3f(0.0f, 0.6f, -1.0f)),
+			// Facing away from the novel view.
+			inputLookAt(Vector3f(0.0f, 0.0f, -2.0f), Vector3f(0.0f, 0.0f, 0.0f)),
+			// Same direction, but its frustum is disjoint from the novel one.
+			inputLookAt(Vector3f(500.0f, 0.0f, 0.0f), Vector3f(500.0f, 0.0f, -1.0f)),
+			inputLookAt(Vector3f(2.0f, 0.0f, 0.0f), Vector3f(2.0f - std::tan(40.0f * float(M_PI) / 180.0f), 0.0f, -1.0f))
+		};
+		const Camera eye = lookAt(Vector3f(0.0f, 0.0f, 0.0f), Vector3f(0.0f, 0.0f, -1.0f), 60.0f, 100.0f);
+		const std::vector<uint> all = { 0, 1, 2, 3, 4, 5, 6 };
+
+		ULRCameraCuller culler(cameras);
+		ULRCullingOptions options;
+
+		SIBR_CHECK(culler.cull(eye, all, options) == std::vector<uint>({ 0, 1, 3, 2, 6 }));
+		SIBR_CHECK(culler.visibleCount() == 5);
+
+		// K bound: the best ones, in order.
+		options.maxCandidates = 3;
+		SIBR_CHECK(culler.cull(eye, all, options) == std::vector<uint>({ 0, 1, 3 }));
+		SIBR_CHECK(culler.candidates() == std::vector<uint>({ 0, 1, 3 }) && culler.visibleCount() == 5);
+		options.maxCandidates = 0;
+		SIBR_CHECK(culler.cull(eye, all, options).empty());
+
+		// Only enabled cameras are selected.
+		options.maxCandidates = 3;
+		SIBR_CHECK(culler.cull(eye, { 6, 2, 3, 4 }, options) == std::vector<uint>({ 3, 2, 6 }));
+
+		// A narrower cone culls the most tilted cameras.
+		options.maxCandidates = 32;
+		options.coneAngle = 25.0f;
+		SIBR_CHECK(culler.cull(eye, all, options) == std::vector<uint>({ 0, 1, 3 }));
+
+		// Everything culled: fall back to the best enabled cameras.
+		options.coneAngle = 80.0f;
+		SIBR_CHECK(culler.cull(eye, { 4, 5 }, options) == std::vector<uint>({ 5, 4 }));
+		SIBR_CHECK(culler.visibleCount() == 0);
+	}
+}
+
+int main(int ac, char ** av)
+{
+	checkFrustum();
+	checkCuller();
+	return checks::result();
+}